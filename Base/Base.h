@@ -1,12 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 class Base
 {
 public:
-	virtual ~Base() = 0 {}
+	virtual ~Base() = 0;
 
 	virtual bool Init() { return true; }
 
@@ -21,6 +22,9 @@ protected:
 	std::vector<std::shared_ptr<Base>>	m_referenceTable;
 };
 
+// Pure, but still called by destructors of subclasses
+inline Base::~Base() {}
+
 template <class T>
 class SelfRefBase : public Base
 {
@@ -7,6 +7,7 @@
 public:	\
 static std::size_t ClassHashCode;	\
 virtual bool IsSameClass(std::size_t classHashCode) const override;	\
+virtual std::size_t GetClassHashCode() const override { return ClassHashCode; }	\
 
 #define DEFINITE_CLASS_RTTI(class_name, base_class)	\
 std::size_t	class_name::ClassHashCode = std::hash<std::string>()(TO_STRING(class_name));	\
@@ -51,35 +52,24 @@ public:
 		return ClassHashCode == classHashCode;
 	}
 
+	// Exact class of this component, used to pick its pool in component registry
+	virtual std::size_t GetClassHashCode() const { return ClassHashCode; }
+
+	// These go through the owner object, they're defined after BaseObject in BaseObject.h
 	template <typename T>
-	std::shared_ptr<T> GetComponent(uint32_t index = 0) const
-	{
-		return GetBaseObject()->GetComponent<T>(index);
-	}
+	std::shared_ptr<T> GetComponent(uint32_t index = 0) const;
 
 	template <typename T>
-	std::vector<std::shared_ptr<T>> GetComponents() const
-	{
-		return GetBaseObject()->GetComponents<T>();
-	}
+	void GetComponents(std::vector<std::shared_ptr<T>>& components) const;
 
 	template <typename T>
-	bool DelComponent(uint32_t index = 0)
-	{
-		return GetBaseObject()->DelComponent<T>(index);
-	}
+	bool DelComponent(uint32_t index = 0);
 
 	template <typename T>
-	uint32_t DelComponents()
-	{
-		GetBaseObject()->DelComponents<T>();
-	}
+	uint32_t DelComponents();
 
 	template <typename T>
-	bool ContainComponent(const std::shared_ptr<T>& pComp) const
-	{
-		return GetBaseObject()->ContainComponent<T>();
-	}
+	bool ContainComponent(const std::shared_ptr<T>& pComp) const;
 
 protected:
 	virtual bool Init(const std::shared_ptr<BaseComponent>& pSelf)
@@ -107,6 +97,11 @@ protected:
 	std::weak_ptr<BaseObject>	m_pObject;
 	std::mutex					m_updateMutex;
 
+	// Location in component registry
+	uint32_t					m_registryPoolIndex = (uint32_t)-1;
+	uint32_t					m_registryIndex = (uint32_t)-1;
+
 	friend class BaseObject;
+	friend class ComponentRegistry;
 };
 
@@ -1,6 +1,8 @@
 #include "BaseObject.h"
-#include "../vulkan/GlobalDeviceObjects.h"
-#include "../vulkan/FrameManager.h"
+#include <algorithm>
+
+std::atomic<uint64_t> BaseObject::m_worldTransformQueryCount = { 0 };
+std::atomic<uint64_t> BaseObject::m_worldTransformRecomputeCount = { 0 };
 
 bool BaseObject::Init(const std::shared_ptr<BaseObject>& pObj)
 {
@@ -8,9 +10,33 @@ bool BaseObject::Init(const std::shared_ptr<BaseObject>& pObj)
 		return false;
 
 	m_localScale = 1.0f;
+
+	m_transformHandle = TransformHierarchy::GetInstance()->AllocateNode();
+	TransformHierarchy::GetInstance()->SetLocalTransform(m_transformHandle, m_localTransform);
 	return true;
 }
 
+BaseObject::~BaseObject()
+{
+	if (m_transformHandle == TransformHierarchy::INVALID_NODE)
+		return;
+
+	// Components might outlive this object too, registry must not point to this object anymore
+	for (auto & pComp : m_components)
+		ComponentRegistry::GetInstance()->Unregister(pComp.get());
+
+	// Children might outlive this object if someone else holds them, make them roots
+	for (auto & pChild : m_children)
+	{
+		TransformHierarchy::GetInstance()->SetParent(pChild->m_transformHandle, TransformHierarchy::INVALID_NODE);
+		pChild->MarkWorldTransformDirty();
+		pChild->SetSceneRoot(pChild.get());
+	}
+
+	ComponentRegistry::GetInstance()->MarkStructureChanged();
+	TransformHierarchy::GetInstance()->FreeNode(m_transformHandle);
+}
+
 std::shared_ptr<BaseObject> BaseObject::Create()
 {
 	std::shared_ptr<BaseObject> pObj = std::make_shared<BaseObject>();
@@ -25,13 +51,22 @@ void BaseObject::AddChild(const std::shared_ptr<BaseObject>& pObj)
 		return;
 	m_children.push_back(pObj);
 	pObj->m_pParent = GetSelfSharedPtr();
+	TransformHierarchy::GetInstance()->SetParent(pObj->m_transformHandle, m_transformHandle);
+	pObj->MarkWorldTransformDirty();
+	pObj->SetSceneRoot(m_pSceneRoot);
+	ComponentRegistry::GetInstance()->MarkStructureChanged();
 }
 
 void BaseObject::DelChild(uint32_t index)
 {
 	if (index < 0 || index >= m_children.size())
 		return;
+	TransformHierarchy::GetInstance()->SetParent(m_children[index]->m_transformHandle, TransformHierarchy::INVALID_NODE);
+	m_children[index]->m_pParent.reset();
+	m_children[index]->MarkWorldTransformDirty();
+	m_children[index]->SetSceneRoot(m_children[index].get());
 	m_children.erase(m_children.begin() + index);
+	ComponentRegistry::GetInstance()->MarkStructureChanged();
 }
 
 std::shared_ptr<BaseObject> BaseObject::GetChild(uint32_t index)
@@ -51,78 +86,49 @@ bool BaseObject::ContainObject(const std::shared_ptr<BaseObject>& pObj) const
 	return false;
 }
 
-void BaseObject::Update()
+void BaseObject::CollectSceneComponents(std::vector<std::shared_ptr<BaseComponent>>& components) const
 {
-	//update components attached to this object
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->Update();
+	components.insert(components.end(), m_components.begin(), m_components.end());
+	for (auto & pChild : m_children)
+		pChild->CollectSceneComponents(components);
+}
 
-	//update all children objects with global registered components
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->Update();
+void BaseObject::Update()
+{
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->Update(); });
 }
 
 void BaseObject::OnAnimationUpdate()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnAnimationUpdate();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnAnimationUpdate();
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->OnAnimationUpdate(); });
 }
 
 void BaseObject::LateUpdate()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->LateUpdate();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->LateUpdate();
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->LateUpdate(); });
 }
 
+// World transforms of the whole scene live in one flattened storage, it's updated level by level rather than by recursion here
 void BaseObject::UpdateCachedData()
 {
-	Matrix4d cachedParentWorldTransform;
-
-	if (!m_pParent.expired())
-		cachedParentWorldTransform = m_pParent.lock()->m_cachedWorldTransform;
-
-	m_cachedWorldTransform = cachedParentWorldTransform * m_localTransform;
-	m_cachedWorldPosition = (cachedParentWorldTransform * Vector4d(m_localPosition, 1.0f)).xyz();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->UpdateCachedData();
+	TransformHierarchy::GetInstance()->Update();
 }
 
 void BaseObject::OnPreRender()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnPreRender();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnPreRender();
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->OnPreRender(); });
 }
 
 void BaseObject::OnRenderObject()
 {
-	//update components attached to this object
 	//for (size_t i = 0; i < m_components.size(); i++)
 	//	FrameMgr()->AddJobToFrame(std::bind(&BaseComponent::OnRenderObject, m_components[i].get(), std::placeholders::_1));
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnRenderObject();
-
-	//update all children objects
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnRenderObject();
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->OnRenderObject(); });
 }
 
 void BaseObject::OnPostRender()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnPostRender();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnPostRender();
+	ForEachSceneComponent([](BaseComponent* pComp) { pComp->OnPostRender(); });
 }
 
 void BaseObject::Awake()
@@ -154,40 +160,51 @@ void BaseObject::SetRotation(const Quaterniond& q)
 void BaseObject::UpdateLocalTransform()
 {
 	m_localTransform = Matrix4d(m_localRotationM * Matrix3d(Vector3d(m_localScale)), m_localPosition);
+	TransformHierarchy::GetInstance()->SetLocalTransform(m_transformHandle, m_localTransform);
+	MarkWorldTransformDirty();
 }
 
-Vector3d BaseObject::GetWorldPosition() const
+void BaseObject::SetSceneRoot(BaseObject* pSceneRoot)
 {
-	Matrix4d parentWorldTransform;
+	m_pSceneRoot = pSceneRoot;
+	for (size_t i = 0; i < m_children.size(); i++)
+		m_children[i]->SetSceneRoot(pSceneRoot);
+}
 
-	if (!m_pParent.expired())
-		parentWorldTransform = m_pParent.lock()->GetWorldTransform();
+void BaseObject::MarkWorldTransformDirty()
+{
+	if (m_isWorldTransformDirty)
+		return;
 
-	//get world transform
-	return (parentWorldTransform * Vector4d(m_localPosition, 1.0)).xyz();
+	m_isWorldTransformDirty = true;
+	for (size_t i = 0; i < m_children.size(); i++)
+		m_children[i]->MarkWorldTransformDirty();
 }
 
-Matrix4d BaseObject::GetWorldTransform() const 
-{ 
-	Matrix4d parentWorldTransform;
-	if (!m_pParent.expired())
-		parentWorldTransform = m_pParent.lock()->GetWorldTransform();
+void BaseObject::UpdateWorldTransform() const
+{
+	m_worldTransformQueryCount++;
 
-	return parentWorldTransform * m_localTransform;
-}
+	if (!m_isWorldTransformDirty)
+		return;
 
-Matrix3d BaseObject::GetWorldRotationM() const
-{ 
-	Matrix3d parentWorldRotationM;
 	if (!m_pParent.expired())
-		parentWorldRotationM = m_pParent.lock()->GetWorldRotationM();
+	{
+		std::shared_ptr<BaseObject> pParent = m_pParent.lock();
+		pParent->UpdateWorldTransform();
 
-	return parentWorldRotationM * m_localRotationM;
-}
+		m_worldTransform = pParent->m_worldTransform * m_localTransform;
+		m_worldRotationM = pParent->m_worldRotationM * m_localRotationM;
+	}
+	else
+	{
+		m_worldTransform = m_localTransform;
+		m_worldRotationM = m_localRotationM;
+	}
 
-Quaterniond BaseObject::GetWorldRotationQ() const
-{ 
-	return Quaterniond(GetWorldRotationM());
+	m_worldRotationQ = Quaterniond(m_worldRotationM);
+	m_isWorldTransformDirty = false;
+	m_worldTransformRecomputeCount++;
 }
 
 void BaseObject::Rotate(const Vector3d& v, double angle)
@@ -1,14 +1,20 @@
 #pragma once
 #include <vector>
+#include <atomic>
 #include "BaseComponent.h"
-#include "../maths/Matrix.h"
-#include "../maths/Quaternion.h"
+#include "../Maths/Matrix.h"
+#include "../Maths/Quaternion.h"
+#include "TransformHierarchy.h"
+#include "ComponentRegistry.h"
 
 class BaseObject : public SelfRefBase<BaseObject>
 {
 protected:
 	bool Init(const std::shared_ptr<BaseObject>& pObj);
 
+public:
+	~BaseObject();
+
 public:
 	template <typename T>
 	void AddComponent(const std::shared_ptr<T>& pComp)
@@ -16,7 +22,11 @@ public:
 		if (ContainComponent(pComp))
 			return;
 
+		// A component belongs to one object at a time in registry
+		ComponentRegistry::GetInstance()->Unregister(pComp.get());
+
 		m_components.push_back(pComp);
+		ComponentRegistry::GetInstance()->Register(this, pComp.get());
 		pComp->OnAddedToObject(GetSelfSharedPtr());
 	}
 
@@ -26,7 +36,7 @@ public:
 		uint32_t currentIndex = 0;
 		auto iter = std::find_if(m_components.begin(), m_components.end(), [&currentIndex, index, classHashCode = T::ClassHashCode](auto & pComp)
 		{
-			return (currentIndex == index) && pComp->IsSameClass(classHashCode);
+			return pComp->IsSameClass(classHashCode) && (currentIndex++ == index);
 		});
 
 		return iter;
@@ -35,6 +45,14 @@ public:
 	template <typename T>
 	std::shared_ptr<T> GetComponent(uint32_t index = 0) const
 	{
+		// First component of exact type goes through registry directly, unless there're only a couple of components, which are quicker to scan
+		if (index == 0 && m_components.size() > 2)
+		{
+			BaseComponent* pComp = ComponentRegistry::GetInstance()->Find(T::ClassHashCode, m_transformHandle);
+			if (pComp != nullptr)
+				return std::static_pointer_cast<T>(pComp->GetSelfSharedPtr());
+		}
+
 		auto iter = GetComponentIter<T>(index);
 
 		if (iter != m_components.end())
@@ -45,18 +63,15 @@ public:
 		return nullptr;
 	}
 
+	// Results are appended, so that a caller could keep one vector around and clear it between calls without allocating again
 	template <typename T>
-	std::vector<std::shared_ptr<T>> GetComponents() const
+	void GetComponents(std::vector<std::shared_ptr<T>>& components) const
 	{
-		std::vector<std::shared_ptr<T>> resultVector;
-		
 		for (auto & pComp : m_components)
 		{
 			if (pComp->IsSameClass(T::ClassHashCode))
-				resultVector.push_back(std::static_pointer_cast<T>(pComp));
+				components.push_back(std::static_pointer_cast<T>(pComp));
 		}
-
-		return resultVector;
 	}
 
 	template <typename T>
@@ -66,6 +81,7 @@ public:
 
 		if (iter != m_components.end())
 		{
+			ComponentRegistry::GetInstance()->Unregister(iter->get());
 			m_components.erase(iter);
 			return true;
 		}
@@ -89,6 +105,7 @@ public:
 
 			if (iter != m_components.end())
 			{
+				ComponentRegistry::GetInstance()->Unregister(iter->get());
 				m_components.erase(iter);
 				removed = true;
 				count++;
@@ -102,8 +119,7 @@ public:
 	template <typename T>
 	bool ContainComponent(const std::shared_ptr<T>& pComp) const
 	{
-		auto vec = GetComponents<T>();
-		return std::find(vec.begin(), vec.end(), pComp) != vec.end();
+		return ComponentRegistry::GetInstance()->GetOwner(pComp.get()) == this;
 	}
 
 	void AddChild(const std::shared_ptr<BaseObject>& pObj);
@@ -131,6 +147,7 @@ public:
 	void Rotate(const Vector3d& v, double angle);
 
 public:
+	// Frame passes go through components of the whole scene this object is root of
 	void Update();
 	void OnAnimationUpdate();
 	void LateUpdate();
@@ -143,25 +160,68 @@ public:
 	virtual void Start();
 
 	Vector3d GetLocalPosition() const { return m_localPosition; }
-	Vector3d GetWorldPosition() const;
+	Vector3d GetLocalScale() const { return m_localScale; }
+	Vector3d GetWorldPosition() const { UpdateWorldTransform(); return m_worldTransform.TranslationVector(); }
 
 	Matrix4d GetLocalTransform() const { return m_localTransform; }
 	Matrix3d GetLocalRotationM() const { return m_localRotationM; }
 	Quaterniond GetLocalRotationQ() const { return m_localRotationQ; }
 
-	Matrix4d GetWorldTransform() const;
-	Matrix3d GetWorldRotationM() const;
-	Quaterniond GetWorldRotationQ() const;
+	// World queries are cached and only recomputed after this object or one of its ancestors is changed
+	Matrix4d GetWorldTransform() const { UpdateWorldTransform(); return m_worldTransform; }
+	Matrix3d GetWorldRotationM() const { UpdateWorldTransform(); return m_worldRotationM; }
+	Quaterniond GetWorldRotationQ() const { UpdateWorldTransform(); return m_worldRotationQ; }
 
 	// These are before the stage of pre render
-	Matrix4d GetCachedWorldTransform() const { return m_cachedWorldTransform; }
-	Vector3d GetCachedWorldPosition() const { return m_cachedWorldPosition; }
+	Matrix4d GetCachedWorldTransform() const { return TransformHierarchy::GetInstance()->GetWorldTransform(m_transformHandle); }
+	Vector3d GetCachedWorldPosition() const { return TransformHierarchy::GetInstance()->GetWorldTransform(m_transformHandle).TranslationVector(); }
+	uint32_t GetTransformHandle() const { return m_transformHandle; }
+
+	// Statistics of world transform queries
+	static uint64_t GetWorldTransformQueryCount() { return m_worldTransformQueryCount; }
+	static uint64_t GetWorldTransformRecomputeCount() { return m_worldTransformRecomputeCount; }
+	static void ResetWorldTransformCounters() { m_worldTransformQueryCount = 0; m_worldTransformRecomputeCount = 0; }
 
 	//creators
 	static std::shared_ptr<BaseObject> Create();
 
 protected:
 	void UpdateLocalTransform();
+	void SetSceneRoot(BaseObject* pSceneRoot);
+
+	// Components of the scene this object is root of, in the same order as recursion through the tree, i.e. an object's components before its children's
+	// They're collected again only when structure of any scene changes, so passes walk a flat array rather than the tree
+	// Passes can't go type by type over registry pools, components of different types depend on each other's order within one pass,
+	// e.g. DirectionLight::OnPreRender reads the view matrix that camera's OnPreRender writes in the same pass
+	void CollectSceneComponents(std::vector<std::shared_ptr<BaseComponent>>& components) const;
+
+	template <typename Func>
+	void ForEachSceneComponent(Func func)
+	{
+		// Scene root is required, objects under a different root belong to a different scene
+		ASSERTION(m_pSceneRoot == this);
+
+		if (m_sceneComponentsVersion != ComponentRegistry::GetInstance()->GetStructureVersion())
+		{
+			m_sceneComponents.clear();
+			CollectSceneComponents(m_sceneComponents);
+			m_sceneComponentsVersion = ComponentRegistry::GetInstance()->GetStructureVersion();
+		}
+
+		// Components removed during a pass are skipped, and ones added join from next pass
+		for (size_t i = 0; i < m_sceneComponents.size(); i++)
+		{
+			BaseObject* pOwner = ComponentRegistry::GetInstance()->GetOwner(m_sceneComponents[i].get());
+			if (pOwner != nullptr && pOwner->m_pSceneRoot == this)
+				func(m_sceneComponents[i].get());
+		}
+
+		// Removed components are held by the list till the end of the pass, they're released here rather than at next pass
+		if (m_sceneComponentsVersion != ComponentRegistry::GetInstance()->GetStructureVersion())
+			m_sceneComponents.clear();
+	}
+	void MarkWorldTransformDirty();
+	void UpdateWorldTransform() const;
 
 protected:
 	std::vector<std::shared_ptr<BaseComponent>>		m_components;
@@ -175,6 +235,56 @@ protected:
 	Matrix3d	m_localRotationM;
 	Quaterniond m_localRotationQ;
 
-	Matrix4d	m_cachedWorldTransform;
-	Vector3d	m_cachedWorldPosition;
-};
\ No newline at end of file
+	// Cached world transform for queries at any time of a frame
+	// If an object is dirty, all of its descendants are dirty too, so marking could stop at the first dirty one
+	// NOTE: Not thread safe, queries are expected from the main thread, same as setters
+	mutable Matrix4d	m_worldTransform;
+	mutable Matrix3d	m_worldRotationM;
+	mutable Quaterniond	m_worldRotationQ;
+	mutable bool		m_isWorldTransformDirty = true;
+
+	static std::atomic<uint64_t>	m_worldTransformQueryCount;
+	static std::atomic<uint64_t>	m_worldTransformRecomputeCount;
+
+	// Root of the hierarchy this object is in, itself if it doesn't have a parent
+	BaseObject*	m_pSceneRoot = this;
+
+	// Handle of world transform in flattened hierarchy storage
+	uint32_t	m_transformHandle = TransformHierarchy::INVALID_NODE;
+
+	// Only used by scene root, see "ForEachSceneComponent"
+	std::vector<std::shared_ptr<BaseComponent>>		m_sceneComponents;
+	uint32_t										m_sceneComponentsVersion = (uint32_t)-1;
+
+	friend class ComponentRegistry;
+};
+
+template <typename T>
+std::shared_ptr<T> BaseComponent::GetComponent(uint32_t index) const
+{
+	return GetBaseObject()->GetComponent<T>(index);
+}
+
+template <typename T>
+void BaseComponent::GetComponents(std::vector<std::shared_ptr<T>>& components) const
+{
+	GetBaseObject()->GetComponents<T>(components);
+}
+
+template <typename T>
+bool BaseComponent::DelComponent(uint32_t index)
+{
+	return GetBaseObject()->DelComponent<T>(index);
+}
+
+template <typename T>
+uint32_t BaseComponent::DelComponents()
+{
+	return GetBaseObject()->DelComponents<T>();
+}
+
+template <typename T>
+bool BaseComponent::ContainComponent(const std::shared_ptr<T>& pComp) const
+{
+	return GetBaseObject()->ContainComponent<T>(pComp);
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "ComponentRegistry.h"
+#include "BaseObject.h"
+#include "BaseComponent.h"
+
+const uint32_t ComponentRegistry::INVALID_INDEX;
+
+ComponentRegistry::ComponentPool* ComponentRegistry::AcquirePool(std::size_t classHashCode, uint32_t& poolIndex)
+{
+	auto iter = m_poolLookupTable.find(classHashCode);
+	if (iter != m_poolLookupTable.end())
+	{
+		poolIndex = iter->second;
+		return m_pools[poolIndex].get();
+	}
+
+	poolIndex = (uint32_t)m_pools.size();
+	m_pools.push_back(std::make_unique<ComponentPool>());
+	m_pools.back()->classHashCode = classHashCode;
+	m_poolLookupTable[classHashCode] = poolIndex;
+	return m_pools.back().get();
+}
+
+const ComponentRegistry::ComponentPool* ComponentRegistry::GetPool(std::size_t classHashCode) const
+{
+	auto iter = m_poolLookupTable.find(classHashCode);
+	if (iter == m_poolLookupTable.end())
+		return nullptr;
+	return m_pools[iter->second].get();
+}
+
+void ComponentRegistry::Register(BaseObject* pObject, BaseComponent* pComp)
+{
+	ASSERTION(pComp->m_registryIndex == INVALID_INDEX);
+
+	uint32_t poolIndex;
+	ComponentPool* pPool = AcquirePool(pComp->GetClassHashCode(), poolIndex);
+
+	uint32_t entryIndex = (uint32_t)pPool->entries.size();
+	pPool->entries.push_back({ pComp, pObject });
+
+	pComp->m_registryPoolIndex = poolIndex;
+	pComp->m_registryIndex = entryIndex;
+
+	uint32_t objectHandle = pObject->GetTransformHandle();
+	if (objectHandle >= pPool->objectToEntry.size())
+		pPool->objectToEntry.resize(objectHandle + 1, INVALID_INDEX);
+
+	// Keep pointing to the first one, if there're multiple components of same type in an object
+	if (pPool->objectToEntry[objectHandle] == INVALID_INDEX)
+		pPool->objectToEntry[objectHandle] = entryIndex;
+
+	m_componentCount++;
+	m_structureVersion++;
+}
+
+void ComponentRegistry::Unregister(BaseComponent* pComp)
+{
+	if (pComp->m_registryIndex == INVALID_INDEX)
+		return;
+
+	uint32_t poolIndex = pComp->m_registryPoolIndex;
+	ComponentPool* pPool = m_pools[poolIndex].get();
+	uint32_t entryIndex = pComp->m_registryIndex;
+	BaseObject* pObject = pPool->entries[entryIndex].pObject;
+	uint32_t objectHandle = pObject->GetTransformHandle();
+	bool isObjectFirst = pPool->objectToEntry[objectHandle] == entryIndex;
+
+	// Entries mustn't move while they're iterated, it's left null and compacted afterwards
+	if (m_iterationDepth > 0)
+	{
+		pPool->entries[entryIndex] = { nullptr, nullptr };
+		pPool->hasNullEntries = true;
+	}
+	// Swap with the last one to keep array dense
+	else
+	{
+		uint32_t lastIndex = (uint32_t)pPool->entries.size() - 1;
+		if (entryIndex != lastIndex)
+		{
+			ComponentEntry& lastEntry = pPool->entries[lastIndex];
+			pPool->entries[entryIndex] = lastEntry;
+			lastEntry.pComponent->m_registryIndex = entryIndex;
+
+			uint32_t lastObjectHandle = lastEntry.pObject->GetTransformHandle();
+			if (pPool->objectToEntry[lastObjectHandle] == lastIndex)
+				pPool->objectToEntry[lastObjectHandle] = entryIndex;
+		}
+		pPool->entries.pop_back();
+	}
+
+	pComp->m_registryPoolIndex = INVALID_INDEX;
+	pComp->m_registryIndex = INVALID_INDEX;
+	m_componentCount--;
+	m_structureVersion++;
+
+	if (!isObjectFirst)
+		return;
+
+	// Removed one was the object's first of its type, point to the next one if any
+	pPool->objectToEntry[objectHandle] = INVALID_INDEX;
+	for (auto & pSibling : pObject->m_components)
+	{
+		if (pSibling.get() != pComp && pSibling->m_registryPoolIndex == poolIndex)
+		{
+			pPool->objectToEntry[objectHandle] = pSibling->m_registryIndex;
+			break;
+		}
+	}
+}
+
+void ComponentRegistry::CompactPools()
+{
+	for (auto & pPool : m_pools)
+	{
+		if (!pPool->hasNullEntries)
+			continue;
+
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < (uint32_t)pPool->entries.size(); i++)
+		{
+			ComponentEntry entry = pPool->entries[i];
+			if (entry.pComponent == nullptr)
+				continue;
+
+			if (i != count)
+			{
+				pPool->entries[count] = entry;
+				entry.pComponent->m_registryIndex = count;
+
+				uint32_t objectHandle = entry.pObject->GetTransformHandle();
+				if (pPool->objectToEntry[objectHandle] == i)
+					pPool->objectToEntry[objectHandle] = count;
+			}
+			count++;
+		}
+
+		pPool->entries.resize(count);
+		pPool->hasNullEntries = false;
+	}
+}
+
+BaseObject* ComponentRegistry::GetOwner(const BaseComponent* pComp) const
+{
+	if (pComp->m_registryIndex == INVALID_INDEX)
+		return nullptr;
+	return m_pools[pComp->m_registryPoolIndex]->entries[pComp->m_registryIndex].pObject;
+}
+
+BaseComponent* ComponentRegistry::Find(std::size_t classHashCode, uint32_t objectHandle) const
+{
+	const ComponentPool* pPool = GetPool(classHashCode);
+	if (pPool == nullptr || objectHandle >= pPool->objectToEntry.size())
+		return nullptr;
+
+	uint32_t entryIndex = pPool->objectToEntry[objectHandle];
+	if (entryIndex == INVALID_INDEX)
+		return nullptr;
+
+	return pPool->entries[entryIndex].pComponent;
+}
+
+uint32_t ComponentRegistry::GetComponentCount(std::size_t classHashCode) const
+{
+	const ComponentPool* pPool = GetPool(classHashCode);
+	return pPool == nullptr ? 0 : (uint32_t)pPool->entries.size();
+}
\ No newline at end of file
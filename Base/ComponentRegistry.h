@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include "../common/Singleton.h"
+
+class BaseObject;
+class BaseComponent;
+
+// Dense storage of all components attached to objects, grouped by exact component type
+// Components of one type are packed in one array, so a pass over a type walks a tight array rather than the object tree
+// Each pool also keeps a sparse table indexed by object transform handle, for constant time lookup of an object's component of that type
+//
+// Components are still owned by their objects, the registry only keeps raw pointers and is kept in sync by BaseObject
+//
+// Components unregistered while "ForEach" is going on leave a null entry behind, pools are compacted once the outermost "ForEach" is done,
+// so that no component is skipped or visited twice
+class ComponentRegistry : public Singleton<ComponentRegistry>
+{
+public:
+	static const uint32_t INVALID_INDEX = (uint32_t)-1;
+
+	typedef struct _ComponentEntry
+	{
+		BaseComponent*	pComponent;
+		BaseObject*		pObject;
+	}ComponentEntry;
+
+	typedef struct _ComponentPool
+	{
+		std::size_t						classHashCode;
+		std::vector<ComponentEntry>		entries;
+		// Object transform handle to index of the object's first component of this type
+		std::vector<uint32_t>			objectToEntry;
+		bool							hasNullEntries = false;
+	}ComponentPool;
+
+public:
+	bool Init() override { return true; }
+
+public:
+	void Register(BaseObject* pObject, BaseComponent* pComp);
+	void Unregister(BaseComponent* pComp);
+
+	BaseObject* GetOwner(const BaseComponent* pComp) const;
+
+	// Object's first component of exact type, nullptr if there isn't any
+	BaseComponent* Find(std::size_t classHashCode, uint32_t objectHandle) const;
+
+	// Pools are in the order their types are first registered, entries might be null while "ForEach" is going on
+	const std::vector<std::unique_ptr<ComponentPool>>& GetPools() const { return m_pools; }
+	const ComponentPool* GetPool(std::size_t classHashCode) const;
+
+	// Components added by callback are visited in the same pass, removed ones aren't visited any more
+	template <typename T>
+	void ForEach(const std::function<void(T*)>& func)
+	{
+		const ComponentPool* pPool = GetPool(T::ClassHashCode);
+		if (pPool == nullptr)
+			return;
+
+		m_iterationDepth++;
+
+		// Size is read every iteration, since callback might add components
+		for (size_t i = 0; i < pPool->entries.size(); i++)
+		{
+			if (pPool->entries[i].pComponent != nullptr)
+				func(static_cast<T*>(pPool->entries[i].pComponent));
+		}
+
+		if (--m_iterationDepth == 0)
+			CompactPools();
+	}
+
+	uint32_t GetComponentCount(std::size_t classHashCode) const;
+	uint32_t GetComponentCount() const { return m_componentCount; }
+
+	// Bumped whenever a component is added or removed, or hierarchy changes, so that scene roots know when to collect their components again
+	uint32_t GetStructureVersion() const { return m_structureVersion; }
+	void MarkStructureChanged() { m_structureVersion++; }
+
+protected:
+	ComponentPool* AcquirePool(std::size_t classHashCode, uint32_t& poolIndex);
+	// Drops null entries left by removal during iteration, order of remaining ones is kept
+	void CompactPools();
+
+protected:
+	std::vector<std::unique_ptr<ComponentPool>>		m_pools;
+	std::unordered_map<std::size_t, uint32_t>		m_poolLookupTable;
+	uint32_t										m_componentCount = 0;
+	uint32_t										m_structureVersion = 0;
+	uint32_t										m_iterationDepth = 0;
+};
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "TransformHierarchy.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <algorithm>
+#include <chrono>
+
+const uint32_t TransformHierarchy::INVALID_NODE;
+const uint32_t TransformHierarchy::PARALLEL_GRAIN;
+
+uint32_t TransformHierarchy::AllocateNode()
+{
+	uint32_t handle;
+	if (m_freeHandles.size() != 0)
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (uint32_t)m_handleToSlot.size();
+		m_handleToSlot.push_back(INVALID_NODE);
+		m_parentHandles.push_back(INVALID_NODE);
+		m_aliveFlags.push_back(0);
+	}
+
+	// New node goes to the end as a root, it'll be moved to its proper depth in next rebuild
+	uint32_t slot = (uint32_t)m_slotToHandle.size();
+	m_handleToSlot[handle] = slot;
+	m_parentHandles[handle] = INVALID_NODE;
+	m_aliveFlags[handle] = 1;
+
+	m_localTransforms.push_back(Matrix4d());
+	m_worldTransforms.push_back(Matrix4d());
+	m_parentSlots.push_back(INVALID_NODE);
+	m_slotToHandle.push_back(handle);
+	m_dirtyFlags.push_back(1);
+	m_changedFlags.push_back(0);
+
+	m_dirtyCount++;
+	m_isOrderDirty = true;
+
+	return handle;
+}
+
+void TransformHierarchy::FreeNode(uint32_t handle)
+{
+	if (handle >= m_aliveFlags.size() || !m_aliveFlags[handle])
+		return;
+
+	// Slot is compacted in next rebuild
+	m_aliveFlags[handle] = 0;
+	m_parentHandles[handle] = INVALID_NODE;
+	m_freeHandles.push_back(handle);
+	m_isOrderDirty = true;
+}
+
+void TransformHierarchy::SetParent(uint32_t handle, uint32_t parentHandle)
+{
+	if (m_parentHandles[handle] == parentHandle)
+		return;
+
+	m_parentHandles[handle] = parentHandle;
+	MarkDirty(m_handleToSlot[handle]);
+	m_isOrderDirty = true;
+}
+
+void TransformHierarchy::SetLocalTransform(uint32_t handle, const Matrix4d& localTransform)
+{
+	uint32_t slot = m_handleToSlot[handle];
+	m_localTransforms[slot] = localTransform;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t slot)
+{
+	if (m_dirtyFlags[slot])
+		return;
+
+	m_dirtyFlags[slot] = 1;
+	m_dirtyCount++;
+
+	// Levels are worked out from dirty flags again by rebuild
+	if (m_isOrderDirty)
+		return;
+
+	uint32_t level = (uint32_t)(std::upper_bound(m_levelOffsets.begin(), m_levelOffsets.end(), slot) - m_levelOffsets.begin()) - 1;
+	m_levelDirtyBegins[level] = std::min(m_levelDirtyBegins[level], slot);
+	m_levelDirtyEnds[level] = std::max(m_levelDirtyEnds[level], slot + 1);
+}
+
+// Lay alive nodes out breadth first, children of each parent are appended in parent order, and rearrange all slot indexed arrays accordingly
+void TransformHierarchy::RebuildOrder()
+{
+	uint32_t handleCount = (uint32_t)m_handleToSlot.size();
+
+	// Children lists in old slot order, so that relative order of siblings is kept. Nodes whose parent is gone become roots
+	std::vector<uint32_t> firstChildren(handleCount, INVALID_NODE);
+	std::vector<uint32_t> lastChildren(handleCount, INVALID_NODE);
+	std::vector<uint32_t> nextSiblings(handleCount, INVALID_NODE);
+	std::vector<uint32_t> slotToHandle;
+
+	for (uint32_t oldSlot = 0; oldSlot < m_slotToHandle.size(); oldSlot++)
+	{
+		uint32_t handle = m_slotToHandle[oldSlot];
+		if (!m_aliveFlags[handle] || m_handleToSlot[handle] != oldSlot)
+			continue;
+
+		uint32_t parent = m_parentHandles[handle];
+		if (parent == INVALID_NODE || !m_aliveFlags[parent])
+		{
+			slotToHandle.push_back(handle);
+			continue;
+		}
+
+		if (firstChildren[parent] == INVALID_NODE)
+			firstChildren[parent] = handle;
+		else
+			nextSiblings[lastChildren[parent]] = handle;
+		lastChildren[parent] = handle;
+	}
+
+	// Roots make level 0, walking slots in order appends each level right after the one above
+	m_levelOffsets.assign(1, 0);
+	m_childOffsets.clear();
+	uint32_t levelEnd = (uint32_t)slotToHandle.size();
+	for (uint32_t slot = 0; slot < slotToHandle.size(); slot++)
+	{
+		if (slot == levelEnd)
+		{
+			m_levelOffsets.push_back(levelEnd);
+			levelEnd = (uint32_t)slotToHandle.size();
+		}
+
+		m_childOffsets.push_back((uint32_t)slotToHandle.size());
+		for (uint32_t child = firstChildren[slotToHandle[slot]]; child != INVALID_NODE; child = nextSiblings[child])
+			slotToHandle.push_back(child);
+	}
+
+	uint32_t nodeCount = (uint32_t)slotToHandle.size();
+	m_levelOffsets.push_back(nodeCount);
+	m_childOffsets.push_back(nodeCount);
+
+	uint32_t levelCount = (uint32_t)m_levelOffsets.size() - 1;
+	m_levelDirtyBegins.assign(levelCount, nodeCount);
+	m_levelDirtyEnds.assign(levelCount, 0);
+
+	std::vector<Matrix4d> localTransforms(nodeCount);
+	std::vector<Matrix4d> worldTransforms(nodeCount);
+	std::vector<uint8_t> dirtyFlags(nodeCount);
+
+	m_dirtyCount = 0;
+	uint32_t level = 0;
+	for (uint32_t slot = 0; slot < nodeCount; slot++)
+	{
+		uint32_t oldSlot = m_handleToSlot[slotToHandle[slot]];
+		localTransforms[slot] = m_localTransforms[oldSlot];
+		worldTransforms[slot] = m_worldTransforms[oldSlot];
+		dirtyFlags[slot] = m_dirtyFlags[oldSlot];
+
+		if (slot == m_levelOffsets[level + 1])
+			level++;
+
+		if (dirtyFlags[slot])
+		{
+			m_dirtyCount++;
+			m_levelDirtyBegins[level] = std::min(m_levelDirtyBegins[level], slot);
+			m_levelDirtyEnds[level] = slot + 1;
+		}
+	}
+
+	for (uint32_t slot = 0; slot < nodeCount; slot++)
+		m_handleToSlot[slotToHandle[slot]] = slot;
+
+	// Dead handles point nowhere
+	for (uint32_t handle = 0; handle < handleCount; handle++)
+	{
+		if (!m_aliveFlags[handle])
+			m_handleToSlot[handle] = INVALID_NODE;
+	}
+
+	m_parentSlots.resize(nodeCount);
+	for (uint32_t slot = 0; slot < nodeCount; slot++)
+	{
+		uint32_t parent = m_parentHandles[slotToHandle[slot]];
+		m_parentSlots[slot] = (parent != INVALID_NODE && m_aliveFlags[parent]) ? m_handleToSlot[parent] : INVALID_NODE;
+	}
+
+	m_localTransforms.swap(localTransforms);
+	m_worldTransforms.swap(worldTransforms);
+	m_dirtyFlags.swap(dirtyFlags);
+	m_slotToHandle.swap(slotToHandle);
+	m_changedFlags.assign(nodeCount, 0);
+
+	m_isOrderDirty = false;
+}
+
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+	uint32_t recomputedCount = 0;
+	for (uint32_t slot = begin; slot < end; slot++)
+	{
+		uint32_t parentSlot = m_parentSlots[slot];
+
+		// Parent level is already done at this point
+		bool changed = m_dirtyFlags[slot] || (parentSlot != INVALID_NODE && m_changedFlags[parentSlot]);
+		m_changedFlags[slot] = changed;
+		m_dirtyFlags[slot] = 0;
+
+		if (!changed)
+			continue;
+
+		if (parentSlot == INVALID_NODE)
+			m_worldTransforms[slot] = m_localTransforms[slot];
+		else
+			m_worldTransforms[slot] = m_worldTransforms[parentSlot] * m_localTransforms[slot];
+
+		recomputedCount++;
+	}
+
+	m_recomputedCount += recomputedCount;
+}
+
+void TransformHierarchy::Update()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if (m_isOrderDirty)
+		RebuildOrder();
+
+	m_recomputedCount = 0;
+
+	// Nothing changed since last update
+	if (m_dirtyCount != 0)
+	{
+		std::shared_ptr<ThreadTaskQueue> pTaskQueue = m_pTaskQueue.lock();
+
+		// Slice walked in the level above, its children might have changed
+		uint32_t parentBegin = 0;
+		uint32_t parentEnd = 0;
+		for (uint32_t level = 0; level < GetLevelCount(); level++)
+		{
+			uint32_t begin = m_levelDirtyBegins[level];
+			uint32_t end = m_levelDirtyEnds[level];
+			if (parentBegin < parentEnd && m_childOffsets[parentBegin] < m_childOffsets[parentEnd])
+			{
+				begin = std::min(begin, m_childOffsets[parentBegin]);
+				end = std::max(end, m_childOffsets[parentEnd]);
+			}
+
+			if (begin < end)
+			{
+				if (pTaskQueue != nullptr && end - begin >= PARALLEL_GRAIN * 2)
+					pTaskQueue->ParallelFor(begin, end, PARALLEL_GRAIN, [this](uint32_t chunkBegin, uint32_t chunkEnd) { UpdateRange(chunkBegin, chunkEnd); });
+				else
+					UpdateRange(begin, end);
+			}
+			else
+				begin = end = 0;
+
+			// Nodes outside of walked slices always have their changed flag cleared, since children outside of parents' slice might read it
+			std::fill(m_changedFlags.begin() + parentBegin, m_changedFlags.begin() + parentEnd, 0);
+
+			m_levelDirtyBegins[level] = GetNodeCount();
+			m_levelDirtyEnds[level] = 0;
+
+			parentBegin = begin;
+			parentEnd = end;
+		}
+		std::fill(m_changedFlags.begin() + parentBegin, m_changedFlags.begin() + parentEnd, 0);
+
+		m_dirtyCount = 0;
+	}
+
+	m_lastUpdateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
\ No newline at end of file
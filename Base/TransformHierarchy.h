@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <memory>
+#include "../common/Singleton.h"
+#include "../Maths/Matrix.h"
+
+// Flattened storage of all object transforms
+// Transforms are kept in contiguous arrays sorted breadth first by depth, so that a parent is always updated before its children,
+// and all nodes of the same depth could be updated in parallel chunks without touching each other
+// Within a level nodes are grouped by parent in parent order, so children of any run of parents are a run of the next level too.
+// Update walks only the slice of each level that is dirty or under a changed slice of the level above
+//
+// Objects hold a handle that's stable during their lifetime, slots(array positions) are rearranged whenever hierarchy structure changes
+
+class ThreadTaskQueue;
+
+class TransformHierarchy : public Singleton<TransformHierarchy>
+{
+public:
+	static const uint32_t INVALID_NODE = (uint32_t)-1;
+
+	// Minimum nodes per job when a level is updated across workers
+	static const uint32_t PARALLEL_GRAIN = 512;
+
+public:
+	bool Init() override { return true; }
+
+public:
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t handle);
+
+	void SetParent(uint32_t handle, uint32_t parentHandle);
+	uint32_t GetParent(uint32_t handle) const { return m_parentHandles[handle]; }
+
+	void SetLocalTransform(uint32_t handle, const Matrix4d& localTransform);
+	const Matrix4d& GetLocalTransform(uint32_t handle) const { return m_localTransforms[m_handleToSlot[handle]]; }
+
+	// World transform as of last update
+	const Matrix4d& GetWorldTransform(uint32_t handle) const { return m_worldTransforms[m_handleToSlot[handle]]; }
+
+	// Recompute world transforms of changed subtrees
+	void Update();
+
+	// Wide levels are split across its workers, everything is updated on calling thread without it
+	void SetTaskQueue(const std::shared_ptr<ThreadTaskQueue>& pTaskQueue) { m_pTaskQueue = pTaskQueue; }
+
+	uint32_t GetNodeCount() const { return (uint32_t)m_slotToHandle.size(); }
+	uint32_t GetLevelCount() const { return m_levelOffsets.size() == 0 ? 0 : (uint32_t)m_levelOffsets.size() - 1; }
+
+	// Statistics of last update
+	uint32_t GetRecomputedCount() const { return m_recomputedCount; }
+	double GetLastUpdateTime() const { return m_lastUpdateTime; }
+
+protected:
+	void RebuildOrder();
+	void UpdateRange(uint32_t begin, uint32_t end);
+	void MarkDirty(uint32_t slot);
+
+protected:
+	// Indexed by handle
+	std::vector<uint32_t>	m_handleToSlot;
+	std::vector<uint32_t>	m_parentHandles;
+	std::vector<uint8_t>	m_aliveFlags;
+	std::vector<uint32_t>	m_freeHandles;
+
+	// Indexed by slot, sorted by depth after each rebuild
+	std::vector<Matrix4d>	m_localTransforms;
+	std::vector<Matrix4d>	m_worldTransforms;
+	std::vector<uint32_t>	m_parentSlots;
+	std::vector<uint32_t>	m_slotToHandle;
+	std::vector<uint8_t>	m_dirtyFlags;
+	// Whether a slot's world transform changed during current update, children look at it to decide if they need recomputing
+	std::vector<uint8_t>	m_changedFlags;
+
+	// Start slot of each depth level, last element is the total count
+	std::vector<uint32_t>	m_levelOffsets;
+	// Children of a slot are [m_childOffsets[slot], m_childOffsets[slot + 1]), one more element than slots
+	std::vector<uint32_t>	m_childOffsets;
+	// Slots of each level marked dirty are within [begin, end), empty if begin >= end
+	std::vector<uint32_t>	m_levelDirtyBegins;
+	std::vector<uint32_t>	m_levelDirtyEnds;
+
+	bool					m_isOrderDirty = false;
+	uint32_t				m_dirtyCount = 0;
+
+	std::atomic<uint32_t>	m_recomputedCount = { 0 };
+	double					m_lastUpdateTime = 0;
+
+	std::weak_ptr<ThreadTaskQueue>	m_pTaskQueue;
+};
\ No newline at end of file
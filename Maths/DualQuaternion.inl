@@ -1,6 +1,8 @@
 #pragma once
 #include "Quaternion.h"
 #include "Vector3.h"
+#include "SIMD.h"
+#include <cmath>
 
 template<typename T>
 DualQuaternion<T>::DualQuaternion()
@@ -233,5 +235,24 @@ DualQuaternion<T> DualQuaternion<T>::DLB(const DualQuaternion<T>& from, const Du
 
 	ret.Normalize();
 
+	return ret;
+}
+
+// Blended in float rather than promoted to double like the template, so it's not bit exact with it
+template<>
+inline DualQuaternion<float> DualQuaternion<float>::DLB(const DualQuaternion<float>& from, const DualQuaternion<float>& to, double factor)
+{
+	SIMDFloat4 fromFactor = SIMDSplat((float)factor);
+	SIMDFloat4 toFactor = SIMDSplat((float)(1.0 - factor));
+
+	SIMDFloat4 real = SIMDMadd(SIMDLoad(&from.x), fromFactor, SIMDMul(SIMDLoad(&to.x), toFactor));
+	SIMDFloat4 dual = SIMDMadd(SIMDLoad(&from.dx), fromFactor, SIMDMul(SIMDLoad(&to.dx), toFactor));
+
+	// Normalize
+	SIMDFloat4 invMag = SIMDSplat(1.0f / std::sqrt(SIMDGetX(SIMDHorizontalAdd(SIMDMul(real, real)))));
+
+	DualQuaternion<float> ret;
+	SIMDStore(&ret.x, SIMDMul(real, invMag));
+	SIMDStore(&ret.dx, SIMDMul(dual, invMag));
 	return ret;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 template <typename T>
 class Vector3;
@@ -71,6 +72,13 @@ public:
 	Vector3<T> TransformAsVector(const Vector3<T>& v) const;
 	Vector3<T> TransformAsPoint(const Vector3<T>& v) const;
 
+	// Batch versions of above, "pSrc" and "pDst" could be the same array
+	void TransformAsVectors(const Vector3<T>* pSrc, Vector3<T>* pDst, uint32_t count) const;
+	void TransformAsPoints(const Vector3<T>* pSrc, Vector3<T>* pDst, uint32_t count) const;
+
+	// Axis aligned bounds as min and max corners, each result is the axis aligned bounds enclosing the transformed one
+	void TransformBounds(const Vector3<T>* pSrcMin, const Vector3<T>* pSrcMax, Vector3<T>* pDstMin, Vector3<T>* pDstMax, uint32_t count) const;
+
 public:
 	union
 	{
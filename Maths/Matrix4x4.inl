@@ -2,7 +2,10 @@
 #include "Matrix4x4.h"
 #include "Vector.h"
 #include "Matrix3x3.inl"
+#include "SIMD.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 template <typename T>
 Matrix4x4<T>::Matrix4x4()
@@ -258,7 +261,7 @@ template <typename T>
 const Matrix4x4<T> Matrix4x4<T>::operator - (const Matrix4x4<T>& m) const
 {
 	Matrix4x4<T> ret = *this;
-	ret -= s;
+	ret -= m;
 	return ret;
 }
 
@@ -407,6 +410,40 @@ Vector3<T> Matrix4x4<T>::TransformAsPoint(const Vector3<T>& v) const
 	return (*this * Vector4<T>(v, 1.0f)).xyz();
 }
 
+template <typename T>
+void Matrix4x4<T>::TransformAsVectors(const Vector3<T>* pSrc, Vector3<T>* pDst, uint32_t count) const
+{
+	for (uint32_t i = 0; i < count; i++)
+		pDst[i] = TransformAsVector(pSrc[i]);
+}
+
+template <typename T>
+void Matrix4x4<T>::TransformAsPoints(const Vector3<T>* pSrc, Vector3<T>* pDst, uint32_t count) const
+{
+	for (uint32_t i = 0; i < count; i++)
+		pDst[i] = TransformAsPoint(pSrc[i]);
+}
+
+template <typename T>
+void Matrix4x4<T>::TransformBounds(const Vector3<T>* pSrcMin, const Vector3<T>* pSrcMax, Vector3<T>* pDstMin, Vector3<T>* pDstMax, uint32_t count) const
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Vector3<T> center = (pSrcMin[i] + pSrcMax[i]) * static_cast<T>(0.5);
+		Vector3<T> extent = (pSrcMax[i] - pSrcMin[i]) * static_cast<T>(0.5);
+
+		// Extent along each axis adds up absolute contributions of all source axes
+		center = TransformAsPoint(center);
+		extent = Vector3<T>(
+			std::abs(x0) * extent.x + std::abs(y0) * extent.y + std::abs(z0) * extent.z,
+			std::abs(x1) * extent.x + std::abs(y1) * extent.y + std::abs(z1) * extent.z,
+			std::abs(x2) * extent.x + std::abs(y2) * extent.y + std::abs(z2) * extent.z);
+
+		pDstMin[i] = center - extent;
+		pDstMax[i] = center + extent;
+	}
+}
+
 template <typename T>
 Matrix3x3<float> Matrix4x4<T>::SinglePrecisionRotation() const
 {
@@ -451,4 +488,266 @@ Matrix4x4<double> Matrix4x4<T>::DoublePrecision() const
 		(double)c20, (double)c21, (double)c22, (double)c23,
 		(double)c30, (double)c31, (double)c32, (double)c33
 	};
+}
+
+// Float specializations below run on SIMD.h, they add up in the same order as templates above
+// So they're bit exact with scalar code, unless FMA is enabled or it's commented otherwise
+template <>
+inline Matrix4x4<float>& Matrix4x4<float>::operator*=(const Matrix4x4<float>& m)
+{
+	SIMDFloat4 col0 = SIMDLoad(&c00);
+	SIMDFloat4 col1 = SIMDLoad(&c10);
+	SIMDFloat4 col2 = SIMDLoad(&c20);
+	SIMDFloat4 col3 = SIMDLoad(&c30);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		SIMDFloat4 v = SIMDLoad(m.c[i].data);
+		SIMDFloat4 ret = SIMDMul(col0, SIMDSplatLane<0>(v));
+		ret = SIMDMadd(col1, SIMDSplatLane<1>(v), ret);
+		ret = SIMDMadd(col2, SIMDSplatLane<2>(v), ret);
+		ret = SIMDMadd(col3, SIMDSplatLane<3>(v), ret);
+		SIMDStore(c[i].data, ret);
+	}
+
+	return *this;
+}
+
+template <>
+inline const Vector4<float> Matrix4x4<float>::operator*(const Vector4<float>& v) const
+{
+	SIMDFloat4 ret = SIMDMul(SIMDLoad(&c00), SIMDSplat(v.x));
+	ret = SIMDMadd(SIMDLoad(&c10), SIMDSplat(v.y), ret);
+	ret = SIMDMadd(SIMDLoad(&c20), SIMDSplat(v.z), ret);
+	ret = SIMDMadd(SIMDLoad(&c30), SIMDSplat(v.w), ret);
+
+	Vector4<float> out;
+	SIMDStore(out.data, ret);
+	return out;
+}
+
+template <>
+inline Matrix4x4<float>& Matrix4x4<float>::Transpose()
+{
+	SIMDFloat4 col0 = SIMDLoad(&c00);
+	SIMDFloat4 col1 = SIMDLoad(&c10);
+	SIMDFloat4 col2 = SIMDLoad(&c20);
+	SIMDFloat4 col3 = SIMDLoad(&c30);
+
+	SIMDTranspose(col0, col1, col2, col3);
+
+	SIMDStore(&c00, col0);
+	SIMDStore(&c10, col1);
+	SIMDStore(&c20, col2);
+	SIMDStore(&c30, col3);
+
+	return *this;
+}
+
+// Block wise inverse with 2x2 sub matrices, each held in one register as (m00, m01, m10, m11)
+// Not bit exact with cofactor expansion of the template, as determinant is summed in a different order
+template <>
+inline Matrix4x4<float>& Matrix4x4<float>::Inverse()
+{
+	SIMDFloat4 col0 = SIMDLoad(&c00);
+	SIMDFloat4 col1 = SIMDLoad(&c10);
+	SIMDFloat4 col2 = SIMDLoad(&c20);
+	SIMDFloat4 col3 = SIMDLoad(&c30);
+
+	// 2x2 "a * b", "adj(a) * b" and "a * adj(b)"
+	auto mat2Mul = [](SIMDFloat4 a, SIMDFloat4 b)
+	{
+		return SIMDAdd(SIMDMul(a, SIMDSwizzle<0, 3, 0, 3>(b)), SIMDMul(SIMDSwizzle<1, 0, 3, 2>(a), SIMDSwizzle<2, 1, 2, 1>(b)));
+	};
+	auto mat2AdjMul = [](SIMDFloat4 a, SIMDFloat4 b)
+	{
+		return SIMDSub(SIMDMul(SIMDSwizzle<3, 3, 0, 0>(a), b), SIMDMul(SIMDSwizzle<1, 1, 2, 2>(a), SIMDSwizzle<2, 3, 0, 1>(b)));
+	};
+	auto mat2MulAdj = [](SIMDFloat4 a, SIMDFloat4 b)
+	{
+		return SIMDSub(SIMDMul(a, SIMDSwizzle<3, 0, 3, 0>(b)), SIMDMul(SIMDSwizzle<1, 0, 3, 2>(a), SIMDSwizzle<2, 1, 2, 1>(b)));
+	};
+
+	// Matrix is split into | A B |
+	//                      | C D |
+	// Inverse works the same no matter it's row or column major, so columns are simply treated as rows here
+	SIMDFloat4 A = SIMDShuffle<0, 1, 0, 1>(col0, col1);
+	SIMDFloat4 B = SIMDShuffle<2, 3, 2, 3>(col0, col1);
+	SIMDFloat4 C = SIMDShuffle<0, 1, 0, 1>(col2, col3);
+	SIMDFloat4 D = SIMDShuffle<2, 3, 2, 3>(col2, col3);
+
+	// (|A|, |B|, |C|, |D|)
+	SIMDFloat4 detSub = SIMDSub(
+		SIMDMul(SIMDShuffle<0, 2, 0, 2>(col0, col2), SIMDShuffle<1, 3, 1, 3>(col1, col3)),
+		SIMDMul(SIMDShuffle<1, 3, 1, 3>(col0, col2), SIMDShuffle<0, 2, 0, 2>(col1, col3)));
+	SIMDFloat4 detA = SIMDSplatLane<0>(detSub);
+	SIMDFloat4 detB = SIMDSplatLane<1>(detSub);
+	SIMDFloat4 detC = SIMDSplatLane<2>(detSub);
+	SIMDFloat4 detD = SIMDSplatLane<3>(detSub);
+
+	SIMDFloat4 D_C = mat2AdjMul(D, C);
+	SIMDFloat4 A_B = mat2AdjMul(A, B);
+
+	// Adjugates of blocks of the inverse
+	SIMDFloat4 X_ = SIMDSub(SIMDMul(detD, A), mat2Mul(B, D_C));
+	SIMDFloat4 W_ = SIMDSub(SIMDMul(detA, D), mat2Mul(C, A_B));
+	SIMDFloat4 Y_ = SIMDSub(SIMDMul(detB, C), mat2MulAdj(D, A_B));
+	SIMDFloat4 Z_ = SIMDSub(SIMDMul(detC, B), mat2MulAdj(A, D_C));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+	SIMDFloat4 detM = SIMDAdd(SIMDMul(detA, detD), SIMDMul(detB, detC));
+	detM = SIMDSub(detM, SIMDHorizontalAdd(SIMDMul(A_B, SIMDSwizzle<0, 2, 1, 3>(D_C))));
+
+	if (SIMDGetX(detM) == 0.0f)
+	{
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		SIMDFloat4 nans = SIMDSplat(nan);
+		for (uint32_t i = 0; i < 4; i++)
+			SIMDStore(c[i].data, nans);
+
+		return *this;
+	}
+
+	SIMDFloat4 rDetM = SIMDDiv(SIMDSet(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X_ = SIMDMul(X_, rDetM);
+	Y_ = SIMDMul(Y_, rDetM);
+	Z_ = SIMDMul(Z_, rDetM);
+	W_ = SIMDMul(W_, rDetM);
+
+	// Adjugate of each block and layout back to columns at once
+	SIMDStore(&c00, SIMDShuffle<3, 1, 3, 1>(X_, Y_));
+	SIMDStore(&c10, SIMDShuffle<2, 0, 2, 0>(X_, Y_));
+	SIMDStore(&c20, SIMDShuffle<3, 1, 3, 1>(Z_, W_));
+	SIMDStore(&c30, SIMDShuffle<2, 0, 2, 0>(Z_, W_));
+
+	return *this;
+}
+
+// 4 vectors at a time, transposed to x, y and z of them, the rest goes through scalar path
+template <>
+inline void Matrix4x4<float>::TransformAsVectors(const Vector3<float>* pSrc, Vector3<float>* pDst, uint32_t count) const
+{
+	static_assert(sizeof(Vector3<float>) == sizeof(float) * 3, "Vector3 has to be tightly packed");
+
+	SIMDFloat4 mx0 = SIMDSplat(x0), my0 = SIMDSplat(y0), mz0 = SIMDSplat(z0);
+	SIMDFloat4 mx1 = SIMDSplat(x1), my1 = SIMDSplat(y1), mz1 = SIMDSplat(z1);
+	SIMDFloat4 mx2 = SIMDSplat(x2), my2 = SIMDSplat(y2), mz2 = SIMDSplat(z2);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const float* pData = pSrc[i].data;
+		SIMDFloat4 x, y, z;
+		SIMDDeinterleave3(SIMDLoad(pData), SIMDLoad(pData + 4), SIMDLoad(pData + 8), x, y, z);
+
+		SIMDFloat4 rx = SIMDMadd(mz0, z, SIMDMadd(my0, y, SIMDMul(mx0, x)));
+		SIMDFloat4 ry = SIMDMadd(mz1, z, SIMDMadd(my1, y, SIMDMul(mx1, x)));
+		SIMDFloat4 rz = SIMDMadd(mz2, z, SIMDMadd(my2, y, SIMDMul(mx2, x)));
+
+		SIMDFloat4 p0, p1, p2;
+		SIMDInterleave3(rx, ry, rz, p0, p1, p2);
+		float* pOut = pDst[i].data;
+		SIMDStore(pOut, p0);
+		SIMDStore(pOut + 4, p1);
+		SIMDStore(pOut + 8, p2);
+	}
+
+	for (; i < count; i++)
+		pDst[i] = TransformAsVector(pSrc[i]);
+}
+
+template <>
+inline void Matrix4x4<float>::TransformAsPoints(const Vector3<float>* pSrc, Vector3<float>* pDst, uint32_t count) const
+{
+	static_assert(sizeof(Vector3<float>) == sizeof(float) * 3, "Vector3 has to be tightly packed");
+
+	SIMDFloat4 mx0 = SIMDSplat(x0), my0 = SIMDSplat(y0), mz0 = SIMDSplat(z0), mw0 = SIMDSplat(w0);
+	SIMDFloat4 mx1 = SIMDSplat(x1), my1 = SIMDSplat(y1), mz1 = SIMDSplat(z1), mw1 = SIMDSplat(w1);
+	SIMDFloat4 mx2 = SIMDSplat(x2), my2 = SIMDSplat(y2), mz2 = SIMDSplat(z2), mw2 = SIMDSplat(w2);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const float* pData = pSrc[i].data;
+		SIMDFloat4 x, y, z;
+		SIMDDeinterleave3(SIMDLoad(pData), SIMDLoad(pData + 4), SIMDLoad(pData + 8), x, y, z);
+
+		SIMDFloat4 rx = SIMDAdd(SIMDMadd(mz0, z, SIMDMadd(my0, y, SIMDMul(mx0, x))), mw0);
+		SIMDFloat4 ry = SIMDAdd(SIMDMadd(mz1, z, SIMDMadd(my1, y, SIMDMul(mx1, x))), mw1);
+		SIMDFloat4 rz = SIMDAdd(SIMDMadd(mz2, z, SIMDMadd(my2, y, SIMDMul(mx2, x))), mw2);
+
+		SIMDFloat4 p0, p1, p2;
+		SIMDInterleave3(rx, ry, rz, p0, p1, p2);
+		float* pOut = pDst[i].data;
+		SIMDStore(pOut, p0);
+		SIMDStore(pOut + 4, p1);
+		SIMDStore(pOut + 8, p2);
+	}
+
+	for (; i < count; i++)
+		pDst[i] = TransformAsPoint(pSrc[i]);
+}
+
+template <>
+inline void Matrix4x4<float>::TransformBounds(const Vector3<float>* pSrcMin, const Vector3<float>* pSrcMax, Vector3<float>* pDstMin, Vector3<float>* pDstMax, uint32_t count) const
+{
+	static_assert(sizeof(Vector3<float>) == sizeof(float) * 3, "Vector3 has to be tightly packed");
+
+	SIMDFloat4 mx0 = SIMDSplat(x0), my0 = SIMDSplat(y0), mz0 = SIMDSplat(z0), mw0 = SIMDSplat(w0);
+	SIMDFloat4 mx1 = SIMDSplat(x1), my1 = SIMDSplat(y1), mz1 = SIMDSplat(z1), mw1 = SIMDSplat(w1);
+	SIMDFloat4 mx2 = SIMDSplat(x2), my2 = SIMDSplat(y2), mz2 = SIMDSplat(z2), mw2 = SIMDSplat(w2);
+	SIMDFloat4 ax0 = SIMDAbs(mx0), ay0 = SIMDAbs(my0), az0 = SIMDAbs(mz0);
+	SIMDFloat4 ax1 = SIMDAbs(mx1), ay1 = SIMDAbs(my1), az1 = SIMDAbs(mz1);
+	SIMDFloat4 ax2 = SIMDAbs(mx2), ay2 = SIMDAbs(my2), az2 = SIMDAbs(mz2);
+	SIMDFloat4 half = SIMDSplat(0.5f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const float* pMin = pSrcMin[i].data;
+		const float* pMax = pSrcMax[i].data;
+		SIMDFloat4 minX, minY, minZ, maxX, maxY, maxZ;
+		SIMDDeinterleave3(SIMDLoad(pMin), SIMDLoad(pMin + 4), SIMDLoad(pMin + 8), minX, minY, minZ);
+		SIMDDeinterleave3(SIMDLoad(pMax), SIMDLoad(pMax + 4), SIMDLoad(pMax + 8), maxX, maxY, maxZ);
+
+		SIMDFloat4 cx = SIMDMul(SIMDAdd(minX, maxX), half);
+		SIMDFloat4 cy = SIMDMul(SIMDAdd(minY, maxY), half);
+		SIMDFloat4 cz = SIMDMul(SIMDAdd(minZ, maxZ), half);
+		SIMDFloat4 ex = SIMDMul(SIMDSub(maxX, minX), half);
+		SIMDFloat4 ey = SIMDMul(SIMDSub(maxY, minY), half);
+		SIMDFloat4 ez = SIMDMul(SIMDSub(maxZ, minZ), half);
+
+		SIMDFloat4 rcx = SIMDAdd(SIMDMadd(mz0, cz, SIMDMadd(my0, cy, SIMDMul(mx0, cx))), mw0);
+		SIMDFloat4 rcy = SIMDAdd(SIMDMadd(mz1, cz, SIMDMadd(my1, cy, SIMDMul(mx1, cx))), mw1);
+		SIMDFloat4 rcz = SIMDAdd(SIMDMadd(mz2, cz, SIMDMadd(my2, cy, SIMDMul(mx2, cx))), mw2);
+		SIMDFloat4 rex = SIMDMadd(az0, ez, SIMDMadd(ay0, ey, SIMDMul(ax0, ex)));
+		SIMDFloat4 rey = SIMDMadd(az1, ez, SIMDMadd(ay1, ey, SIMDMul(ax1, ex)));
+		SIMDFloat4 rez = SIMDMadd(az2, ez, SIMDMadd(ay2, ey, SIMDMul(ax2, ex)));
+
+		SIMDFloat4 p0, p1, p2;
+		float* pOutMin = pDstMin[i].data;
+		SIMDInterleave3(SIMDSub(rcx, rex), SIMDSub(rcy, rey), SIMDSub(rcz, rez), p0, p1, p2);
+		SIMDStore(pOutMin, p0);
+		SIMDStore(pOutMin + 4, p1);
+		SIMDStore(pOutMin + 8, p2);
+
+		float* pOutMax = pDstMax[i].data;
+		SIMDInterleave3(SIMDAdd(rcx, rex), SIMDAdd(rcy, rey), SIMDAdd(rcz, rez), p0, p1, p2);
+		SIMDStore(pOutMax, p0);
+		SIMDStore(pOutMax + 4, p1);
+		SIMDStore(pOutMax + 8, p2);
+	}
+
+	for (; i < count; i++)
+	{
+		Vector3<float> center = TransformAsPoint((pSrcMin[i] + pSrcMax[i]) * 0.5f);
+		Vector3<float> extent = (pSrcMax[i] - pSrcMin[i]) * 0.5f;
+		extent = Vector3<float>(
+			std::abs(x0) * extent.x + std::abs(y0) * extent.y + std::abs(z0) * extent.z,
+			std::abs(x1) * extent.x + std::abs(y1) * extent.y + std::abs(z1) * extent.z,
+			std::abs(x2) * extent.x + std::abs(y2) * extent.y + std::abs(z2) * extent.z);
+
+		pDstMin[i] = center - extent;
+		pDstMax[i] = center + extent;
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 template <typename T>
 class Vector3;
@@ -32,6 +33,9 @@ public:
 	void Transform(const Matrix3x3<T>& matrix);
 	void Transform(const Matrix4x4<T>& matrix);
 
+	// Batch version of above, planes are transformed in place
+	static void Transform(const Matrix4x4<T>& matrix, Plane<T>* pPlanes, uint32_t count);
+
 public:
 	// normal * x = D
 	Vector3<T>	normal;
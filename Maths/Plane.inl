@@ -3,6 +3,7 @@
 #include "Vector3.h"
 #include "Matrix3x3.h"
 #include "Matrix4x4.h"
+#include "SIMD.h"
 
 template<typename T>
 Plane<T>::Plane(const Vector3<T>& p0, const Vector3<T>& p1, const Vector3<T>& p2, const Vector3<T>& up)
@@ -55,4 +56,57 @@ void Plane<T>::Transform(const Matrix4x4<T>& matrix)
 	// Normal * D is a point on the plane
 	// p dot with normal is D
 	D = matrix.TransformAsPoint(normal * D) * normal;
+}
+
+template<typename T>
+void Plane<T>::Transform(const Matrix4x4<T>& matrix, Plane<T>* pPlanes, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		pPlanes[i].Transform(matrix);
+}
+
+// A plane is exactly 4 floats, so 4 of them are loaded and transposed to normal x, y, z and D of each
+template<>
+inline void Plane<float>::Transform(const Matrix4x4<float>& matrix, Plane<float>* pPlanes, uint32_t count)
+{
+	static_assert(sizeof(Plane<float>) == sizeof(float) * 4, "Plane has to be tightly packed");
+
+	SIMDFloat4 mx0 = SIMDSplat(matrix.x0), my0 = SIMDSplat(matrix.y0), mz0 = SIMDSplat(matrix.z0), mw0 = SIMDSplat(matrix.w0);
+	SIMDFloat4 mx1 = SIMDSplat(matrix.x1), my1 = SIMDSplat(matrix.y1), mz1 = SIMDSplat(matrix.z1), mw1 = SIMDSplat(matrix.w1);
+	SIMDFloat4 mx2 = SIMDSplat(matrix.x2), my2 = SIMDSplat(matrix.y2), mz2 = SIMDSplat(matrix.z2), mw2 = SIMDSplat(matrix.w2);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		float* pData = pPlanes[i].normal.data;
+		SIMDFloat4 nx = SIMDLoad(pData);
+		SIMDFloat4 ny = SIMDLoad(pData + 4);
+		SIMDFloat4 nz = SIMDLoad(pData + 8);
+		SIMDFloat4 d = SIMDLoad(pData + 12);
+		SIMDTranspose(nx, ny, nz, d);
+
+		SIMDFloat4 rnx = SIMDMadd(mz0, nz, SIMDMadd(my0, ny, SIMDMul(mx0, nx)));
+		SIMDFloat4 rny = SIMDMadd(mz1, nz, SIMDMadd(my1, ny, SIMDMul(mx1, nx)));
+		SIMDFloat4 rnz = SIMDMadd(mz2, nz, SIMDMadd(my2, ny, SIMDMul(mx2, nx)));
+
+		// Point along transformed normal, the same way per plane Transform picks it
+		SIMDFloat4 px = SIMDMul(rnx, d);
+		SIMDFloat4 py = SIMDMul(rny, d);
+		SIMDFloat4 pz = SIMDMul(rnz, d);
+
+		SIMDFloat4 rpx = SIMDAdd(SIMDMadd(mz0, pz, SIMDMadd(my0, py, SIMDMul(mx0, px))), mw0);
+		SIMDFloat4 rpy = SIMDAdd(SIMDMadd(mz1, pz, SIMDMadd(my1, py, SIMDMul(mx1, px))), mw1);
+		SIMDFloat4 rpz = SIMDAdd(SIMDMadd(mz2, pz, SIMDMadd(my2, py, SIMDMul(mx2, px))), mw2);
+
+		SIMDFloat4 rd = SIMDMadd(rpz, rnz, SIMDMadd(rpy, rny, SIMDMul(rpx, rnx)));
+
+		SIMDTranspose(rnx, rny, rnz, rd);
+		SIMDStore(pData, rnx);
+		SIMDStore(pData + 4, rny);
+		SIMDStore(pData + 8, rnz);
+		SIMDStore(pData + 12, rd);
+	}
+
+	for (; i < count; i++)
+		pPlanes[i].Transform(matrix);
 }
\ No newline at end of file
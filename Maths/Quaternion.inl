@@ -1,6 +1,7 @@
 #pragma once
 #include "Quaternion.h"
 #include "Vector3.h"
+#include "SIMD.h"
 
 template<typename T>
 Quaternion<T>::Quaternion()
@@ -314,9 +315,9 @@ T Quaternion<T>::Dot(const Quaternion<T>& q)
 template<typename T>
 Quaternion<T>& Quaternion<T>::Conjugate()
 {
-	ret.x = -ret.x;
-	ret.y = -ret.y;
-	ret.z = -ret.z;
+	x = -x;
+	y = -y;
+	z = -z;
 
 	return *this;
 }
@@ -410,4 +411,55 @@ template<typename T>
 T Quaternion<T>::Dot(const Quaternion<T>& q0, const Quaternion<T>& q1)
 {
 	return q0.x * q1.x + q0.y * q1.y + q0.z *q1.z + q0.w * q1.w;
+}
+
+// Lanes add up in a different order from the template, results could differ in the last bit
+template<>
+inline Quaternion<float>& Quaternion<float>::operator *= (const Quaternion<float>& q)
+{
+	SIMDFloat4 a = SIMDLoad(&x);
+	SIMDFloat4 b = SIMDLoad(&q.x);
+
+	SIMDFloat4 ret = SIMDMul(SIMDSplatLane<3>(a), b);
+	ret = SIMDMadd(SIMDSplatLane<0>(a), SIMDMul(SIMDSwizzle<3, 2, 1, 0>(b), SIMDSet(1.0f, -1.0f, 1.0f, -1.0f)), ret);
+	ret = SIMDMadd(SIMDSplatLane<1>(a), SIMDMul(SIMDSwizzle<2, 3, 0, 1>(b), SIMDSet(1.0f, 1.0f, -1.0f, -1.0f)), ret);
+	ret = SIMDMadd(SIMDSplatLane<2>(a), SIMDMul(SIMDSwizzle<1, 0, 3, 2>(b), SIMDSet(-1.0f, 1.0f, 1.0f, -1.0f)), ret);
+
+	SIMDStore(&x, ret);
+	return *this;
+}
+
+// Coefficients are still scalar, dot product, sign flip and blend are done in one register each
+template<>
+inline Quaternion<float> Quaternion<float>::SLerp(const Quaternion<float>& from, const Quaternion<float>& to, float factor)
+{
+	SIMDFloat4 f = SIMDLoad(&from.x);
+	SIMDFloat4 t = SIMDLoad(&to.x);
+
+	float cosom = SIMDGetX(SIMDHorizontalAdd(SIMDMul(f, t)));
+
+	if (cosom < 0.0f)
+	{
+		cosom = -cosom;
+		t = SIMDSub(SIMDSplat(0.0f), t);
+	}
+
+	float sclp, sclq;
+	if ((1.0f - cosom) > 0.0001f)
+	{
+		float omega, sinom;
+		omega = std::acos(cosom);
+		sinom = std::sin(omega);
+		sclp = std::sin((1.0f - factor) * omega) / sinom;
+		sclq = std::sin(factor * omega) / sinom;
+	}
+	else
+	{
+		sclp = 1.0f - factor;
+		sclq = factor;
+	}
+
+	Quaternion<float> out;
+	SIMDStore(&out.x, SIMDMadd(SIMDSplat(sclp), f, SIMDMul(SIMDSplat(sclq), t)));
+	return out;
 }
\ No newline at end of file
@@ -0,0 +1,301 @@
+#pragma once
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+
+// Thin wrapper of 4 wide float registers, used by float specializations of maths templates
+// SSE is always there on x86/x64, AVX2 adds fused multiply add, NEON is picked on arm, and plain scalar code is the fallback
+// Functions here are kept to what those specializations need, their scalar twins in templates stay the reference
+// SIMD_FORCE_SCALAR picks scalar fallback on any target, so it could be tested where SIMD is there
+#if defined(SIMD_FORCE_SCALAR)
+#define SIMD_SCALAR
+#elif defined(__AVX2__)
+#define SIMD_SSE
+#define SIMD_FMA
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#else
+#define SIMD_SCALAR
+#endif
+
+#if defined(SIMD_SSE)
+typedef __m128 SIMDFloat4;
+#elif defined(SIMD_NEON)
+typedef float32x4_t SIMDFloat4;
+#else
+typedef struct _SIMDFloat4
+{
+	float data[4];
+}SIMDFloat4;
+#endif
+
+// Unaligned, data of maths classes only has natural alignment of float
+inline SIMDFloat4 SIMDLoad(const float* pData)
+{
+#if defined(SIMD_SSE)
+	return _mm_loadu_ps(pData);
+#elif defined(SIMD_NEON)
+	return vld1q_f32(pData);
+#else
+	return { { pData[0], pData[1], pData[2], pData[3] } };
+#endif
+}
+
+inline void SIMDStore(float* pData, SIMDFloat4 v)
+{
+#if defined(SIMD_SSE)
+	_mm_storeu_ps(pData, v);
+#elif defined(SIMD_NEON)
+	vst1q_f32(pData, v);
+#else
+	for (uint32_t i = 0; i < 4; i++)
+		pData[i] = v.data[i];
+#endif
+}
+
+inline SIMDFloat4 SIMDSet(float x, float y, float z, float w)
+{
+#if defined(SIMD_SSE)
+	return _mm_setr_ps(x, y, z, w);
+#else
+	float data[4] = { x, y, z, w };
+	return SIMDLoad(data);
+#endif
+}
+
+inline SIMDFloat4 SIMDSplat(float s)
+{
+#if defined(SIMD_SSE)
+	return _mm_set1_ps(s);
+#elif defined(SIMD_NEON)
+	return vdupq_n_f32(s);
+#else
+	return { { s, s, s, s } };
+#endif
+}
+
+inline float SIMDGetX(SIMDFloat4 v)
+{
+#if defined(SIMD_SSE)
+	return _mm_cvtss_f32(v);
+#elif defined(SIMD_NEON)
+	return vgetq_lane_f32(v, 0);
+#else
+	return v.data[0];
+#endif
+}
+
+inline SIMDFloat4 SIMDAdd(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_add_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vaddq_f32(a, b);
+#else
+	return { { a.data[0] + b.data[0], a.data[1] + b.data[1], a.data[2] + b.data[2], a.data[3] + b.data[3] } };
+#endif
+}
+
+inline SIMDFloat4 SIMDSub(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_sub_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vsubq_f32(a, b);
+#else
+	return { { a.data[0] - b.data[0], a.data[1] - b.data[1], a.data[2] - b.data[2], a.data[3] - b.data[3] } };
+#endif
+}
+
+inline SIMDFloat4 SIMDMul(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_mul_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vmulq_f32(a, b);
+#else
+	return { { a.data[0] * b.data[0], a.data[1] * b.data[1], a.data[2] * b.data[2], a.data[3] * b.data[3] } };
+#endif
+}
+
+inline SIMDFloat4 SIMDDiv(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_div_ps(a, b);
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+	return vdivq_f32(a, b);
+#else
+	float _a[4], _b[4];
+	SIMDStore(_a, a);
+	SIMDStore(_b, b);
+	return SIMDSet(_a[0] / _b[0], _a[1] / _b[1], _a[2] / _b[2], _a[3] / _b[3]);
+#endif
+}
+
+inline SIMDFloat4 SIMDAbs(SIMDFloat4 v)
+{
+#if defined(SIMD_SSE)
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+#elif defined(SIMD_NEON)
+	return vabsq_f32(v);
+#else
+	return { { std::fabs(v.data[0]), std::fabs(v.data[1]), std::fabs(v.data[2]), std::fabs(v.data[3]) } };
+#endif
+}
+
+// Lanes with all bits set where "a >= b", and zero elsewhere
+inline SIMDFloat4 SIMDCompareGE(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_cmpge_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vreinterpretq_f32_u32(vcgeq_f32(a, b));
+#else
+	SIMDFloat4 ret;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		uint32_t bits = a.data[i] >= b.data[i] ? 0xFFFFFFFF : 0;
+		memcpy(&ret.data[i], &bits, sizeof(float));
+	}
+	return ret;
+#endif
+}
+
+// Bitwise and, meant for masks of comparisons
+inline SIMDFloat4 SIMDAnd(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_and_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+	SIMDFloat4 ret;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		uint32_t bitsA, bitsB;
+		memcpy(&bitsA, &a.data[i], sizeof(float));
+		memcpy(&bitsB, &b.data[i], sizeof(float));
+		bitsA &= bitsB;
+		memcpy(&ret.data[i], &bitsA, sizeof(float));
+	}
+	return ret;
+#endif
+}
+
+// Sign bits of lanes packed into lowest 4 bits, lane 0 goes to bit 0
+inline int SIMDMoveMask(SIMDFloat4 v)
+{
+#if defined(SIMD_SSE)
+	return _mm_movemask_ps(v);
+#elif defined(SIMD_NEON)
+	uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(v), 31);
+	return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+#else
+	int mask = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		uint32_t bits;
+		memcpy(&bits, &v.data[i], sizeof(float));
+		mask |= (int)(bits >> 31) << i;
+	}
+	return mask;
+#endif
+}
+
+// a * b + c
+// Rounded once with FMA, so results could differ from scalar templates in the last bit
+// Without FMA it rounds exactly like "a * b + c" in scalar code
+inline SIMDFloat4 SIMDMadd(SIMDFloat4 a, SIMDFloat4 b, SIMDFloat4 c)
+{
+#if defined(SIMD_FMA)
+	return _mm_fmadd_ps(a, b, c);
+#else
+	return SIMDAdd(SIMDMul(a, b), c);
+#endif
+}
+
+// (v[i0], v[i1], v[i2], v[i3])
+template<int i0, int i1, int i2, int i3>
+inline SIMDFloat4 SIMDSwizzle(SIMDFloat4 v)
+{
+#if defined(SIMD_SSE)
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i3, i2, i1, i0));
+#elif defined(SIMD_NEON)
+	float32x4_t ret = vdupq_n_f32(vgetq_lane_f32(v, i0));
+	ret = vsetq_lane_f32(vgetq_lane_f32(v, i1), ret, 1);
+	ret = vsetq_lane_f32(vgetq_lane_f32(v, i2), ret, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(v, i3), ret, 3);
+#else
+	return { { v.data[i0], v.data[i1], v.data[i2], v.data[i3] } };
+#endif
+}
+
+// (a[i0], a[i1], b[i2], b[i3])
+template<int i0, int i1, int i2, int i3>
+inline SIMDFloat4 SIMDShuffle(SIMDFloat4 a, SIMDFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0));
+#elif defined(SIMD_NEON)
+	float32x4_t ret = vdupq_n_f32(vgetq_lane_f32(a, i0));
+	ret = vsetq_lane_f32(vgetq_lane_f32(a, i1), ret, 1);
+	ret = vsetq_lane_f32(vgetq_lane_f32(b, i2), ret, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(b, i3), ret, 3);
+#else
+	return { { a.data[i0], a.data[i1], b.data[i2], b.data[i3] } };
+#endif
+}
+
+template<int i>
+inline SIMDFloat4 SIMDSplatLane(SIMDFloat4 v)
+{
+	return SIMDSwizzle<i, i, i, i>(v);
+}
+
+// Sum of all 4 lanes, broadcasted to every lane
+inline SIMDFloat4 SIMDHorizontalAdd(SIMDFloat4 v)
+{
+	v = SIMDAdd(v, SIMDSwizzle<1, 0, 3, 2>(v));
+	return SIMDAdd(v, SIMDSwizzle<2, 3, 0, 1>(v));
+}
+
+inline void SIMDTranspose(SIMDFloat4& r0, SIMDFloat4& r1, SIMDFloat4& r2, SIMDFloat4& r3)
+{
+#if defined(SIMD_SSE)
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+#elif defined(SIMD_NEON)
+	float32x4x2_t t01 = vtrnq_f32(r0, r1);
+	float32x4x2_t t23 = vtrnq_f32(r2, r3);
+	r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+#else
+	SIMDFloat4 t0 = r0, t1 = r1, t2 = r2, t3 = r3;
+	r0 = { { t0.data[0], t1.data[0], t2.data[0], t3.data[0] } };
+	r1 = { { t0.data[1], t1.data[1], t2.data[1], t3.data[1] } };
+	r2 = { { t0.data[2], t1.data[2], t2.data[2], t3.data[2] } };
+	r3 = { { t0.data[3], t1.data[3], t2.data[3], t3.data[3] } };
+#endif
+}
+
+// 4 packed Vector3 (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) to x, y and z of them
+inline void SIMDDeinterleave3(SIMDFloat4 p0, SIMDFloat4 p1, SIMDFloat4 p2, SIMDFloat4& x, SIMDFloat4& y, SIMDFloat4& z)
+{
+	x = SIMDShuffle<0, 3, 0, 2>(p0, SIMDShuffle<2, 2, 1, 1>(p1, p2));
+	y = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<1, 1, 0, 0>(p0, p1), SIMDShuffle<3, 3, 2, 2>(p1, p2));
+	z = SIMDShuffle<0, 2, 0, 3>(SIMDShuffle<2, 2, 1, 1>(p0, p1), p2);
+}
+
+// Reverse of "SIMDDeinterleave3"
+inline void SIMDInterleave3(SIMDFloat4 x, SIMDFloat4 y, SIMDFloat4 z, SIMDFloat4& p0, SIMDFloat4& p1, SIMDFloat4& p2)
+{
+	p0 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<0, 0, 0, 0>(x, y), SIMDShuffle<0, 0, 1, 1>(z, x));
+	p1 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<1, 1, 1, 1>(y, z), SIMDShuffle<2, 2, 2, 2>(x, y));
+	p2 = SIMDShuffle<0, 2, 0, 2>(SIMDShuffle<2, 2, 3, 3>(z, x), SIMDShuffle<3, 3, 3, 3>(y, z));
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 #include "Vector2.h"
 #include "Vector3.h"
 #include "Vector4.h"
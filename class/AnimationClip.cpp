@@ -0,0 +1,151 @@
+#include "AnimationClip.h"
+#include <algorithm>
+
+const uint32_t AnimationClip::INVALID_TRACK;
+const float AnimationClip::NLERP_COSINE_THRESHOLD = 0.99f;
+
+bool AnimationClip::Init(const std::shared_ptr<AnimationClip>& pSelf, const AnimationData& animationData)
+{
+	if (!SelfRefBase<AnimationClip>::Init(pSelf))
+		return false;
+
+	m_duration = (float)animationData.duration;
+
+	for (auto& objectAnimation : animationData.objectAnimationDiction)
+	{
+		Track track = {};
+		track.nameHashCode = std::hash<std::wstring>()(objectAnimation.objectName);
+
+		track.rotationKeys = { (uint32_t)m_rotationTimeline.times.size(), (uint32_t)objectAnimation.rotationKeyFrames.size() };
+		for (auto& keyFrame : objectAnimation.rotationKeyFrames)
+		{
+			m_rotationTimeline.times.push_back((float)keyFrame.time);
+			m_rotationTimeline.values.push_back(keyFrame.transform.SinglePrecision());
+		}
+
+		track.translationKeys = { (uint32_t)m_translationTimeline.times.size(), (uint32_t)objectAnimation.translationKeyFrames.size() };
+		for (auto& keyFrame : objectAnimation.translationKeyFrames)
+		{
+			m_translationTimeline.times.push_back((float)keyFrame.time);
+			m_translationTimeline.values.push_back(keyFrame.transform.SinglePrecision());
+		}
+
+		track.scaleKeys = { (uint32_t)m_scaleTimeline.times.size(), (uint32_t)objectAnimation.ScaleKeyFrames.size() };
+		for (auto& keyFrame : objectAnimation.ScaleKeyFrames)
+		{
+			m_scaleTimeline.times.push_back((float)keyFrame.time);
+			m_scaleTimeline.values.push_back(keyFrame.transform.SinglePrecision());
+		}
+
+		m_tracks.push_back(track);
+		m_trackLookupTable[track.nameHashCode] = (uint32_t)m_tracks.size() - 1;
+	}
+
+	return true;
+}
+
+std::shared_ptr<AnimationClip> AnimationClip::Create(const AnimationData& animationData)
+{
+	std::shared_ptr<AnimationClip> pAnimationClip = std::make_shared<AnimationClip>();
+	if (pAnimationClip != nullptr && pAnimationClip->Init(pAnimationClip, animationData))
+		return pAnimationClip;
+
+	return nullptr;
+}
+
+uint32_t AnimationClip::FindTrack(std::size_t nameHashCode) const
+{
+	auto iter = m_trackLookupTable.find(nameHashCode);
+	if (iter == m_trackLookupTable.end())
+		return INVALID_TRACK;
+	return iter->second;
+}
+
+uint32_t AnimationClip::FindKey(const float* pTimes, uint32_t count, float time, uint32_t cursor)
+{
+	if (cursor >= count)
+		cursor = 0;
+
+	if (pTimes[cursor] <= time)
+	{
+		if (cursor + 1 >= count || time < pTimes[cursor + 1])
+			return cursor;
+		if (cursor + 2 >= count || time < pTimes[cursor + 2])
+			return cursor + 1;
+	}
+
+	uint32_t index = (uint32_t)(std::upper_bound(pTimes, pTimes + count, time) - pTimes);
+	return index == 0 ? 0 : index - 1;
+}
+
+uint32_t AnimationClip::FindKeyPair(const float* pTimes, uint32_t count, float time, uint32_t& cursor, float& factor)
+{
+	cursor = FindKey(pTimes, count, time, cursor);
+
+	// Before the first key or after the last one, hold it
+	if (cursor + 1 >= count || time <= pTimes[cursor])
+	{
+		factor = 0;
+		return cursor;
+	}
+
+	factor = (time - pTimes[cursor]) / (pTimes[cursor + 1] - pTimes[cursor]);
+	factor = factor > 1.0f ? 1.0f : factor;
+	return cursor + 1;
+}
+
+void AnimationClip::SampleTrack(uint32_t track, float time, TrackCursor& cursor, TrackPose& pose) const
+{
+	const Track& trackData = m_tracks[track];
+	float factor;
+
+	if (trackData.rotationKeys.count != 0)
+	{
+		const float* pTimes = &m_rotationTimeline.times[trackData.rotationKeys.offset];
+		const Quaternionf* pValues = &m_rotationTimeline.values[trackData.rotationKeys.offset];
+
+		uint32_t nextKey = FindKeyPair(pTimes, trackData.rotationKeys.count, time, cursor.rotation, factor);
+		const Quaternionf& from = pValues[cursor.rotation];
+		Quaternionf to = pValues[nextKey];
+
+		// Take the shorter arc
+		float cosom = Quaternionf::Dot(from, to);
+		if (cosom < 0)
+		{
+			cosom = -cosom;
+			to *= -1.0f;
+		}
+
+		if (cosom > NLERP_COSINE_THRESHOLD)
+		{
+			pose.rotation = from * (1.0f - factor) + to * factor;
+			pose.rotation.Normalize();
+		}
+		else
+			pose.rotation = Quaternionf::SLerp(from, to, factor);
+	}
+
+	if (trackData.translationKeys.count != 0)
+	{
+		const float* pTimes = &m_translationTimeline.times[trackData.translationKeys.offset];
+		const Vector3f* pValues = &m_translationTimeline.values[trackData.translationKeys.offset];
+
+		uint32_t nextKey = FindKeyPair(pTimes, trackData.translationKeys.count, time, cursor.translation, factor);
+		pose.translation = pValues[cursor.translation] * (1.0f - factor) + pValues[nextKey] * factor;
+	}
+
+	if (trackData.scaleKeys.count != 0)
+	{
+		const float* pTimes = &m_scaleTimeline.times[trackData.scaleKeys.offset];
+		const Vector3f* pValues = &m_scaleTimeline.values[trackData.scaleKeys.offset];
+
+		uint32_t nextKey = FindKeyPair(pTimes, trackData.scaleKeys.count, time, cursor.scale, factor);
+		pose.scale = pValues[cursor.scale] * (1.0f - factor) + pValues[nextKey] * factor;
+	}
+}
+
+void AnimationClip::SamplePose(float time, TrackCursor* pCursors, TrackPose* pPose) const
+{
+	for (uint32_t i = 0; i < (uint32_t)m_tracks.size(); i++)
+		SampleTrack(i, time, pCursors[i], pPose[i]);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "SkeletonAnimation.h"
+#include "../Maths/Vector.h"
+#include "../Maths/Quaternion.h"
+#include <vector>
+#include <unordered_map>
+
+// Animation data compiled for sampling
+// Each track(an animated object) has its own rotation, translation and scale timelines, and each of them could have different key times
+// Key times and key values of all tracks are packed into flat arrays per timeline, a track only keeps ranges of its keys
+// So that searching a timeline walks through times only, and a whole skeleton is evaluated into a contiguous pose with one call
+class AnimationClip : public SelfRefBase<AnimationClip>
+{
+public:
+	static const uint32_t INVALID_TRACK = UINT32_MAX;
+
+	// Rotation keys closer than this cosine are blended with nlerp instead of slerp
+	static const float NLERP_COSINE_THRESHOLD;
+
+	// Local transform of a track
+	typedef struct _TrackPose
+	{
+		Quaternionf		rotation;
+		Vector3f		translation;
+		Vector3f		scale = { 1, 1, 1 };
+	}TrackPose;
+
+	// Keys found by last sampling, kept per playing instance
+	// Playing forward mostly stays at the same key or moves to the next one, binary search is only needed after a loop or a jump
+	typedef struct _TrackCursor
+	{
+		uint32_t	rotation = 0;
+		uint32_t	translation = 0;
+		uint32_t	scale = 0;
+	}TrackCursor;
+
+protected:
+	// Keys of a timeline of a track are in [offset, offset + count) of timeline arrays
+	typedef struct _KeyRange
+	{
+		uint32_t	offset = 0;
+		uint32_t	count = 0;
+	}KeyRange;
+
+	typedef struct _Track
+	{
+		std::size_t		nameHashCode;
+		KeyRange		rotationKeys;
+		KeyRange		translationKeys;
+		KeyRange		scaleKeys;
+	}Track;
+
+	template<typename T>
+	struct Timeline
+	{
+		std::vector<float>	times;
+		std::vector<T>		values;
+	};
+
+protected:
+	bool Init(const std::shared_ptr<AnimationClip>& pSelf, const AnimationData& animationData);
+
+public:
+	static std::shared_ptr<AnimationClip> Create(const AnimationData& animationData);
+
+public:
+	float GetDuration() const { return m_duration; }
+	uint32_t GetTrackCount() const { return (uint32_t)m_tracks.size(); }
+
+	// Returns INVALID_TRACK if object with this name isn't animated by this clip
+	uint32_t FindTrack(std::size_t nameHashCode) const;
+	bool HasRotation(uint32_t track) const { return m_tracks[track].rotationKeys.count != 0; }
+	bool HasTranslation(uint32_t track) const { return m_tracks[track].translationKeys.count != 0; }
+	bool HasScale(uint32_t track) const { return m_tracks[track].scaleKeys.count != 0; }
+
+	// Evaluate all tracks at "time", "pCursors" and "pPose" both have "GetTrackCount()" elements
+	// Timelines without keys leave identity in pose
+	void SamplePose(float time, TrackCursor* pCursors, TrackPose* pPose) const;
+	// Evaluate a single track
+	void SampleTrack(uint32_t track, float time, TrackCursor& cursor, TrackPose& pose) const;
+
+protected:
+	// Index of the last key not later than "time" in "pTimes", clamped to the first key, search starts from "cursor"
+	static uint32_t FindKey(const float* pTimes, uint32_t count, float time, uint32_t cursor);
+
+	// Key pair around "time" and blend factor between them
+	static uint32_t FindKeyPair(const float* pTimes, uint32_t count, float time, uint32_t& cursor, float& factor);
+
+protected:
+	float									m_duration = 0;
+
+	std::vector<Track>						m_tracks;
+	std::unordered_map<std::size_t, uint32_t>	m_trackLookupTable;
+
+	Timeline<Quaternionf>					m_rotationTimeline;
+	Timeline<Vector3f>						m_translationTimeline;
+	Timeline<Vector3f>						m_scaleTimeline;
+};
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "AnimationManager.h"
+#include "../component/AnimationController.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <algorithm>
+#include <chrono>
+
+const uint32_t AnimationManager::PARALLEL_GRAIN;
+
+void AnimationManager::RegisterController(const std::shared_ptr<AnimationController>& pController)
+{
+	m_controllers.push_back(pController);
+}
+
+void AnimationManager::Update()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	m_controllers.erase(std::remove_if(m_controllers.begin(), m_controllers.end(), [](const std::weak_ptr<AnimationController>& pController) { return pController.expired(); }), m_controllers.end());
+
+	std::vector<std::shared_ptr<AnimationController>> controllers;
+	for (auto& pController : m_controllers)
+		controllers.push_back(pController.lock());
+
+	GlobalThreadTaskQueue()->ParallelFor(0, (uint32_t)controllers.size(), PARALLEL_GRAIN, [&controllers](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			controllers[i]->UpdateSkeleton();
+	}, FrameMgr()->FrameIndex());
+
+	// Dirty lists of bone storage and object transforms aren't thread safe, they're updated here after all skeletons are done
+	m_boneCount = 0;
+	for (auto& pController : controllers)
+	{
+		pController->MarkBonesDirty();
+		pController->ApplyPoseToObjects();
+		m_boneCount += pController->GetBoneCount();
+	}
+
+	m_controllerCount = (uint32_t)controllers.size();
+	m_lastUpdateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "../common/Singleton.h"
+
+class AnimationController;
+
+// Gathers all animation controllers, and updates their skeletons in one go after scene update
+// Skeletons don't share anything while they're updated, so they're spread across workers of job system
+// Each of them samples its pose, builds model space bone palette and writes it into per frame bone storage
+class AnimationManager : public Singleton<AnimationManager>
+{
+public:
+	// Controllers per job
+	static const uint32_t PARALLEL_GRAIN = 4;
+
+public:
+	bool Init() override { return true; }
+
+public:
+	void RegisterController(const std::shared_ptr<AnimationController>& pController);
+
+	void Update();
+
+	// Statistics of last update
+	uint32_t GetControllerCount() const { return m_controllerCount; }
+	uint32_t GetBoneCount() const { return m_boneCount; }
+	double GetLastUpdateTime() const { return m_lastUpdateTime; }
+
+protected:
+	// Controllers are owned by objects, expired ones are dropped during update
+	std::vector<std::weak_ptr<AnimationController>>	m_controllers;
+
+	uint32_t		m_controllerCount = 0;
+	uint32_t		m_boneCount = 0;
+	double			m_lastUpdateTime = 0;
+};
\ No newline at end of file
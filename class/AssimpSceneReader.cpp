@@ -8,64 +8,192 @@
 #include "SkeletonAnimation.h"
 #include "SkeletonAnimationInstance.h"
 #include "../component/AnimationController.h"
+#include "CookedScene.h"
+#include "../common/Util.h"
 #include <string>
 #include <codecvt>
 #include <locale>
+#include <chrono>
+
+const uint32_t AssimpSceneReader::MESH_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+const uint32_t AssimpSceneReader::SCENE_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+
+AssimpSceneReader::LoadStatistics AssimpSceneReader::m_loadStatistics;
+
+static double ElapsedMilliseconds(const std::chrono::high_resolution_clock::time_point& startTime)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+// Depth first, so that a node is followed by all its descendants
+static void FlattenNode(const aiNode* pAssimpNode, CookedScene::SceneData& sceneData)
+{
+	CookedScene::CookedNode node = {};
+	node.rotation = AssimpDataConverter::AcquireRotationMatrix(pAssimpNode->mTransformation);
+	node.translation = AssimpDataConverter::AcquireTranslationVector(pAssimpNode->mTransformation);
+	node.nameOffset = (uint32_t)sceneData.names.size();
+	node.nameLength = (uint32_t)pAssimpNode->mName.length;
+	node.meshIndexOffset = (uint32_t)sceneData.meshIndices.size();
+	node.meshCount = pAssimpNode->mNumMeshes;
+	node.childCount = pAssimpNode->mNumChildren;
+
+	sceneData.names.append(pAssimpNode->mName.C_Str(), pAssimpNode->mName.length);
+	sceneData.meshIndices.insert(sceneData.meshIndices.end(), pAssimpNode->mMeshes, pAssimpNode->mMeshes + pAssimpNode->mNumMeshes);
+	sceneData.nodes.push_back(node);
+
+	for (uint32_t i = 0; i < pAssimpNode->mNumChildren; i++)
+		FlattenNode(pAssimpNode->mChildren[i], sceneData);
+}
+
+bool AssimpSceneReader::CookScene(const aiScene* pScene, const std::string& path, uint32_t importFlags)
+{
+	if (pScene == nullptr || pScene->mRootNode == nullptr || pScene->mNumAnimations != 0)
+		return false;
+
+	CookedScene::SceneData sceneData;
+	FlattenNode(pScene->mRootNode, sceneData);
+
+	// Extracted data has to stay around until it's written
+	std::vector<std::vector<uint8_t>> vertices(pScene->mNumMeshes);
+	std::vector<std::vector<uint32_t>> indices(pScene->mNumMeshes);
+	std::vector<std::vector<Mesh::BoneOffset>> bones(pScene->mNumMeshes);
+	for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+	{
+		const aiMesh* pMesh = pScene->mMeshes[i];
+		Mesh::ExtractMeshData(pMesh, vertices[i], indices[i], bones[i]);
+
+		CookedScene::MeshData meshData = {};
+		meshData.mesh.vertexFormat = Mesh::GetVertexFormat(pMesh);
+		meshData.mesh.vertexBytes = ::GetVertexBytes(meshData.mesh.vertexFormat);
+		meshData.mesh.verticesCount = pMesh->mNumVertices;
+		meshData.mesh.indicesCount = (uint32_t)indices[i].size();
+		meshData.mesh.boneCount = (uint32_t)bones[i].size();
+		meshData.pVertices = vertices[i].data();
+		meshData.pIndices = indices[i].data();
+		meshData.pBones = (const CookedScene::CookedBone*)bones[i].data();
+		sceneData.meshes.push_back(meshData);
+	}
+
+	return CookedScene::Cook(sceneData, path, importFlags);
+}
+
+std::shared_ptr<CookedScene> AssimpSceneReader::AcquireCookedScene(const std::string& path, uint32_t importFlags, Assimp::Importer& imp, const aiScene*& pScene)
+{
+	m_loadStatistics = {};
+	m_loadStatistics.path = path;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	pScene = nullptr;
+	std::shared_ptr<CookedScene> pCookedScene = CookedScene::Load(path, importFlags);
+	if (pCookedScene != nullptr)
+	{
+		m_loadStatistics.fromCookedScene = true;
+		m_loadStatistics.sourceMissing = pCookedScene->IsSourceMissing();
+		return pCookedScene;
+	}
+
+	// Stale or not cooked yet
+	pScene = imp.ReadFile(path.c_str(), importFlags);
+	ASSERTION(pScene != nullptr);
+	m_loadStatistics.importTime = ElapsedMilliseconds(startTime);
+
+	startTime = std::chrono::high_resolution_clock::now();
+	if (CookScene(pScene, path, importFlags))
+	{
+		m_loadStatistics.cooked = true;
+		pCookedScene = CookedScene::Load(path, importFlags);
+	}
+	m_loadStatistics.cookTime = ElapsedMilliseconds(startTime);
+
+	// Cooked one is used from the very first load, so that both paths produce the same meshes
+	if (pCookedScene != nullptr)
+	{
+		m_loadStatistics.fromCookedScene = true;
+		pScene = nullptr;
+	}
+
+	return pCookedScene;
+}
+
+std::shared_ptr<Mesh> AssimpSceneReader::CreateMesh(const std::shared_ptr<CookedScene>& pCookedScene, const aiScene* pScene, uint32_t meshIndex, const std::vector<uint32_t>& argumentedVAFList)
+{
+	std::shared_ptr<Mesh> pMesh = nullptr;
+
+	// Iterate all argumented vertex format, from first to last, and see if we can get one match
+	for (auto vaf : argumentedVAFList)
+	{
+		if (pCookedScene != nullptr)
+			pMesh = Mesh::Create(pCookedScene, meshIndex, vaf);
+		else
+			pMesh = Mesh::Create(pScene->mMeshes[meshIndex], vaf);
+
+		if (pMesh)
+			break;
+	}
+
+	return pMesh;
+}
 
 std::vector<std::shared_ptr<Mesh>> AssimpSceneReader::Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList)
 {
+	auto startTime = std::chrono::high_resolution_clock::now();
+
 	Assimp::Importer imp;
 	const aiScene* pScene = nullptr;
-	pScene = imp.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
-	ASSERTION(pScene != nullptr);
+	std::shared_ptr<CookedScene> pCookedScene = AcquireCookedScene(path, MESH_IMPORT_FLAGS, imp, pScene);
+
+	uint32_t meshCount = pCookedScene != nullptr ? pCookedScene->GetMeshCount() : pScene->mNumMeshes;
 
 	std::vector<std::shared_ptr<Mesh>> meshes;
-	for (uint32_t i = 0; i < (uint32_t)pScene->mNumMeshes; i++)
+	for (uint32_t i = 0; i < meshCount; i++)
 	{
-		std::shared_ptr<Mesh> pMesh = nullptr;
-
-		// Iterate all argumented vertex format, from first to last, and see if we can get one match
-		for (auto vaf : argumentedVAFList)
-		{
-			pMesh = Mesh::Create(pScene->mMeshes[i], vaf);
-			if (pMesh)
-				break;
-		}
+		std::shared_ptr<Mesh> pMesh = CreateMesh(pCookedScene, pScene, i, argumentedVAFList);
 
 		// Add mesh to result vector if available
 		if (pMesh)
 			meshes.push_back(pMesh);
 	}
 
+	m_loadStatistics.totalTime = ElapsedMilliseconds(startTime);
+
 	return meshes;
 }
 
 std::shared_ptr<Mesh> AssimpSceneReader::Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, uint32_t meshIndex)
 {
+	auto startTime = std::chrono::high_resolution_clock::now();
+
 	Assimp::Importer imp;
 	const aiScene* pScene = nullptr;
-	pScene = imp.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
-	ASSERTION(pScene != nullptr && meshIndex < pScene->mNumMeshes);
+	std::shared_ptr<CookedScene> pCookedScene = AcquireCookedScene(path, MESH_IMPORT_FLAGS, imp, pScene);
+	ASSERTION(meshIndex < (pCookedScene != nullptr ? pCookedScene->GetMeshCount() : pScene->mNumMeshes));
 
-	std::shared_ptr<Mesh> pMesh = nullptr;
+	std::shared_ptr<Mesh> pMesh = CreateMesh(pCookedScene, pScene, meshIndex, argumentedVAFList);
 
-	// Iterate all argumented vertex format, from first to last, and see if we can get one match
-	for (auto vaf : argumentedVAFList)
-	{
-		pMesh = Mesh::Create(pScene->mMeshes[meshIndex], vaf);
-		if (pMesh)
-			break;
-	}
+	m_loadStatistics.totalTime = ElapsedMilliseconds(startTime);
 
 	return pMesh;
 }
 
 std::shared_ptr<BaseObject> AssimpSceneReader::ReadAndAssemblyScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
 {
+	auto startTime = std::chrono::high_resolution_clock::now();
+
 	Assimp::Importer imp;
 	const aiScene* pScene = nullptr;
-	pScene = imp.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
-	ASSERTION(pScene != nullptr);
+	std::shared_ptr<CookedScene> pCookedScene = AcquireCookedScene(path, SCENE_IMPORT_FLAGS, imp, pScene);
+
+	// Cooked scenes have no animation
+	if (pCookedScene != nullptr)
+	{
+		uint32_t nodeIndex = 0;
+		std::shared_ptr<BaseObject> rootObject = AssemblyCookedNode(pCookedScene, nodeIndex, argumentedVAFList, sceneInfo);
+		sceneInfo.pAnimation = nullptr;
+
+		m_loadStatistics.totalTime = ElapsedMilliseconds(startTime);
+		return rootObject;
+	}
 
 	ExtractAnimations(pScene);
 
@@ -75,7 +203,10 @@ std::shared_ptr<BaseObject> AssimpSceneReader::ReadAndAssemblyScene(const std::s
 	sceneInfo.pAnimation = SkeletonAnimation::Create(pScene);
 
 	if (sceneInfo.pAnimation == nullptr)
+	{
+		m_loadStatistics.totalTime = ElapsedMilliseconds(startTime);
 		return rootObject;
+	}
 
 	// For each object with animation in his children, create animation instance and animation controller to attach to it
 	for (auto link : sceneInfo.meshLinks)
@@ -88,9 +219,45 @@ std::shared_ptr<BaseObject> AssimpSceneReader::ReadAndAssemblyScene(const std::s
 		}
 	}
 
+	m_loadStatistics.totalTime = ElapsedMilliseconds(startTime);
+
 	return rootObject;
 }
 
+std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyCookedNode(const std::shared_ptr<CookedScene>& pCookedScene, uint32_t& nodeIndex, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
+{
+	ASSERTION(nodeIndex < pCookedScene->GetNodeCount());
+
+	uint32_t currentIndex = nodeIndex++;
+	const CookedScene::CookedNode& node = pCookedScene->GetNode(currentIndex);
+
+	std::shared_ptr<BaseObject> pObject = BaseObject::Create();
+
+	pObject->SetRotation(node.rotation);
+	pObject->SetPos(node.translation);
+
+	std::wstring wstr_name = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(pCookedScene->GetNodeName(currentIndex));
+	pObject->SetName(wstr_name);
+
+	const uint32_t* pMeshIndices = pCookedScene->GetNodeMeshIndices(currentIndex);
+	for (uint32_t i = 0; i < node.meshCount; i++)
+	{
+		std::shared_ptr<Mesh> pMesh = CreateMesh(pCookedScene, nullptr, pMeshIndices[i], argumentedVAFList);
+
+		// Add mesh to result vector if available
+		if (pMesh)
+			sceneInfo.meshLinks.push_back({ pMesh, pObject });
+	}
+
+	for (uint32_t i = 0; i < node.childCount; i++)
+	{
+		std::shared_ptr<BaseObject> pChild = AssemblyCookedNode(pCookedScene, nodeIndex, argumentedVAFList, sceneInfo);
+		pObject->AddChild(pChild);
+	}
+
+	return pObject;
+}
+
 std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyNode(const aiNode* pAssimpNode, const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
 {
 	if (pAssimpNode == nullptr)
@@ -106,15 +273,7 @@ std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyNode(const aiNode* pAssim
 
 	for (uint32_t i = 0; i < (uint32_t)pAssimpNode->mNumMeshes; i++)
 	{
-		std::shared_ptr<Mesh> pMesh = nullptr;
-
-		// Iterate all argumented vertex format, from first to last, and see if we can get one match
-		for (auto vaf : argumentedVAFList)
-		{
-			pMesh = Mesh::Create(pScene->mMeshes[pAssimpNode->mMeshes[i]], vaf);
-			if (pMesh)
-				break;
-		}
+		std::shared_ptr<Mesh> pMesh = CreateMesh(nullptr, pScene, pAssimpNode->mMeshes[i], argumentedVAFList);
 
 		// Add mesh to result vector if available
 		if (pMesh)
@@ -4,11 +4,13 @@
 #include "scene.h"
 #include <vector>
 #include <memory>
+#include <string>
 #include "../Maths/DualQuaternion.h"
 
 class Mesh;
 class BaseObject;
 class SkeletonAnimation;
+class CookedScene;
 
 class AssimpSceneReader : public Singleton<AssimpSceneReader>
 {
@@ -20,13 +22,49 @@ public:
 		std::shared_ptr<SkeletonAnimation>	pAnimation;
 	}SceneInfo;
 
+	typedef struct _LoadStatistics
+	{
+		std::string	path;
+		// Whether data came from a cooked container, and whether it was cooked during this load
+		bool		fromCookedScene = false;
+		bool		cooked = false;
+		// Cooked container was used as is, since there's no source to check it against
+		bool		sourceMissing = false;
+		// In milliseconds
+		double		importTime = 0;
+		double		cookTime = 0;
+		double		totalTime = 0;
+	}LoadStatistics;
+
+	// Meshes are read with all nodes transformation baked in
+	static const uint32_t MESH_IMPORT_FLAGS;
+	// Scenes keep their node hierarchy
+	static const uint32_t SCENE_IMPORT_FLAGS;
+
 public:
 	static std::vector<std::shared_ptr<Mesh>> Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList);
 	static std::shared_ptr<Mesh> Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, uint32_t meshIndex);
 	static std::shared_ptr<BaseObject> ReadAndAssemblyScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
 
+	// Maps cooked container of a file if it's up to date, otherwise imports it with assimp and cooks it
+	// "pScene" is only set if cooked container isn't available, e.g. scenes with animations
+	static std::shared_ptr<CookedScene> AcquireCookedScene(const std::string& path, uint32_t importFlags, Assimp::Importer& imp, const aiScene*& pScene);
+
+	// Statistics of the latest read
+	static const LoadStatistics& GetLoadStatistics() { return m_loadStatistics; }
+
 protected:
+	// Extracts mesh data and node hierarchy and writes them into cooked container, false if scene can't be cooked
+	static bool CookScene(const aiScene* pScene, const std::string& path, uint32_t importFlags);
 	static void ExtractAnimations(const aiScene* pScene);
 	static DualQuaterniond ExtractBoneInfo(const aiBone* pBone);
 	static std::shared_ptr<BaseObject> AssemblyNode(const aiNode* pAssimpNode, const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
+	// "nodeIndex" steps over the node and all its descendants
+	static std::shared_ptr<BaseObject> AssemblyCookedNode(const std::shared_ptr<CookedScene>& pCookedScene, uint32_t& nodeIndex, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
+
+	// Tries argumented vertex formats from first to last
+	static std::shared_ptr<Mesh> CreateMesh(const std::shared_ptr<CookedScene>& pCookedScene, const aiScene* pScene, uint32_t meshIndex, const std::vector<uint32_t>& argumentedVAFList);
+
+protected:
+	static LoadStatistics	m_loadStatistics;
 };
\ No newline at end of file
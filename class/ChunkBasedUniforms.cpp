@@ -2,118 +2,93 @@
 #include "ChunkBasedUniforms.h"
 #include "../vulkan/SwapChain.h"
 #include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
 #include "../vulkan/Buffer.h"
 #include "UniformData.h"
 #include "Material.h"
+#include <algorithm>
 
 bool ChunkBasedUniforms::Init(const std::shared_ptr<ChunkBasedUniforms>& pSelf, uint32_t numBytes)
 {
-	if (!UniformDataStorage::Init(pSelf, numBytes * MAXIMUM_OBJECTS, PerFrameDataStorage::ShaderStorage))
+	if (!UniformDataStorage::Init(pSelf, numBytes * PAGE_CHUNKS, PerFrameDataStorage::ShaderStorage))
 		return false;
 
 	m_perChunkBytes = numBytes;
 
-	m_freeChunks.push_back({ 0, MAXIMUM_OBJECTS });
+	m_pageCount = 1;
+	AllocatePages(m_pageCount);
+	m_chunkRanges.Grow(GetChunkCapacity());
+
+	m_uploadRanges.Init((uint32_t)m_pendingSync.size(), m_perChunkBytes, COALESCE_GAP_BYTES);
+	ResizeChunkBits();
+
 	return true;
 }
 
-uint32_t ChunkBasedUniforms::AllocatePerObjectChunk()
+void ChunkBasedUniforms::ResizeChunkBits()
 {
-	ASSERTION(m_freeChunks.size() != 0);
-
-	uint32_t index = m_freeChunks[0].first++;
-	if (m_freeChunks[0].first > m_freeChunks[0].second)
-		m_freeChunks.erase(m_freeChunks.begin());
-
-	// To remind you when chunks are all in use(you'll have to increase the pool, statically or dynamically)
-	ASSERTION(m_freeChunks.size() != 0);
-
-	return index;
+	uint32_t wordCount = GetChunkCapacity() / 64;
+	m_dirtyChunkBits.resize(wordCount, 0);
+	m_uploadRanges.Resize(GetChunkCapacity());
 }
 
-uint32_t ChunkBasedUniforms::AllocateConsecutiveChunks(uint32_t chunkSize)
+void ChunkBasedUniforms::Grow(uint32_t minPageCount)
 {
-	ASSERTION(m_freeChunks.size() != 0);
-	for (auto iter = m_freeChunks.begin(); iter != m_freeChunks.end(); iter++)
-	{
-		uint32_t freeChunkSize = iter->second - iter->first;
-		if (freeChunkSize >= chunkSize)
-		{
-			uint32_t offsetChunkIndex = iter->first;
+	uint32_t pageCount = std::max(m_pageCount * 2, minPageCount);
 
-			if (freeChunkSize == chunkSize)
-				m_freeChunks.erase(iter);
-			else
-				iter->first += chunkSize;
+	AllocatePages(pageCount);
+	m_pageCount = pageCount;
+	m_chunkRanges.Grow(GetChunkCapacity());
 
-			ASSERTION(m_freeChunks.size() != 0);
+	ResizeChunkBits();
 
-			return offsetChunkIndex;
-		}
-	}
+	ResizeBuffer(AcquireDataSize());
 
-	ASSERTION(false);
-	return -1;
+	// New buffer has nothing in it
+	m_uploadRanges.SetFullUpload();
 }
 
-void ChunkBasedUniforms::FreePreObjectChunk(uint32_t index, uint32_t start, uint32_t end)
+uint32_t ChunkBasedUniforms::AllocatePerObjectChunk()
 {
-	uint32_t midChunkIndex = (start + end) / 2;
-
-	std::pair<bool, bool> val;
-	val = std::make_pair<bool, bool>(index <= m_freeChunks[midChunkIndex].first, index >= m_freeChunks[midChunkIndex].first);
-
-	int32_t left, right;
-
-	// If index is already freed
-	if (val.first && val.second)
-		return;
-	else if (val.first)
+	uint32_t index = m_chunkRanges.AllocateChunk();
+	if (index == ChunkRangeAllocator::INVALID_INDEX)
 	{
-		left = midChunkIndex - 1;
-		right = midChunkIndex;
-	}
-	else
-	{
-		left = midChunkIndex;
-		right = midChunkIndex + 1;
+		Grow(m_pageCount + 1);
+		index = m_chunkRanges.AllocateChunk();
 	}
 
-	if ((left < 0 || right == m_freeChunks.size()) ||
-		(index > m_freeChunks[left].second) ||
-		(index < m_freeChunks[right].first))
-		InsertIntoFreeChunk(index, midChunkIndex);
-	else
-	{
-		if (right == midChunkIndex)
-			FreePreObjectChunk(index, start, midChunkIndex);
-		else
-			FreePreObjectChunk(index, midChunkIndex, end);
-	}
+	return index;
 }
 
-void ChunkBasedUniforms::InsertIntoFreeChunk(uint32_t index, uint32_t chunkIndex)
+uint32_t ChunkBasedUniforms::AllocateConsecutiveChunks(uint32_t chunkSize)
 {
-	if (index < m_freeChunks[chunkIndex].first)
-	{
-		if (index == m_freeChunks[chunkIndex].first - 1)
-			m_freeChunks[chunkIndex].first--;
-		else
-			m_freeChunks.insert(m_freeChunks.begin() + chunkIndex, { index, index });
-	}
-	else if (index > m_freeChunks[chunkIndex].second)
+	ASSERTION(chunkSize > 0);
+
+	uint32_t index = m_chunkRanges.AllocateConsecutiveChunks(chunkSize);
+	if (index == ChunkRangeAllocator::INVALID_INDEX)
 	{
-		if (index == m_freeChunks[chunkIndex].second + 1)
-			m_freeChunks[chunkIndex].second++;
-		else
-			m_freeChunks.insert(m_freeChunks.begin() + chunkIndex + 1, { index, index });
+		// Trailing free range is extended by new pages
+		uint32_t trailingChunks = m_chunkRanges.GetTrailingFreeChunkCount();
+		Grow((GetChunkCapacity() + chunkSize - trailingChunks + PAGE_CHUNKS - 1) / PAGE_CHUNKS);
+
+		index = m_chunkRanges.AllocateConsecutiveChunks(chunkSize);
+		ASSERTION(index != ChunkRangeAllocator::INVALID_INDEX);
 	}
 
+	return index;
 }
 
 void ChunkBasedUniforms::FreePreObjectChunk(uint32_t index)
 {
-	FreePreObjectChunk(index, 0, (uint32_t)m_freeChunks.size() - 1);
+	FreeConsecutiveChunks(index, 1);
+}
+
+void ChunkBasedUniforms::FreeConsecutiveChunks(uint32_t index, uint32_t chunkSize)
+{
+	ASSERTION(index + chunkSize <= GetChunkCapacity());
+
+	// Chunks that are already free are left alone
+	m_chunkRanges.FreeConsecutiveChunks(index, chunkSize);
 }
 
 void ChunkBasedUniforms::UpdateUniformDataInternal()
@@ -121,19 +96,78 @@ void ChunkBasedUniforms::UpdateUniformDataInternal()
 	for (auto index : m_dirtyChunks)
 	{
 		UpdateDirtyChunkInternal(index);
+		ChunkUploadRanges::ClearChunkBit(m_dirtyChunkBits, index);
 	}
 	m_dirtyChunks.clear();
 }
 
-void ChunkBasedUniforms::SetDirtyInternal()
+void ChunkBasedUniforms::SyncBufferDataInternal()
 {
+	uint32_t currentFrameIndex = FrameMgr()->FrameIndex();
+	if (m_pendingSync[currentFrameIndex])
+		return;
+
+	m_flushedRanges.clear();
+	m_uploadRanges.Flush(currentFrameIndex, m_flushedRanges);
+	for (auto & range : m_flushedRanges)
+		UploadChunks(currentFrameIndex, range.start, range.end);
+
+	m_pendingSync[currentFrameIndex] = true;
+	m_pendingSyncCount--;
 }
 
-void ChunkBasedUniforms::SetChunkDirty(uint32_t index)
+void ChunkBasedUniforms::UploadChunks(uint32_t frameIndex, uint32_t start, uint32_t end)
 {
-	m_dirtyChunks.push_back(index);
+	if (IsDirectWrite())
+	{
+		uint32_t offset = frameIndex * GetFrameOffset() + start * m_perChunkBytes;
+		uint32_t numBytes = (end - start) * m_perChunkBytes;
 
-	UniformDataStorage::SetDirty();
+		uint8_t* pMappedData = (uint8_t*)GetBuffer()->GetMappedDataPtr();
+		if (pMappedData != nullptr)
+		{
+			WriteChunks(start, end, pMappedData + offset);
+
+			m_uploadStatistics.uploadCount++;
+			m_uploadStatistics.uploadedBytes += numBytes;
+			m_uploadStatistics.directBytes += numBytes;
+		}
+		else
+		{
+			m_scratchChunks.resize(numBytes);
+			WriteChunks(start, end, m_scratchChunks.data());
+			UploadBytes(m_scratchChunks.data(), offset, numBytes);
+		}
+		return;
+	}
+
+	// Pages aren't contiguous in memory, so a range is split at page boundaries, while it's contiguous in buffer
+	while (start < end)
+	{
+		uint32_t pageIndex = start / PAGE_CHUNKS;
+		uint32_t pageEnd = std::min(end, (pageIndex + 1) * PAGE_CHUNKS);
+
+		const uint8_t* pPageData = (const uint8_t*)AcquirePageDataPtr(pageIndex);
+		UploadBytes(pPageData + (start % PAGE_CHUNKS) * m_perChunkBytes, frameIndex * GetFrameOffset() + start * m_perChunkBytes, (pageEnd - start) * m_perChunkBytes);
+
+		start = pageEnd;
+	}
+}
+
+void ChunkBasedUniforms::SetDirtyInternal()
+{
 }
 
+void ChunkBasedUniforms::SetChunkDirty(uint32_t index)
+{
+	if (!ChunkUploadRanges::TestChunkBit(m_dirtyChunkBits, index))
+	{
+		ChunkUploadRanges::SetChunkBit(m_dirtyChunkBits, index);
+		m_dirtyChunks.push_back(index);
+	}
+
+	// Every frame's region has to get it
+	m_uploadRanges.SetChunkPending(index);
 
+	UniformDataStorage::SetDirty();
+}
\ No newline at end of file
@@ -2,32 +2,95 @@
 
 #include "../Maths/Matrix.h"
 #include "UniformDataStorage.h"
+#include "ChunkRangeAllocator.h"
+#include "ChunkUploadRanges.h"
 
+// Chunks live in fixed size pages, pages are allocated on demand and GPU buffer grows to hold all of them
+// Which chunks are free is left to ChunkRangeAllocator
+// Each frame keeps its own bits of chunks to upload, only those are written to its region, in coalesced ranges by ChunkUploadRanges
 class ChunkBasedUniforms : public UniformDataStorage
 {
+public:
+	static const uint32_t PAGE_CHUNKS = 256;
+	// Clean chunks between two dirty ones are uploaded along with them if they're no more than this, to save uploads
+	static const uint32_t COALESCE_GAP_BYTES = 256;
 
 protected:
-	static const uint32_t MAXIMUM_OBJECTS = 256;
+	// Chunk data of a storage, a chunk never moves once its page is allocated
+	template <typename T>
+	class ChunkPages
+	{
+	public:
+		T& operator[](uint32_t index) { return m_pages[index / PAGE_CHUNKS][index % PAGE_CHUNKS]; }
+		const T& operator[](uint32_t index) const { return m_pages[index / PAGE_CHUNKS][index % PAGE_CHUNKS]; }
+
+		void AllocatePages(uint32_t pageCount)
+		{
+			while ((uint32_t)m_pages.size() < pageCount)
+				m_pages.push_back(std::unique_ptr<T[]>(new T[PAGE_CHUNKS]()));
+		}
+
+		const T* GetPage(uint32_t pageIndex) const { return m_pages[pageIndex].get(); }
+
+	protected:
+		std::vector<std::unique_ptr<T[]>>	m_pages;
+	};
 
 public:
 	virtual uint32_t AllocatePerObjectChunk();
 	virtual uint32_t AllocateConsecutiveChunks(uint32_t chunkSize);
 	virtual void FreePreObjectChunk(uint32_t index);
+	void FreeConsecutiveChunks(uint32_t index, uint32_t chunkSize);
+
+	// For storages indexed directly rather than by allocated chunks, e.g. by draw id
+	void EnsureChunkCapacity(uint32_t chunkCount) { if (chunkCount > GetChunkCapacity()) Grow((chunkCount + PAGE_CHUNKS - 1) / PAGE_CHUNKS); }
+
+	uint32_t GetPageCount() const { return m_pageCount; }
+	uint32_t GetChunkCapacity() const { return m_pageCount * PAGE_CHUNKS; }
+	uint32_t GetFreeChunkCount() const { return m_chunkRanges.GetFreeChunkCount(); }
 
 protected:
 	bool Init(const std::shared_ptr<ChunkBasedUniforms>& pSelf, uint32_t numBytes);
 
-	void InsertIntoFreeChunk(uint32_t index, uint32_t chunkIndex);
-	void FreePreObjectChunk(uint32_t index, uint32_t start, uint32_t end);
+	// Page count is at least doubled, so that GPU buffer is only reallocated a logarithmic number of times
+	void Grow(uint32_t minPageCount);
 
 	void UpdateUniformDataInternal() override;
+	void SyncBufferDataInternal() override;
 	void SetDirtyInternal() override;
+	const void* AcquireDataPtr() const override { return AcquirePageDataPtr(0); }
+	uint32_t AcquireDataSize() const override { return m_pageCount * PAGE_CHUNKS * m_perChunkBytes; }
 
 	virtual void UpdateDirtyChunkInternal(uint32_t index) = 0;
 	virtual void SetChunkDirty(uint32_t index);
 
+	// Uploads chunks [start, end) of current frame, page by page
+	void UploadChunks(uint32_t frameIndex, uint32_t start, uint32_t end);
+
+	// Storages that don't keep what's uploaded, but compute chunks straight into mapped memory of frame region
+	// They go through a scratch copy only if buffer isn't host visible
+	virtual bool IsDirectWrite() const { return false; }
+	virtual void WriteChunks(uint32_t start, uint32_t end, uint8_t* pDst) const {}
+	// Bit sets have a bit for each chunk of capacity
+	void ResizeChunkBits();
+
+	// Storages allocate pages of their own chunk data, and tell what's uploaded of a page
+	virtual void AllocatePages(uint32_t pageCount) = 0;
+	virtual const void* AcquirePageDataPtr(uint32_t pageIndex) const = 0;
+
 protected:
-	std::vector<std::pair<uint32_t, uint32_t>>	m_freeChunks;
+	ChunkRangeAllocator							m_chunkRanges;
+
+	uint32_t									m_pageCount = 0;
 	uint32_t									m_perChunkBytes;
+
+	// Chunks to be updated by "UpdateDirtyChunkInternal", bits keep them unique
 	std::vector<uint32_t>						m_dirtyChunks;
+	std::vector<uint64_t>						m_dirtyChunkBits;
+
+	// Chunks each frame has yet to upload
+	ChunkUploadRanges							m_uploadRanges;
+	std::vector<ChunkUploadRanges::Range>		m_flushedRanges;
+
+	std::vector<uint8_t>						m_scratchChunks;
 };
\ No newline at end of file
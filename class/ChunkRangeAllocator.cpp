@@ -0,0 +1,104 @@
+#include "ChunkRangeAllocator.h"
+#include <iterator>
+
+const uint32_t ChunkRangeAllocator::INVALID_INDEX;
+
+uint32_t ChunkRangeAllocator::AllocateChunk()
+{
+	if (m_freeRanges.empty())
+		return INVALID_INDEX;
+
+	auto iter = m_freeRanges.begin();
+	uint32_t index = iter->first;
+	uint32_t end = iter->second;
+
+	RemoveFreeRange(iter);
+	if (index + 1 < end)
+		AddFreeRange(index + 1, end);
+
+	return index;
+}
+
+uint32_t ChunkRangeAllocator::AllocateConsecutiveChunks(uint32_t chunkCount)
+{
+	if (chunkCount == 0)
+		return INVALID_INDEX;
+
+	auto iter = m_freeRangesBySize.lower_bound({ chunkCount, 0 });
+	if (iter == m_freeRangesBySize.end())
+		return INVALID_INDEX;
+
+	uint32_t rangeSize = iter->first;
+	uint32_t index = iter->second;
+
+	RemoveFreeRange(m_freeRanges.find(index));
+	if (rangeSize > chunkCount)
+		AddFreeRange(index + chunkCount, index + rangeSize);
+
+	return index;
+}
+
+bool ChunkRangeAllocator::FreeConsecutiveChunks(uint32_t index, uint32_t chunkCount)
+{
+	if (chunkCount == 0 || (uint64_t)index + chunkCount > m_chunkCapacity)
+		return false;
+
+	uint32_t start = index;
+	uint32_t end = index + chunkCount;
+
+	// The first range after freed chunks, and the one before it
+	// Both are checked for overlap before either is touched, so that a bad free leaves ranges as they are
+	auto next = m_freeRanges.upper_bound(start);
+	auto prev = next != m_freeRanges.begin() ? std::prev(next) : m_freeRanges.end();
+
+	if (prev != m_freeRanges.end() && prev->second > start)
+		return false;
+	if (next != m_freeRanges.end() && next->first < end)
+		return false;
+
+	if (prev != m_freeRanges.end() && prev->second == start)
+	{
+		start = prev->first;
+		RemoveFreeRange(prev);
+	}
+
+	if (next != m_freeRanges.end() && next->first == end)
+	{
+		end = next->second;
+		RemoveFreeRange(next);
+	}
+
+	AddFreeRange(start, end);
+	return true;
+}
+
+void ChunkRangeAllocator::Grow(uint32_t chunkCapacity)
+{
+	if (chunkCapacity <= m_chunkCapacity)
+		return;
+
+	uint32_t oldCapacity = m_chunkCapacity;
+	m_chunkCapacity = chunkCapacity;
+	FreeConsecutiveChunks(oldCapacity, chunkCapacity - oldCapacity);
+}
+
+uint32_t ChunkRangeAllocator::GetTrailingFreeChunkCount() const
+{
+	if (m_freeRanges.empty() || m_freeRanges.rbegin()->second != m_chunkCapacity)
+		return 0;
+	return m_freeRanges.rbegin()->second - m_freeRanges.rbegin()->first;
+}
+
+void ChunkRangeAllocator::AddFreeRange(uint32_t start, uint32_t end)
+{
+	m_freeRanges[start] = end;
+	m_freeRangesBySize.insert({ end - start, start });
+	m_freeChunkCount += end - start;
+}
+
+void ChunkRangeAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator iter)
+{
+	m_freeRangesBySize.erase({ iter->second - iter->first, iter->first });
+	m_freeChunkCount -= iter->second - iter->first;
+	m_freeRanges.erase(iter);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <set>
+
+// Hands out chunk indices of a range that only grows at its end
+// Free chunks are kept as ranges, ordered by position to coalesce on free, and by size to allocate consecutive chunks with best fit
+// So allocation and free are both O(log n), and it only deals with indices, which keeps it testable without any device
+class ChunkRangeAllocator
+{
+public:
+	static const uint32_t INVALID_INDEX = (uint32_t)-1;
+
+public:
+	// Lowest free chunk, to keep chunks in use packed, INVALID_INDEX if there's none
+	uint32_t AllocateChunk();
+	// Smallest free range that fits, INVALID_INDEX if there's none
+	uint32_t AllocateConsecutiveChunks(uint32_t chunkCount);
+	// Nothing is changed and false is returned if any of these chunks is out of range or already free
+	bool FreeConsecutiveChunks(uint32_t index, uint32_t chunkCount);
+	// New chunks join trailing free range if there's one
+	void Grow(uint32_t chunkCapacity);
+
+	uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+	uint32_t GetFreeChunkCount() const { return m_freeChunkCount; }
+	uint32_t GetFreeRangeCount() const { return (uint32_t)m_freeRanges.size(); }
+	// Free chunks at the end of range, they're extended by growing
+	uint32_t GetTrailingFreeChunkCount() const;
+
+private:
+	void AddFreeRange(uint32_t start, uint32_t end);
+	void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator iter);
+
+private:
+	// Free chunk ranges [first, second), keyed by first
+	std::map<uint32_t, uint32_t>				m_freeRanges;
+	// The same ranges as pairs of size and first
+	std::set<std::pair<uint32_t, uint32_t>>		m_freeRangesBySize;
+	uint32_t									m_freeChunkCount = 0;
+	uint32_t									m_chunkCapacity = 0;
+};
\ No newline at end of file
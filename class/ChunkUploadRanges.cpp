@@ -0,0 +1,81 @@
+#include "ChunkUploadRanges.h"
+#include <algorithm>
+
+void ChunkUploadRanges::Init(uint32_t frameCount, uint32_t perChunkBytes, uint32_t coalesceGapBytes)
+{
+	m_maxGapChunks = coalesceGapBytes / perChunkBytes;
+
+	m_pendingChunkBits.resize(frameCount);
+	m_pendingFullUploads.resize(frameCount, false);
+}
+
+void ChunkUploadRanges::Resize(uint32_t chunkCapacity)
+{
+	m_chunkCapacity = chunkCapacity;
+	for (auto & bits : m_pendingChunkBits)
+		bits.resize(chunkCapacity / 64, 0);
+}
+
+void ChunkUploadRanges::SetChunkPending(uint32_t index)
+{
+	for (auto & bits : m_pendingChunkBits)
+		SetChunkBit(bits, index);
+}
+
+void ChunkUploadRanges::SetFullUpload()
+{
+	for (uint32_t i = 0; i < (uint32_t)m_pendingFullUploads.size(); i++)
+		m_pendingFullUploads[i] = true;
+}
+
+void ChunkUploadRanges::Flush(uint32_t frameIndex, std::vector<Range>& ranges)
+{
+	std::vector<uint64_t>& pendingBits = m_pendingChunkBits[frameIndex];
+
+	if (m_pendingFullUploads[frameIndex])
+	{
+		if (m_chunkCapacity > 0)
+			ranges.push_back({ 0, m_chunkCapacity });
+		m_pendingFullUploads[frameIndex] = false;
+	}
+	else
+	{
+		uint32_t start = FindChunkBit(pendingBits, 0, m_chunkCapacity, true);
+		while (start < m_chunkCapacity)
+		{
+			uint32_t end = FindChunkBit(pendingBits, start, m_chunkCapacity, false);
+			uint32_t next = FindChunkBit(pendingBits, end, m_chunkCapacity, true);
+
+			// Merge following pending ranges separated by small gaps
+			while (next < m_chunkCapacity && next - end <= m_maxGapChunks)
+			{
+				end = FindChunkBit(pendingBits, next, m_chunkCapacity, false);
+				next = FindChunkBit(pendingBits, end, m_chunkCapacity, true);
+			}
+
+			ranges.push_back({ start, end });
+			start = next;
+		}
+	}
+
+	std::fill(pendingBits.begin(), pendingBits.end(), 0);
+}
+
+uint32_t ChunkUploadRanges::FindChunkBit(const std::vector<uint64_t>& bits, uint32_t index, uint32_t end, bool value)
+{
+	uint64_t skippedWord = value ? 0 : ~0ull;
+	while (index < end)
+	{
+		// Skip whole words that can't have it
+		if (index % 64 == 0 && bits[index / 64] == skippedWord)
+		{
+			index += 64;
+			continue;
+		}
+
+		if (TestChunkBit(bits, index) == value)
+			return index;
+		index++;
+	}
+	return end;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Keeps bits of chunks each frame's region has yet to get, and turns them into coalesced ranges to upload
+// It only deals with chunk indices, which keeps it testable without any device
+class ChunkUploadRanges
+{
+public:
+	// Chunks [start, end)
+	typedef struct _Range
+	{
+		uint32_t	start;
+		uint32_t	end;
+	}Range;
+
+public:
+	// Clean chunks between two pending ones are uploaded along with them if they're no more than "coalesceGapBytes"
+	void Init(uint32_t frameCount, uint32_t perChunkBytes, uint32_t coalesceGapBytes);
+	// Capacity is a multiple of 64, new chunks aren't pending
+	void Resize(uint32_t chunkCapacity);
+
+	void SetChunkPending(uint32_t index);
+	// Every frame uploads all chunks on its next flush, e.g. after buffer grows
+	void SetFullUpload();
+
+	// Appends ranges pending for a frame to "ranges", in ascending order, and resets its pending chunks
+	void Flush(uint32_t frameIndex, std::vector<Range>& ranges);
+
+	bool IsChunkPending(uint32_t frameIndex, uint32_t index) const { return TestChunkBit(m_pendingChunkBits[frameIndex], index); }
+	uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+
+public:
+	static bool TestChunkBit(const std::vector<uint64_t>& bits, uint32_t index) { return (bits[index / 64] & (1ull << (index % 64))) != 0; }
+	static void SetChunkBit(std::vector<uint64_t>& bits, uint32_t index) { bits[index / 64] |= 1ull << (index % 64); }
+	static void ClearChunkBit(std::vector<uint64_t>& bits, uint32_t index) { bits[index / 64] &= ~(1ull << (index % 64)); }
+	// First chunk from "index" whose bit equals "value", or "end" if there's none
+	static uint32_t FindChunkBit(const std::vector<uint64_t>& bits, uint32_t index, uint32_t end, bool value);
+
+private:
+	uint32_t								m_chunkCapacity = 0;
+	uint32_t								m_maxGapChunks = 0;
+
+	std::vector<std::vector<uint64_t>>		m_pendingChunkBits;
+	std::vector<bool>						m_pendingFullUploads;
+};
\ No newline at end of file
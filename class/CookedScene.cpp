@@ -0,0 +1,157 @@
+#include "CookedScene.h"
+#include "../common/MappedFile.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+	return (offset + CookedScene::DATA_ALIGNMENT - 1) / CookedScene::DATA_ALIGNMENT * CookedScene::DATA_ALIGNMENT;
+}
+
+static uint64_t AppendBytes(std::vector<uint8_t>& bytes, const void* pData, uint64_t size)
+{
+	uint64_t offset = AlignOffset(bytes.size());
+	bytes.resize(offset + size, 0);
+	// No data only reserves zeroed bytes
+	if (pData && size)
+		memcpy(bytes.data() + offset, pData, size);
+	return offset;
+}
+
+std::string CookedScene::GetCookedPath(const std::string& sourcePath, uint32_t importFlags)
+{
+	return sourcePath + "_" + std::to_string(importFlags) + ".cooked";
+}
+
+bool CookedScene::Cook(const SceneData& sceneData, const std::string& sourcePath, uint32_t importFlags)
+{
+	Header header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.importFlags = importFlags;
+	header.meshCount = (uint32_t)sceneData.meshes.size();
+	header.nodeCount = (uint32_t)sceneData.nodes.size();
+	if (!MappedFile::AcquireFileStamp(sourcePath, header.sourceSize, header.sourceModifiedTime))
+		return false;
+
+	// Tables go first, they're filled in after mesh data offsets are known
+	std::vector<uint8_t> bytes;
+	AppendBytes(bytes, &header, sizeof(Header));
+	header.meshesOffset = AppendBytes(bytes, nullptr, sizeof(CookedMesh) * header.meshCount);
+	header.nodesOffset = AppendBytes(bytes, sceneData.nodes.data(), sizeof(CookedNode) * sceneData.nodes.size());
+	header.meshIndicesOffset = AppendBytes(bytes, sceneData.meshIndices.data(), sizeof(uint32_t) * sceneData.meshIndices.size());
+	header.namesOffset = AppendBytes(bytes, sceneData.names.data(), sceneData.names.size());
+	header.namesSize = sceneData.names.size();
+
+	std::vector<CookedMesh> meshes(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++)
+	{
+		const MeshData& meshData = sceneData.meshes[i];
+		meshes[i] = meshData.mesh;
+		meshes[i].verticesOffset = AppendBytes(bytes, meshData.pVertices, (uint64_t)meshData.mesh.vertexBytes * meshData.mesh.verticesCount);
+		meshes[i].indicesOffset = AppendBytes(bytes, meshData.pIndices, sizeof(uint32_t) * (uint64_t)meshData.mesh.indicesCount);
+		meshes[i].bonesOffset = AppendBytes(bytes, meshData.pBones, sizeof(CookedBone) * (uint64_t)meshData.mesh.boneCount);
+	}
+
+	memcpy(bytes.data(), &header, sizeof(Header));
+	if (header.meshCount)
+		memcpy(bytes.data() + header.meshesOffset, meshes.data(), sizeof(CookedMesh) * header.meshCount);
+
+	// Written into a temporary file first, a half written container is never picked up
+	std::string cookedPath = GetCookedPath(sourcePath, importFlags);
+	std::string tempPath = cookedPath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file.write((const char*)bytes.data(), bytes.size());
+		if (!file.good())
+			return false;
+	}
+
+	std::remove(cookedPath.c_str());
+	return std::rename(tempPath.c_str(), cookedPath.c_str()) == 0;
+}
+
+std::shared_ptr<CookedScene> CookedScene::Load(const std::string& sourcePath, uint32_t importFlags)
+{
+	std::shared_ptr<CookedScene> pCookedScene = std::make_shared<CookedScene>();
+	if (pCookedScene.get() && pCookedScene->Init(sourcePath, importFlags))
+		return pCookedScene;
+	return nullptr;
+}
+
+bool CookedScene::Init(const std::string& sourcePath, uint32_t importFlags)
+{
+	m_pMappedFile = MappedFile::Create(GetCookedPath(sourcePath, importFlags));
+	if (m_pMappedFile == nullptr || m_pMappedFile->GetSize() < sizeof(Header))
+		return false;
+
+	const uint8_t* pData = m_pMappedFile->GetData();
+	m_pMappedData = pData;
+	m_pHeader = (const Header*)pData;
+
+	if (m_pHeader->magic != MAGIC || m_pHeader->version != VERSION || m_pHeader->importFlags != importFlags)
+		return false;
+
+	// Cooked file could also ship without its source, it's up to date as long as source isn't around
+	uint64_t sourceSize, sourceModifiedTime;
+	m_isSourceMissing = !MappedFile::AcquireFileStamp(sourcePath, sourceSize, sourceModifiedTime);
+	if (!m_isSourceMissing && (sourceSize != m_pHeader->sourceSize || sourceModifiedTime != m_pHeader->sourceModifiedTime))
+		return false;
+
+	if (!IsInFile(m_pHeader->meshesOffset, sizeof(CookedMesh) * (uint64_t)m_pHeader->meshCount) ||
+		!IsInFile(m_pHeader->nodesOffset, sizeof(CookedNode) * (uint64_t)m_pHeader->nodeCount) ||
+		!IsInFile(m_pHeader->namesOffset, m_pHeader->namesSize))
+		return false;
+
+	m_pMeshes = (const CookedMesh*)(pData + m_pHeader->meshesOffset);
+	m_pNodes = (const CookedNode*)(pData + m_pHeader->nodesOffset);
+	m_pMeshIndices = (const uint32_t*)(pData + m_pHeader->meshIndicesOffset);
+	m_pNames = (const char*)(pData + m_pHeader->namesOffset);
+
+	uint64_t meshIndexCount = 0;
+	for (uint32_t i = 0; i < m_pHeader->nodeCount; i++)
+	{
+		if ((uint64_t)m_pNodes[i].nameOffset + m_pNodes[i].nameLength > m_pHeader->namesSize)
+			return false;
+		meshIndexCount = std::max(meshIndexCount, (uint64_t)m_pNodes[i].meshIndexOffset + m_pNodes[i].meshCount);
+	}
+	if (!IsInFile(m_pHeader->meshIndicesOffset, sizeof(uint32_t) * meshIndexCount))
+		return false;
+
+	for (uint64_t i = 0; i < meshIndexCount; i++)
+	{
+		if (m_pMeshIndices[i] >= m_pHeader->meshCount)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < m_pHeader->meshCount; i++)
+	{
+		const CookedMesh& mesh = m_pMeshes[i];
+		if (!IsInFile(mesh.verticesOffset, (uint64_t)mesh.vertexBytes * mesh.verticesCount) ||
+			!IsInFile(mesh.indicesOffset, sizeof(uint32_t) * (uint64_t)mesh.indicesCount) ||
+			!IsInFile(mesh.bonesOffset, sizeof(CookedBone) * (uint64_t)mesh.boneCount))
+			return false;
+	}
+
+	return true;
+}
+
+bool CookedScene::IsInFile(uint64_t offset, uint64_t size) const
+{
+	return offset <= m_pMappedFile->GetSize() && size <= m_pMappedFile->GetSize() - offset;
+}
+
+std::string CookedScene::GetNodeName(uint32_t nodeIndex) const
+{
+	return std::string(m_pNames + m_pNodes[nodeIndex].nameOffset, m_pNodes[nodeIndex].nameLength);
+}
+
+uint64_t CookedScene::GetFileSize() const
+{
+	return m_pMappedFile->GetSize();
+}
\ No newline at end of file
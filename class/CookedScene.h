@@ -0,0 +1,138 @@
+#pragma once
+#include "../Maths/Matrix.h"
+#include "../Maths/DualQuaternion.h"
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+class MappedFile;
+
+// Binary container of an assimp scene imported with certain flags, it's cooked once and mapped into memory afterwards
+// Vertices are interleaved exactly as their vertex format, so they're uploaded as they are without any conversion
+// Nodes are stored depth first, each followed by all its descendants
+//
+// It only deals with bytes: "AssimpSceneReader" extracts what's cooked from assimp scenes, and "Mesh::Create" makes meshes of what's mapped
+// Animations aren't cooked, scenes with animations always go through assimp
+class CookedScene
+{
+public:
+	static const uint32_t MAGIC = 0x4b4f4f43;	// "COOK"
+	// Bump it whenever layout below or mesh data extraction changes, so that existing cooked files are treated as stale
+	static const uint32_t VERSION = 3;
+	static const uint32_t DATA_ALIGNMENT = 16;
+
+	typedef struct _Header
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	importFlags;
+		uint32_t	meshCount;
+		uint32_t	nodeCount;
+		uint32_t	reserved;
+		// Stamp of source file when it's cooked, see "MappedFile::AcquireFileStamp"
+		uint64_t	sourceSize;
+		// In nanoseconds
+		uint64_t	sourceModifiedTime;
+		// Byte offsets from the beginning of file
+		uint64_t	meshesOffset;
+		uint64_t	nodesOffset;
+		uint64_t	meshIndicesOffset;
+		uint64_t	namesOffset;
+		uint64_t	namesSize;
+	}Header;
+
+	typedef struct _CookedMesh
+	{
+		uint32_t	vertexFormat;
+		uint32_t	vertexBytes;
+		uint32_t	verticesCount;
+		uint32_t	indicesCount;
+		uint32_t	boneCount;
+		uint32_t	reserved;
+		uint64_t	verticesOffset;
+		// Indices are always 32 bit
+		uint64_t	indicesOffset;
+		uint64_t	bonesOffset;
+	}CookedMesh;
+
+	// Same layout as "Mesh::BoneOffset"
+	typedef struct _CookedBone
+	{
+		uint64_t		nameHash;
+		DualQuaterniond	offsetDQ;
+	}CookedBone;
+
+	typedef struct _CookedNode
+	{
+		Matrix3d	rotation;
+		Vector3d	translation;
+		// Name in utf8, within name table
+		uint32_t	nameOffset;
+		uint32_t	nameLength;
+		// Mesh indices of this node, within mesh index table
+		uint32_t	meshIndexOffset;
+		uint32_t	meshCount;
+		uint32_t	childCount;
+		uint32_t	reserved;
+	}CookedNode;
+
+	// A mesh to be cooked, offsets are worked out while writing
+	typedef struct _MeshData
+	{
+		CookedMesh			mesh;
+		const void*			pVertices;
+		const uint32_t*		pIndices;
+		const CookedBone*	pBones;
+	}MeshData;
+
+	typedef struct _SceneData
+	{
+		std::vector<MeshData>	meshes;
+		std::vector<CookedNode>	nodes;
+		std::vector<uint32_t>	meshIndices;
+		std::string				names;
+	}SceneData;
+
+public:
+	static std::string GetCookedPath(const std::string& sourcePath, uint32_t importFlags);
+
+	// Writes cooked file next to source, false if source doesn't exist or file can't be written
+	static bool Cook(const SceneData& sceneData, const std::string& sourcePath, uint32_t importFlags);
+	// Nullptr if cooked file doesn't exist, or it's stale against source file and current version
+	static std::shared_ptr<CookedScene> Load(const std::string& sourcePath, uint32_t importFlags);
+
+public:
+	uint32_t GetMeshCount() const { return m_pHeader->meshCount; }
+	const CookedMesh& GetMesh(uint32_t meshIndex) const { return m_pMeshes[meshIndex]; }
+	// Within mapped file, valid as long as this object is
+	const uint8_t* GetMeshVertices(uint32_t meshIndex) const { return m_pMappedData + m_pMeshes[meshIndex].verticesOffset; }
+	const uint32_t* GetMeshIndices(uint32_t meshIndex) const { return (const uint32_t*)(m_pMappedData + m_pMeshes[meshIndex].indicesOffset); }
+	const CookedBone* GetMeshBones(uint32_t meshIndex) const { return (const CookedBone*)(m_pMappedData + m_pMeshes[meshIndex].bonesOffset); }
+
+	uint32_t GetNodeCount() const { return m_pHeader->nodeCount; }
+	const CookedNode& GetNode(uint32_t nodeIndex) const { return m_pNodes[nodeIndex]; }
+	std::string GetNodeName(uint32_t nodeIndex) const;
+	const uint32_t* GetNodeMeshIndices(uint32_t nodeIndex) const { return m_pMeshIndices + m_pNodes[nodeIndex].meshIndexOffset; }
+
+	uint64_t GetFileSize() const;
+	// Cooked file shipped without its source, so it can't be checked against it
+	bool IsSourceMissing() const { return m_isSourceMissing; }
+
+protected:
+	bool Init(const std::string& sourcePath, uint32_t importFlags);
+
+	// Whether a range is within mapped file
+	bool IsInFile(uint64_t offset, uint64_t size) const;
+
+protected:
+	std::shared_ptr<MappedFile>	m_pMappedFile;
+
+	const uint8_t*				m_pMappedData = nullptr;
+	const Header*				m_pHeader = nullptr;
+	const CookedMesh*			m_pMeshes = nullptr;
+	const CookedNode*			m_pNodes = nullptr;
+	const uint32_t*				m_pMeshIndices = nullptr;
+	const char*					m_pNames = nullptr;
+	bool						m_isSourceMissing = false;
+};
\ No newline at end of file
@@ -18,6 +18,7 @@
 #include "RenderWorkManager.h"
 #include "GBufferPass.h"
 #include "SSAOPass.h"
+#include "SkinningManager.h"
 #include "FrameBufferDiction.h"
 #include "../common/Util.h"
 
@@ -51,10 +52,19 @@ std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool ski
 
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
 	std::wstring vert = skinned ? L"../data/shaders/pbr_gbuffer_gen_skinned.vert.spv" : L"../data/shaders/pbr_gbuffer_gen.vert.spv";
+	uint32_t vertexFormat = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+
+	// Compute skinned meshes come with previous frame's skinned position instead of bones, for motion vectors
+	if (skinned && SkinningManager::GetInstance()->IsEnabled())
+	{
+		vert = L"../data/shaders/pbr_gbuffer_gen_preskinned.vert.spv";
+		vertexFormat = VertexFormatPNCTCT;
+	}
+
 	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"../data/shaders/pbr_gbuffer_gen.frag.spv", L"" };
 	simpleMaterialInfo.materialUniformVars = vars;
-	simpleMaterialInfo.vertexFormat = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
-	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	simpleMaterialInfo.vertexFormat = vertexFormat;
+	simpleMaterialInfo.vertexFormatInMem = vertexFormat;
 	simpleMaterialInfo.subpassIndex = 0;
 	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_GBuffer;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer);
@@ -77,22 +77,16 @@ bool FrameBufferDiction::Init()
 FrameBufferDiction::FrameBufferCombo FrameBufferDiction::GetFrameBuffers(FrameBufferType type, uint32_t layer)
 { 
 	// Only bloom is layered, might generalize it through all frame buffers, when needed
-	if (m_frameBuffers[type].size() <= layer)
-	{
-		for (uint32_t i = 0; i < layer - m_frameBuffers[type].size() + 1; i++)
-			m_frameBuffers[type].push_back(CreateFrameBuffer(type, (uint32_t)m_frameBuffers[type].size()));
-	}
+	while (m_frameBuffers[type].size() <= layer)
+		m_frameBuffers[type].push_back(CreateFrameBuffer(type, (uint32_t)m_frameBuffers[type].size()));
 	return m_frameBuffers[type][layer];
 }
 
 std::shared_ptr<FrameBuffer> FrameBufferDiction::GetFrameBuffer(FrameBufferType type, uint32_t layer)
 {
 	// Only bloom is layered, might generalize it through all frame buffers, when needed
-	if (m_frameBuffers[type].size() <= layer)
-	{
-		for (uint32_t i = 0; i < layer - m_frameBuffers[type].size() + 1; i++)
-			m_frameBuffers[type].push_back(CreateFrameBuffer(type, (uint32_t)m_frameBuffers[type].size()));
-	}
+	while (m_frameBuffers[type].size() <= layer)
+		m_frameBuffers[type].push_back(CreateFrameBuffer(type, (uint32_t)m_frameBuffers[type].size()));
 	return m_frameBuffers[type][layer][FrameMgr()->FrameIndex()];
 }
 
@@ -115,6 +109,25 @@ std::shared_ptr<FrameBuffer> FrameBufferDiction::GetPingPongFrameBuffer(FrameBuf
 		return m_frameBuffers[type][0][frameIndex];
 }
 
+void FrameBufferDiction::AliasFrameBuffer(FrameBufferType type, uint32_t layer, const std::vector<std::shared_ptr<MemoryKey>>& memKeys, uint32_t memoryOffset)
+{
+	FrameBufferCombo& frameBuffers = m_frameBuffers[type][layer];
+	ASSERTION(memKeys.size() == frameBuffers.size());
+
+	for (uint32_t i = 0; i < frameBuffers.size(); i++)
+	{
+		ASSERTION(frameBuffers[i]->GetColorTargets().size() == 1 && frameBuffers[i]->GetDepthStencilTarget() == nullptr);
+
+		const VkImageCreateInfo& info = frameBuffers[i]->GetColorTarget(0)->GetImageInfo();
+		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), info.extent.width, info.extent.height, info.format, memKeys[i], memoryOffset);
+		frameBuffers[i] = FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, frameBuffers[i]->GetRenderPass());
+	}
+
+	// DOF post filter renders into pre filter's image
+	if (type == FrameBufferType_DOF && layer == PrefilterLayer && m_frameBuffers[type].size() > PostfilterLayer)
+		m_frameBuffers[type][PostfilterLayer] = CreateDOFFrameBuffer(PostfilterLayer);
+}
+
 FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateGBufferFrameBuffer(uint32_t layer)
 {
 	Vector2d windowSize = UniformData::GetInstance()->GetGlobalUniforms()->GetGameWindowSize();
@@ -6,6 +6,7 @@
 
 class FrameBuffer;
 class Texture2D;
+class MemoryKey;
 
 class FrameBufferDiction : public Singleton<FrameBufferDiction>
 {
@@ -93,6 +94,10 @@ public:
 	static VkFormat GetGBufferFormat(GBuffer gbuffer) { return m_GBufferFormatTable[gbuffer]; }
 	FrameBufferCombo CreateFrameBuffer(FrameBufferType type, uint32_t layer = 0);
 
+	// Recreate single color target frame buffers with their images placed at "memoryOffset" of given memory chunk per frame
+	// Images of different frame buffers could share memory, as long as they're not used at the same time within a frame
+	void AliasFrameBuffer(FrameBufferType type, uint32_t layer, const std::vector<std::shared_ptr<MemoryKey>>& memKeys, uint32_t memoryOffset);
+
 	FrameBufferCombo CreateGBufferFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateMotionTileMaxFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateMotionNeighborMaxFrameBuffer(uint32_t layer = 0);
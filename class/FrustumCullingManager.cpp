@@ -0,0 +1,163 @@
+#include "FrustumCullingManager.h"
+#include "UniformData.h"
+#include "../Maths/Plane.h"
+#include "../Maths/SIMD.h"
+#include <cmath>
+
+const uint32_t FrustumCullingManager::INVALID_INDEX;
+
+uint32_t FrustumCullingManager::AllocateBounds()
+{
+	uint32_t index;
+	if (!m_freeIndices.empty())
+	{
+		index = m_freeIndices.back();
+		m_freeIndices.pop_back();
+	}
+	else
+	{
+		index = m_boundsCount++;
+
+		// Keep arrays a multiple of 4, so the batch never needs a scalar tail
+		uint32_t paddedCount = (m_boundsCount + 3) & ~3u;
+		if (paddedCount > (uint32_t)m_radius.size())
+		{
+			m_centerX.resize(paddedCount, 0);
+			m_centerY.resize(paddedCount, 0);
+			m_centerZ.resize(paddedCount, 0);
+			m_radius.resize(paddedCount, 0);
+			m_cullingEnabled.resize(paddedCount, 0);
+			for (uint32_t i = 0; i < CullingFrustum_Count; i++)
+				m_visibility[i].resize(paddedCount, 1);
+		}
+	}
+
+	m_cullingEnabled[index] = 0;
+	for (uint32_t i = 0; i < CullingFrustum_Count; i++)
+		m_visibility[i][index] = 1;
+
+	return index;
+}
+
+void FrustumCullingManager::FreeBounds(uint32_t index)
+{
+	m_cullingEnabled[index] = 0;
+	m_freeIndices.push_back(index);
+}
+
+void FrustumCullingManager::SetWorldBounds(uint32_t index, const Vector3f& center, float radius)
+{
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_radius[index] = radius;
+	m_cullingEnabled[index] = 1;
+
+	m_isDirty = true;
+}
+
+void FrustumCullingManager::DisableCulling(uint32_t index)
+{
+	m_cullingEnabled[index] = 0;
+	for (uint32_t i = 0; i < CullingFrustum_Count; i++)
+		m_visibility[i][index] = 1;
+}
+
+bool FrustumCullingManager::IsVisible(uint32_t index, CullingFrustum frustum)
+{
+	if (m_isDirty)
+		Cull();
+
+	return m_visibility[frustum][index] != 0;
+}
+
+void FrustumCullingManager::Cull()
+{
+	Matrix4d viewMatrix = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix();
+
+	// World space to camera clip space
+	CullAgainst(UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix() * viewMatrix, m_visibility[CullingFrustum_Camera], m_statistics[CullingFrustum_Camera]);
+
+	// Main light matrix goes from camera space to light clip space
+	CullAgainst(UniformData::GetInstance()->GetGlobalUniforms()->GetmainLightVP() * viewMatrix, m_visibility[CullingFrustum_Light], m_statistics[CullingFrustum_Light]);
+
+	m_isDirty = false;
+}
+
+void FrustumCullingManager::CullAgainst(const Matrix4d& clipMatrix, std::vector<uint8_t>& visibility, CullingStatistics& statistics)
+{
+	// Planes from rows of clip matrix, vulkan clip volume is -w <= x <= w, -w <= y <= w, 0 <= z <= w
+	// Reversed infinite projection leaves a degenerated far plane with zero normal and positive D, which passes everything
+	const double* m = &clipMatrix.c00;
+	auto row = [m](uint32_t r, uint32_t c) { return m[c * 4 + r]; };
+
+	Vector4d rows[4];
+	for (uint32_t r = 0; r < 4; r++)
+		rows[r] = { row(r, 0), row(r, 1), row(r, 2), row(r, 3) };
+
+	Vector4d planeEquations[6] =
+	{
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		rows[2],
+		rows[3] - rows[2]
+	};
+
+	SIMDFloat4 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		Planed plane(planeEquations[i].xyz(), -planeEquations[i].w);
+
+		double length = plane.normal.Length();
+		if (length > 1e-12)
+		{
+			plane.normal /= length;
+			plane.D /= length;
+		}
+
+		// Sphere is inside the plane when "PlaneTest(center) >= -radius"
+		planeX[i] = SIMDSplat((float)plane.normal.x);
+		planeY[i] = SIMDSplat((float)plane.normal.y);
+		planeZ[i] = SIMDSplat((float)plane.normal.z);
+		planeW[i] = SIMDSplat((float)-plane.D);
+	}
+
+	statistics = {};
+
+	SIMDFloat4 zero = SIMDSplat(0.0f);
+	for (uint32_t i = 0; i < (uint32_t)m_radius.size(); i += 4)
+	{
+		SIMDFloat4 x = SIMDLoad(&m_centerX[i]);
+		SIMDFloat4 y = SIMDLoad(&m_centerY[i]);
+		SIMDFloat4 z = SIMDLoad(&m_centerZ[i]);
+		SIMDFloat4 negRadius = SIMDSub(zero, SIMDLoad(&m_radius[i]));
+
+		// Sphere is outside once it's completely behind any plane
+		// Not fused, so that every path of SIMD wrapper gives the same result
+		SIMDFloat4 inside = SIMDCompareGE(zero, zero);
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			SIMDFloat4 distance = SIMDAdd(
+				SIMDAdd(SIMDMul(planeX[p], x), SIMDMul(planeY[p], y)),
+				SIMDAdd(SIMDMul(planeZ[p], z), planeW[p]));
+			inside = SIMDAnd(inside, SIMDCompareGE(distance, negRadius));
+		}
+
+		int mask = SIMDMoveMask(inside);
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			if (!m_cullingEnabled[i + j])
+				continue;
+
+			uint8_t visible = (mask >> j) & 1;
+			visibility[i + j] = visible;
+
+			if (visible)
+				statistics.visibleCount++;
+			else
+				statistics.culledCount++;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "../common/Singleton.h"
+#include "../Maths/Matrix.h"
+
+// World bounding spheres of all mesh renderers, packed as structure of arrays, so that culling tests 4 of them at a time with SIMD wrapper
+// Renderers write their bounds in pre-render, the first visibility query after that culls all of them against all frustums in one batch
+//
+// Frustums are taken from uniform data, which cameras and lights have updated during pre-render as well
+class FrustumCullingManager : public Singleton<FrustumCullingManager>
+{
+public:
+	enum CullingFrustum
+	{
+		CullingFrustum_Camera,
+		CullingFrustum_Light,
+		CullingFrustum_Count
+	};
+
+	static const uint32_t INVALID_INDEX = (uint32_t)-1;
+
+	typedef struct _CullingStatistics
+	{
+		uint32_t	visibleCount = 0;
+		uint32_t	culledCount = 0;
+	}CullingStatistics;
+
+public:
+	bool Init() override { return true; }
+
+public:
+	uint32_t AllocateBounds();
+	void FreeBounds(uint32_t index);
+
+	void SetWorldBounds(uint32_t index, const Vector3f& center, float radius);
+	// Bounds without culling are always visible
+	void DisableCulling(uint32_t index);
+
+	bool IsVisible(uint32_t index, CullingFrustum frustum);
+
+	// Counts of the latest batch
+	const CullingStatistics& GetStatistics(CullingFrustum frustum) const { return m_statistics[frustum]; }
+
+protected:
+	void Cull();
+	void CullAgainst(const Matrix4d& clipMatrix, std::vector<uint8_t>& visibility, CullingStatistics& statistics);
+
+protected:
+	// Padded to a multiple of 4
+	std::vector<float>		m_centerX;
+	std::vector<float>		m_centerY;
+	std::vector<float>		m_centerZ;
+	std::vector<float>		m_radius;
+	std::vector<uint8_t>	m_cullingEnabled;
+
+	std::vector<uint8_t>	m_visibility[CullingFrustum_Count];
+	CullingStatistics		m_statistics[CullingFrustum_Count];
+
+	uint32_t				m_boundsCount = 0;
+	std::vector<uint32_t>	m_freeIndices;
+
+	// Bounds or frustums changed since last batch
+	bool					m_isDirty = true;
+};
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "FrameBufferDiction.h"
 #include "../common/Util.h"
 #include "../vulkan/ShaderStorageBuffer.h"
+#include "../vulkan/Buffer.h"
 #include "../class/PlanetGeoDataManager.h"
 
 std::shared_ptr<GBufferPlanetMaterial> GBufferPlanetMaterial::CreateDefaultMaterial()
@@ -202,6 +203,5 @@ std::shared_ptr<GBufferPlanetMaterial> GBufferPlanetMaterial::CreateDefaultMater
 
 void GBufferPlanetMaterial::CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong)
 {
-	std::shared_ptr<PerFrameBuffer> pPerFrameBuffer = PlanetGeoDataManager::GetInstance()->GetPerFrameBuffer();
-	pSecondaryCmdBuf->BindVertexBuffer(pPerFrameBuffer->GetBuffer(), FrameMgr()->FrameIndex() * pPerFrameBuffer->GetFrameOffset(), 1);
+	pSecondaryCmdBuf->BindVertexBuffer(PlanetGeoDataManager::GetInstance()->GetBuffer(), 0, 1);
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "GPUCullingManager.h"
+#include "UniformData.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../vulkan/DescriptorSetLayout.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/DescriptorPool.h"
+#include "../vulkan/PipelineLayout.h"
+#include "../vulkan/ShaderModule.h"
+#include "../vulkan/ComputePipeline.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+
+bool CandidateDrawUniforms::Init(const std::shared_ptr<CandidateDrawUniforms>& pSelf)
+{
+	if (!ChunkBasedUniforms::Init(pSelf, sizeof(CandidateDraw)))
+		return false;
+	return true;
+}
+
+std::shared_ptr<CandidateDrawUniforms> CandidateDrawUniforms::Create()
+{
+	std::shared_ptr<CandidateDrawUniforms> pCandidateDrawUniforms = std::make_shared<CandidateDrawUniforms>();
+	if (pCandidateDrawUniforms.get() && pCandidateDrawUniforms->Init(pCandidateDrawUniforms))
+		return pCandidateDrawUniforms;
+	return nullptr;
+}
+
+std::vector<UniformVarList> CandidateDrawUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"CandidateDraws",
+			{
+				{ OneUnit, "Index count" },
+				{ OneUnit, "Instance count" },
+				{ OneUnit, "First index" },
+				{ OneUnit, "Vertex offset" },
+				{ OneUnit, "First instance" },
+				{ OneUnit, "Candidate offset" },
+				{ OneUnit, "Candidate count" },
+				{ OneUnit, "Reserved" },
+				{ Vec4Unit, "Mesh space bounding sphere" },
+			}
+		}
+	};
+}
+
+uint32_t CandidateDrawUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
+
+	return bindingIndex;
+}
+
+bool GPUCullingManager::Init()
+{
+	if (!Singleton<GPUCullingManager>::Init())
+		return false;
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	for (uint32_t i = 0; i < CullingBinding_Count; i++)
+	{
+		bool isDynamic = i == CullingBinding_CandidateDraws || i == CullingBinding_IndirectOffsets || i == CullingBinding_IndirectIndices || i == CullingBinding_CandidateIndices;
+
+		bindings.push_back
+		({
+			i,
+			isDynamic ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			1,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			nullptr
+		});
+	}
+	m_pDescriptorSetLayout = DescriptorSetLayout::Create(GetDevice(), bindings);
+
+	std::vector<std::shared_ptr<DescriptorSetLayout>> descriptorSetLayouts = UniformData::GetInstance()->GetDescriptorSetLayouts();
+	descriptorSetLayouts.push_back(m_pDescriptorSetLayout);
+
+	m_pPipelineLayout = PipelineLayout::Create(GetDevice(), descriptorSetLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) } });
+
+	std::vector<VkDescriptorPoolSize> descPoolSize =
+	{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * MAX_CULLING_DESCRIPTOR_SETS },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 4 * MAX_CULLING_DESCRIPTOR_SETS }
+	};
+
+	VkDescriptorPoolCreateInfo descPoolInfo = {};
+	descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descPoolInfo.pPoolSizes = descPoolSize.data();
+	descPoolInfo.poolSizeCount = (uint32_t)descPoolSize.size();
+	descPoolInfo.maxSets = MAX_CULLING_DESCRIPTOR_SETS;
+
+	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
+
+	// Shader is optional, without it everything keeps being culled on CPU
+	std::shared_ptr<ShaderModule> pShader = ShaderModule::Create(GetDevice(), L"../data/shaders/indirect_culling.comp.spv", ShaderModule::ShaderTypeCompute, "main");
+	if (pShader == nullptr)
+		return true;
+
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	m_pComputePipeline = ComputePipeline::Create(GetDevice(), pipelineCreateInfo, pShader, m_pPipelineLayout);
+
+	return true;
+}
+
+std::shared_ptr<DescriptorSet> GPUCullingManager::AllocateDescriptorSet()
+{
+	return m_pDescriptorPool->AllocateDescriptorSet(m_pDescriptorSetLayout);
+}
+
+void GPUCullingManager::Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<DescriptorSet>& pDescriptorSet, const std::vector<uint32_t>& dynamicOffsets, uint32_t cullingFrustum, uint32_t candidateCapacity)
+{
+	std::vector<std::shared_ptr<DescriptorSet>> descriptorSets = UniformData::GetInstance()->GetDescriptorSets();
+	descriptorSets.push_back(pDescriptorSet);
+
+	std::vector<uint32_t> offsets = UniformData::GetInstance()->GetCachedFrameOffsets()[FrameMgr()->FrameIndex()];
+	offsets.insert(offsets.end(), dynamicOffsets.begin(), dynamicOffsets.end());
+
+	pCmdBuf->BindPipeline(m_pComputePipeline);
+	pCmdBuf->BindDescriptorSets(m_pPipelineLayout, descriptorSets, offsets, VK_PIPELINE_BIND_POINT_COMPUTE);
+	pCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &cullingFrustum);
+	pCmdBuf->Dispatch((candidateCapacity + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+	// Culled commands are consumed by indirect draw, and indices by vertex shaders
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	pCmdBuf->AttachBarriers
+	(
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		{ barrier },
+		{},
+		{}
+	);
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "../common/Singleton.h"
+#include "../Maths/Vector.h"
+#include "../vulkan/DeviceObjectBase.h"
+#include "ChunkBasedUniforms.h"
+#include <vector>
+
+class DescriptorSetLayout;
+class DescriptorSet;
+class DescriptorPool;
+class PipelineLayout;
+class ComputePipeline;
+class CommandBuffer;
+
+// Follows std430 layout of "CandidateDraw" in indirect_culling.comp
+typedef struct _CandidateDraw
+{
+	VkDrawIndexedIndirectCommand	cmd;
+	uint32_t						candidateOffset;
+	uint32_t						candidateCount;
+	uint32_t						reserved;
+	Vector4f						boundingSphere;		// Mesh space, negative radius means never culled
+}CandidateDraw;
+
+// Candidate draws of a material indexed by draw id, it grows with draw count like other indirect storages
+class CandidateDrawUniforms : public ChunkBasedUniforms
+{
+public:
+	bool Init(const std::shared_ptr<CandidateDrawUniforms>& pSelf);
+	static std::shared_ptr<CandidateDrawUniforms> Create();
+
+public:
+	void SetCandidateDraw(uint32_t drawID, const CandidateDraw& draw) { EnsureChunkCapacity(drawID + 1); m_candidateDraws[drawID] = draw; SetChunkDirty(drawID); }
+	const CandidateDraw& GetCandidateDraw(uint32_t drawID) const { return m_candidateDraws[drawID]; }
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateDirtyChunkInternal(uint32_t index) override {}
+	void AllocatePages(uint32_t pageCount) override { m_candidateDraws.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_candidateDraws.GetPage(pageIndex); }
+
+protected:
+	ChunkPages<CandidateDraw>	m_candidateDraws;
+};
+
+// Shared compute pipeline that frustum culls draws of a material and compacts survivors into its indirect buffers
+// Each material owns its per frame buffers and descriptor sets, layout of set 3:
+// 0: candidate draws
+// 1: indirect offsets, read by vertex shaders
+// 2: indirect object indices, read by vertex shaders
+// 3: candidate object indices
+// 4: culled indirect commands
+// 5: culled draw count, followed by candidate draw count
+//
+// Dispatch covers capacity of candidate storage rather than draw count, so that it works with prebaked command buffers
+// Those are recorded again once any storage grows, so the dispatch keeps up with draw count
+class GPUCullingManager : public Singleton<GPUCullingManager>
+{
+public:
+	static const uint32_t MAX_CULLING_DESCRIPTOR_SETS = 64;
+	static const uint32_t GROUP_SIZE = 64;
+
+	enum CullingBinding
+	{
+		CullingBinding_CandidateDraws,
+		CullingBinding_IndirectOffsets,
+		CullingBinding_IndirectIndices,
+		CullingBinding_CandidateIndices,
+		CullingBinding_CulledDraws,
+		CullingBinding_CulledDrawCount,
+		CullingBinding_Count
+	};
+
+public:
+	bool Init() override;
+
+public:
+	// False if culling shader isn't available, CPU culling should be used instead
+	bool IsSupported() const { return m_pComputePipeline != nullptr; }
+
+	std::shared_ptr<DescriptorSet> AllocateDescriptorSet();
+
+	// "dynamicOffsets" for bindings 0 to 3 of material's set, "candidateCapacity" is chunk capacity of candidate storage
+	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<DescriptorSet>& pDescriptorSet, const std::vector<uint32_t>& dynamicOffsets, uint32_t cullingFrustum, uint32_t candidateCapacity);
+
+protected:
+	std::shared_ptr<DescriptorSetLayout>	m_pDescriptorSetLayout;
+	std::shared_ptr<PipelineLayout>			m_pPipelineLayout;
+	std::shared_ptr<ComputePipeline>		m_pComputePipeline;
+	std::shared_ptr<DescriptorPool>			m_pDescriptorPool;
+};
\ No newline at end of file
@@ -546,6 +546,17 @@ void GlobalUniforms::SetPlanetSphericalTransitionRatio(double ratio)
 	SetDirty();
 }
 
+void GlobalUniforms::SetPlanetRebaseOffset(const Vector3d& offset)
+{
+	m_globalVariables.PlanetRenderingSettings.y = offset.x;
+	m_globalVariables.PlanetRenderingSettings.z = offset.y;
+	m_globalVariables.PlanetRenderingSettings.w = offset.z;
+	CONVERT2SINGLEVAL(m_globalVariables, m_singlePrecisionGlobalVariables, PlanetRenderingSettings.y);
+	CONVERT2SINGLEVAL(m_globalVariables, m_singlePrecisionGlobalVariables, PlanetRenderingSettings.z);
+	CONVERT2SINGLEVAL(m_globalVariables, m_singlePrecisionGlobalVariables, PlanetRenderingSettings.w);
+	SetDirty();
+}
+
 
 
 
@@ -720,20 +731,29 @@ std::shared_ptr<PerBoneUniforms> PerBoneUniforms::Create()
 
 void PerBoneUniforms::SetBoneOffsetTransform(uint32_t chunkIndex, const DualQuaterniond& offsetDQ)
 {
-	m_boneData[chunkIndex].prevBoneOffsetDQ = m_boneData[chunkIndex].currBoneOffsetDQ;
-	m_boneData[chunkIndex].currBoneOffsetDQ = offsetDQ;
+	WriteBoneOffsetTransform(chunkIndex, offsetDQ);
 	SetChunkDirty(chunkIndex);
 }
 
 DualQuaterniond PerBoneUniforms::GetBoneOffsetTransform(uint32_t chunkIndex) const
 {
-	return m_boneData[chunkIndex].currBoneOffsetDQ;
+	return m_singlePrecisionBoneData[chunkIndex].currBoneOffsetDQ.DoublePrecision();
+}
+
+void PerBoneUniforms::WriteBoneOffsetTransform(uint32_t chunkIndex, const DualQuaternionf& offsetDQ)
+{
+	m_singlePrecisionBoneData[chunkIndex].prevBoneOffsetDQ = m_singlePrecisionBoneData[chunkIndex].currBoneOffsetDQ;
+	m_singlePrecisionBoneData[chunkIndex].currBoneOffsetDQ = offsetDQ;
+}
+
+void PerBoneUniforms::SetBonesDirty(const std::vector<uint32_t>& chunkIndices)
+{
+	for (auto chunkIndex : chunkIndices)
+		SetChunkDirty(chunkIndex);
 }
 
 void PerBoneUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
-	m_singlePrecisionBoneData[index].currBoneOffsetDQ = m_boneData[index].currBoneOffsetDQ.SinglePrecision();
-	m_singlePrecisionBoneData[index].prevBoneOffsetDQ = m_boneData[index].prevBoneOffsetDQ.SinglePrecision();
 }
 
 std::vector<UniformVarList> PerBoneUniforms::PrepareUniformVarList() const
@@ -207,9 +207,7 @@ public:
 	* DESCRIPTION: Planet Rendering Settings
 	*
 	* X: The ratio in planet radius that transition between rendering raw vertices to normalized spherical vertices
-	* Y: Reserved
-	* Z: Reserved
-	* W: Reserved
+	* YZW: Offset from camera to planet rebase origin, planet triangles are stored relative to that origin
 	*/
 	Vector4<T>	PlanetRenderingSettings;
 
@@ -370,6 +368,8 @@ public:
 
 	void SetPlanetSphericalTransitionRatio(double ratio);
 	double GetPlanetSphericalTransitionRatio() const { return m_globalVariables.PlanetRenderingSettings.x; }
+	void SetPlanetRebaseOffset(const Vector3d& offset);
+	Vector3d GetPlanetRebaseOffset() const { return { m_globalVariables.PlanetRenderingSettings.y, m_globalVariables.PlanetRenderingSettings.z, m_globalVariables.PlanetRenderingSettings.w }; }
 
 public:
 	bool Init(const std::shared_ptr<GlobalUniforms>& pSelf);
@@ -401,6 +401,7 @@ public:
 
 class BoneIndirectUniform;
 
+// Bone data is only kept in float, the same as it's uploaded, there's no double copy to convert from
 class PerBoneUniforms : public ChunkBasedUniforms
 {
 protected:
@@ -417,16 +418,23 @@ protected:
 	void SetBoneOffsetTransform(uint32_t chunkIndex, const DualQuaterniond& offsetDQ);
 	DualQuaterniond GetBoneOffsetTransform(uint32_t chunkIndex) const;
 
+	// Same as "SetBoneOffsetTransform" without marking chunk dirty, so that different chunks could be written from different threads
+	// Written chunks are marked dirty afterwards with "SetBonesDirty" on one thread
+	void WriteBoneOffsetTransform(uint32_t chunkIndex, const DualQuaterniond& offsetDQ) { WriteBoneOffsetTransform(chunkIndex, offsetDQ.SinglePrecision()); }
+	void WriteBoneOffsetTransform(uint32_t chunkIndex, const DualQuaternionf& offsetDQ);
+	void SetBonesDirty(const std::vector<uint32_t>& chunkIndices);
+
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_singlePrecisionBoneData[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_singlePrecisionBoneData); }
+	void AllocatePages(uint32_t pageCount) override { m_singlePrecisionBoneData.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_singlePrecisionBoneData.GetPage(pageIndex); }
 
 protected:
-	BoneData<double>	m_boneData[MAXIMUM_OBJECTS];
-	BoneData<float>		m_singlePrecisionBoneData[MAXIMUM_OBJECTS];
+	ChunkPages<BoneData<float>>		m_singlePrecisionBoneData;
 
 	friend class BoneIndirectUniform;
+	friend class AnimationController;
+	friend class SkinningManager;
 };
 
 class Mesh;
@@ -456,6 +464,8 @@ public:
 	bool GetBoneCount(uint32_t chunkIndex, uint32_t& outBoneCount) const;
 
 	std::size_t GetBoneHashCode(uint32_t chunkIndex, uint32_t index) const;
+	// Where data of a bone is located in bone buffer
+	uint32_t GetBoneChunkIndex(uint32_t chunkIndex, uint32_t boneIndex) const { return m_boneChunkIndex[chunkIndex + boneIndex]; }
 
 	// Disable the visibility of these access functions, since meshChunkIndex is something internal only within mesh
 	// Let specific mesh to deal with these functions and make wrappers of them
@@ -474,11 +484,11 @@ public:
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_boneChunkIndex[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_boneChunkIndex); }
+	void AllocatePages(uint32_t pageCount) override { m_boneChunkIndex.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_boneChunkIndex.GetPage(pageIndex); }
 
 protected:
-	uint32_t									m_boneChunkIndex[MAXIMUM_OBJECTS];
+	ChunkPages<uint32_t>						m_boneChunkIndex;
 	// index stands for instance chunk index of a set of bones
 	std::unordered_map<uint32_t, BoneIndexLookupTable>	m_boneIndexLookupTables;
 
@@ -512,11 +522,11 @@ protected:
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_meshData[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_meshData); }
+	void AllocatePages(uint32_t pageCount) override { m_meshData.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_meshData.GetPage(pageIndex); }
 
 protected:
-	MeshData	m_meshData[MAXIMUM_OBJECTS];
+	ChunkPages<MeshData>	m_meshData;
 
 	friend class Mesh;
 };
@@ -544,11 +554,11 @@ protected:
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_animationData[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_animationData); }
+	void AllocatePages(uint32_t pageCount) override { m_animationData.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_animationData.GetPage(pageIndex); }
 
 protected:
-	AnimationData	m_animationData[MAXIMUM_OBJECTS];
+	ChunkPages<AnimationData>	m_animationData;
 
 	friend class SkeletonAnimationInstance;
 };
\ No newline at end of file
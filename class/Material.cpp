@@ -38,6 +38,15 @@
 #include "RenderPassBase.h"
 #include "../vulkan/ComputePipeline.h"
 #include "Mesh.h"
+#include "GPUCullingManager.h"
+#include "PerObjectUniforms.h"
+#include "../common/Util.h"
+#include "../common/RadixSort.h"
+#include <algorithm>
+#include <cstring>
+
+const uint32_t Material::RENDER_QUEUE_INDEX_BITS;
+const uint32_t Material::RENDER_QUEUE_DISTANCE_BITS;
 
 void Material::GeneralInit
 (
@@ -183,9 +192,6 @@ void Material::GeneralInit
 	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
 	m_pUniformStorageDescriptorSet = m_pDescriptorPool->AllocateDescriptorSet(m_pDescriptorSetLayout);
 
-	m_descriptorSets = UniformData::GetInstance()->GetDescriptorSets();
-	m_descriptorSets.push_back(m_pUniformStorageDescriptorSet);
-
 	// Setup descriptor set
 	uint32_t bindingIndex = 0;
 	for (uint32_t i = 0; i < MaterialUniformStorageTypeCount; i++)
@@ -193,17 +199,63 @@ void Material::GeneralInit
 		bindingIndex = m_materialUniforms[i]->SetupDescriptorSet(m_pUniformStorageDescriptorSet, bindingIndex);
 	}
 
+	UpdateCachedDescriptorSets();
+}
+
+void Material::UpdateCachedDescriptorSets()
+{
+	m_descriptorSets = UniformData::GetInstance()->GetDescriptorSets();
+	m_descriptorSets.push_back(m_pUniformStorageDescriptorSet);
+
 	// Setup cached frame offsets
 	m_cachedFrameOffsets = UniformData::GetInstance()->GetCachedFrameOffsets();
 
 	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
 	{
-		std::vector<uint32_t> offsets;
 		for (uint32_t i = 0; i < MaterialUniformStorageTypeCount; i++)
 		{
 			m_cachedFrameOffsets[frameIndex].push_back(m_materialUniforms[i]->GetFrameOffset() * frameIndex);
 		}
 	}
+
+	m_uniformDataDescriptorSetVersion = UniformData::GetInstance()->GetDescriptorSetVersion();
+
+	m_cachedBufferVersions.clear();
+	for (uint32_t i = 0; i < MaterialUniformStorageTypeCount; i++)
+		m_cachedBufferVersions.push_back(m_materialUniforms[i]->GetBufferVersion());
+}
+
+void Material::RefreshDescriptorSets()
+{
+	bool bufferChanged = false;
+	for (uint32_t i = 0; i < MaterialUniformStorageTypeCount; i++)
+		bufferChanged |= m_cachedBufferVersions[i] != m_materialUniforms[i]->GetBufferVersion();
+
+	if (!bufferChanged && m_uniformDataDescriptorSetVersion == UniformData::GetInstance()->GetDescriptorSetVersion())
+		return;
+
+	if (bufferChanged)
+	{
+		// Frames in flight still use current set, so a new one is made of it, from a new pool since current one could be full
+		// Old set keeps old pool alive until it's released
+		FrameMgr()->RetireResource(m_pUniformStorageDescriptorSet);
+
+		m_pDescriptorPool = DescriptorPool::Create(GetDevice(), m_pDescriptorPool->GetDescriptorSetLayoutBinding());
+		std::shared_ptr<DescriptorSet> pDescriptorSet = m_pDescriptorPool->AllocateDescriptorSet(m_pDescriptorSetLayout);
+
+		// Textures and anything else bound by subclasses are carried over, and storages are bound again
+		pDescriptorSet->CopyDescriptors(m_pUniformStorageDescriptorSet);
+
+		uint32_t bindingIndex = 0;
+		for (uint32_t i = 0; i < MaterialUniformStorageTypeCount; i++)
+		{
+			bindingIndex = m_materialUniforms[i]->SetupDescriptorSet(pDescriptorSet, bindingIndex);
+		}
+
+		m_pUniformStorageDescriptorSet = pDescriptorSet;
+	}
+
+	UpdateCachedDescriptorSets();
 }
 
 bool Material::Init
@@ -257,12 +309,13 @@ bool Material::Init
 	{
 		for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 		{
-			m_indirectBuffers.push_back(SharedIndirectBuffer::Create(GetDevice(), sizeof(VkDrawIndirectCommand) * MAX_INDIRECT_COUNT));
+			m_indirectBuffers.push_back(SharedIndirectBuffer::Create(GetDevice(), sizeof(VkDrawIndexedIndirectCommand) * MAX_INDIRECT_COUNT));
 		}
 
 		for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 		{
-			m_indirectCmdCountBuffers.push_back(SharedIndirectBuffer::Create(GetDevice(), sizeof(uint32_t)));
+			// Draw count, followed by candidate draw count that GPU culling reads
+			m_indirectCmdCountBuffers.push_back(SharedIndirectBuffer::Create(GetDevice(), sizeof(uint32_t) * 2));
 		}
 	}
 
@@ -395,43 +448,120 @@ uint32_t Material::GetUniformBufferSize() const
 
 void Material::SyncBufferData()
 {
-	if (m_indirectBuffers.size() > 0)
+	if (m_isGPUCullingEnabled)
+		SyncCandidateDraws();
+	else if (m_indirectBuffers.size() > 0)
 	{
-		uint32_t drawID = 0;
-		uint32_t offset = 0;
+		BuildRenderQueue(m_pPerMaterialIndirectUniforms);
+
 		VkDrawIndexedIndirectCommand cmd;
 
 		// Contruct indirect buffer for current frame
-		for each(auto& meshRenderData in m_cachedMeshRenderData)
+		for (uint32_t drawID = 0; drawID < (uint32_t)m_renderQueueDraws.size(); drawID++)
 		{
+			const RenderQueueDraw& draw = m_renderQueueDraws[drawID];
+
 			// Prepare mesh indirect data
-			meshRenderData.pMesh->PrepareIndirectCmd(cmd);
-			cmd.instanceCount = meshRenderData.instanceCount;
-			cmd.firstInstance = meshRenderData.instanceDataOffset;
+			draw.pMesh->PrepareIndirectCmd(cmd);
+			cmd.instanceCount = draw.instanceCount;
+			cmd.firstInstance = draw.firstInstance;
 			m_indirectBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmd(drawID, cmd);
 
 			// Prepare indirect offset
-			m_pPerMaterialIndirectOffset->SetIndirectOffset(drawID, offset);
-
-			// Prepare indirect indices for all data
-			for (uint32_t instanceCount = 0; instanceCount < meshRenderData.indirectIndices.size(); instanceCount++)
-			{
-				m_pPerMaterialIndirectUniforms->SetPerObjectIndex(offset, meshRenderData.indirectIndices[instanceCount].perObjectIndex);
-				m_pPerMaterialIndirectUniforms->SetPerMaterialIndex(offset, meshRenderData.indirectIndices[instanceCount].perMaterialIndex);
-				m_pPerMaterialIndirectUniforms->SetPerMeshIndex(offset, meshRenderData.indirectIndices[instanceCount].perMeshIndex);
-				m_pPerMaterialIndirectUniforms->SetPerAnimationIndex(offset, meshRenderData.indirectIndices[instanceCount].perAnimationIndex);
-				offset++;
-			}
-
-			drawID++;
+			m_pPerMaterialIndirectOffset->SetIndirectOffset(drawID, draw.indirectOffset);
 		}
 
-		m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmdCount((uint32_t)m_cachedMeshRenderData.size());
+		m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmdCount((uint32_t)m_renderQueueDraws.size());
 	}
 
 	for (auto & var : m_materialUniforms)
 		if (var != nullptr)
 			var->SyncBufferData();
+
+	if (m_isGPUCullingEnabled)
+	{
+		m_pCandidateIndirectUniforms->SyncBufferData();
+		m_pCandidateDrawUniforms->SyncBufferData();
+	}
+
+	RefreshDescriptorSets();
+}
+
+// Same as indirect data built above, except that it's only candidates, culling shader decides what's really drawn
+void Material::SyncCandidateDraws()
+{
+	uint32_t frameIndex = FrameMgr()->FrameIndex();
+	uint32_t offset = BuildRenderQueue(m_pCandidateIndirectUniforms);
+	uint32_t drawCount = (uint32_t)m_renderQueueDraws.size();
+
+	// Culled draws are written by draw id as well
+	ASSERTION(drawCount <= MAX_INDIRECT_COUNT);
+
+	// Growing storage gets prebaked commands recorded again, with a dispatch that covers all draws
+	m_pCandidateDrawUniforms->EnsureChunkCapacity(drawCount);
+
+	CandidateDraw draw;
+	for (uint32_t i = 0; i < drawCount; i++)
+	{
+		const RenderQueueDraw& renderQueueDraw = m_renderQueueDraws[i];
+
+		renderQueueDraw.pMesh->PrepareIndirectCmd(draw.cmd);
+		draw.cmd.instanceCount = renderQueueDraw.instanceCount;
+		draw.cmd.firstInstance = renderQueueDraw.firstInstance;
+
+		draw.candidateOffset = renderQueueDraw.indirectOffset;
+		draw.candidateCount = renderQueueDraw.indirectCount;
+		draw.reserved = 0;
+
+		if (renderQueueDraw.cullable)
+		{
+			Vector3f center = renderQueueDraw.pMesh->GetBoundingSphereCenter();
+			draw.boundingSphere = { center.x, center.y, center.z, renderQueueDraw.pMesh->GetBoundingSphereRadius() };
+		}
+		else
+			draw.boundingSphere = { 0, 0, 0, -1 };
+
+		m_pCandidateDrawUniforms->SetCandidateDraw(i, draw);
+	}
+
+	// Culling shader counts survivors up from zero, and skips candidates beyond draw count, which are left from earlier frames
+	uint32_t drawCounts[2] = { 0, drawCount };
+	m_indirectCmdCountBuffers[frameIndex]->UpdateByteStream(drawCounts, 0, sizeof(drawCounts));
+
+	// Culling shader writes indirect data of survivors, so there has to be room for all candidates
+	m_pPerMaterialIndirectOffset->EnsureChunkCapacity(drawCount);
+	m_pPerMaterialIndirectUniforms->EnsureChunkCapacity(offset);
+}
+
+bool Material::EnableGPUCulling(uint32_t cullingFrustum)
+{
+	if (m_isGPUCullingEnabled)
+		return true;
+
+	if (m_indirectBuffers.size() == 0 || !GPUCullingManager::GetInstance()->IsSupported())
+		return false;
+
+	m_pCandidateIndirectUniforms = PerMaterialIndirectUniforms::Create();
+	m_pCandidateDrawUniforms = CandidateDrawUniforms::Create();
+
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		std::shared_ptr<DescriptorSet> pDescriptorSet = GPUCullingManager::GetInstance()->AllocateDescriptorSet();
+		m_pCandidateDrawUniforms->SetupDescriptorSet(pDescriptorSet, GPUCullingManager::CullingBinding_CandidateDraws);
+		m_pPerMaterialIndirectOffset->SetupDescriptorSet(pDescriptorSet, GPUCullingManager::CullingBinding_IndirectOffsets);
+		m_pPerMaterialIndirectUniforms->SetupDescriptorSet(pDescriptorSet, GPUCullingManager::CullingBinding_IndirectIndices);
+		m_pCandidateIndirectUniforms->SetupDescriptorSet(pDescriptorSet, GPUCullingManager::CullingBinding_CandidateIndices);
+		pDescriptorSet->UpdateIndirectBuffer(GPUCullingManager::CullingBinding_CulledDraws, m_indirectBuffers[i]);
+		pDescriptorSet->UpdateIndirectBuffer(GPUCullingManager::CullingBinding_CulledDrawCount, m_indirectCmdCountBuffers[i]);
+
+		m_cullingDescriptorSets.push_back(pDescriptorSet);
+		m_cullingBufferVersions.push_back(GetCullingBufferVersion());
+	}
+
+	m_cullingFrustum = cullingFrustum;
+	m_isGPUCullingEnabled = true;
+
+	return true;
 }
 
 void Material::BindPipeline(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
@@ -459,48 +589,119 @@ void Material::BindMeshData(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
 	pCmdBuffer->BindIndexBuffer(IndexBufferMgr()->GetBuffer(), VK_INDEX_TYPE_UINT32);
 }
 
-void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t perAnimationIndex, uint32_t instanceCount, uint32_t startInstance)
+void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t perAnimationIndex, uint32_t instanceCount, uint32_t startInstance, bool cullable)
 {
 	ASSERTION(instanceCount > 0);
 
-	auto iter = m_perFrameMeshRefTable.find(pMesh);
-
 	// Instance count greater than 1 means manually instanced rendering
 	bool manualInstance = instanceCount > 1;
 
-	// If a mesh is not yet added to ref table of current frame
-	if (iter == m_perFrameMeshRefTable.end() || manualInstance)
+	// Positive floats keep their order as bits, so top bits of squared distance are good enough for near to far
+	float distance = UniformData::GetInstance()->GetPerObjectUniforms()->GetCameraDistanceSquared(perObjectIndex);
+	uint32_t distanceBits;
+	memcpy(&distanceBits, &distance, sizeof(float));
+
+	uint64_t sortKey = (uint64_t)pMesh->GetMeshID() << (RENDER_QUEUE_DISTANCE_BITS + 1 + RENDER_QUEUE_INDEX_BITS);
+	sortKey |= (uint64_t)manualInstance << (RENDER_QUEUE_DISTANCE_BITS + RENDER_QUEUE_INDEX_BITS);
+	sortKey |= (uint64_t)(distanceBits >> (31 - RENDER_QUEUE_DISTANCE_BITS)) << RENDER_QUEUE_INDEX_BITS;
+
+	m_renderQueueItems.push_back({ pMesh.get(), { perObjectIndex, perMaterialIndex, perMeshIndex, perAnimationIndex }, instanceCount, startInstance, cullable, sortKey });
+}
+
+uint32_t Material::BuildRenderQueue(const std::shared_ptr<PerMaterialIndirectUniforms>& pIndirectUniforms)
+{
+	uint32_t itemCount = (uint32_t)m_renderQueueItems.size();
+	uint32_t batchSize = 1 << RENDER_QUEUE_INDEX_BITS;
+
+	m_renderQueueDraws.clear();
+	uint32_t offset = 0;
+
+	// Indirect indices of batches are contiguous, so a draw could still continue into next batch
+	for (uint32_t batchStart = 0; batchStart < itemCount; batchStart += batchSize)
 	{
-		// First all the info into cached mesh render data
-		m_cachedMeshRenderData.push_back
-		(
+		uint32_t batchCount = std::min(itemCount - batchStart, batchSize);
+
+		m_renderQueueKeys.resize(batchCount);
+		for (uint32_t i = 0; i < batchCount; i++)
+			m_renderQueueKeys[i] = m_renderQueueItems[batchStart + i].sortKey | i;
+
+		// Item indices are unique, no need to sort by them
+		RadixSort(m_renderQueueKeys, m_sortScratch, RENDER_QUEUE_INDEX_BITS);
+
+		// Auto instanced items of a mesh are adjacent after sorting, and become one draw, while each manually instanced item is a draw on its own
+		for (uint32_t i = 0; i < batchCount; i++)
+		{
+			const RenderQueueItem& item = m_renderQueueItems[batchStart + (uint32_t)(m_renderQueueKeys[i] & (batchSize - 1))];
+			bool manualInstance = item.instanceCount > 1;
+
+			// Mesh is compared as well, since IDs wrap around once 2^32 meshes have been created
+			if (m_renderQueueDraws.size() == 0 || manualInstance || m_renderQueueDraws.back().manualInstance || m_renderQueueDraws.back().pMesh != item.pMesh)
 			{
-				pMesh,
-				instanceCount,
-				startInstance,
-				std::vector<PerMaterialIndirectVariables>(1, {perObjectIndex, perMaterialIndex, perMeshIndex, perAnimationIndex})
+				m_renderQueueDraws.push_back
+				(
+					{
+						item.pMesh,
+						item.instanceCount,
+						item.startInstance,
+						offset,
+						0,
+						manualInstance,
+						item.cullable && !manualInstance && item.pMesh->HasBounds()
+					}
+				);
+			}
+			else
+			{
+				m_renderQueueDraws.back().instanceCount += 1;
+				m_renderQueueDraws.back().cullable = m_renderQueueDraws.back().cullable && item.cullable;
 			}
-		);
 
-		// Then add mesh to ref table, as well as its index in render data table
-		// Ref table is only updated when auto instanced rendering is enabled
-		// Or there's no need to search this mesh and add it to instance count
-		// NOTE: Only add to ref table if it's not manual instanced rendering
-		if (!manualInstance)
-			m_perFrameMeshRefTable[pMesh] = (uint32_t)m_cachedMeshRenderData.size() - 1;
+			m_renderQueueDraws.back().indirectCount++;
 
-		return;
+			pIndirectUniforms->SetPerObjectIndex(offset, item.indirectIndices.perObjectIndex);
+			pIndirectUniforms->SetPerMaterialIndex(offset, item.indirectIndices.perMaterialIndex);
+			pIndirectUniforms->SetPerMeshIndex(offset, item.indirectIndices.perMeshIndex);
+			pIndirectUniforms->SetPerAnimationIndex(offset, item.indirectIndices.perAnimationIndex);
+			offset++;
+		}
 	}
 
-	// If a mesh is already recorded, add instance count by 1
-	auto& renderData = m_cachedMeshRenderData[iter->second];
-	renderData.instanceCount += 1;
-	renderData.indirectIndices.push_back({ perObjectIndex, perMaterialIndex, perMeshIndex, perAnimationIndex });
+	return offset;
 }
 
 void Material::BeforeRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong)
 {
-	AttachResourceBarriers(pCmdBuf, pingpong);
+	if (m_isGPUCullingEnabled)
+	{
+		uint32_t frameIndex = FrameMgr()->FrameIndex();
+
+		// Culling sets are per frame, and GPU is done with this frame's one, so it's rewritten in place once storages grow
+		if (m_cullingBufferVersions[frameIndex] != GetCullingBufferVersion())
+		{
+			m_pCandidateDrawUniforms->SetupDescriptorSet(m_cullingDescriptorSets[frameIndex], GPUCullingManager::CullingBinding_CandidateDraws);
+			m_pPerMaterialIndirectOffset->SetupDescriptorSet(m_cullingDescriptorSets[frameIndex], GPUCullingManager::CullingBinding_IndirectOffsets);
+			m_pPerMaterialIndirectUniforms->SetupDescriptorSet(m_cullingDescriptorSets[frameIndex], GPUCullingManager::CullingBinding_IndirectIndices);
+			m_pCandidateIndirectUniforms->SetupDescriptorSet(m_cullingDescriptorSets[frameIndex], GPUCullingManager::CullingBinding_CandidateIndices);
+			m_cullingBufferVersions[frameIndex] = GetCullingBufferVersion();
+		}
+
+		GPUCullingManager::GetInstance()->Dispatch
+		(
+			pCmdBuf,
+			m_cullingDescriptorSets[frameIndex],
+			{
+				m_pCandidateDrawUniforms->GetFrameOffset() * frameIndex,
+				m_pPerMaterialIndirectOffset->GetFrameOffset() * frameIndex,
+				m_pPerMaterialIndirectUniforms->GetFrameOffset() * frameIndex,
+				m_pCandidateIndirectUniforms->GetFrameOffset() * frameIndex
+			},
+			m_cullingFrustum,
+			m_pCandidateDrawUniforms->GetChunkCapacity()
+		);
+	}
+
+	if (!m_externalResourceBarriers)
+		AttachResourceBarriers(pCmdBuf, pingpong);
 }
 
 void Material::AfterRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong)
@@ -546,7 +747,10 @@ void Material::DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const
 	if (m_indirectBuffers.size() == 0)
 		return;
 
-	std::shared_ptr<CommandBuffer> pSecondaryCmd = MainThreadPerFrameRes()->AllocatePersistantSecondaryCommandBuffer();
+	if (ExecutePreparedCmd(pCmdBuf, pFrameBuffer))
+		return;
+
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = AllocateSecondaryCmd();
 
 	pSecondaryCmd->StartSecondaryRecording(m_pRenderPass->GetRenderPass(), m_pGraphicPipeline->GetInfo().subpass, pFrameBuffer);
 
@@ -556,12 +760,15 @@ void Material::DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const
 
 	pSecondaryCmd->EndSecondaryRecording();
 
-	pCmdBuf->Execute({ pSecondaryCmd });
+	ExecuteSecondaryCmd(pCmdBuf, pSecondaryCmd, pFrameBuffer);
 }
 
 void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
 {
-	std::shared_ptr<CommandBuffer> pSecondaryCmd = MainThreadPerFrameRes()->AllocatePersistantSecondaryCommandBuffer();
+	if (ExecutePreparedCmd(pCmdBuf, pFrameBuffer))
+		return;
+
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = AllocateSecondaryCmd();
 
 	pSecondaryCmd->StartSecondaryRecording(m_pRenderPass->GetRenderPass(), m_pGraphicPipeline->GetInfo().subpass, pFrameBuffer);
 
@@ -571,7 +778,56 @@ void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, con
 
 	pSecondaryCmd->EndSecondaryRecording();
 
-	pCmdBuf->Execute({ pSecondaryCmd });
+	ExecuteSecondaryCmd(pCmdBuf, pSecondaryCmd, pFrameBuffer);
+}
+
+void Material::PrepareDraw(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	m_pPreparingPerFrameRes = pPerFrameRes;
+	Draw(nullptr, pFrameBuffer, pingpong, overrideVP);
+	m_pPreparingPerFrameRes = nullptr;
+}
+
+void Material::PrepareDrawScreenQuad(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	m_pPreparingPerFrameRes = pPerFrameRes;
+	DrawScreenQuad(nullptr, pFrameBuffer, pingpong, overrideVP);
+	m_pPreparingPerFrameRes = nullptr;
+}
+
+std::shared_ptr<CommandBuffer> Material::AllocateSecondaryCmd() const
+{
+	if (m_pPreparingPerFrameRes != nullptr)
+		return m_pPreparingPerFrameRes->AllocatePersistantSecondaryCommandBuffer();
+
+	return MainThreadPerFrameRes()->AllocatePersistantSecondaryCommandBuffer();
+}
+
+bool Material::ExecutePreparedCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer)
+{
+	if (pCmdBuf == nullptr || m_pPreparedCmd == nullptr)
+		return false;
+
+	// Prepared for another target, it can't be used here
+	ASSERTION(m_pPreparedFrameBuffer == pFrameBuffer);
+
+	pCmdBuf->Execute({ m_pPreparedCmd });
+
+	m_pPreparedCmd = nullptr;
+	m_pPreparedFrameBuffer = nullptr;
+	return true;
+}
+
+void Material::ExecuteSecondaryCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<CommandBuffer>& pSecondaryCmd, const std::shared_ptr<FrameBuffer>& pFrameBuffer)
+{
+	if (pCmdBuf != nullptr)
+	{
+		pCmdBuf->Execute({ pSecondaryCmd });
+		return;
+	}
+
+	m_pPreparedCmd = pSecondaryCmd;
+	m_pPreparedFrameBuffer = pFrameBuffer;
 }
 
 void Material::OnFrameBegin()
@@ -580,11 +836,8 @@ void Material::OnFrameBegin()
 
 void Material::OnFrameEnd()
 {
-	//m_indirectIndex = 0;
-
-	// Clear tables that are used to construct indirect buffer of current frame
-	m_perFrameMeshRefTable.clear();
-	m_cachedMeshRenderData.clear();
+	// Render queue of current frame is done
+	m_renderQueueItems.clear();
 }
 
 void Material::SetPerObjectIndex(uint32_t indirectIndex, uint32_t perObjectIndex)
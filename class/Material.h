@@ -5,10 +5,10 @@
 #include "PerMaterialUniforms.h"
 #include "FrameBufferDiction.h"
 #include <map>
-#include  <unordered_map>
 #include "../common/Enums.h"
 #include "../Maths/Vector3.h"
 #include "PerMaterialIndirectUniforms.h"
+#include "GPUCullingManager.h"
 
 #include "../vulkan/Buffer.h"
 
@@ -28,6 +28,7 @@ class Image;
 class SharedIndirectBuffer;
 class FrameBuffer;
 class RenderPassBase;
+class PerFrameResource;
 
 // More to add
 enum MaterialVariableType
@@ -113,12 +114,26 @@ public:
 
 	virtual void SyncBufferData();
 
+	// Cull draws with compute shader before they're rendered, "cullingFrustum" is from FrustumCullingManager::CullingFrustum
+	// Returns false if material doesn't render indirectly, or culling shader isn't available
+	bool EnableGPUCulling(uint32_t cullingFrustum);
+	bool IsGPUCullingEnabled() const { return m_isGPUCullingEnabled; }
+
+	// Resource barriers could be handled outside, e.g. by a render graph that knows every access of the frame
+	void SetExternalResourceBarriers(bool externalResourceBarriers) { m_externalResourceBarriers = externalResourceBarriers; }
+
 	virtual void BeforeRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 
 	virtual void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) = 0;
 	virtual void DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 	virtual void DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 
+	// Record secondary command buffer of the next "Draw" or "DrawScreenQuad" ahead of time, allocated from "pPerFrameRes"
+	// The next call with the same frame buffer executes it instead of recording again
+	// Different materials could be prepared concurrently, as long as each thread uses its own per frame resource
+	void PrepareDraw(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
+	void PrepareDrawScreenQuad(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
+
 	virtual void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) = 0;
 	virtual void AfterRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 
@@ -135,6 +150,11 @@ protected:
 	virtual void PrepareSecondaryCmd(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 	virtual void CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0) {}
 
+	// Null "pCmdBuf" means it's being prepared, the recorded secondary command buffer is kept until next draw
+	std::shared_ptr<CommandBuffer> AllocateSecondaryCmd() const;
+	bool ExecutePreparedCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer);
+	void ExecuteSecondaryCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<CommandBuffer>& pSecondaryCmd, const std::shared_ptr<FrameBuffer>& pFrameBuffer);
+
 protected:
 	void GeneralInit
 	(
@@ -181,16 +201,47 @@ protected:
 	virtual void CustomizePoolSize(std::vector<uint32_t>& counts) {}
 
 	static uint32_t GetByteSize(std::vector<UniformVar>& UBOLayout);
-	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t perAnimationIndex, uint32_t instanceCount, uint32_t startInstance);
+	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t perAnimationIndex, uint32_t instanceCount, uint32_t startInstance, bool cullable);
+	// Sorts render queue of current frame and turns it into "m_renderQueueDraws", indices of each instance are written into "pIndirectUniforms"
+	// Returns count of indices written
+	uint32_t BuildRenderQueue(const std::shared_ptr<PerMaterialIndirectUniforms>& pIndirectUniforms);
+	void SyncCandidateDraws();
+
+	void UpdateCachedDescriptorSets();
+	void RefreshDescriptorSets();
+	// Changes whenever any storage bound to culling descriptor sets moves to another buffer
+	uint32_t GetCullingBufferVersion() const { return m_pPerMaterialIndirectOffset->GetBufferVersion() + m_pPerMaterialIndirectUniforms->GetBufferVersion() + m_pCandidateIndirectUniforms->GetBufferVersion() + m_pCandidateDrawUniforms->GetBufferVersion(); }
 
 protected:
-	typedef struct _MeshRenderData
+	// Sort key of a render queue item, from high bits to low: 32 bit mesh ID, whether it's manually instanced, squared camera distance and item index
+	// A material draws with one pipeline in one pass, so draws are grouped by mesh, and instances of a draw go from near to far
+	// Queues of more items than index bits could address are sorted in batches
+	static const uint32_t RENDER_QUEUE_INDEX_BITS = 20;
+	static const uint32_t RENDER_QUEUE_DISTANCE_BITS = 11;
+
+	typedef struct _RenderQueueItem
 	{
-		std::shared_ptr<Mesh>						pMesh;
-		uint32_t									instanceCount;
-		uint32_t									instanceDataOffset;
-		std::vector<PerMaterialIndirectVariables>	indirectIndices;
-	}MeshRenderData;
+		// Meshes are held by their renderers through the frame they're queued in
+		Mesh*							pMesh;
+		PerMaterialIndirectVariables	indirectIndices;
+		uint32_t						instanceCount;
+		uint32_t						startInstance;
+		bool							cullable;
+		// Without item index, it's added while queue is built
+		uint64_t						sortKey;
+	}RenderQueueItem;
+
+	typedef struct _RenderQueueDraw
+	{
+		Mesh*							pMesh;
+		uint32_t						instanceCount;
+		uint32_t						firstInstance;
+		// Range of indirect indices
+		uint32_t						indirectOffset;
+		uint32_t						indirectCount;
+		bool							manualInstance;
+		bool							cullable;	// False if any instance can't be culled
+	}RenderQueueDraw;
 
 	std::shared_ptr<RenderPassBase>						m_pRenderPass;
 
@@ -208,14 +259,19 @@ protected:
 	std::vector<std::shared_ptr<UniformDataStorage>>	m_materialUniforms;
 	std::vector<std::vector<uint32_t>>					m_cachedFrameOffsets;
 
+	// What descriptor sets above are made of, they're refreshed once uniform data or storages here move to other buffers
+	uint32_t											m_uniformDataDescriptorSetVersion = 0;
+	std::vector<uint32_t>								m_cachedBufferVersions;
+
 	std::shared_ptr<PerMaterialIndirectOffsetUniforms>	m_pPerMaterialIndirectOffset;
 	std::shared_ptr<PerMaterialIndirectUniforms>		m_pPerMaterialIndirectUniforms;
 	std::shared_ptr<PerMaterialUniforms>				m_pPerMaterialUniforms;
 
-	// key: mesh, value: mesh index at "m_cachedMeshRenderData"
-	std::unordered_map<std::shared_ptr<Mesh>, uint32_t>	m_perFrameMeshRefTable;
-
-	std::vector<MeshRenderData>							m_cachedMeshRenderData;
+	// Flat arrays of current frame, they're cleared rather than freed, so nothing is allocated once they're large enough
+	std::vector<RenderQueueItem>						m_renderQueueItems;
+	std::vector<uint64_t>								m_renderQueueKeys;
+	std::vector<uint64_t>								m_sortScratch;
+	std::vector<RenderQueueDraw>						m_renderQueueDraws;
 
 	bool												m_isScreenMaterial;
 
@@ -223,6 +279,21 @@ protected:
 
 	std::vector<std::shared_ptr<SharedIndirectBuffer>>	m_indirectBuffers;
 	std::vector<std::shared_ptr<SharedIndirectBuffer>>	m_indirectCmdCountBuffers;
+
+	// With GPU culling, CPU fills candidates, and culling shader fills indirect buffers and indirect uniforms above
+	bool												m_isGPUCullingEnabled = false;
+	uint32_t											m_cullingFrustum = 0;
+	std::shared_ptr<PerMaterialIndirectUniforms>		m_pCandidateIndirectUniforms;
+	std::shared_ptr<CandidateDrawUniforms>				m_pCandidateDrawUniforms;
+	std::vector<std::shared_ptr<DescriptorSet>>			m_cullingDescriptorSets;
+	std::vector<uint32_t>								m_cullingBufferVersions;
+
+	bool												m_externalResourceBarriers = false;
+
+	// Per frame resource of the thread preparing this material, only valid during "PrepareDraw"
+	std::shared_ptr<PerFrameResource>					m_pPreparingPerFrameRes;
+	std::shared_ptr<CommandBuffer>						m_pPreparedCmd;
+	std::shared_ptr<FrameBuffer>						m_pPreparedFrameBuffer;
 	
 	uint32_t											m_vertexFormat;
 	uint32_t											m_vertexFormatInMem;
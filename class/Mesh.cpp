@@ -5,12 +5,18 @@
 #include "../vulkan/CommandBuffer.h"
 #include "../Maths/AssimpDataConverter.h"
 #include "UniformData.h"
+#include "AssimpSceneReader.h"
+#include "CookedScene.h"
 #include "Importer.hpp"
 #include "postprocess.h"
 #include <string>
 #include "../common/Util.h"
 #include <codecvt>
 #include <locale>
+#include <cfloat>
+#include <cmath>
+
+std::atomic<uint32_t> Mesh::m_meshIDCount = { 0 };
 
 bool Mesh::Init
 (
@@ -28,6 +34,8 @@ bool Mesh::Init
 
 	m_pVertexBuffer = SharedVertexBuffer::Create(GetDevice(), m_verticesCount * m_vertexBytes, vertexFormat);
 	m_pVertexBuffer->UpdateByteStream(pVertices, 0, m_verticesCount * m_vertexBytes);
+
+	ComputeBounds(pVertices, verticesCount, vertexFormat);
 	m_pIndexBuffer = SharedIndexBuffer::Create(GetDevice(), indicesCount * GetIndexBytes(indexType), indexType);
 	m_pIndexBuffer->UpdateByteStream(pIndices, 0, indicesCount * GetIndexBytes(indexType));
 
@@ -51,11 +59,67 @@ std::shared_ptr<Mesh> Mesh::Create
 	return nullptr;
 }
 
+bool Mesh::InitSkinningTarget(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSkinnedMesh)
+{
+	if (!SelfRefBase<Mesh>::Init(pSelf))
+		return false;
+
+	m_vertexBytes = ::GetVertexBytes(VertexFormatPNCTCT);
+	m_verticesCount = pSkinnedMesh->m_verticesCount;
+	m_indicesCount = pSkinnedMesh->m_indicesCount;
+
+	m_pVertexBuffer = SharedVertexBuffer::Create(GetDevice(), m_verticesCount * m_vertexBytes, VertexFormatPNCTCT);
+	m_pIndexBuffer = pSkinnedMesh->m_pIndexBuffer;
+
+	m_meshBoneChunkIndexOffset = 0;
+	m_boneCount = 0;
+
+	m_hasBounds = pSkinnedMesh->m_hasBounds;
+	m_boundingBoxMin = pSkinnedMesh->m_boundingBoxMin;
+	m_boundingBoxMax = pSkinnedMesh->m_boundingBoxMax;
+	m_boundingSphereCenter = pSkinnedMesh->m_boundingSphereCenter;
+	m_boundingSphereRadius = pSkinnedMesh->m_boundingSphereRadius;
+
+	return m_pVertexBuffer != nullptr;
+}
+
+std::shared_ptr<Mesh> Mesh::CreateSkinningTarget(const std::shared_ptr<Mesh>& pSkinnedMesh)
+{
+	std::shared_ptr<Mesh> pRetMesh = std::make_shared<Mesh>();
+	if (pRetMesh.get() && pRetMesh->InitSkinningTarget(pRetMesh, pSkinnedMesh))
+		return pRetMesh;
+	return nullptr;
+}
+
+static_assert(sizeof(CookedScene::CookedBone) == sizeof(Mesh::BoneOffset), "Cooked bones are read as bone offsets");
+
+std::shared_ptr<Mesh> Mesh::Create(const std::shared_ptr<CookedScene>& pCookedScene, uint32_t meshIndex, uint32_t argumentedVertexFormat)
+{
+	ASSERTION(meshIndex < pCookedScene->GetMeshCount());
+
+	const CookedScene::CookedMesh& mesh = pCookedScene->GetMesh(meshIndex);
+	if (mesh.vertexFormat != argumentedVertexFormat && argumentedVertexFormat != 0)
+		return nullptr;
+	if (mesh.vertexBytes != ::GetVertexBytes(mesh.vertexFormat))
+		return nullptr;
+
+	// Mapped bytes go to staging buffer directly
+	return Create
+	(
+		pCookedScene->GetMeshVertices(meshIndex), mesh.verticesCount, mesh.vertexFormat,
+		pCookedScene->GetMeshIndices(meshIndex), mesh.indicesCount, VK_INDEX_TYPE_UINT32,
+		(const BoneOffset*)pCookedScene->GetMeshBones(meshIndex), mesh.boneCount
+	);
+}
+
 std::shared_ptr<Mesh> Mesh::Create(const std::string& filePath, uint32_t meshIndex, uint32_t argumentedVertexFormat)
 {
 	Assimp::Importer imp;
-	const aiScene* pScene = imp.ReadFile(filePath.c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
-	ASSERTION(pScene != nullptr);
+	const aiScene* pScene = nullptr;
+	std::shared_ptr<CookedScene> pCookedScene = AssimpSceneReader::AcquireCookedScene(filePath, AssimpSceneReader::MESH_IMPORT_FLAGS, imp, pScene);
+
+	if (pCookedScene != nullptr)
+		return Create(pCookedScene, meshIndex, argumentedVertexFormat);
 
 	return Create(pScene->mMeshes[meshIndex], argumentedVertexFormat);
 }
@@ -64,13 +128,14 @@ std::vector<std::shared_ptr<Mesh>> Mesh::CreateMeshes(const std::string& filePat
 {
 	Assimp::Importer imp;
 	const aiScene* pScene = nullptr;
-	pScene = imp.ReadFile(filePath.c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
-	ASSERTION(pScene != nullptr);
+	std::shared_ptr<CookedScene> pCookedScene = AssimpSceneReader::AcquireCookedScene(filePath, AssimpSceneReader::MESH_IMPORT_FLAGS, imp, pScene);
+
+	uint32_t meshCount = pCookedScene != nullptr ? pCookedScene->GetMeshCount() : pScene->mNumMeshes;
 
 	std::vector<std::shared_ptr<Mesh>> meshes;
-	for (uint32_t i = 0; i < (uint32_t)pScene->mNumMeshes; i++)
+	for (uint32_t i = 0; i < meshCount; i++)
 	{
-		std::shared_ptr<Mesh> pMesh = Create(pScene->mMeshes[i], argumentedVertexFormat);
+		std::shared_ptr<Mesh> pMesh = pCookedScene != nullptr ? Create(pCookedScene, i, argumentedVertexFormat) : Create(pScene->mMeshes[i], argumentedVertexFormat);
 		if (pMesh == nullptr)
 			return {};
 
@@ -79,51 +144,35 @@ std::vector<std::shared_ptr<Mesh>> Mesh::CreateMeshes(const std::string& filePat
 	return meshes;
 }
 
-std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat)
+uint32_t Mesh::GetVertexFormat(const aiMesh* pMesh)
 {
 	uint32_t vertexFormat = 0;
 
-	uint32_t vertexSize = 0;
 	if (pMesh->HasPositions())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFPosition);
-	}
 	if (pMesh->HasNormals())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFNormal);
-	}
 	//FIXME: hard-coded index 0 here, we don't have more than 1 color for now
 	if (pMesh->HasVertexColors(0))
-	{
-		vertexSize += 4 * sizeof(float);
 		vertexFormat |= (1 << VAFColor);
-	}
 	//FIXME: hard-coded index 0 here, we don't have more than 1 texture coord for now
 	if (pMesh->HasTextureCoords(0))
-	{
-		vertexSize += 2 * sizeof(float);
 		vertexFormat |= (1 << VAFTexCoord);
-	}
 	if (pMesh->HasTangentsAndBitangents())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFTangent);
-	}
 	if (pMesh->HasBones())
-	{
-		vertexSize += 4 * sizeof(float);	// Bone weight
-		vertexSize += 4 * sizeof(uint8_t);	// Bone index
 		vertexFormat |= (1 << VAFBone);
-	}
 
-	if (vertexFormat != argumentedVertexFormat && argumentedVertexFormat != 0)
-		return nullptr;
+	return vertexFormat;
+}
+
+void Mesh::ExtractMeshData(const aiMesh* pMesh, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, std::vector<BoneOffset>& bones)
+{
+	uint32_t vertexFormat = GetVertexFormat(pMesh);
+	uint32_t vertexSize = ::GetVertexBytes(vertexFormat);
 
-	float* pVertices = new float[pMesh->mNumVertices * vertexSize / sizeof(float)];
-	memset(pVertices, 0, pMesh->mNumVertices * vertexSize);
-	uint32_t verticesNumBytes = pMesh->mNumVertices * vertexSize;
+	vertices.assign(pMesh->mNumVertices * vertexSize, 0);
+	float* pVertices = (float*)vertices.data();
 	uint32_t count = 0;
 
 	for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
@@ -167,6 +216,7 @@ std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVerte
 		}
 	}
 
+	bones.clear();
 	if (vertexFormat & (1 << VAFBone))
 	{
 		uint32_t vertexSizeInFloats = vertexSize / sizeof(float);
@@ -189,51 +239,113 @@ std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVerte
 
 				pOffsets[vertexID]++;
 			}
+
+			bones.push_back
+			({
+				(uint64_t)std::hash<std::wstring>()(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(pMesh->mBones[i]->mName.C_Str())),
+				AssimpDataConverter::AcquireDualQuaternion(pMesh->mBones[i]->mOffsetMatrix)
+			});
 		}
 		delete[] pOffsets;
 	}
 
-	uint32_t* pIndices = new uint32_t[pMesh->mNumFaces * 3];
-	uint32_t indicesNumBytes = pMesh->mNumFaces * 3 * sizeof(uint32_t);
+	indices.resize(pMesh->mNumFaces * 3);
 	for (size_t i = 0; i < pMesh->mNumFaces; i++)
 	{
-		pIndices[i * 3] = pMesh->mFaces[i].mIndices[0];
-		pIndices[i * 3 + 1] = pMesh->mFaces[i].mIndices[1];
-		pIndices[i * 3 + 2] = pMesh->mFaces[i].mIndices[2];
+		indices[i * 3] = pMesh->mFaces[i].mIndices[0];
+		indices[i * 3 + 1] = pMesh->mFaces[i].mIndices[1];
+		indices[i * 3 + 2] = pMesh->mFaces[i].mIndices[2];
 	}
+}
 
+std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat)
+{
+	uint32_t vertexFormat = GetVertexFormat(pMesh);
+	if (vertexFormat != argumentedVertexFormat && argumentedVertexFormat != 0)
+		return nullptr;
+
+	std::vector<uint8_t> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<BoneOffset> bones;
+	ExtractMeshData(pMesh, vertices, indices, bones);
+
+	return Create
+	(
+		vertices.data(), pMesh->mNumVertices, vertexFormat,
+		indices.data(), (uint32_t)indices.size(), VK_INDEX_TYPE_UINT32,
+		bones.data(), (uint32_t)bones.size()
+	);
+}
+
+std::shared_ptr<Mesh> Mesh::Create
+(
+	const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
+	const void* pIndices, uint32_t indicesCount, VkIndexType indexType,
+	const BoneOffset* pBones, uint32_t boneCount
+)
+{
 	std::shared_ptr<Mesh> pRetMesh = std::make_shared<Mesh>();
 	if (pRetMesh.get() && pRetMesh->Init
 	(
 		pRetMesh,
-		pVertices, pMesh->mNumVertices, vertexFormat,
-		pIndices, pMesh->mNumFaces * 3, VK_INDEX_TYPE_UINT32
+		pVertices, verticesCount, vertexFormat,
+		pIndices, indicesCount, indexType
 	))
 	{
-		pRetMesh->m_boneCount = pMesh->mNumBones;
+		pRetMesh->m_boneCount = boneCount;
 
-		if (pMesh->mNumBones)
-			pRetMesh->m_meshBoneChunkIndexOffset = UniformData::GetInstance()->GetPerBoneIndirectUniforms()->AllocateConsecutiveChunks(pMesh->mNumBones);
+		if (boneCount)
+			pRetMesh->m_meshBoneChunkIndexOffset = UniformData::GetInstance()->GetPerBoneIndirectUniforms()->AllocateConsecutiveChunks(boneCount);
 
-		for (uint32_t i = 0; i < pMesh->mNumBones; i++)
-		{
-			DualQuaterniond dq = AssimpDataConverter::AcquireDualQuaternion(pMesh->mBones[i]->mOffsetMatrix);
-			UniformData::GetInstance()->GetPerBoneIndirectUniforms()->SetBoneTransform(pRetMesh->m_meshBoneChunkIndexOffset, std::hash<std::wstring>()(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(pMesh->mBones[i]->mName.C_Str())), dq);
-		}
+		for (uint32_t i = 0; i < boneCount; i++)
+			UniformData::GetInstance()->GetPerBoneIndirectUniforms()->SetBoneTransform(pRetMesh->m_meshBoneChunkIndexOffset, (std::size_t)pBones[i].nameHash, pBones[i].offsetDQ);
 
 		pRetMesh->m_meshChunkIndex = UniformData::GetInstance()->GetPerMeshUniforms()->AllocatePerObjectChunk();
 		UniformData::GetInstance()->GetPerMeshUniforms()->SetBoneChunkIndexOffset(pRetMesh->m_meshChunkIndex, pRetMesh->m_meshBoneChunkIndexOffset);
 
-		delete[] pVertices;
-		delete[] pIndices;
 		return pRetMesh;
 	}
 
-	delete[] pVertices;
-	delete[] pIndices;
 	return nullptr;
 }
 
+// Position always comes first in a vertex
+// Sphere is centered at box center, it's not the tightest, but good enough for culling and cheap to build
+void Mesh::ComputeBounds(const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat)
+{
+	m_hasBounds = false;
+
+	if (pVertices == nullptr || verticesCount == 0 || (vertexFormat & (1 << VAFPosition)) == 0)
+		return;
+
+	const uint8_t* pBytes = (const uint8_t*)pVertices;
+
+	m_boundingBoxMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	m_boundingBoxMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		const float* pPosition = (const float*)(pBytes + i * m_vertexBytes);
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			m_boundingBoxMin[j] = std::fmin(m_boundingBoxMin[j], pPosition[j]);
+			m_boundingBoxMax[j] = std::fmax(m_boundingBoxMax[j], pPosition[j]);
+		}
+	}
+
+	m_boundingSphereCenter = (m_boundingBoxMin + m_boundingBoxMax) * 0.5f;
+
+	float maxSquaredDistance = 0;
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		const float* pPosition = (const float*)(pBytes + i * m_vertexBytes);
+		Vector3f offset = Vector3f(pPosition[0], pPosition[1], pPosition[2]) - m_boundingSphereCenter;
+		maxSquaredDistance = std::fmax(maxSquaredDistance, offset.SquareLength());
+	}
+	m_boundingSphereRadius = std::sqrt(maxSquaredDistance);
+
+	m_hasBounds = true;
+}
+
 uint32_t Mesh::GetVertexFormat() const
 { 
 	return m_pVertexBuffer->GetVertexFormat();
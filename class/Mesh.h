@@ -1,26 +1,53 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../Maths/DualQuaternion.h"
 #include "../vulkan/DeviceObjectBase.h"
 #include <string>
+#include <atomic>
 #include "../common/Enums.h"
 #include "scene.h"
 
 class SharedVertexBuffer;
 class SharedIndexBuffer;
 class CommandBuffer;
+class CookedScene;
 
 class Mesh : public SelfRefBase<Mesh>
 {
+public:
+	typedef struct _BoneOffset
+	{
+		// Hash of bone name, as what animations refer to
+		uint64_t		nameHash;
+		DualQuaterniond	offsetDQ;
+	}BoneOffset;
+
 public:
 	static std::shared_ptr<Mesh> Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat = 0);
 	static std::shared_ptr<Mesh> Create(const std::string& filePath, uint32_t meshIndex, uint32_t argumentedVertexFormat = 0);
+	// Nullptr if vertex format doesn't match, the same as creating a mesh from assimp
+	static std::shared_ptr<Mesh> Create(const std::shared_ptr<CookedScene>& pCookedScene, uint32_t meshIndex, uint32_t argumentedVertexFormat = 0);
 	static std::vector<std::shared_ptr<Mesh>> CreateMeshes(const std::string& filePath, uint32_t argumentedVertexFormat = 0);
 	static std::shared_ptr<Mesh> Create
 	(
 		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
+	// Meshes from assimp, bones are in the same order as bone indices packed in vertices
+	static std::shared_ptr<Mesh> Create
+	(
+		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
+		const void* pIndices, uint32_t indicesCount, VkIndexType indexType,
+		const BoneOffset* pBones, uint32_t boneCount
+	);
+	// Shares indices and bounds of a skinned mesh, while vertices in "VertexFormatPNCTCT" are left to be filled by compute skinning
+	static std::shared_ptr<Mesh> CreateSkinningTarget(const std::shared_ptr<Mesh>& pSkinnedMesh);
+
+	// Vertex format an assimp mesh is created with
+	static uint32_t GetVertexFormat(const aiMesh* pMesh);
+	// Vertices interleaved exactly as their vertex format and indices, they're uploaded as they are
+	static void ExtractMeshData(const aiMesh* pMesh, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, std::vector<BoneOffset>& bones);
 
 public:
 	std::shared_ptr<SharedVertexBuffer> GetVertexBuffer() const { return m_pVertexBuffer; }
@@ -32,8 +59,17 @@ public:
 	uint32_t GetMeshBoneChunkIndexOffset() const { return m_meshBoneChunkIndexOffset; }
 	uint32_t ContainBoneData() const { return m_meshChunkIndex != -1; }
 	uint32_t GetBoneCount() const { return m_boneCount; }
+	// Unique among meshes created so far, render queues group draws by it
+	uint32_t GetMeshID() const { return m_meshID; }
 	void PrepareIndirectCmd(VkDrawIndexedIndirectCommand& cmd);
 
+	// Bounds in mesh space, from vertex positions, bind pose for skinned meshes
+	bool HasBounds() const { return m_hasBounds; }
+	Vector3f GetBoundingBoxMin() const { return m_boundingBoxMin; }
+	Vector3f GetBoundingBoxMax() const { return m_boundingBoxMax; }
+	Vector3f GetBoundingSphereCenter() const { return m_boundingSphereCenter; }
+	float GetBoundingSphereRadius() const { return m_boundingSphereRadius; }
+
 protected:
 	bool Init
 	(
@@ -42,6 +78,10 @@ protected:
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
 
+	bool InitSkinningTarget(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSkinnedMesh);
+
+	void ComputeBounds(const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat);
+
 protected:
 	std::shared_ptr<SharedVertexBuffer>	m_pVertexBuffer;
 	std::shared_ptr<SharedIndexBuffer>	m_pIndexBuffer;
@@ -51,4 +91,13 @@ protected:
 	uint32_t							m_meshChunkIndex = -1;
 	uint32_t							m_meshBoneChunkIndexOffset;
 	uint32_t							m_boneCount;
+
+	bool								m_hasBounds = false;
+	Vector3f							m_boundingBoxMin;
+	Vector3f							m_boundingBoxMax;
+	Vector3f							m_boundingSphereCenter;
+	float								m_boundingSphereRadius = 0;
+
+	uint32_t							m_meshID = m_meshIDCount++;
+	static std::atomic<uint32_t>		m_meshIDCount;
 };
\ No newline at end of file
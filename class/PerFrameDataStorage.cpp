@@ -3,8 +3,12 @@
 #include "../vulkan/UniformBuffer.h"
 #include "../vulkan/ShaderStorageBuffer.h"
 #include "../vulkan/StreamingBuffer.h"
+#include "../vulkan/FrameManager.h"
 #include "PerFrameDataStorage.h"
 
+uint32_t PerFrameDataStorage::m_resizeCount = 0;
+PerFrameDataStorage::UploadStatistics PerFrameDataStorage::m_uploadStatistics;
+
 bool PerFrameDataStorage::Init(const std::shared_ptr<PerFrameDataStorage>& pSelf, uint32_t numBytes, StorageType storageType)
 {
 	if (!SelfRefBase<PerFrameDataStorage>::Init(pSelf))
@@ -13,11 +17,19 @@ bool PerFrameDataStorage::Init(const std::shared_ptr<PerFrameDataStorage>& pSelf
 	m_pendingSync.resize(GetSwapChain()->GetSwapChainImageCount(), true);
 	m_pendingSyncCount = 0;
 
+	m_storageType = storageType;
+	CreateBuffer(numBytes);
+
+	return true;
+}
+
+void PerFrameDataStorage::CreateBuffer(uint32_t numBytes)
+{
 	uint32_t minAlign = (uint32_t)GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment;
 	m_frameOffset = numBytes / minAlign * minAlign + (numBytes % minAlign > 0 ? minAlign : 0);
 	uint32_t totalUniformBytes = m_frameOffset * GetSwapChain()->GetSwapChainImageCount();
 
-	switch (storageType)
+	switch (m_storageType)
 	{
 	case Uniform:
 		m_pBuffer = UniformBuffer::Create(GetDevice(), totalUniformBytes);
@@ -33,8 +45,19 @@ bool PerFrameDataStorage::Init(const std::shared_ptr<PerFrameDataStorage>& pSelf
 		ASSERTION(false);
 		break;
 	}
+}
 
-	return true;
+void PerFrameDataStorage::ResizeBuffer(uint32_t numBytes)
+{
+	// Frames in flight still read old buffer through old descriptor sets
+	FrameMgr()->RetireResource(m_pBuffer);
+
+	CreateBuffer(numBytes);
+
+	m_bufferVersion++;
+	m_resizeCount++;
+
+	SetDirty();
 }
 
 void PerFrameDataStorage::SyncBufferData()
@@ -55,12 +78,20 @@ void PerFrameDataStorage::SyncBufferDataInternal()
 	if (m_pendingSync[currentFrameIndex])
 		return;
 
-	GetBuffer()->UpdateByteStream(AcquireDataPtr(), currentFrameIndex * GetFrameOffset(), AcquireDataSize());
+	UploadBytes(AcquireDataPtr(), currentFrameIndex * GetFrameOffset(), AcquireDataSize());
 
 	m_pendingSync[currentFrameIndex] = true;
 	m_pendingSyncCount--;
 }
 
+void PerFrameDataStorage::UploadBytes(const void* pData, uint32_t offset, uint32_t numBytes)
+{
+	GetBuffer()->UpdateByteStream(pData, offset, numBytes);
+
+	m_uploadStatistics.uploadCount++;
+	m_uploadStatistics.uploadedBytes += numBytes;
+}
+
 void PerFrameDataStorage::SetDirty()
 {
 	m_pendingSyncCount = (uint32_t)m_pendingSync.size();
@@ -25,6 +25,15 @@ public:
 		StorageTypeCount
 	};
 
+	// Uploads of all storages since last reset, which is done once per frame before storages are synced
+	typedef struct _UploadStatistics
+	{
+		uint32_t	uploadCount = 0;
+		uint32_t	uploadedBytes = 0;
+		// Part of bytes above that's computed straight into mapped memory, without a copy in between
+		uint32_t	directBytes = 0;
+	}UploadStatistics;
+
 protected:
 	bool Init(const std::shared_ptr<PerFrameDataStorage>& pSelf, uint32_t numBytes, StorageType storageType);
 
@@ -33,6 +42,14 @@ public:
 	void SyncBufferData();
 	std::shared_ptr<BufferBase> GetBuffer() const;
 
+	// Bumped whenever this storage moves to a larger buffer, descriptor sets referring to it have to be refreshed then
+	uint32_t GetBufferVersion() const { return m_bufferVersion; }
+	// The same for all storages, commands recorded ahead have to be recorded again once it changes
+	static uint32_t GetResizeCount() { return m_resizeCount; }
+
+	static const UploadStatistics& GetUploadStatistics() { return m_uploadStatistics; }
+	static void ResetUploadStatistics() { m_uploadStatistics = {}; }
+
 protected:
 	virtual void UpdateUniformDataInternal() = 0;
 	virtual void SyncBufferDataInternal();
@@ -40,6 +57,12 @@ protected:
 	virtual const void* AcquireDataPtr() const = 0;
 	virtual uint32_t AcquireDataSize() const = 0;
 	void SetDirty();
+	// Writes bytes into buffer and counts them into upload statistics
+	void UploadBytes(const void* pData, uint32_t offset, uint32_t numBytes);
+
+	// Moves to a buffer of "numBytes" per frame, old buffer is retired rather than waited for, and data is synced to every frame again
+	void ResizeBuffer(uint32_t numBytes);
+	void CreateBuffer(uint32_t numBytes);
 
 protected:
 	std::shared_ptr<BufferBase>	m_pBuffer;
@@ -47,4 +70,8 @@ protected:
 	std::vector<bool>			m_pendingSync;
 	uint32_t					m_pendingSyncCount;
 	uint32_t					m_frameOffset;
+	uint32_t					m_bufferVersion = 0;
+
+	static uint32_t				m_resizeCount;
+	static UploadStatistics		m_uploadStatistics;
 };
\ No newline at end of file
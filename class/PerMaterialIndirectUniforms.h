@@ -30,7 +30,7 @@ public:
 	static std::shared_ptr<PerMaterialIndirectOffsetUniforms> Create();
 
 public:
-	void SetIndirectOffset(uint32_t drawID, uint32_t indirectOffset) { m_indirectOffsets[drawID].offset = indirectOffset; SetChunkDirty(drawID); }
+	void SetIndirectOffset(uint32_t drawID, uint32_t indirectOffset) { EnsureChunkCapacity(drawID + 1); m_indirectOffsets[drawID].offset = indirectOffset; SetChunkDirty(drawID); }
 	uint32_t GetIndirectOffset(uint32_t drawID) const { return m_indirectOffsets[drawID].offset; }
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
@@ -38,11 +38,11 @@ public:
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_indirectOffsets[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_indirectOffsets); }
+	void AllocatePages(uint32_t pageCount) override { m_indirectOffsets.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_indirectOffsets.GetPage(pageIndex); }
 
 protected:
-	IndirectOffset	m_indirectOffsets[MAXIMUM_OBJECTS];
+	ChunkPages<IndirectOffset>	m_indirectOffsets;
 };
 
 
@@ -53,13 +53,13 @@ public:
 	static std::shared_ptr<PerMaterialIndirectUniforms> Create();
 
 public:
-	void SetPerObjectIndex(uint32_t indirectIndex, uint32_t perObjectIndex) { m_perMaterialIndirectIndex[indirectIndex].perObjectIndex = perObjectIndex; SetChunkDirty(indirectIndex); }
+	void SetPerObjectIndex(uint32_t indirectIndex, uint32_t perObjectIndex) { EnsureChunkCapacity(indirectIndex + 1); m_perMaterialIndirectIndex[indirectIndex].perObjectIndex = perObjectIndex; SetChunkDirty(indirectIndex); }
 	uint32_t GetPerObjectIndex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].perObjectIndex; }
-	void SetPerMaterialIndex(uint32_t indirectIndex, uint32_t perMaterialIndex) { m_perMaterialIndirectIndex[indirectIndex].perMaterialIndex = perMaterialIndex; SetChunkDirty(indirectIndex); }
+	void SetPerMaterialIndex(uint32_t indirectIndex, uint32_t perMaterialIndex) { EnsureChunkCapacity(indirectIndex + 1); m_perMaterialIndirectIndex[indirectIndex].perMaterialIndex = perMaterialIndex; SetChunkDirty(indirectIndex); }
 	uint32_t GetPerMaterialIndex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].perMaterialIndex; }
-	void SetPerMeshIndex(uint32_t indirectIndex, uint32_t perMeshIndex) { m_perMaterialIndirectIndex[indirectIndex].perMeshIndex = perMeshIndex; SetChunkDirty(indirectIndex); }
+	void SetPerMeshIndex(uint32_t indirectIndex, uint32_t perMeshIndex) { EnsureChunkCapacity(indirectIndex + 1); m_perMaterialIndirectIndex[indirectIndex].perMeshIndex = perMeshIndex; SetChunkDirty(indirectIndex); }
 	uint32_t GetPerMeshIndex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].perMeshIndex; }
-	void SetPerAnimationIndex(uint32_t indirectIndex, uint32_t perAnimationIndex) { m_perMaterialIndirectIndex[indirectIndex].perAnimationIndex = perAnimationIndex; SetChunkDirty(indirectIndex); }
+	void SetPerAnimationIndex(uint32_t indirectIndex, uint32_t perAnimationIndex) { EnsureChunkCapacity(indirectIndex + 1); m_perMaterialIndirectIndex[indirectIndex].perAnimationIndex = perAnimationIndex; SetChunkDirty(indirectIndex); }
 	uint32_t GetPerAnimationindex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].perAnimationIndex; }
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
@@ -67,9 +67,9 @@ public:
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_perMaterialIndirectIndex[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_perMaterialIndirectIndex); }
+	void AllocatePages(uint32_t pageCount) override { m_perMaterialIndirectIndex.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_perMaterialIndirectIndex.GetPage(pageIndex); }
 
 protected:
-	PerMaterialIndirectVariables	m_perMaterialIndirectIndex[MAXIMUM_OBJECTS];
+	ChunkPages<PerMaterialIndirectVariables>	m_perMaterialIndirectIndex;
 };
\ No newline at end of file
@@ -13,17 +13,9 @@ bool PerMaterialUniforms::Init(const std::shared_ptr<PerMaterialUniforms>& pSelf
 	if (!ChunkBasedUniforms::Init(pSelf, numBytes))
 		return false;
 
-	m_pData = new uint8_t[GetFrameOffset()];
-	memset(m_pData, 0, GetFrameOffset());
-
 	return true;
 }
 
-PerMaterialUniforms::~PerMaterialUniforms()
-{
-	delete [] m_pData;
-}
-
 std::shared_ptr<PerMaterialUniforms> PerMaterialUniforms::Create(uint32_t numBytes)
 {
 	std::shared_ptr<PerMaterialUniforms> pPerMaterialUniforms = std::make_shared<PerMaterialUniforms>();
@@ -36,6 +28,12 @@ void PerMaterialUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
 }
 
+void PerMaterialUniforms::AllocatePages(uint32_t pageCount)
+{
+	while ((uint32_t)m_pages.size() < pageCount)
+		m_pages.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[PAGE_CHUNKS * m_perChunkBytes]()));
+}
+
 uint32_t PerMaterialUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
 {
 	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
@@ -10,7 +10,6 @@ class PerMaterialUniforms : public ChunkBasedUniforms
 {
 public:
 	static std::shared_ptr<PerMaterialUniforms> Create(uint32_t numBytes);
-	~PerMaterialUniforms();
 
 public:
 	std::vector<UniformVarList> PrepareUniformVarList() const override { return {}; }
@@ -19,13 +18,13 @@ public:
 	template <typename T>
 	void SetParameter(uint32_t parameterChunkIndex, uint32_t parameterOffset, T val)
 	{
-		// m_pData : GetFrameOffset()            GetFrameOffset()            GetFrameOffset()
-		//           =======================     =======================     =======================
-		//                                            |
-		//                              chunkIndex * m_perMaterialInstanceBytes
-		//                                               |
-		//                                              offset
-		memcpy_s(m_pData + parameterChunkIndex * m_perChunkBytes + parameterOffset, sizeof(val), &val, sizeof(val));
+		// m_pages : PAGE_CHUNKS * m_perChunkBytes     PAGE_CHUNKS * m_perChunkBytes
+		//           =============================     =============================
+		//                                                    |
+		//                              (chunkIndex % PAGE_CHUNKS) * m_perChunkBytes
+		//                                                       |
+		//                                                     offset
+		memcpy_s(AcquireChunkPtr(parameterChunkIndex) + parameterOffset, sizeof(val), &val, sizeof(val));
 		SetChunkDirty(parameterChunkIndex);
 	}
 
@@ -34,7 +33,7 @@ public:
 	{
 		//return m_pMaterial->GetParameter(bindingIndex, parameterIndex);
 		T ret;
-		memcpy_s(&ret, sizeof(ret), m_pData + parameterChunkIndex * m_perChunkBytes + parameterOffset, sizeof(T));
+		memcpy_s(&ret, sizeof(ret), AcquireChunkPtr(parameterChunkIndex) + parameterOffset, sizeof(T));
 		return ret;
 	}
 
@@ -42,9 +41,12 @@ protected:
 	bool Init(const std::shared_ptr<PerMaterialUniforms>& pSelf, uint32_t numBytes);
 
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return m_pData; }
-	uint32_t AcquireDataSize() const override { return GetFrameOffset(); }
+	void AllocatePages(uint32_t pageCount) override;
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return m_pages[pageIndex].get(); }
+
+	// Chunk size is only known at runtime, so pages are raw bytes
+	uint8_t* AcquireChunkPtr(uint32_t chunkIndex) const { return m_pages[chunkIndex / PAGE_CHUNKS].get() + (chunkIndex % PAGE_CHUNKS) * m_perChunkBytes; }
 
 protected:
-	uint8_t*	m_pData;
+	std::vector<std::unique_ptr<uint8_t[]>>	m_pages;
 };
\ No newline at end of file
@@ -25,37 +25,51 @@ std::shared_ptr<PerObjectUniforms> PerObjectUniforms::Create()
 
 void PerObjectUniforms::SetModelMatrix(uint32_t index, const Matrix4d& modelMatrix)
 {
-	m_perObjectVariables[index].prevMV =  m_perObjectVariables[index].MV;
-	m_perObjectVariables[index].MV = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix() * modelMatrix;
+	Vector3d cameraPosition = UniformData::GetInstance()->GetPerFrameUniforms()->GetCameraPosition();
+
+	m_perObjectStates[index].relativeModel = GetRelativeModelMatrix(modelMatrix, cameraPosition);
+
 	SetChunkDirty(index);
 }
 
-void PerObjectUniforms::UpdateDirtyChunkInternal(uint32_t index)
+float PerObjectUniforms::GetCameraDistanceSquared(uint32_t index) const
+{
+	const Matrix4f& relativeModel = m_perObjectStates[index].relativeModel;
+	return relativeModel.c30 * relativeModel.c30 + relativeModel.c31 * relativeModel.c31 + relativeModel.c32 * relativeModel.c32;
+}
+
+void PerObjectUniforms::UpdateUniformDataInternal()
 {
-	m_perObjectVariables[index].MVP = UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix();
-	m_perObjectVariables[index].prevMVP = m_perObjectVariables[index].MVP;
-	m_perObjectVariables[index].MV_Rotation_P = m_perObjectVariables[index].MVP;
-	m_perObjectVariables[index].prevMV_Rotation_P = m_perObjectVariables[index].MVP;
+	// View matrix is rotation times translation of minus camera position, the latter is already in relative model matrices
+	Matrix4d viewRotation = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix();
+	viewRotation.c30 = viewRotation.c31 = viewRotation.c32 = 0;
+	m_viewRotation = viewRotation.SinglePrecision();
 
+	m_projection = UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix().SinglePrecision();
 
-	m_perObjectVariables[index].MVP *= m_perObjectVariables[index].MV;
-	m_perObjectVariables[index].prevMVP *= m_perObjectVariables[index].prevMV;
+	ChunkBasedUniforms::UpdateUniformDataInternal();
+}
 
+void PerObjectUniforms::UpdateDirtyChunkInternal(uint32_t index)
+{
+	PerObjectState& state = m_perObjectStates[index];
+	state.prevMV = state.MV;
+	state.MV = m_viewRotation * state.relativeModel;
+}
 
-	Matrix4d temp = m_perObjectVariables[index].MV;
-	temp.c30 = temp.c31 = temp.c32 = 0;
-	m_perObjectVariables[index].MV_Rotation_P *= temp;
+void PerObjectUniforms::WriteChunks(uint32_t start, uint32_t end, uint8_t* pDst) const
+{
+	PerObjectVariablesf* pVariables = (PerObjectVariablesf*)pDst;
 
-	temp = m_perObjectVariables[index].prevMV;
-	temp.c30 = temp.c31 = temp.c32 = 0;
-	m_perObjectVariables[index].prevMV_Rotation_P *= temp;
+	PerObjectVariablesf variables;
+	for (uint32_t i = start; i < end; i++)
+	{
+		const PerObjectState& state = m_perObjectStates[i];
+		DerivePerObjectVariables(state.MV, state.prevMV, m_projection, variables);
 
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], MV);
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], MVP);
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], MV_Rotation_P);
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], prevMV);
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], prevMVP);
-	CONVERT2SINGLE(m_perObjectVariables[index], m_singlePrecisionPerObjectVariables[index], prevMV_Rotation_P);
+		// Written as a whole, mapped memory could be write combined
+		pVariables[i - start] = variables;
+	}
 }
 
 std::vector<UniformVarList> PerObjectUniforms::PrepareUniformVarList() const
@@ -2,27 +2,23 @@
 
 #include "../Maths/Matrix.h"
 #include "ChunkBasedUniforms.h"
+#include "PerObjectVariables.h"
 
 class DescriptorSet;
 
-template <typename T>
-class PerObjectVariables
-{
-public:
-	Matrix4x4<T> MV;
-	Matrix4x4<T> MVP;			// projection * view * model
-	Matrix4x4<T> MV_Rotation_P;	// Model view only has rotation, no translation
-
-	Matrix4x4<T> prevMV;
-	Matrix4x4<T> prevMVP;
-	Matrix4x4<T> prevMV_Rotation_P;
-};
-
-typedef PerObjectVariables<float> PerObjectVariablesf;
-typedef PerObjectVariables<double> PerObjectVariablesd;
-
+// Per object matrices are only kept in float
+// MV is made of model matrix relative to camera position, so that float isn't lost to large world translations,
+// and the rest of "PerObjectVariablesf" is derived from it while it's written straight into mapped memory of each frame region
 class PerObjectUniforms : public ChunkBasedUniforms
 {
+	typedef struct _PerObjectState
+	{
+		// Model matrix with camera position subtracted from its translation in double
+		Matrix4f	relativeModel;
+		Matrix4f	MV;
+		Matrix4f	prevMV;
+	}PerObjectState;
+
 protected:
 	bool Init(const std::shared_ptr<PerObjectUniforms>& pSelf);
 
@@ -31,20 +27,27 @@ public:
 
 public:
 	void SetModelMatrix(uint32_t index, const Matrix4d& modelMatrix);
-	Matrix4d GetMVMatrix(uint32_t index) const { return m_perObjectVariables[index].MV; }
-	Matrix4d GetMVP(uint32_t index) const { return m_perObjectVariables[index].MVP; }
+	Matrix4d GetMVMatrix(uint32_t index) const { return m_perObjectStates[index].MV.DoublePrecision(); }
+	Matrix4d GetMVP(uint32_t index) const { return (m_projection * m_perObjectStates[index].MV).DoublePrecision(); }
+	// From camera position the latest model matrix is set with
+	float GetCameraDistanceSquared(uint32_t index) const;
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
 
 protected:
+	void UpdateUniformDataInternal() override;
 	void UpdateDirtyChunkInternal(uint32_t index) override;
-	const void* AcquireDataPtr() const override { return &m_singlePrecisionPerObjectVariables[0]; }
-	uint32_t AcquireDataSize() const override { return sizeof(m_singlePrecisionPerObjectVariables); }
+	void AllocatePages(uint32_t pageCount) override { m_perObjectStates.AllocatePages(pageCount); }
+	const void* AcquirePageDataPtr(uint32_t pageIndex) const override { return nullptr; }
+
+	bool IsDirectWrite() const override { return true; }
+	void WriteChunks(uint32_t start, uint32_t end, uint8_t* pDst) const override;
 
 protected:
-	PerObjectVariablesd		m_perObjectVariables[MAXIMUM_OBJECTS];
-	PerObjectVariablesf		m_singlePrecisionPerObjectVariables[MAXIMUM_OBJECTS];
+	ChunkPages<PerObjectState>	m_perObjectStates;
 
-	std::vector<uint32_t>	m_dirtyChunks;
+	// Camera of the latest update
+	Matrix4f					m_viewRotation;
+	Matrix4f					m_projection;
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../Maths/Matrix.h"
+
+template <typename T>
+class PerObjectVariables
+{
+public:
+	Matrix4x4<T> MV;
+	Matrix4x4<T> MVP;			// projection * view * model
+	Matrix4x4<T> MV_Rotation_P;	// Model view only has rotation, no translation
+
+	Matrix4x4<T> prevMV;
+	Matrix4x4<T> prevMVP;
+	Matrix4x4<T> prevMV_Rotation_P;
+};
+
+typedef PerObjectVariables<float> PerObjectVariablesf;
+typedef PerObjectVariables<double> PerObjectVariablesd;
+
+// Camera position is subtracted from translation in double before it's narrowed, so that float isn't lost to large world translations
+inline Matrix4f GetRelativeModelMatrix(const Matrix4d& modelMatrix, const Vector3d& cameraPosition)
+{
+	Matrix4f relativeModel = modelMatrix.SinglePrecision();
+	relativeModel.c30 = (float)(modelMatrix.c30 - cameraPosition.x);
+	relativeModel.c31 = (float)(modelMatrix.c31 - cameraPosition.y);
+	relativeModel.c32 = (float)(modelMatrix.c32 - cameraPosition.z);
+	return relativeModel;
+}
+
+// Rest of variables are derived from model view matrices of this frame and the previous one
+inline void DerivePerObjectVariables(const Matrix4f& MV, const Matrix4f& prevMV, const Matrix4f& projection, PerObjectVariablesf& variables)
+{
+	variables.MV = MV;
+	variables.MVP = projection * MV;
+	variables.MV_Rotation_P = MV;
+	variables.MV_Rotation_P.c30 = variables.MV_Rotation_P.c31 = variables.MV_Rotation_P.c32 = 0;
+	variables.MV_Rotation_P = projection * variables.MV_Rotation_P;
+
+	variables.prevMV = prevMV;
+	variables.prevMVP = projection * prevMV;
+	variables.prevMV_Rotation_P = prevMV;
+	variables.prevMV_Rotation_P.c30 = variables.prevMV_Rotation_P.c31 = variables.prevMV_Rotation_P.c32 = 0;
+	variables.prevMV_Rotation_P = projection * variables.prevMV_Rotation_P;
+}
\ No newline at end of file
@@ -1,42 +1,160 @@
 #include "PlanetGeoDataManager.h"
 #include "FrameEventManager.h"
+#include "TransientDataAllocator.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/Buffer.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/PerFrameResource.h"
+#include "../common/Macros.h"
+#include <algorithm>
+#include <cstring>
+
+const uint32_t PlanetGeoDataManager::TRIANGLE_BYTES;
+const uint32_t PlanetGeoDataManager::TRIANGLE_BUDGET;
+const uint32_t PlanetGeoDataManager::INVALID_SLOT;
 
 bool PlanetGeoDataManager::Init()
 {
 	if (!Singleton<PlanetGeoDataManager>::Init())
 		return false;
 
-	// FIXME: Magic number
-	m_pBufferKey = PerFrameData::GetInstance()->AllocateBuffer(4 * 1024 * 1024);
+	VkBufferCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	info.size = TRIANGLE_BUDGET * TRIANGLE_BYTES;
+	m_pBuffer = Buffer::Create(GetDevice(), info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	m_slotData.resize(TRIANGLE_BUDGET * TRIANGLE_BYTES, 0);
+	m_slotUsed.resize(TRIANGLE_BUDGET, false);
+	m_slotDirty.resize(TRIANGLE_BUDGET, false);
 
 	FrameEventManager::GetInstance()->Register(m_pInstance);
 
-	return m_pBufferKey != nullptr;
+	return m_pBuffer != nullptr;
 }
 
-void* PlanetGeoDataManager::AcquireDataPtr(uint32_t& offsetInBytes) const
+uint32_t PlanetGeoDataManager::AllocateSlot()
 {
-	offsetInBytes = m_updatedSize;
-	return (uint8_t*)PerFrameData::GetInstance()->GetPerFrameBuffer(m_pBufferKey)->DataPtr() + m_updatedSize;
+	uint32_t slot = INVALID_SLOT;
+	while (!m_freeSlots.empty())
+	{
+		uint32_t freeSlot = m_freeSlots.top();
+		m_freeSlots.pop();
+
+		if (freeSlot < m_slotCount && !m_slotUsed[freeSlot])
+		{
+			slot = freeSlot;
+			break;
+		}
+	}
+
+	if (slot == INVALID_SLOT)
+	{
+		if (m_slotCount == TRIANGLE_BUDGET)
+			return INVALID_SLOT;
+		slot = m_slotCount++;
+	}
+
+	m_slotUsed[slot] = true;
+	m_usedSlotCount++;
+
+	return slot;
 }
 
-void PlanetGeoDataManager::FinishDataUpdate(uint32_t size)
+void PlanetGeoDataManager::FreeSlot(uint32_t slot)
 {
-	m_updatedSize += size;
-	PerFrameData::GetInstance()->GetPerFrameBuffer(m_pBufferKey)->SetDirty();
+	ASSERTION(m_slotUsed[slot]);
+
+	m_slotUsed[slot] = false;
+	m_usedSlotCount--;
+
+	// Trailing free slots are simply not drawn
+	if (slot == m_slotCount - 1)
+	{
+		while (m_slotCount > 0 && !m_slotUsed[m_slotCount - 1])
+			m_slotCount--;
+		return;
+	}
+
+	memset(m_slotData.data() + slot * TRIANGLE_BYTES, 0, TRIANGLE_BYTES);
+	m_freeSlots.push(slot);
+
+	MarkSlotDirty(slot);
 }
 
-std::shared_ptr<PerFrameBuffer> PlanetGeoDataManager::GetPerFrameBuffer() const
+void PlanetGeoDataManager::WriteSlot(uint32_t slot, const void* pTriangle)
 {
-	return PerFrameData::GetInstance()->GetPerFrameBuffer(m_pBufferKey);
+	ASSERTION(m_slotUsed[slot]);
+
+	memcpy(m_slotData.data() + slot * TRIANGLE_BYTES, pTriangle, TRIANGLE_BYTES);
+
+	MarkSlotDirty(slot);
 }
 
-void PlanetGeoDataManager::OnFrameBegin()
+void PlanetGeoDataManager::MarkSlotDirty(uint32_t slot)
+{
+	m_updatedBytes += TRIANGLE_BYTES;
+
+	// A slot could be freed and reused within a frame, it's uploaded once with what's written last
+	if (m_slotDirty[slot])
+		return;
+
+	m_slotDirty[slot] = true;
+	m_dirtySlots.push_back(slot);
+}
+
+std::shared_ptr<CommandBuffer> PlanetGeoDataManager::RecordUploads()
 {
+	if (m_dirtySlots.empty())
+		return nullptr;
+
+	// Adjacent slots are merged into one copy region
+	std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+	TransientDataAllocator::TransientAllocation allocation = TransientDataAllocator::GetInstance()->Allocate((uint32_t)m_dirtySlots.size() * TRIANGLE_BYTES);
+	if (allocation.pData == nullptr)
+		return nullptr;
+
+	std::vector<VkBufferCopy> regions;
+	for (uint32_t i = 0; i < (uint32_t)m_dirtySlots.size(); i++)
+	{
+		uint32_t slot = m_dirtySlots[i];
+		memcpy((uint8_t*)allocation.pData + i * TRIANGLE_BYTES, m_slotData.data() + slot * TRIANGLE_BYTES, TRIANGLE_BYTES);
+		m_slotDirty[slot] = false;
+
+		if (i > 0 && m_dirtySlots[i - 1] + 1 == slot)
+			regions.back().size += TRIANGLE_BYTES;
+		else
+			regions.push_back({ allocation.offset + i * TRIANGLE_BYTES, slot * TRIANGLE_BYTES, TRIANGLE_BYTES });
+	}
+	m_dirtySlots.clear();
+
+	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPerFrameRes()->AllocateTransientPrimaryCommandBuffer();
+	pCmdBuffer->StartPrimaryRecording();
+
+	// Frames submitted before might still read slots being overwritten, it's a write after read hazard, execution dependency is enough
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {}, {}, {});
 
+	vkCmdCopyBuffer(pCmdBuffer->GetDeviceHandle(), TransientDataAllocator::GetInstance()->GetBuffer()->GetDeviceHandle(), m_pBuffer->GetDeviceHandle(), (uint32_t)regions.size(), regions.data());
+
+	// Frame commands drawing planets are submitted right after this in the same batch
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, { barrier }, {}, {});
+
+	pCmdBuffer->EndPrimaryRecording();
+
+	return pCmdBuffer;
+}
+
+void PlanetGeoDataManager::OnFrameBegin()
+{
+	m_updatedBytes = 0;
 }
 
 void PlanetGeoDataManager::OnFrameEnd()
 {
-	m_updatedSize = 0;
+
 }
\ No newline at end of file
@@ -2,24 +2,65 @@
 
 #include "../common/Singleton.h"
 #include "FrameEventListener.h"
-#include "PerFrameData.h"
+#include "../Maths/Vector.h"
+#include <queue>
 
+class Buffer;
+class CommandBuffer;
+
+// Planet triangles live in fixed slots of a device local buffer that persist across frames, only slots changed in a frame are uploaded
+// Freed slots in between are filled with degenerate triangles, so instances up to the last used slot can be drawn as they are
+//
+// Changed slots are staged in transient data of current frame and copied by a command buffer recorded every frame,
+// which has to be submitted ahead of frame commands
 class PlanetGeoDataManager : public Singleton<PlanetGeoDataManager>, public IFrameEventListener
 {
+public:
+	// A triangle consists of 3 vertices
+	static const uint32_t TRIANGLE_BYTES = 3 * sizeof(Vector3f);
+	// Size of planet geometry buffer comes from this, planets stop refining once it's used up
+	static const uint32_t TRIANGLE_BUDGET = 128 * 1024;
+	static const uint32_t INVALID_SLOT = (uint32_t)-1;
+
 public:
 	bool Init();
 
 public:
-	void* AcquireDataPtr(uint32_t& offsetInBytes) const;
-	void FinishDataUpdate(uint32_t size);
+	// Lower slots are preferred, so that slot count shrinks back as soon as possible
+	uint32_t AllocateSlot();
+	void FreeSlot(uint32_t slot);
+	void WriteSlot(uint32_t slot, const void* pTriangle);
+	// Records copies of slots changed since last upload, nullptr if there's nothing to upload
+	// If transient data of current frame is used up, slots stay dirty and are uploaded next frame, when transient allocator has grown
+	std::shared_ptr<CommandBuffer> RecordUploads();
+
+	// Slots up to the last used one
+	uint32_t GetSlotCount() const { return m_slotCount; }
+	uint32_t GetUsedSlotCount() const { return m_usedSlotCount; }
+	// Bytes rewritten in current frame
+	uint32_t GetUpdatedBytes() const { return m_updatedBytes; }
 
-	std::shared_ptr<PerFrameBuffer> GetPerFrameBuffer() const;
+	std::shared_ptr<Buffer> GetBuffer() const { return m_pBuffer; }
 
 public:
 	void OnFrameBegin() override;
 	void OnFrameEnd() override;
 
 private:
-	std::shared_ptr<PerFrameData::PerFrameDataKey>	m_pBufferKey;
-	uint32_t										m_updatedSize = 0;
+	void MarkSlotDirty(uint32_t slot);
+
+private:
+	std::shared_ptr<Buffer>							m_pBuffer;
+	// CPU copy of all slots, dirty ones are uploaded from here
+	std::vector<uint8_t>							m_slotData;
+
+	std::vector<bool>								m_slotUsed;
+	std::vector<bool>								m_slotDirty;
+	std::vector<uint32_t>							m_dirtySlots;
+	// Might contain slots that are already reused or beyond slot count, they're skipped when popped
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>>	m_freeSlots;
+	uint32_t										m_slotCount = 0;
+	uint32_t										m_usedSlotCount = 0;
+
+	uint32_t										m_updatedBytes = 0;
 };
\ No newline at end of file
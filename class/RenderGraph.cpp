@@ -0,0 +1,440 @@
+#include "RenderGraph.h"
+#include "../common/Macros.h"
+#include <algorithm>
+
+const uint32_t RenderGraph::INVALID_HANDLE;
+const uint64_t RenderGraph::INVALID_OFFSET;
+
+// Render passes of this renderer leave their attachments in shader read layout, so that's the layout after attachment writes
+const RenderGraph::UsageInfo RenderGraph::m_usageTable[RenderGraph::ResourceUsage_Count] =
+{
+	{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, true },
+	{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, true },
+	{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+	{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+};
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+}
+
+RenderGraph::ResourceHandle RenderGraph::AddResource(const std::string& name, const ImageResolver& resolver, ResourceUsage initialUsage)
+{
+	m_isCompiled = false;
+
+	Resource resource;
+	resource.name = name;
+	resource.resolver = resolver;
+	resource.initialUsage = initialUsage;
+	m_resources.push_back(resource);
+
+	return (ResourceHandle)m_resources.size() - 1;
+}
+
+RenderGraph::ResourceHandle RenderGraph::AddTransientResource(const std::string& name, const ImageResolver& resolver, const VkMemoryRequirements& memoryReqs)
+{
+	m_isCompiled = false;
+
+	Resource resource;
+	resource.name = name;
+	resource.resolver = resolver;
+	resource.isTransient = true;
+	resource.memoryReqs = memoryReqs;
+	m_resources.push_back(resource);
+
+	return (ResourceHandle)m_resources.size() - 1;
+}
+
+void RenderGraph::MarkOutput(ResourceHandle resource)
+{
+	ASSERTION(resource < m_resources.size());
+	m_isCompiled = false;
+	m_resources[resource].isOutput = true;
+}
+
+RenderGraph::PassHandle RenderGraph::AddPass(const std::string& name, const PassCallback& callback)
+{
+	m_isCompiled = false;
+
+	Pass pass;
+	pass.name = name;
+	pass.callback = callback;
+	m_passes.push_back(pass);
+
+	return (PassHandle)m_passes.size() - 1;
+}
+
+void RenderGraph::Read(PassHandle pass, ResourceHandle resource, ResourceUsage usage)
+{
+	ASSERTION(pass < m_passes.size() && resource < m_resources.size());
+	ASSERTION(!m_usageTable[usage].isWrite);
+
+	m_isCompiled = false;
+	m_passes[pass].reads.push_back({ resource, usage });
+}
+
+void RenderGraph::Write(PassHandle pass, ResourceHandle resource, ResourceUsage usage)
+{
+	ASSERTION(pass < m_passes.size() && resource < m_resources.size());
+	ASSERTION(m_usageTable[usage].isWrite);
+
+	m_isCompiled = false;
+	m_passes[pass].writes.push_back({ resource, usage });
+}
+
+void RenderGraph::SetPrepareCallback(PassHandle pass, const PrepareCallback& callback)
+{
+	ASSERTION(pass < m_passes.size());
+	m_passes[pass].prepareCallback = callback;
+	m_isCompiled = false;
+}
+
+void RenderGraph::Clear()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_passOrder.clear();
+	m_preparePasses.clear();
+	m_barrierBatches.clear();
+	m_transientMemoryReqs = {};
+	m_statistics = {};
+	m_isCompiled = false;
+}
+
+bool RenderGraph::Compile()
+{
+	m_statistics = {};
+	m_statistics.passCount = (uint32_t)m_passes.size();
+
+	CullPasses();
+
+	if (!ComputeLifetimes())
+		return false;
+
+	AliasTransientResources();
+	BuildBarriers();
+
+	m_isCompiled = true;
+	return true;
+}
+
+// Walk backwards from outputs, a pass is needed if it writes what a needed pass reads
+// Only the latest write before a read is visible to it, since every pass clears what it writes
+// A pass that loads what's written before should declare a read of it as well
+void RenderGraph::CullPasses()
+{
+	for (auto& pass : m_passes)
+		pass.isCulled = true;
+
+	auto writesResource = [this](PassHandle pass, ResourceHandle resource)
+	{
+		for (auto& write : m_passes[pass].writes)
+		{
+			if (write.resource == resource)
+				return true;
+		}
+		return false;
+	};
+
+	std::vector<PassHandle> neededPasses;
+	auto markLatestWriter = [&](ResourceHandle resource, uint32_t passEnd)
+	{
+		for (uint32_t i = passEnd; i > 0; i--)
+		{
+			if (!writesResource(i - 1, resource))
+				continue;
+
+			if (m_passes[i - 1].isCulled)
+			{
+				m_passes[i - 1].isCulled = false;
+				neededPasses.push_back(i - 1);
+			}
+			return;
+		}
+	};
+
+	for (uint32_t i = 0; i < m_resources.size(); i++)
+	{
+		if (m_resources[i].isOutput)
+			markLatestWriter(i, (uint32_t)m_passes.size());
+	}
+
+	while (!neededPasses.empty())
+	{
+		PassHandle pass = neededPasses.back();
+		neededPasses.pop_back();
+
+		for (auto& read : m_passes[pass].reads)
+			markLatestWriter(read.resource, pass);
+	}
+
+	for (auto& pass : m_passes)
+	{
+		if (pass.isCulled)
+			m_statistics.culledPassCount++;
+	}
+}
+
+bool RenderGraph::ComputeLifetimes()
+{
+	m_passOrder.clear();
+	m_preparePasses.clear();
+	for (uint32_t i = 0; i < m_passes.size(); i++)
+	{
+		if (m_passes[i].isCulled)
+			continue;
+
+		m_passOrder.push_back(i);
+		if (m_passes[i].prepareCallback)
+			m_preparePasses.push_back(i);
+	}
+
+	for (auto& resource : m_resources)
+	{
+		resource.firstPass = INVALID_HANDLE;
+		resource.lastPass = INVALID_HANDLE;
+		resource.aliasOffset = INVALID_OFFSET;
+	}
+
+	std::vector<bool> written(m_resources.size(), false);
+	auto touch = [this](ResourceHandle resource, uint32_t orderIndex)
+	{
+		if (m_resources[resource].firstPass == INVALID_HANDLE)
+			m_resources[resource].firstPass = orderIndex;
+		m_resources[resource].lastPass = orderIndex;
+	};
+
+	for (uint32_t i = 0; i < m_passOrder.size(); i++)
+	{
+		const Pass& pass = m_passes[m_passOrder[i]];
+
+		for (auto& read : pass.reads)
+		{
+			// Transient resource has nothing in it before it's written in this frame
+			if (m_resources[read.resource].isTransient && !written[read.resource])
+			{
+				ASSERTION(false);
+				return false;
+			}
+			touch(read.resource, i);
+		}
+
+		for (auto& write : pass.writes)
+		{
+			written[write.resource] = true;
+			touch(write.resource, i);
+		}
+	}
+
+	return true;
+}
+
+// Greedy first fit, larger resources go first
+// A resource takes the lowest offset that doesn't collide with any placed resource alive at the same time
+void RenderGraph::AliasTransientResources()
+{
+	std::vector<ResourceHandle> transients;
+	for (uint32_t i = 0; i < m_resources.size(); i++)
+	{
+		if (m_resources[i].isTransient && m_resources[i].firstPass != INVALID_HANDLE)
+			transients.push_back(i);
+	}
+
+	std::sort(transients.begin(), transients.end(), [this](ResourceHandle a, ResourceHandle b)
+	{
+		if (m_resources[a].memoryReqs.size != m_resources[b].memoryReqs.size)
+			return m_resources[a].memoryReqs.size > m_resources[b].memoryReqs.size;
+		return m_resources[a].firstPass < m_resources[b].firstPass;
+	});
+
+	m_transientMemoryReqs = {};
+	m_transientMemoryReqs.alignment = 1;
+	m_transientMemoryReqs.memoryTypeBits = UINT32_MAX;
+
+	uint64_t separateBytes = 0;
+	uint64_t unaliasedBytes = 0;
+	std::vector<ResourceHandle> placed;
+
+	for (auto handle : transients)
+	{
+		Resource& resource = m_resources[handle];
+		const VkMemoryRequirements& reqs = resource.memoryReqs;
+
+		separateBytes = AlignUp(separateBytes, reqs.alignment) + reqs.size;
+		m_statistics.transientResourceCount++;
+
+		// Can't share memory with the others, leave it to its own allocation
+		if ((m_transientMemoryReqs.memoryTypeBits & reqs.memoryTypeBits) == 0)
+		{
+			unaliasedBytes += reqs.size;
+			continue;
+		}
+
+		std::vector<std::pair<uint64_t, uint64_t>> takenRanges;
+		for (auto other : placed)
+		{
+			const Resource& otherResource = m_resources[other];
+			if (otherResource.firstPass <= resource.lastPass && resource.firstPass <= otherResource.lastPass)
+				takenRanges.push_back({ otherResource.aliasOffset, otherResource.aliasOffset + otherResource.memoryReqs.size });
+		}
+		std::sort(takenRanges.begin(), takenRanges.end());
+
+		uint64_t offset = 0;
+		for (auto& range : takenRanges)
+		{
+			offset = AlignUp(offset, reqs.alignment);
+			if (offset + reqs.size <= range.first)
+				break;
+			offset = std::max(offset, range.second);
+		}
+		offset = AlignUp(offset, reqs.alignment);
+
+		resource.aliasOffset = offset;
+		placed.push_back(handle);
+
+		m_transientMemoryReqs.size = std::max(m_transientMemoryReqs.size, offset + reqs.size);
+		m_transientMemoryReqs.alignment = std::max(m_transientMemoryReqs.alignment, reqs.alignment);
+		m_transientMemoryReqs.memoryTypeBits &= reqs.memoryTypeBits;
+	}
+
+	if (placed.empty())
+		m_transientMemoryReqs = {};
+
+	m_statistics.transientBytes = separateBytes;
+	m_statistics.aliasedTransientBytes = m_transientMemoryReqs.size + unaliasedBytes;
+
+	for (uint32_t i = 0; i < m_passOrder.size(); i++)
+	{
+		uint64_t liveBytes = 0;
+		for (auto handle : transients)
+		{
+			if (m_resources[handle].firstPass <= i && i <= m_resources[handle].lastPass)
+				liveBytes += m_resources[handle].memoryReqs.size;
+		}
+		m_statistics.liveTransientBytes = std::max(m_statistics.liveTransientBytes, liveBytes);
+	}
+}
+
+// Replay accesses of surviving passes in order, and record what each access has to wait for
+void RenderGraph::BuildBarriers()
+{
+	typedef struct _ResourceState
+	{
+		bool					isWritten = false;
+		VkPipelineStageFlags	writeStages = 0;
+		VkAccessFlags			writeAccess = 0;
+		// Stages the last write has been made visible to
+		VkPipelineStageFlags	visibleStages = 0;
+		// Stages reading it since the last write
+		VkPipelineStageFlags	readStages = 0;
+		VkImageLayout			layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	}ResourceState;
+
+	std::vector<ResourceState> states(m_resources.size());
+	for (uint32_t i = 0; i < m_resources.size(); i++)
+	{
+		if (m_resources[i].initialUsage == ResourceUsage_Count)
+			continue;
+
+		const UsageInfo& usage = m_usageTable[m_resources[i].initialUsage];
+		states[i].layout = usage.layout;
+		if (usage.isWrite)
+		{
+			states[i].isWritten = true;
+			states[i].writeStages = usage.stages;
+			states[i].writeAccess = usage.access;
+		}
+		else
+			states[i].readStages = usage.stages;
+	}
+
+	// Write after read only needs execution dependency, write after write needs memory dependency as well
+	auto waitBeforeWrite = [](BarrierBatch& batch, const ResourceState& state, const UsageInfo& usage)
+	{
+		if (state.readStages != 0)
+		{
+			batch.srcStages |= state.readStages;
+			batch.dstStages |= usage.stages;
+		}
+		else if (state.isWritten)
+		{
+			batch.srcStages |= state.writeStages;
+			batch.dstStages |= usage.stages;
+			batch.memorySrcAccess |= state.writeAccess;
+			batch.memoryDstAccess |= usage.access;
+		}
+	};
+
+	m_barrierBatches.clear();
+	m_barrierBatches.resize(m_passOrder.size());
+
+	for (uint32_t i = 0; i < m_passOrder.size(); i++)
+	{
+		const Pass& pass = m_passes[m_passOrder[i]];
+		BarrierBatch& batch = m_barrierBatches[i];
+
+		for (auto& read : pass.reads)
+		{
+			ResourceState& state = states[read.resource];
+			const UsageInfo& usage = m_usageTable[read.usage];
+
+			if (state.isWritten)
+			{
+				if ((state.visibleStages & usage.stages) != usage.stages || state.layout != usage.layout)
+				{
+					batch.srcStages |= state.writeStages;
+					batch.dstStages |= usage.stages;
+
+					// Same image read in different ways by one pass shares one barrier
+					auto it = std::find_if(batch.imageBarriers.begin(), batch.imageBarriers.end(), [&read](const ImageBarrier& barrier) { return barrier.resource == read.resource; });
+					if (it != batch.imageBarriers.end() && it->newLayout == usage.layout)
+						it->dstAccess |= usage.access;
+					else
+						batch.imageBarriers.push_back({ read.resource, state.writeAccess, usage.access, state.layout, usage.layout });
+
+					state.visibleStages |= usage.stages;
+					state.layout = usage.layout;
+				}
+				else
+					m_statistics.skippedBarrierCount++;
+			}
+
+			state.readStages |= usage.stages;
+		}
+
+		for (auto& write : pass.writes)
+		{
+			const Resource& resource = m_resources[write.resource];
+			const UsageInfo& usage = m_usageTable[write.usage];
+
+			// First write takes over memory from aliased resources that are already dead
+			if (resource.firstPass == i && resource.aliasOffset != INVALID_OFFSET)
+			{
+				for (uint32_t j = 0; j < m_resources.size(); j++)
+				{
+					const Resource& other = m_resources[j];
+					if (j == write.resource || other.aliasOffset == INVALID_OFFSET || other.lastPass >= i)
+						continue;
+
+					if (other.aliasOffset < resource.aliasOffset + resource.memoryReqs.size && resource.aliasOffset < other.aliasOffset + other.memoryReqs.size)
+						waitBeforeWrite(batch, states[j], usage);
+				}
+			}
+
+			waitBeforeWrite(batch, states[write.resource], usage);
+
+			ResourceState& state = states[write.resource];
+			state.isWritten = true;
+			state.writeStages = usage.stages;
+			state.writeAccess = usage.access;
+			state.visibleStages = 0;
+			state.readStages = 0;
+			state.layout = usage.layout;
+		}
+
+		if (batch.srcStages != 0)
+			m_statistics.barrierBatchCount++;
+		m_statistics.imageBarrierCount += (uint32_t)batch.imageBarriers.size();
+	}
+}
\ No newline at end of file
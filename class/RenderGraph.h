@@ -0,0 +1,184 @@
+#pragma once
+#include "vulkan.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+
+class CommandBuffer;
+class Image;
+class PerFrameResource;
+
+// Frame described as passes, each declares images it reads and writes
+// Compile() works on declarations only, no device involved, so it could be verified without GPU, see tests/RenderGraphTest.cpp:
+// 1. Passes that don't contribute to any output are culled
+// 2. Lifetimes of transient resources are measured in surviving passes
+// 3. Transient resources whose lifetimes don't overlap are packed into the same memory range
+// 4. Barriers are derived from access history of each resource, and merged into one pipeline barrier per pass
+// Execute() records barriers and pass callbacks in declaration order, which has to be a valid order already
+// Passes could also have prepare callbacks, which record secondary command buffers ahead of Execute(), possibly on worker threads
+// Execute() and Prepare() are in RenderGraphExecute.cpp, the rest only needs Vulkan headers
+class RenderGraph
+{
+public:
+	typedef uint32_t PassHandle;
+	typedef uint32_t ResourceHandle;
+
+	static const uint32_t INVALID_HANDLE = UINT32_MAX;
+	static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	enum ResourceUsage
+	{
+		ResourceUsage_ColorAttachment,
+		ResourceUsage_DepthAttachment,
+		// Depth test against depth written by another pass, without writing it
+		ResourceUsage_DepthTestRead,
+		ResourceUsage_FragmentShaderRead,
+		ResourceUsage_Count
+	};
+
+	// Image could change with frame index and ping pong, so it's resolved while recording
+	typedef std::function<std::shared_ptr<Image>(uint32_t pingpong)> ImageResolver;
+	typedef std::function<void(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong)> PassCallback;
+	// Doesn't touch primary command buffer, so prepare callbacks of different passes are free to run concurrently
+	typedef std::function<void(const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)> PrepareCallback;
+
+	typedef struct _CompileStatistics
+	{
+		uint32_t	passCount = 0;
+		uint32_t	culledPassCount = 0;
+		uint32_t	barrierBatchCount = 0;
+		uint32_t	imageBarrierCount = 0;
+		// Reads that are already covered by a previous barrier of the same write
+		uint32_t	skippedBarrierCount = 0;
+
+		uint32_t	transientResourceCount = 0;
+		// Peak transient memory if each resource had its own, i.e. before aliasing
+		uint64_t	transientBytes = 0;
+		// Peak transient memory after aliasing
+		uint64_t	aliasedTransientBytes = 0;
+		// Lower bound, the most bytes alive at the same time
+		uint64_t	liveTransientBytes = 0;
+	}CompileStatistics;
+
+protected:
+	typedef struct _ResourceAccess
+	{
+		ResourceHandle	resource;
+		ResourceUsage	usage;
+	}ResourceAccess;
+
+	typedef struct _Resource
+	{
+		std::string				name;
+		ImageResolver			resolver;
+
+		// Transient resources only live within a frame, their memory could be reused by others
+		bool					isTransient = false;
+		VkMemoryRequirements	memoryReqs = {};
+
+		// Imported resources could have been accessed before graph, e.g. history written by last frame
+		ResourceUsage			initialUsage = ResourceUsage_Count;
+		bool					isOutput = false;
+
+		// Compile results, "firstPass" and "lastPass" are indices of surviving passes
+		uint32_t				firstPass = INVALID_HANDLE;
+		uint32_t				lastPass = INVALID_HANDLE;
+		uint64_t				aliasOffset = INVALID_OFFSET;
+	}Resource;
+
+	typedef struct _Pass
+	{
+		std::string					name;
+		PassCallback				callback;
+		PrepareCallback				prepareCallback;
+		std::vector<ResourceAccess>	reads;
+		std::vector<ResourceAccess>	writes;
+		bool						isCulled = false;
+	}Pass;
+
+	typedef struct _ImageBarrier
+	{
+		ResourceHandle	resource;
+		VkAccessFlags	srcAccess;
+		VkAccessFlags	dstAccess;
+		VkImageLayout	oldLayout;
+		VkImageLayout	newLayout;
+	}ImageBarrier;
+
+	// All barriers needed before a pass, recorded with one vkCmdPipelineBarrier
+	typedef struct _BarrierBatch
+	{
+		VkPipelineStageFlags		srcStages = 0;
+		VkPipelineStageFlags		dstStages = 0;
+		std::vector<ImageBarrier>	imageBarriers;
+		// Write after write, including writes to memory previously owned by an aliased resource
+		VkAccessFlags				memorySrcAccess = 0;
+		VkAccessFlags				memoryDstAccess = 0;
+	}BarrierBatch;
+
+	typedef struct _UsageInfo
+	{
+		VkPipelineStageFlags	stages;
+		VkAccessFlags			access;
+		VkImageLayout			layout;
+		bool					isWrite;
+	}UsageInfo;
+
+public:
+	// Imported resources are owned outside, "initialUsage" is the last access before graph, if any
+	ResourceHandle AddResource(const std::string& name, const ImageResolver& resolver, ResourceUsage initialUsage = ResourceUsage_Count);
+	ResourceHandle AddTransientResource(const std::string& name, const ImageResolver& resolver, const VkMemoryRequirements& memoryReqs);
+	// Output resources are consumed outside graph, passes producing them are never culled
+	void MarkOutput(ResourceHandle resource);
+
+	PassHandle AddPass(const std::string& name, const PassCallback& callback);
+	void Read(PassHandle pass, ResourceHandle resource, ResourceUsage usage = ResourceUsage_FragmentShaderRead);
+	void Write(PassHandle pass, ResourceHandle resource, ResourceUsage usage = ResourceUsage_ColorAttachment);
+	void SetPrepareCallback(PassHandle pass, const PrepareCallback& callback);
+
+	void Clear();
+
+	bool Compile();
+	void Execute(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong) const;
+
+	// Surviving passes that have prepare callbacks, "index" is in [0, GetPrepareCount())
+	uint32_t GetPrepareCount() const { return (uint32_t)m_preparePasses.size(); }
+	void Prepare(uint32_t index, const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong) const;
+
+	const CompileStatistics& GetStatistics() const { return m_statistics; }
+	uint32_t GetPassCount() const { return (uint32_t)m_passes.size(); }
+	uint32_t GetResourceCount() const { return (uint32_t)m_resources.size(); }
+	const std::string& GetPassName(PassHandle pass) const { return m_passes[pass].name; }
+	const std::string& GetResourceName(ResourceHandle resource) const { return m_resources[resource].name; }
+	bool IsPassCulled(PassHandle pass) const { return m_passes[pass].isCulled; }
+
+	// Offset into transient memory, INVALID_OFFSET if resource isn't transient or it's not used by any surviving pass
+	uint64_t GetAliasOffset(ResourceHandle resource) const { return m_resources[resource].aliasOffset; }
+	// Size, alignment and memory types of the memory all transient resources are packed into
+	const VkMemoryRequirements& GetTransientMemoryRequirements() const { return m_transientMemoryReqs; }
+
+	static const UsageInfo& GetUsageInfo(ResourceUsage usage) { return m_usageTable[usage]; }
+
+protected:
+	void CullPasses();
+	bool ComputeLifetimes();
+	void AliasTransientResources();
+	void BuildBarriers();
+
+	static VkImageAspectFlags GetAspectFlags(VkFormat format);
+
+protected:
+	std::vector<Resource>		m_resources;
+	std::vector<Pass>			m_passes;
+
+	// Compile results
+	std::vector<PassHandle>		m_passOrder;
+	std::vector<PassHandle>		m_preparePasses;
+	std::vector<BarrierBatch>	m_barrierBatches;
+	VkMemoryRequirements		m_transientMemoryReqs = {};
+	CompileStatistics			m_statistics;
+	bool						m_isCompiled = false;
+
+	static const UsageInfo		m_usageTable[ResourceUsage_Count];
+};
\ No newline at end of file
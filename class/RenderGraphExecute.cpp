@@ -0,0 +1,80 @@
+#include "RenderGraph.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/Image.h"
+#include "../common/Macros.h"
+
+// Recording half of RenderGraph, kept apart so that declaring and compiling a graph doesn't drag in device objects
+void RenderGraph::Execute(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong) const
+{
+	ASSERTION(m_isCompiled);
+
+	for (uint32_t i = 0; i < m_passOrder.size(); i++)
+	{
+		const BarrierBatch& batch = m_barrierBatches[i];
+
+		if (batch.srcStages != 0)
+		{
+			std::vector<VkMemoryBarrier> memoryBarriers;
+			if (batch.memorySrcAccess != 0)
+			{
+				VkMemoryBarrier memoryBarrier = {};
+				memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				memoryBarrier.srcAccessMask = batch.memorySrcAccess;
+				memoryBarrier.dstAccessMask = batch.memoryDstAccess;
+				memoryBarriers.push_back(memoryBarrier);
+			}
+
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			for (auto& barrier : batch.imageBarriers)
+			{
+				std::shared_ptr<Image> pImage = m_resources[barrier.resource].resolver(pingpong);
+
+				VkImageSubresourceRange subresourceRange = {};
+				subresourceRange.aspectMask = GetAspectFlags(pImage->GetImageInfo().format);
+				subresourceRange.baseMipLevel = 0;
+				subresourceRange.levelCount = pImage->GetImageInfo().mipLevels;
+				subresourceRange.layerCount = pImage->GetImageInfo().arrayLayers;
+
+				VkImageMemoryBarrier imgBarrier = {};
+				imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				imgBarrier.image = pImage->GetDeviceHandle();
+				imgBarrier.subresourceRange = subresourceRange;
+				imgBarrier.oldLayout = barrier.oldLayout;
+				imgBarrier.srcAccessMask = barrier.srcAccess;
+				imgBarrier.newLayout = barrier.newLayout;
+				imgBarrier.dstAccessMask = barrier.dstAccess;
+
+				imageBarriers.push_back(imgBarrier);
+			}
+
+			pCmdBuf->AttachBarriers(batch.srcStages, batch.dstStages, memoryBarriers, {}, imageBarriers);
+		}
+
+		const Pass& pass = m_passes[m_passOrder[i]];
+		if (pass.callback)
+			pass.callback(pCmdBuf, pingpong);
+	}
+}
+
+void RenderGraph::Prepare(uint32_t index, const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong) const
+{
+	ASSERTION(m_isCompiled && index < m_preparePasses.size());
+	m_passes[m_preparePasses[index]].prepareCallback(pPerFrameRes, pingpong);
+}
+
+VkImageAspectFlags RenderGraph::GetAspectFlags(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
\ No newline at end of file
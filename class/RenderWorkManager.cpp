@@ -6,12 +6,15 @@
 #include "../vulkan/DepthStencilBuffer.h"
 #include "../vulkan/Texture2D.h"
 #include "../vulkan/GlobalVulkanStates.h"
+#include "../vulkan/DeviceMemoryManager.h"
+#include "../vulkan/PipelineCache.h"
 #include "RenderPassDiction.h"
 #include "ForwardRenderPass.h"
 #include "DeferredMaterial.h"
 #include "MotionTileMaxMaterial.h"
 #include "MotionNeighborMaxMaterial.h"
 #include "ShadowMapMaterial.h"
+#include "FrustumCullingManager.h"
 #include "SSAOMaterial.h"
 #include "GaussianBlurMaterial.h"
 #include "BloomMaterial.h"
@@ -22,6 +25,10 @@
 #include "DOFMaterial.h"
 #include "GBufferPlanetMaterial.h"
 #include "MaterialInstance.h"
+#include "SkinningManager.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <chrono>
 
 enum MaterialEnum
 {
@@ -52,6 +59,14 @@ bool RenderWorkManager::Init()
 	if (!Singleton<RenderWorkManager>::Init())
 		return false;
 
+	// Materials bind frame buffer images into their descriptor sets, so transient ones have to be aliased before materials are created
+	if (!BuildRenderGraph())
+		return false;
+	AliasTransientFrameBuffers();
+
+	// Materials are created one after another, while their pipelines are compiled together across worker threads
+	GlobalPipelineCache()->BeginBatch();
+
 	m_materials.resize(MaterialEnumCount);
 	for (uint32_t i = 0; i < MaterialEnumCount; i++)
 	{
@@ -131,9 +146,308 @@ bool RenderWorkManager::Init()
 		}
 	}
 
+	GlobalPipelineCache()->EndBatch();
+
+	// Static meshes are culled by compute shader if it's available, or they fall back to CPU culling
+	GetMaterial(PBRGBuffer)->EnableGPUCulling(FrustumCullingManager::CullingFrustum_Camera);
+	GetMaterial(Shadow)->EnableGPUCulling(FrustumCullingManager::CullingFrustum_Light);
+
+	// Render graph knows every access of a frame, barriers between passes come from it
+	for (auto& materialSet : m_materials)
+	{
+		for (auto pMaterial : materialSet.materialSet)
+		{
+			pMaterial->SetExternalResourceBarriers(true);
+		}
+	}
+
 	return true;
 }
 
+bool RenderWorkManager::BuildRenderGraph()
+{
+	m_renderGraph.Clear();
+	m_transientFrameBuffers.clear();
+
+	auto colorTarget = [](FrameBufferDiction::FrameBufferType type, uint32_t layer, uint32_t index) -> RenderGraph::ImageResolver
+	{
+		return [type, layer, index](uint32_t pingpong) { return FrameBufferDiction::GetInstance()->GetFrameBuffer(type, layer)->GetColorTarget(index); };
+	};
+
+	auto depthTarget = [](FrameBufferDiction::FrameBufferType type) -> RenderGraph::ImageResolver
+	{
+		return [type](uint32_t pingpong) -> std::shared_ptr<Image> { return FrameBufferDiction::GetInstance()->GetFrameBuffer(type)->GetDepthStencilTarget(); };
+	};
+
+	// Temporal resolve reads history from ping pong image "pingpong", and writes the other one
+	auto temporalTarget = [](uint32_t index, bool isHistory) -> RenderGraph::ImageResolver
+	{
+		return [index, isHistory](uint32_t pingpong) { return FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, isHistory ? pingpong : (pingpong + 1) % 2)->GetColorTarget(index); };
+	};
+
+	// Transient targets are only used within a frame, their memory requirements come from images created by frame buffer diction
+	auto addTransient = [this, &colorTarget](const std::string& name, FrameBufferDiction::FrameBufferType type, uint32_t layer)
+	{
+		VkMemoryRequirements reqs = FrameBufferDiction::GetInstance()->GetFrameBuffers(type, layer)[0]->GetColorTarget(0)->GetMemoryReqirments();
+		RenderGraph::ResourceHandle resource = m_renderGraph.AddTransientResource(name, colorTarget(type, layer, 0), reqs);
+		m_transientFrameBuffers.push_back({ resource, type, layer });
+		return resource;
+	};
+
+	// Most passes draw one material into one frame buffer
+	auto addPass = [this](const std::string& name, MaterialEnum material, uint32_t materialIndex, RenderPassDiction::PipelineRenderPass renderPass, FrameBufferDiction::FrameBufferType type, uint32_t layer)
+	{
+		RenderGraph::PassHandle pass = m_renderGraph.AddPass(name, [this, material, materialIndex, renderPass, type, layer](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+		{
+			std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(type, layer);
+
+			GetMaterial(material, materialIndex)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+			RenderPassDiction::GetInstance()->GetPipelineRenderPass(renderPass)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
+			GetMaterial(material, materialIndex)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
+			RenderPassDiction::GetInstance()->GetPipelineRenderPass(renderPass)->EndRenderPass(pDrawCmdBuffer);
+			GetMaterial(material, materialIndex)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		});
+
+		m_renderGraph.SetPrepareCallback(pass, [this, material, materialIndex, type, layer](const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)
+		{
+			GetMaterial(material, materialIndex)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(type, layer), pingpong);
+		});
+
+		return pass;
+	};
+
+	std::vector<RenderGraph::ResourceHandle> gbuffers(FrameBufferDiction::GBufferCount);
+	for (uint32_t i = 0; i < FrameBufferDiction::GBufferCount; i++)
+		gbuffers[i] = m_renderGraph.AddResource("GBuffer" + std::to_string(i), colorTarget(FrameBufferDiction::FrameBufferType_GBuffer, 0, i));
+	RenderGraph::ResourceHandle depth = m_renderGraph.AddResource("GBufferDepth", depthTarget(FrameBufferDiction::FrameBufferType_GBuffer));
+	RenderGraph::ResourceHandle shadowMap = m_renderGraph.AddResource("ShadowMap", depthTarget(FrameBufferDiction::FrameBufferType_ShadowMap));
+	RenderGraph::ResourceHandle ssao = m_renderGraph.AddResource("SSAO", colorTarget(FrameBufferDiction::FrameBufferType_SSAOSSR, 0, 0));
+	RenderGraph::ResourceHandle ssr = m_renderGraph.AddResource("SSR", colorTarget(FrameBufferDiction::FrameBufferType_SSAOSSR, 0, 1));
+	RenderGraph::ResourceHandle shadingResult = m_renderGraph.AddResource("ShadingResult", colorTarget(FrameBufferDiction::FrameBufferType_Shading, 0, 0));
+	RenderGraph::ResourceHandle ssrResult = m_renderGraph.AddResource("SSRResult", colorTarget(FrameBufferDiction::FrameBufferType_Shading, 0, 1));
+	RenderGraph::ResourceHandle combineResult = m_renderGraph.AddResource("CombineResult", colorTarget(FrameBufferDiction::FrameBufferType_CombineResult, 0, 0));
+	RenderGraph::ResourceHandle swapChainImage = m_renderGraph.AddResource("SwapChainImage", colorTarget(FrameBufferDiction::FrameBufferType_PostProcessing, 0, 0));
+	m_renderGraph.MarkOutput(swapChainImage);
+
+	// History is written by temporal resolve of last frame, and temporal results are next frame's history
+	std::vector<RenderGraph::ResourceHandle> temporalHistory(FrameBufferDiction::TemporalFrameBufferCount);
+	std::vector<RenderGraph::ResourceHandle> temporalResults(FrameBufferDiction::TemporalFrameBufferCount);
+	for (uint32_t i = 0; i < FrameBufferDiction::TemporalFrameBufferCount; i++)
+	{
+		temporalHistory[i] = m_renderGraph.AddResource("TemporalHistory" + std::to_string(i), temporalTarget(i, true), RenderGraph::ResourceUsage_ColorAttachment);
+		temporalResults[i] = m_renderGraph.AddResource("TemporalResult" + std::to_string(i), temporalTarget(i, false));
+		m_renderGraph.MarkOutput(temporalResults[i]);
+	}
+
+	RenderGraph::ResourceHandle motionTileMax = addTransient("MotionTileMax", FrameBufferDiction::FrameBufferType_MotionTileMax, 0);
+	RenderGraph::ResourceHandle motionNeighborMax = addTransient("MotionNeighborMax", FrameBufferDiction::FrameBufferType_MotionNeighborMax, 0);
+	RenderGraph::ResourceHandle ssaoBlurV = addTransient("SSAOBlurV", FrameBufferDiction::FrameBufferType_SSAOBlurV, 0);
+	RenderGraph::ResourceHandle ssaoBlurH = addTransient("SSAOBlurH", FrameBufferDiction::FrameBufferType_SSAOBlurH, 0);
+	// Post filter layer renders into pre filter layer's image
+	RenderGraph::ResourceHandle dofPrefilter = addTransient("DOFPrefilter", FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::PrefilterLayer);
+	RenderGraph::ResourceHandle dofBokehBlur = addTransient("DOFBokehBlur", FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::BokehBlurLayer);
+	RenderGraph::ResourceHandle dofCombine = addTransient("DOFCombine", FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::CombineLayer);
+	std::vector<RenderGraph::ResourceHandle> bloom(BLOOM_ITER_COUNT + 1);
+	for (uint32_t i = 0; i <= BLOOM_ITER_COUNT; i++)
+		bloom[i] = addTransient("Bloom" + std::to_string(i), FrameBufferDiction::FrameBufferType_Bloom, i);
+
+	RenderGraph::PassHandle pass = m_renderGraph.AddPass("GBuffer", [this](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+	{
+		GetMaterial(PBRGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(PBRSkinnedGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(PBRPlanetGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(BackgroundMotion)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
+		GetMaterial(PBRGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		GetMaterial(PBRSkinnedGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		GetMaterial(PBRPlanetGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->NextSubpass(pDrawCmdBuffer);
+		GetMaterial(BackgroundMotion)->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->EndRenderPass(pDrawCmdBuffer);
+		GetMaterial(BackgroundMotion)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(PBRPlanetGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(PBRSkinnedGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(PBRGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	});
+	m_renderGraph.SetPrepareCallback(pass, [this](const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)
+	{
+		GetMaterial(PBRGBuffer)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		GetMaterial(PBRSkinnedGBuffer)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		GetMaterial(PBRPlanetGBuffer)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+		GetMaterial(BackgroundMotion)->PrepareDrawScreenQuad(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
+	});
+	for (auto gbuffer : gbuffers)
+		m_renderGraph.Write(pass, gbuffer);
+	m_renderGraph.Write(pass, depth, RenderGraph::ResourceUsage_DepthAttachment);
+
+	pass = addPass("MotionTileMax", MotionTileMax, 0, RenderPassDiction::PipelineRenderPassMotionTileMax, FrameBufferDiction::FrameBufferType_MotionTileMax, 0);
+	m_renderGraph.Read(pass, gbuffers[FrameBufferDiction::MotionVector]);
+	m_renderGraph.Write(pass, motionTileMax);
+
+	pass = addPass("MotionNeighborMax", MotionNeighborMax, 0, RenderPassDiction::PipelineRenderPassMotionNeighborMax, FrameBufferDiction::FrameBufferType_MotionNeighborMax, 0);
+	m_renderGraph.Read(pass, motionTileMax);
+	m_renderGraph.Write(pass, motionNeighborMax);
+
+	pass = m_renderGraph.AddPass("ShadowMap", [this](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+	{
+		GetMaterial(Shadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(SkinnedShadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap));
+		GetMaterial(Shadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+		GetMaterial(SkinnedShadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pDrawCmdBuffer);
+		GetMaterial(SkinnedShadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(Shadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	});
+	m_renderGraph.SetPrepareCallback(pass, [this](const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)
+	{
+		GetMaterial(Shadow)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+		GetMaterial(SkinnedShadow)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+	});
+	m_renderGraph.Write(pass, shadowMap, RenderGraph::ResourceUsage_DepthAttachment);
+
+	pass = addPass("SSAOSSR", SSAO, 0, RenderPassDiction::PipelineRenderPassSSAOSSR, FrameBufferDiction::FrameBufferType_SSAOSSR, 0);
+	m_renderGraph.Read(pass, gbuffers[FrameBufferDiction::GBuffer0]);
+	m_renderGraph.Read(pass, gbuffers[FrameBufferDiction::GBuffer2]);
+	m_renderGraph.Read(pass, depth);
+	m_renderGraph.Write(pass, ssao);
+	m_renderGraph.Write(pass, ssr);
+
+	pass = addPass("SSAOBlurV", SSAOBlurV, 0, RenderPassDiction::PipelineRenderPassSSAOBlurV, FrameBufferDiction::FrameBufferType_SSAOBlurV, 0);
+	m_renderGraph.Read(pass, ssao);
+	m_renderGraph.Write(pass, ssaoBlurV);
+
+	pass = addPass("SSAOBlurH", SSAOBlurH, 0, RenderPassDiction::PipelineRenderPassSSAOBlurH, FrameBufferDiction::FrameBufferType_SSAOBlurH, 0);
+	m_renderGraph.Read(pass, ssaoBlurV);
+	m_renderGraph.Write(pass, ssaoBlurH);
+
+	pass = m_renderGraph.AddPass("Shading", [this](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+	{
+		GetMaterial(DeferredShading)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(SkyBox)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading));
+		GetMaterial(DeferredShading)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->NextSubpass(pDrawCmdBuffer);
+		GetMaterial(SkyBox)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->EndRenderPass(pDrawCmdBuffer);
+		GetMaterial(SkyBox)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GetMaterial(DeferredShading)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	});
+	m_renderGraph.SetPrepareCallback(pass, [this](const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)
+	{
+		GetMaterial(DeferredShading)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
+		GetMaterial(SkyBox)->PrepareDraw(pPerFrameRes, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
+	});
+	for (auto gbuffer : gbuffers)
+		m_renderGraph.Read(pass, gbuffer);
+	m_renderGraph.Read(pass, depth);
+	// Sky box is depth tested against GBuffer depth
+	m_renderGraph.Read(pass, depth, RenderGraph::ResourceUsage_DepthTestRead);
+	m_renderGraph.Read(pass, shadowMap);
+	m_renderGraph.Read(pass, ssaoBlurH);
+	m_renderGraph.Read(pass, ssr);
+	m_renderGraph.Write(pass, shadingResult);
+	m_renderGraph.Write(pass, ssrResult);
+
+	auto temporalFrameBuffer = [](uint32_t pingpong)
+	{
+		return FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2);
+	};
+
+	pass = m_renderGraph.AddPass("TemporalResolve", [this, temporalFrameBuffer](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+	{
+		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = temporalFrameBuffer(pingpong);
+
+		GetMaterial(TemporalResolve, pingpong)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
+		GetMaterial(TemporalResolve, pingpong)->Draw(pDrawCmdBuffer, pTargetFrameBuffer);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->EndRenderPass(pDrawCmdBuffer);
+		GetMaterial(TemporalResolve, pingpong)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	});
+	m_renderGraph.SetPrepareCallback(pass, [this, temporalFrameBuffer](const std::shared_ptr<PerFrameResource>& pPerFrameRes, uint32_t pingpong)
+	{
+		GetMaterial(TemporalResolve, pingpong)->PrepareDraw(pPerFrameRes, temporalFrameBuffer(pingpong));
+	});
+	m_renderGraph.Read(pass, gbuffers[FrameBufferDiction::MotionVector]);
+	m_renderGraph.Read(pass, gbuffers[FrameBufferDiction::GBuffer1]);
+	m_renderGraph.Read(pass, shadingResult);
+	m_renderGraph.Read(pass, ssrResult);
+	m_renderGraph.Read(pass, motionNeighborMax);
+	for (auto history : temporalHistory)
+		m_renderGraph.Read(pass, history);
+	for (auto result : temporalResults)
+		m_renderGraph.Write(pass, result);
+
+	pass = addPass("DOFPrefilter", DepthOfField, DOFMaterial::DOFPass_Prefilter, RenderPassDiction::PipelineRenderPassDOF, FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::PrefilterLayer);
+	m_renderGraph.Read(pass, temporalResults[FrameBufferDiction::CombinedResult]);
+	m_renderGraph.Read(pass, temporalResults[FrameBufferDiction::CoC]);
+	m_renderGraph.Write(pass, dofPrefilter);
+
+	pass = addPass("DOFBokehBlur", DepthOfField, DOFMaterial::DOFPass_Blur, RenderPassDiction::PipelineRenderPassDOF, FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::BokehBlurLayer);
+	m_renderGraph.Read(pass, dofPrefilter);
+	m_renderGraph.Write(pass, dofBokehBlur);
+
+	pass = addPass("DOFPostfilter", DepthOfField, DOFMaterial::DOFPass_Postfilter, RenderPassDiction::PipelineRenderPassDOF, FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::PostfilterLayer);
+	m_renderGraph.Read(pass, dofBokehBlur);
+	m_renderGraph.Write(pass, dofPrefilter);
+
+	pass = addPass("DOFCombine", DepthOfField, DOFMaterial::DOFPass_Combine, RenderPassDiction::PipelineRenderPassDOF, FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::CombineLayer);
+	m_renderGraph.Read(pass, dofPrefilter);
+	m_renderGraph.Read(pass, temporalResults[FrameBufferDiction::CombinedResult]);
+	m_renderGraph.Read(pass, temporalResults[FrameBufferDiction::CoC]);
+	m_renderGraph.Write(pass, dofCombine);
+
+	// Downsample first
+	for (uint32_t i = 0; i < BLOOM_ITER_COUNT; i++)
+	{
+		pass = addPass("BloomDownSample" + std::to_string(i), BloomDownSample, i, RenderPassDiction::PipelineRenderPassBloom, FrameBufferDiction::FrameBufferType_Bloom, i + 1);
+		m_renderGraph.Read(pass, i == 0 ? dofCombine : bloom[i]);
+		m_renderGraph.Write(pass, bloom[i + 1]);
+	}
+
+	// Upsample then
+	for (int32_t i = BLOOM_ITER_COUNT - 1; i >= 0; i--)
+	{
+		pass = addPass("BloomUpSample" + std::to_string(i), BloomUpSample, i, RenderPassDiction::PipelineRenderPassBloom, FrameBufferDiction::FrameBufferType_Bloom, i);
+		m_renderGraph.Read(pass, bloom[i + 1]);
+		m_renderGraph.Write(pass, bloom[i]);
+	}
+
+	pass = addPass("Combine", Combine, 0, RenderPassDiction::PipelineRenderPassCombine, FrameBufferDiction::FrameBufferType_CombineResult, 0);
+	m_renderGraph.Read(pass, dofCombine);
+	m_renderGraph.Read(pass, bloom[0]);
+	m_renderGraph.Write(pass, combineResult);
+
+	pass = addPass("PostProcess", PostProcess, 0, RenderPassDiction::PipelineRenderPassPostProcessing, FrameBufferDiction::FrameBufferType_PostProcessing, 0);
+	m_renderGraph.Read(pass, combineResult);
+	m_renderGraph.Read(pass, motionNeighborMax);
+	m_renderGraph.Write(pass, swapChainImage);
+
+	return m_renderGraph.Compile();
+}
+
+void RenderWorkManager::AliasTransientFrameBuffers()
+{
+	const VkMemoryRequirements& reqs = m_renderGraph.GetTransientMemoryRequirements();
+	if (reqs.size == 0)
+		return;
+
+	// Frames in flight are rendered at the same time, each of them needs its own memory
+	// Images hold their memory key, memory is released together with the last of them
+	std::vector<std::shared_ptr<MemoryKey>> memKeys;
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+		memKeys.push_back(DeviceMemMgr()->AllocateImageMemChunk(reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+	for (auto& transient : m_transientFrameBuffers)
+	{
+		uint64_t offset = m_renderGraph.GetAliasOffset(transient.resource);
+		if (offset == RenderGraph::INVALID_OFFSET)
+			continue;
+
+		FrameBufferDiction::GetInstance()->AliasFrameBuffer(transient.type, transient.layer, memKeys, (uint32_t)offset);
+	}
+}
+
 std::shared_ptr<MaterialInstance> RenderWorkManager::AcquirePBRMaterialInstance() const
 {
 	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(PBRGBuffer)->CreateMaterialInstance();
@@ -189,135 +503,55 @@ void RenderWorkManager::SyncMaterialData()
 
 void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
 {
-	GetMaterial(PBRGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRPlanetGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(BackgroundMotion)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
-	GetMaterial(PBRGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRPlanetGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->NextSubpass(pDrawCmdBuffer);
-	GetMaterial(BackgroundMotion)->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(BackgroundMotion)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRPlanetGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(MotionTileMax)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionTileMax)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionTileMax));
-	GetMaterial(MotionTileMax)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionTileMax), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionTileMax)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(MotionTileMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(MotionNeighborMax)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionNeighborMax));
-	GetMaterial(MotionNeighborMax)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionNeighborMax), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(MotionNeighborMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(Shadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(SkinnedShadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap));
-	GetMaterial(Shadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	GetMaterial(SkinnedShadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SkinnedShadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(Shadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAO)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOSSR)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR));
-	GetMaterial(SSAO)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOSSR)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAO)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAOBlurV)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurV)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurV));
-	GetMaterial(SSAOBlurV)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurV), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurV)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAOBlurV)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAOBlurH)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurH)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH));
-	GetMaterial(SSAOBlurH)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurH)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAOBlurH)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(DeferredShading)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(SkyBox)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading));
-	GetMaterial(DeferredShading)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->NextSubpass(pDrawCmdBuffer);
-	GetMaterial(SkyBox)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SkyBox)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(DeferredShading)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(TemporalResolve, pingpong)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2));
-	GetMaterial(TemporalResolve, pingpong)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2));
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(TemporalResolve, pingpong)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-	for (uint32_t i = 0; i < DOFMaterial::DOFPass_Count; i++)
-	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, i);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(DepthOfField, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassDOF)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(DepthOfField, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassDOF)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(DepthOfField, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	}
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	// Downsample first
-	for (uint32_t i = 0; i < BLOOM_ITER_COUNT; i++)
+	PrepareDraw(pingpong);
+
+	m_recordingStatistics.prepareTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	// Primary command buffer only begins render passes, attaches barriers and executes prepared secondary command buffers
+	m_renderGraph.Execute(pDrawCmdBuffer, pingpong);
+
+	m_recordingStatistics.recordingTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+void RenderWorkManager::PrepareDraw(uint32_t pingpong)
+{
+	uint32_t prepareCount = m_renderGraph.GetPrepareCount();
+
+	uint32_t threadCount = GlobalThreadTaskQueue()->GetWorkerCount() + 1;
+	if (m_recordingThreadCount != 0 && m_recordingThreadCount < threadCount)
+		threadCount = m_recordingThreadCount;
+	threadCount = prepareCount < threadCount ? prepareCount : threadCount;
+
+	m_recordingStatistics.threadCount = threadCount;
+	m_recordingStatistics.preparedPassCount = prepareCount;
+
+	if (threadCount <= 1)
 	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i + 1);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(BloomDownSample, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(BloomDownSample, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(BloomDownSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		for (uint32_t i = 0; i < prepareCount; i++)
+			m_renderGraph.Prepare(i, MainThreadPerFrameRes(), pingpong);
+		return;
 	}
 
-	// Upsample then
-	for (int32_t i = BLOOM_ITER_COUNT - 1; i >= 0; i--)
+	// Passes are grabbed dynamically, since a pass of scene materials takes much longer than a screen quad
+	// Each thread records with its own per frame resource, command pools are never shared between threads
+	std::atomic<uint32_t> nextPrepare = { 0 };
+	auto preparePasses = [this, &nextPrepare, prepareCount, pingpong](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
 	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(BloomUpSample, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(BloomUpSample, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(BloomUpSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	}
+		uint32_t index;
+		while ((index = nextPrepare++) < prepareCount)
+			m_renderGraph.Prepare(index, pPerFrameRes, pingpong);
+	};
 
-	GetMaterial(Combine)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassCombine)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_CombineResult));
-	GetMaterial(Combine)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_CombineResult), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassCombine)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(Combine)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	JobCounter counter;
+	for (uint32_t i = 0; i < threadCount - 1; i++)
+		GlobalThreadTaskQueue()->AddJob(preparePasses, FrameMgr()->FrameIndex(), &counter);
 
+	// Calling thread takes its share too
+	preparePasses(MainThreadPerFrameRes());
 
-	GetMaterial(PostProcess)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing));
-	GetMaterial(PostProcess)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(PostProcess)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GlobalThreadTaskQueue()->WaitForCounter(counter);
 }
 
 void RenderWorkManager::OnFrameBegin()
@@ -340,4 +574,6 @@ void RenderWorkManager::OnFrameEnd()
 			pMaterial->OnFrameEnd();
 		}
 	}
+
+	SkinningManager::GetInstance()->OnFrameEnd();
 }
\ No newline at end of file
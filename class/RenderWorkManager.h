@@ -3,6 +3,8 @@
 #include "../common/Singleton.h"
 #include "../vulkan/RenderPass.h"
 #include "RenderPassDiction.h"
+#include "FrameBufferDiction.h"
+#include "RenderGraph.h"
 
 class FrameBuffer;
 class Texture2D;
@@ -88,7 +90,30 @@ public:
 	void OnFrameBegin();
 	void OnFrameEnd();
 
+	const RenderGraph::CompileStatistics& GetRenderGraphStatistics() const { return m_renderGraph.GetStatistics(); }
+
+	typedef struct _RecordingStatistics
+	{
+		uint32_t	threadCount = 0;
+		uint32_t	preparedPassCount = 0;
+		// Milliseconds spent on secondary command buffers of passes, and on the whole "Draw"
+		double		prepareTime = 0;
+		double		recordingTime = 0;
+	}RecordingStatistics;
+
+	// Threads recording secondary command buffers of passes, calling thread included
+	// 1 records everything on calling thread, 0 uses all workers of global thread task queue
+	void SetRecordingThreadCount(uint32_t threadCount) { m_recordingThreadCount = threadCount; }
+	const RecordingStatistics& GetRecordingStatistics() const { return m_recordingStatistics; }
+
 protected:
+	// Declare all passes of a frame, their callbacks are what "Draw" used to record one after another
+	bool BuildRenderGraph();
+	// Recreate transient frame buffers into memory shared according to compiled render graph
+	void AliasTransientFrameBuffers();
+	// Record secondary command buffers of all passes across worker threads, before they're executed by render graph in order
+	void PrepareDraw(uint32_t pingpong);
+
 	// Since there could be some mutants of the same material class
 	// We encapsulate these one or more materials into "MaterialSet"
 	typedef struct _MaterialSet
@@ -99,6 +124,19 @@ protected:
 
 	std::shared_ptr<Material>	GetMaterial(MaterialEnum materialEnum, uint32_t index = 0) const { return m_materials[materialEnum].GetMaterial(index); }
 
+	typedef struct _TransientFrameBuffer
+	{
+		RenderGraph::ResourceHandle			resource;
+		FrameBufferDiction::FrameBufferType	type;
+		uint32_t							layer;
+	}TransientFrameBuffer;
+
 	std::vector<MaterialSet>	m_materials;
 	uint32_t					m_renderStateMask;
+
+	RenderGraph							m_renderGraph;
+	std::vector<TransientFrameBuffer>	m_transientFrameBuffers;
+
+	uint32_t							m_recordingThreadCount = 0;
+	RecordingStatistics					m_recordingStatistics;
 };
\ No newline at end of file
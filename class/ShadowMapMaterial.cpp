@@ -11,15 +11,27 @@
 #include "RenderPassDiction.h"
 #include "ForwardRenderPass.h"
 #include "RenderPassDiction.h"
+#include "SkinningManager.h"
 #include "../common/Util.h"
 
 std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool skinned)
 {
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
 	std::wstring vert = skinned ? L"../data/shaders/shadow_map_gen_skinned.vert.spv" : L"../data/shaders/shadow_map_gen.vert.spv";
+	uint32_t vertexFormat = skinned ? (1 << VAFPosition) | (1 << VAFBone) : (1 << VAFPosition);
+	uint32_t vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+
+	// Compute skinned meshes only need their positions read
+	if (skinned && SkinningManager::GetInstance()->IsEnabled())
+	{
+		vert = L"../data/shaders/shadow_map_gen.vert.spv";
+		vertexFormat = (1 << VAFPosition);
+		vertexFormatInMem = VertexFormatPNCTCT;
+	}
+
 	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"", L"" };
-	simpleMaterialInfo.vertexFormat = skinned ? (1 << VAFPosition) | (1 << VAFBone) : (1 << VAFPosition);
-	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	simpleMaterialInfo.vertexFormat = vertexFormat;
+	simpleMaterialInfo.vertexFormatInMem = vertexFormatInMem;
 	simpleMaterialInfo.subpassIndex = 0;
 	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_ShadowMap;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap);
@@ -1,4 +1,5 @@
 #include "SkeletonAnimation.h"
+#include "AnimationClip.h"
 #include "../Maths/AssimpDataConverter.h"
 #include "scene.h"
 #include "UniformData.h"
@@ -19,6 +20,7 @@ bool SkeletonAnimation::Init(const std::shared_ptr<SkeletonAnimation>& pSelf, co
 		AssemblyAnimationData(pAssimpScene->mAnimations[i], animationData);
 
 		m_animationDataDiction.push_back(animationData);
+		m_animationClips.push_back(AnimationClip::Create(animationData));
 		m_animationDataLookupTable[std::hash<std::wstring>()(animationData.animationName)] = (uint32_t)m_animationDataDiction.size() - 1;
 	}
 
@@ -64,7 +66,7 @@ void SkeletonAnimation::AssemblyObjectAnimation(const aiNodeAnim* pAssimpNodeAni
 	for (uint32_t i = 0; i < pAssimpNodeAnimation->mNumPositionKeys; i++)
 	{
 		TranslationKeyFrame translationKeyFrame = {};
-		translationKeyFrame.time = pAssimpNodeAnimation->mRotationKeys[i].mTime;
+		translationKeyFrame.time = pAssimpNodeAnimation->mPositionKeys[i].mTime / ticksPerSecond;
 		translationKeyFrame.transform = AssimpDataConverter::AcquireVector3(pAssimpNodeAnimation->mPositionKeys[i].mValue);
 		objectAnimation.translationKeyFrames.push_back(translationKeyFrame);
 	}
@@ -72,7 +74,7 @@ void SkeletonAnimation::AssemblyObjectAnimation(const aiNodeAnim* pAssimpNodeAni
 	for (uint32_t i = 0; i < pAssimpNodeAnimation->mNumScalingKeys; i++)
 	{
 		ScaleKeyFrame scaleKeyFrame = {};
-		scaleKeyFrame.time = pAssimpNodeAnimation->mRotationKeys[i].mTime;
+		scaleKeyFrame.time = pAssimpNodeAnimation->mScalingKeys[i].mTime / ticksPerSecond;
 		scaleKeyFrame.transform = AssimpDataConverter::AcquireVector3(pAssimpNodeAnimation->mScalingKeys[i].mValue);
 		objectAnimation.ScaleKeyFrames.push_back(scaleKeyFrame);
 	}
@@ -10,6 +10,7 @@ struct aiAnimation;
 struct aiNodeAnim;
 
 class SkeletonAnimationInstance;
+class AnimationClip;
 class AnimationController;
 
 typedef struct _RotationKeyFrame
@@ -54,6 +55,10 @@ protected:
 public:
 	static std::shared_ptr<SkeletonAnimation> Create(const aiScene* pAssimpScene);
 
+public:
+	// Compiled version of animation data at the same index, which is what's sampled at runtime
+	std::shared_ptr<AnimationClip> GetAnimationClip(uint32_t index) const { return m_animationClips[index]; }
+
 protected:
 	static void AssemblyAnimationData(const aiAnimation* pAssimpAnimation, AnimationData& animationData);
 	static void AssemblyObjectAnimation(const aiNodeAnim* pAssimpNodeAnimation, double ticksPerSecond, ObjectAnimation& objectAnimation);
@@ -61,6 +66,7 @@ protected:
 protected:
 	std::vector<AnimationData>						m_animationDataDiction;			// Entire animation dictionary, containing all the data of current assimp scene's animation
 	std::unordered_map<std::size_t, uint32_t>		m_animationDataLookupTable;		// Using this to lookup specific index in animation dictionary
+	std::vector<std::shared_ptr<AnimationClip>>		m_animationClips;				// Compiled animation data, indexed the same way as animation dictionary
 
 	friend class SkeletonAnimationInstance;
 	friend class AnimationController;
@@ -18,6 +18,7 @@ public:
 	std::shared_ptr<SkeletonAnimation> GetAnimation() const { return m_pSkeletonAnimation; }
 	void SetBoneTransform(std::size_t hashCode, uint32_t boneIndex, const DualQuaterniond& dq);
 	uint32_t GetAnimationChunkIndex() const { return m_animationChunk; }
+	uint32_t GetBoneChunkIndexOffset() const { return m_boneChunkIndexOffset; }
 
 protected:
 	std::shared_ptr<SkeletonAnimation>	m_pSkeletonAnimation;
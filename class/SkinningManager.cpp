@@ -0,0 +1,420 @@
+#include "SkinningManager.h"
+#include "UniformData.h"
+#include "Mesh.h"
+#include "SkeletonAnimationInstance.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../vulkan/SwapChain.h"
+#include "../vulkan/DescriptorSetLayout.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/DescriptorPool.h"
+#include "../vulkan/PipelineLayout.h"
+#include "../vulkan/ShaderModule.h"
+#include "../vulkan/ComputePipeline.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/CommandPool.h"
+#include "../vulkan/Queue.h"
+#include "../vulkan/Buffer.h"
+#include "../vulkan/SharedVertexBuffer.h"
+#include "../vulkan/StagingBufferManager.h"
+#include "../vulkan/PerFrameResource.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Nothing of CPU skinning is fused into multiply-adds, same as precise arithmetic of skinning.comp
+#if defined(_MSC_VER)
+#pragma fp_contract (off)
+#endif
+
+const uint32_t SkinningManager::GROUP_SIZE;
+const uint32_t SkinningManager::INVALID_INDEX;
+const uint32_t SkinningManager::SOURCE_VERTEX_FLOATS;
+const uint32_t SkinningManager::SKINNED_VERTEX_FLOATS;
+
+bool SkinningManager::Init()
+{
+	if (!Singleton<SkinningManager>::Init())
+		return false;
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	for (uint32_t i = 0; i < SkinningBinding_Count; i++)
+		bindings.push_back({ i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+	m_pDescriptorSetLayout = DescriptorSetLayout::Create(GetDevice(), bindings);
+
+	std::vector<std::shared_ptr<DescriptorSetLayout>> descriptorSetLayouts = UniformData::GetInstance()->GetDescriptorSetLayouts();
+	descriptorSetLayouts.push_back(m_pDescriptorSetLayout);
+
+	m_pPipelineLayout = PipelineLayout::Create(GetDevice(), descriptorSetLayouts, { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkinningPushConstants) } });
+
+	std::vector<VkDescriptorPoolSize> descPoolSize =
+	{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SkinningBinding_Count }
+	};
+
+	VkDescriptorPoolCreateInfo descPoolInfo = {};
+	descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descPoolInfo.pPoolSizes = descPoolSize.data();
+	descPoolInfo.poolSizeCount = (uint32_t)descPoolSize.size();
+	descPoolInfo.maxSets = 1;
+
+	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
+
+	// Vertex pools don't grow, so one set bound to both of them works for all jobs
+	m_pDescriptorSet = m_pDescriptorPool->AllocateDescriptorSet(m_pDescriptorSetLayout);
+	m_pDescriptorSet->UpdateStorageBuffer(SkinningBinding_SourceVertices, VertexAttribBufferMgr(VertexFormatPNTCTB)->GetBuffer());
+	m_pDescriptorSet->UpdateStorageBuffer(SkinningBinding_SkinnedVertices, VertexAttribBufferMgr(VertexFormatPNCTCT)->GetBuffer());
+
+	// Shader is optional, without it skinning stays in vertex shaders
+	std::shared_ptr<ShaderModule> pShader = ShaderModule::Create(GetDevice(), L"../data/shaders/skinning.comp.spv", ShaderModule::ShaderTypeCompute, "main");
+	if (pShader == nullptr)
+		return true;
+
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	m_pComputePipeline = ComputePipeline::Create(GetDevice(), pipelineCreateInfo, pShader, m_pPipelineLayout);
+
+	return true;
+}
+
+uint32_t SkinningManager::AllocateSkinningJob(const std::shared_ptr<Mesh>& pSourceMesh, const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance)
+{
+	ASSERTION(pSourceMesh->GetVertexFormat() == VertexFormatPNTCTB);
+
+	SkinningJob job;
+	job.pSourceMesh = pSourceMesh;
+	job.pAnimationInstance = pAnimationInstance;
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		std::shared_ptr<Mesh> pTargetMesh = Mesh::CreateSkinningTarget(pSourceMesh);
+		if (pTargetMesh == nullptr)
+			return INVALID_INDEX;
+		job.targetMeshes.push_back(pTargetMesh);
+	}
+
+	uint32_t jobIndex;
+	if (!m_freeJobs.empty())
+	{
+		jobIndex = m_freeJobs.back();
+		m_freeJobs.pop_back();
+		m_jobs[jobIndex] = job;
+	}
+	else
+	{
+		jobIndex = (uint32_t)m_jobs.size();
+		m_jobs.push_back(job);
+	}
+
+	m_statistics.jobCount++;
+
+	return jobIndex;
+}
+
+void SkinningManager::FreeSkinningJob(uint32_t jobIndex)
+{
+	if (jobIndex == INVALID_INDEX)
+		return;
+
+	// Frames in flight could still draw what's skinned into target meshes, their vertices aren't handed out until those frames are done
+	for (auto& pTargetMesh : m_jobs[jobIndex].targetMeshes)
+		FrameMgr()->RetireResource(pTargetMesh);
+
+	m_queuedJobs.erase(std::remove(m_queuedJobs.begin(), m_queuedJobs.end(), jobIndex), m_queuedJobs.end());
+
+	m_jobs[jobIndex] = {};
+	m_freeJobs.push_back(jobIndex);
+
+	m_statistics.jobCount--;
+}
+
+std::shared_ptr<Mesh> SkinningManager::GetSkinnedMesh(uint32_t jobIndex) const
+{
+	return m_jobs[jobIndex].targetMeshes[FrameMgr()->FrameIndex()];
+}
+
+void SkinningManager::QueueSkinning(uint32_t jobIndex)
+{
+	m_queuedJobs.push_back(jobIndex);
+}
+
+void SkinningManager::BindPipeline(const std::shared_ptr<CommandBuffer>& pCmdBuf)
+{
+	std::vector<std::shared_ptr<DescriptorSet>> descriptorSets = UniformData::GetInstance()->GetDescriptorSets();
+	descriptorSets.push_back(m_pDescriptorSet);
+
+	pCmdBuf->BindPipeline(m_pComputePipeline);
+	pCmdBuf->BindDescriptorSets(m_pPipelineLayout, descriptorSets, UniformData::GetInstance()->GetCachedFrameOffsets()[FrameMgr()->FrameIndex()], VK_PIPELINE_BIND_POINT_COMPUTE);
+}
+
+uint32_t SkinningManager::DispatchJob(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t jobIndex)
+{
+	const SkinningJob& job = m_jobs[jobIndex];
+	std::shared_ptr<Mesh> pTargetMesh = job.targetMeshes[FrameMgr()->FrameIndex()];
+
+	SkinningPushConstants pushConstants =
+	{
+		job.pSourceMesh->GetVertexBuffer()->GetBufferOffset() / sizeof(float),
+		pTargetMesh->GetVertexBuffer()->GetBufferOffset() / sizeof(float),
+		job.pSourceMesh->GetVerticesCount(),
+		job.pAnimationInstance->GetAnimationChunkIndex()
+	};
+
+	pCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	pCmdBuf->Dispatch((pushConstants.vertexCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+	return pushConstants.vertexCount;
+}
+
+std::shared_ptr<CommandBuffer> SkinningManager::RecordDispatches()
+{
+	m_statistics.dispatchCount = 0;
+	m_statistics.vertexCount = 0;
+
+	if (!IsEnabled() || m_queuedJobs.empty())
+		return nullptr;
+
+#if defined(_DEBUG)
+	for (uint32_t jobIndex : m_queuedJobs)
+	{
+		if (m_jobs[jobIndex].isValidated)
+			continue;
+
+		ValidationResult result = Validate(jobIndex);
+		ASSERTION(result.passed);
+		m_jobs[jobIndex].isValidated = true;
+	}
+#endif
+
+	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPerFrameRes()->AllocateTransientPrimaryCommandBuffer();
+	pCmdBuffer->StartPrimaryRecording();
+	Dispatch(pCmdBuffer);
+	pCmdBuffer->EndPrimaryRecording();
+
+	return pCmdBuffer;
+}
+
+void SkinningManager::Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf)
+{
+	BindPipeline(pCmdBuf);
+
+	for (uint32_t jobIndex : m_queuedJobs)
+	{
+		m_statistics.vertexCount += DispatchJob(pCmdBuf, jobIndex);
+		m_statistics.dispatchCount++;
+	}
+
+	// Skinned vertices are consumed by vertex input of GBuffer and shadow passes, which are submitted right after this in the same batch
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+	pCmdBuf->AttachBarriers
+	(
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		{ barrier },
+		{},
+		{}
+	);
+}
+
+// Helpers below follow functions of the same names in skinning.comp, operation by operation
+static float InverseSqrt(float x)
+{
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(float));
+	bits = 0x5f375a86u - (bits >> 1);
+
+	float y;
+	memcpy(&y, &bits, sizeof(float));
+	y = y * (1.5f - 0.5f * x * y * y);
+	y = y * (1.5f - 0.5f * x * y * y);
+	y = y * (1.5f - 0.5f * x * y * y);
+	return y;
+}
+
+static void BlendBones(const DualQuaternionf* dqs[4], const float* pBoneWeights, float real[4], float dual[4])
+{
+	float weights[4] = { pBoneWeights[0], pBoneWeights[1], pBoneWeights[2], pBoneWeights[3] };
+
+	// Ensure all bone transforms are in the same neighbourhood
+	for (uint32_t j = 1; j < 4; j++)
+	{
+		float d = dqs[0]->x * dqs[j]->x + dqs[0]->y * dqs[j]->y + dqs[0]->z * dqs[j]->z + dqs[0]->w * dqs[j]->w;
+		if (d < 0.0f)
+			weights[j] = -weights[j];
+	}
+
+	for (uint32_t k = 0; k < 4; k++)
+	{
+		real[k] = weights[0] * (&dqs[0]->x)[k] + weights[1] * (&dqs[1]->x)[k] + weights[2] * (&dqs[2]->x)[k] + weights[3] * (&dqs[3]->x)[k];
+		dual[k] = weights[0] * (&dqs[0]->dx)[k] + weights[1] * (&dqs[1]->dx)[k] + weights[2] * (&dqs[2]->dx)[k] + weights[3] * (&dqs[3]->dx)[k];
+	}
+
+	float lengthSquared = real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3];
+	float invLen = InverseSqrt(lengthSquared);
+	for (uint32_t k = 0; k < 4; k++)
+	{
+		real[k] *= invLen;
+		dual[k] *= invLen;
+	}
+}
+
+// t = 2 * dual * conjugate(real)
+static void Translation(const float real[4], const float dual[4], float translation[3])
+{
+	translation[0] = 2.0f * (real[3] * dual[0] - dual[3] * real[0] + (-dual[1] * real[2] + dual[2] * real[1]));
+	translation[1] = 2.0f * (real[3] * dual[1] - dual[3] * real[1] + (-dual[2] * real[0] + dual[0] * real[2]));
+	translation[2] = 2.0f * (real[3] * dual[2] - dual[3] * real[2] + (-dual[0] * real[1] + dual[1] * real[0]));
+}
+
+// v + 2 * cross(q, w * v + cross(q, v))
+static void Rotate(const float real[4], const float v[3], float rotated[3])
+{
+	float c[3] = { real[1] * v[2] - v[1] * real[2], real[2] * v[0] - v[2] * real[0], real[0] * v[1] - v[0] * real[1] };
+	float u[3] = { real[3] * v[0] + c[0], real[3] * v[1] + c[1], real[3] * v[2] + c[2] };
+	rotated[0] = v[0] + 2.0f * (real[1] * u[2] - u[1] * real[2]);
+	rotated[1] = v[1] + 2.0f * (real[2] * u[0] - u[2] * real[0]);
+	rotated[2] = v[2] + 2.0f * (real[0] * u[1] - u[0] * real[1]);
+}
+
+void SkinningManager::SkinVertices(const float* pSourceVertices, float* pSkinnedVertices, uint32_t vertexCount, const DualQuaternionf* pBoneTransforms, const DualQuaternionf* pPrevBoneTransforms)
+{
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		const float* pSrc = pSourceVertices + i * SOURCE_VERTEX_FLOATS;
+		float* pDst = pSkinnedVertices + i * SKINNED_VERTEX_FLOATS;
+
+		uint32_t boneIndices;
+		memcpy(&boneIndices, &pSrc[15], sizeof(uint32_t));
+
+		const DualQuaternionf* dqs[4];
+		const DualQuaternionf* prevDQs[4];
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			dqs[j] = &pBoneTransforms[(boneIndices >> (j * 8)) & 255];
+			prevDQs[j] = &pPrevBoneTransforms[(boneIndices >> (j * 8)) & 255];
+		}
+
+		float real[4], dual[4], prevReal[4], prevDual[4];
+		BlendBones(dqs, &pSrc[11], real, dual);
+		BlendBones(prevDQs, &pSrc[11], prevReal, prevDual);
+
+		float translation[3], prevTranslation[3];
+		Translation(real, dual, translation);
+		Translation(prevReal, prevDual, prevTranslation);
+
+		float position[3], prevPosition[3], normal[3], tangent[3];
+		Rotate(real, &pSrc[0], position);
+		Rotate(prevReal, &pSrc[0], prevPosition);
+		Rotate(real, &pSrc[3], normal);
+		Rotate(real, &pSrc[8], tangent);
+
+		pDst[0] = position[0] + translation[0];
+		pDst[1] = position[1] + translation[1];
+		pDst[2] = position[2] + translation[2];
+		pDst[3] = normal[0];
+		pDst[4] = normal[1];
+		pDst[5] = normal[2];
+		pDst[6] = prevPosition[0] + prevTranslation[0];
+		pDst[7] = prevPosition[1] + prevTranslation[1];
+		pDst[8] = prevPosition[2] + prevTranslation[2];
+		pDst[9] = 1.0f;
+		pDst[10] = pSrc[6];
+		pDst[11] = pSrc[7];
+		pDst[12] = tangent[0];
+		pDst[13] = tangent[1];
+		pDst[14] = tangent[2];
+	}
+}
+
+SkinningManager::ValidationResult SkinningManager::Validate(uint32_t jobIndex)
+{
+	ValidationResult result;
+	if (!IsSupported())
+		return result;
+
+	const SkinningJob& job = m_jobs[jobIndex];
+	std::shared_ptr<Mesh> pTargetMesh = job.targetMeshes[FrameMgr()->FrameIndex()];
+
+	uint32_t vertexCount = job.pSourceMesh->GetVerticesCount();
+	uint32_t sourceBytes = vertexCount * SOURCE_VERTEX_FLOATS * sizeof(float);
+	uint32_t skinnedBytes = vertexCount * SKINNED_VERTEX_FLOATS * sizeof(float);
+
+	// Source vertices are read back too, so that CPU skins exactly what GPU has
+	VkBufferCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	info.size = sourceBytes + skinnedBytes;
+	std::shared_ptr<Buffer> pReadbackBuffer = Buffer::Create(GetDevice(), info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	StagingBufferMgr()->FlushDataMainThread();
+
+	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPool()->AllocatePrimaryCommandBuffer();
+	pCmdBuffer->StartPrimaryRecording();
+
+	BindPipeline(pCmdBuffer);
+	DispatchJob(pCmdBuffer, jobIndex);
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, { barrier }, {}, {});
+
+	VkBufferCopy copy = {};
+	copy.srcOffset = job.pSourceMesh->GetVertexBuffer()->GetBufferOffset();
+	copy.size = sourceBytes;
+	vkCmdCopyBuffer(pCmdBuffer->GetDeviceHandle(), job.pSourceMesh->GetVertexBuffer()->GetDeviceHandle(), pReadbackBuffer->GetDeviceHandle(), 1, &copy);
+
+	copy.srcOffset = pTargetMesh->GetVertexBuffer()->GetBufferOffset();
+	copy.dstOffset = sourceBytes;
+	copy.size = skinnedBytes;
+	vkCmdCopyBuffer(pCmdBuffer->GetDeviceHandle(), pTargetMesh->GetVertexBuffer()->GetDeviceHandle(), pReadbackBuffer->GetDeviceHandle(), 1, &copy);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, { barrier }, {}, {});
+
+	pCmdBuffer->EndPrimaryRecording();
+
+	GlobalGraphicQueue()->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+
+	std::vector<float> sourceVertices(vertexCount * SOURCE_VERTEX_FLOATS);
+	std::vector<float> gpuVertices(vertexCount * SKINNED_VERTEX_FLOATS);
+	pReadbackBuffer->ReadByteStream(sourceVertices.data(), 0, sourceBytes);
+	pReadbackBuffer->ReadByteStream(gpuVertices.data(), sourceBytes, skinnedBytes);
+
+	// Same bone transforms GPU reads, single precision data of current frame
+	std::shared_ptr<PerBoneUniforms> pBoneUniforms = UniformData::GetInstance()->GetPerFrameBoneUniforms();
+	std::shared_ptr<BoneIndirectUniform> pBoneIndirectUniforms = UniformData::GetInstance()->GetPerFrameBoneIndirectUniforms();
+
+	std::vector<DualQuaternionf> boneTransforms(job.pSourceMesh->GetBoneCount());
+	std::vector<DualQuaternionf> prevBoneTransforms(job.pSourceMesh->GetBoneCount());
+	for (uint32_t i = 0; i < (uint32_t)boneTransforms.size(); i++)
+	{
+		uint32_t boneChunkIndex = pBoneIndirectUniforms->GetBoneChunkIndex(job.pAnimationInstance->GetBoneChunkIndexOffset(), i);
+		boneTransforms[i] = pBoneUniforms->m_singlePrecisionBoneData[boneChunkIndex].currBoneOffsetDQ;
+		prevBoneTransforms[i] = pBoneUniforms->m_singlePrecisionBoneData[boneChunkIndex].prevBoneOffsetDQ;
+	}
+
+	std::vector<float> cpuVertices(vertexCount * SKINNED_VERTEX_FLOATS);
+	SkinVertices(sourceVertices.data(), cpuVertices.data(), vertexCount, boneTransforms.data(), prevBoneTransforms.data());
+
+	result.floatCount = (uint32_t)cpuVertices.size();
+	for (uint32_t i = 0; i < result.floatCount; i++)
+	{
+		if (memcmp(&cpuVertices[i], &gpuVertices[i], sizeof(float)) == 0)
+			continue;
+
+		result.mismatchCount++;
+		float error = std::fabs(cpuVertices[i] - gpuVertices[i]) / std::fmax(1.0f, std::fabs(cpuVertices[i]));
+		result.maxError = std::fmax(result.maxError, error);
+	}
+
+	// Skinning shader avoids sqrt and division, whose precision is up to drivers, so every bit has to match
+	result.passed = result.mismatchCount == 0;
+
+	return result;
+}
\ No newline at end of file
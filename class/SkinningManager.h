@@ -0,0 +1,134 @@
+#pragma once
+#include "../common/Singleton.h"
+#include "../Maths/DualQuaternion.h"
+#include "../vulkan/DeviceObjectBase.h"
+#include <vector>
+
+class DescriptorSetLayout;
+class DescriptorSet;
+class DescriptorPool;
+class PipelineLayout;
+class ComputePipeline;
+class CommandBuffer;
+class Mesh;
+class SkeletonAnimationInstance;
+
+// Optional compute pre-pass that skins each rendered skinned mesh once per frame, rather than once in every pass drawing it
+// Output goes into per frame meshes of "VertexFormatPNCTCT", so GBuffer and shadow passes draw them without skinning in vertex shaders
+// Their color slot carries position skinned with previous frame's bones, which GBuffer turns into motion vectors like skinned vertex shaders do
+//
+// Dispatches are recorded into a command buffer of their own every frame and submitted ahead of prebaked frame commands,
+// as jobs and their vertex offsets change whenever skinned meshes come and go
+//
+// Layout of set 3:
+// 0: whole vertex pool of "VertexFormatPNTCTB", read
+// 1: whole vertex pool of "VertexFormatPNCTCT", written
+class SkinningManager : public Singleton<SkinningManager>
+{
+public:
+	static const uint32_t GROUP_SIZE = 64;
+	static const uint32_t INVALID_INDEX = (uint32_t)-1;
+
+	// Floats of a source vertex and a skinned vertex
+	static const uint32_t SOURCE_VERTEX_FLOATS = 16;
+	static const uint32_t SKINNED_VERTEX_FLOATS = 15;
+
+	enum SkinningBinding
+	{
+		SkinningBinding_SourceVertices,
+		SkinningBinding_SkinnedVertices,
+		SkinningBinding_Count
+	};
+
+	typedef struct _SkinningStatistics
+	{
+		uint32_t	jobCount = 0;
+		// Of current frame
+		uint32_t	dispatchCount = 0;
+		uint32_t	vertexCount = 0;
+	}SkinningStatistics;
+
+	typedef struct _ValidationResult
+	{
+		uint32_t	floatCount = 0;
+		// Floats that aren't bit exact, and the largest relative error among them
+		// Any mismatch fails, as GPU and CPU do the same correctly rounded operations
+		uint32_t	mismatchCount = 0;
+		float		maxError = 0;
+		bool		passed = false;
+	}ValidationResult;
+
+	// Follows push constants of skinning.comp
+	typedef struct _SkinningPushConstants
+	{
+		uint32_t	sourceOffset;
+		uint32_t	skinnedOffset;
+		uint32_t	vertexCount;
+		uint32_t	animationIndex;
+	}SkinningPushConstants;
+
+protected:
+	typedef struct _SkinningJob
+	{
+		std::shared_ptr<Mesh>						pSourceMesh;
+		std::shared_ptr<SkeletonAnimationInstance>	pAnimationInstance;
+		// One per frame, a frame in flight could still be reading what's skinned before
+		std::vector<std::shared_ptr<Mesh>>			targetMeshes;
+		// Checked against CPU skinning the first time it's dispatched, debug only
+		bool										isValidated = false;
+	}SkinningJob;
+
+public:
+	bool Init() override;
+
+public:
+	// False if skinning shader isn't available
+	bool IsSupported() const { return m_pComputePipeline != nullptr; }
+
+	// Skinned materials take vertex format and shaders according to this, so it has to be decided before render work manager is initialized
+	bool IsEnabled() const { return m_isEnabled && IsSupported(); }
+	void SetEnabled(bool isEnabled) { m_isEnabled = isEnabled; }
+
+	uint32_t AllocateSkinningJob(const std::shared_ptr<Mesh>& pSourceMesh, const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance);
+	void FreeSkinningJob(uint32_t jobIndex);
+
+	// What's drawn instead of source mesh in current frame
+	std::shared_ptr<Mesh> GetSkinnedMesh(uint32_t jobIndex) const;
+
+	// Only jobs queued in current frame are dispatched, i.e. meshes rendered by any pass
+	void QueueSkinning(uint32_t jobIndex);
+	// Records dispatches of queued jobs into a command buffer, which has to be submitted ahead of frame commands
+	// Nullptr if there's nothing to skin
+	std::shared_ptr<CommandBuffer> RecordDispatches();
+	void OnFrameEnd() { m_queuedJobs.clear(); }
+
+	const SkinningStatistics& GetStatistics() const { return m_statistics; }
+
+	// CPU twin of skinning.comp, every operation is done in the same order, so that GPU output could be checked against it bit by bit
+	// Bone transforms of current and previous frame are indexed by bone indices packed in source vertices
+	static void SkinVertices(const float* pSourceVertices, float* pSkinnedVertices, uint32_t vertexCount, const DualQuaternionf* pBoneTransforms, const DualQuaternionf* pPrevBoneTransforms);
+
+	// Skins a job on GPU into its mesh of current frame, reads it back and compares it with "SkinVertices"
+	// It waits for GPU to finish, debugging only, and bone data of current frame has to be synced already
+	ValidationResult Validate(uint32_t jobIndex);
+
+protected:
+	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf);
+	void BindPipeline(const std::shared_ptr<CommandBuffer>& pCmdBuf);
+	uint32_t DispatchJob(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t jobIndex);
+
+protected:
+	std::shared_ptr<DescriptorSetLayout>	m_pDescriptorSetLayout;
+	std::shared_ptr<PipelineLayout>			m_pPipelineLayout;
+	std::shared_ptr<ComputePipeline>		m_pComputePipeline;
+	std::shared_ptr<DescriptorPool>			m_pDescriptorPool;
+	std::shared_ptr<DescriptorSet>			m_pDescriptorSet;
+
+	bool									m_isEnabled = false;
+
+	std::vector<SkinningJob>				m_jobs;
+	std::vector<uint32_t>					m_freeJobs;
+	std::vector<uint32_t>					m_queuedJobs;
+
+	SkinningStatistics						m_statistics;
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "TransientDataAllocator.h"
+#include "FrameEventManager.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/PhysicalDevice.h"
+#include "../vulkan/SwapChain.h"
+#include "../vulkan/FrameManager.h"
+#include "../vulkan/Buffer.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../common/Macros.h"
+#include <algorithm>
+
+const uint32_t TransientDataAllocator::INITIAL_FRAME_BYTES;
+const uint32_t TransientDataAllocator::INVALID_OFFSET;
+
+bool TransientDataAllocator::Init()
+{
+	if (!Singleton<TransientDataAllocator>::Init())
+		return false;
+
+	m_minUniformAlignment = (uint32_t)GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment;
+	m_minStorageAlignment = (uint32_t)GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.minStorageBufferOffsetAlignment;
+
+	CreateBuffer(INITIAL_FRAME_BYTES);
+	m_statistics.frameBytes = m_frameBytes;
+
+	FrameEventManager::GetInstance()->Register(m_pInstance);
+
+	return m_pMappedData != nullptr;
+}
+
+void TransientDataAllocator::CreateBuffer(uint32_t frameBytes)
+{
+	// Regions have to start at offsets that suit any alignment asked for
+	uint32_t regionAlign = std::max(std::max(m_minUniformAlignment, m_minStorageAlignment), 256u);
+	m_frameBytes = (frameBytes + regionAlign - 1) / regionAlign * regionAlign;
+
+	VkBufferCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+		| VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+		| VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+		| VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+		| VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+		| VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	info.size = m_frameBytes * GetSwapChain()->GetSwapChainImageCount();
+
+	m_pBuffer = Buffer::Create(GetDevice(), info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	m_pMappedData = (uint8_t*)m_pBuffer->GetMappedDataPtr();
+	ASSERTION(m_pMappedData != nullptr);
+}
+
+TransientDataAllocator::TransientAllocation TransientDataAllocator::Allocate(uint32_t numBytes, uint32_t alignment)
+{
+	ASSERTION(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	m_frameRequestedBytes.fetch_add(numBytes + alignment - 1, std::memory_order_relaxed);
+
+	uint32_t usedBytes = m_frameUsedBytes.load(std::memory_order_relaxed);
+	uint32_t offset;
+	do
+	{
+		offset = (usedBytes + alignment - 1) & ~(alignment - 1);
+		if (offset + numBytes > m_frameBytes)
+		{
+			m_frameFailedCount.fetch_add(1, std::memory_order_relaxed);
+			return TransientAllocation();
+		}
+	} while (!m_frameUsedBytes.compare_exchange_weak(usedBytes, offset + numBytes, std::memory_order_relaxed));
+
+	m_frameAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	TransientAllocation allocation;
+	allocation.offset = m_frameStart + offset;
+	allocation.pData = m_pMappedData + allocation.offset;
+	allocation.numBytes = numBytes;
+	return allocation;
+}
+
+VkDescriptorBufferInfo TransientDataAllocator::GetDescBufferInfo(const TransientAllocation& allocation) const
+{
+	return { m_pBuffer->GetDeviceHandle(), allocation.offset, allocation.numBytes };
+}
+
+void TransientDataAllocator::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t binding, VkDescriptorType descriptorType, uint32_t range) const
+{
+	ASSERTION(descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+	pDescriptorSet->UpdateBufferDynamic(binding, descriptorType, m_pBuffer, range);
+}
+
+// Worker jobs of last frame are done by now, and fence of current frame is waited for while acquiring, so nothing else touches counters here
+void TransientDataAllocator::OnFrameBegin()
+{
+	uint32_t requestedBytes = m_frameRequestedBytes.load(std::memory_order_relaxed);
+
+	m_statistics.allocationCount = m_frameAllocationCount.load(std::memory_order_relaxed);
+	m_statistics.usedBytes = m_frameUsedBytes.load(std::memory_order_relaxed);
+	m_statistics.failedCount = m_frameFailedCount.load(std::memory_order_relaxed);
+	m_statistics.highWaterBytes = std::max(m_statistics.highWaterBytes, requestedBytes);
+
+	// Regions of frames in flight are in old buffer, it's retired rather than waited for
+	if (requestedBytes > m_frameBytes)
+	{
+		uint32_t frameBytes = m_frameBytes;
+		while (frameBytes < requestedBytes)
+			frameBytes *= 2;
+
+		FrameMgr()->RetireResource(m_pBuffer);
+		CreateBuffer(frameBytes);
+		m_bufferVersion++;
+
+		m_statistics.frameBytes = m_frameBytes;
+	}
+
+	m_frameStart = FrameMgr()->FrameIndex() * m_frameBytes;
+	m_frameUsedBytes.store(0, std::memory_order_relaxed);
+	m_frameRequestedBytes.store(0, std::memory_order_relaxed);
+	m_frameAllocationCount.store(0, std::memory_order_relaxed);
+	m_frameFailedCount.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "FrameEventListener.h"
+#include "../vulkan/DeviceObjectBase.h"
+#include <atomic>
+
+class Buffer;
+class DescriptorSet;
+
+// Linear allocator of data that lives for one frame only, e.g. dynamic vertices, instance data, indirect commands, uniforms and upload sources
+// Each frame in flight owns a region of one large persistently mapped buffer, and allocating is a lock free bump within region of current frame,
+// so any worker thread could produce data without a permanent allocation of its own
+// A region is reset at frame begin, when fence of that frame has been waited for, so nothing written before is read by GPU any more
+//
+// Offsets change every frame, so allocations are only referred by commands recorded in current frame, or by dynamic offsets
+class TransientDataAllocator : public Singleton<TransientDataAllocator>, public IFrameEventListener
+{
+public:
+	// Large enough for planet geometry manager to upload its whole triangle budget in one frame
+	static const uint32_t INITIAL_FRAME_BYTES = 8 * 1024 * 1024;
+	static const uint32_t INVALID_OFFSET = (uint32_t)-1;
+
+	typedef struct _TransientAllocation
+	{
+		// Nullptr if region of current frame is used up
+		void*		pData = nullptr;
+		// Offset in buffer, it's also the dynamic offset of a descriptor set up by "SetupDescriptorSet"
+		uint32_t	offset = INVALID_OFFSET;
+		uint32_t	numBytes = 0;
+	}TransientAllocation;
+
+	typedef struct _TransientStatistics
+	{
+		uint32_t	frameBytes = 0;
+		// Of latest finished frame
+		uint32_t	allocationCount = 0;
+		uint32_t	usedBytes = 0;
+		uint32_t	failedCount = 0;
+		// Largest bytes a frame has ever asked for, including failed allocations
+		uint32_t	highWaterBytes = 0;
+	}TransientStatistics;
+
+public:
+	bool Init() override;
+
+public:
+	// Thread safe, "alignment" has to be power of 2
+	TransientAllocation Allocate(uint32_t numBytes, uint32_t alignment = 16);
+	TransientAllocation AllocateUniform(uint32_t numBytes) { return Allocate(numBytes, m_minUniformAlignment); }
+	TransientAllocation AllocateStorage(uint32_t numBytes) { return Allocate(numBytes, m_minStorageAlignment); }
+
+	std::shared_ptr<Buffer> GetBuffer() const { return m_pBuffer; }
+	VkDescriptorBufferInfo GetDescBufferInfo(const TransientAllocation& allocation) const;
+
+	// Binds buffer to a dynamic uniform or storage buffer descriptor with a window of "range" bytes, allocations are then picked by their offsets
+	// Bumped buffer version means buffer has grown, and descriptor sets set up before have to be set up again
+	void SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t binding, VkDescriptorType descriptorType, uint32_t range) const;
+	uint32_t GetBufferVersion() const { return m_bufferVersion; }
+
+	const TransientStatistics& GetStatistics() const { return m_statistics; }
+
+public:
+	void OnFrameBegin() override;
+	void OnFrameEnd() override {}
+
+protected:
+	void CreateBuffer(uint32_t frameBytes);
+
+protected:
+	std::shared_ptr<Buffer>		m_pBuffer;
+	uint8_t*					m_pMappedData = nullptr;
+	uint32_t					m_frameBytes = 0;
+	uint32_t					m_bufferVersion = 0;
+
+	uint32_t					m_minUniformAlignment = 0;
+	uint32_t					m_minStorageAlignment = 0;
+
+	// Start of region of current frame, only changed at frame begin
+	uint32_t					m_frameStart = 0;
+	// Bytes bumped in region of current frame
+	std::atomic<uint32_t>		m_frameUsedBytes = { 0 };
+	// Bytes asked for in current frame, it keeps counting once region is used up, so that buffer knows how large to grow
+	std::atomic<uint32_t>		m_frameRequestedBytes = { 0 };
+	std::atomic<uint32_t>		m_frameAllocationCount = { 0 };
+	std::atomic<uint32_t>		m_frameFailedCount = { 0 };
+
+	TransientStatistics			m_statistics;
+};
\ No newline at end of file
@@ -49,24 +49,36 @@ bool UniformData::Init()
 
 	BuildDescriptorSets();
 
-	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
-	{
-		std::vector<uint32_t> offsets;
-		for (uint32_t i = 0; i < UniformStorageType::PerObjectMaterialVariableBuffer; i++)
-			offsets.push_back(m_uniformStorageBuffers[i]->GetFrameOffset() * frameIndex);
-
-		m_cachedFrameOffsets.push_back(offsets);
-	}
-
 	return true;
 }
 
 void UniformData::SyncDataBuffer()
 {
+	RefreshDescriptorSets();
+
 	for (auto& var : m_uniformStorageBuffers)
 		var->SyncBufferData();
 }
 
+void UniformData::RefreshDescriptorSets()
+{
+	bool bufferChanged = false;
+	for (uint32_t i = 0; i < UniformStorageType::PerObjectMaterialVariableBuffer; i++)
+		bufferChanged |= m_cachedBufferVersions[i] != m_uniformStorageBuffers[i]->GetBufferVersion();
+
+	if (!bufferChanged)
+		return;
+
+	// Old sets keep their pool alive
+	for (auto & pDescriptorSet : m_descriptorSets)
+		FrameMgr()->RetireResource(pDescriptorSet);
+
+	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), m_pDescriptorPool->GetDescriptorSetLayoutBinding());
+	AllocateDescriptorSets();
+
+	m_descriptorSetVersion++;
+}
+
 std::vector<std::vector<UniformVarList>> UniformData::GenerateUniformVarLayout() const
 {
 	std::vector<std::vector<UniformVarList>> layout;
@@ -139,7 +151,7 @@ void UniformData::BuildDescriptorSets()
 					(uint32_t)bindings.size(),
 					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 					1,
-					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
 					nullptr
 					});
 
@@ -150,7 +162,7 @@ void UniformData::BuildDescriptorSets()
 					(uint32_t)bindings.size(),
 					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
 					1,
-					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
 					nullptr
 					});
 
@@ -209,12 +221,16 @@ void UniformData::BuildDescriptorSets()
 
 	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
 
+	AllocateDescriptorSets();
+}
+
+void UniformData::AllocateDescriptorSets()
+{
 	// Allocate descriptor sets according to layouts
+	m_descriptorSets.clear();
 	for (auto & layout : m_descriptorSetLayouts)
 		m_descriptorSets.push_back(m_pDescriptorPool->AllocateDescriptorSet(layout));
 
-
-
 	// Setup descriptor sets data
 
 	// 1. Global descriptor set
@@ -235,4 +251,18 @@ void UniformData::BuildDescriptorSets()
 	// 3. Per object descriptor set
 	m_uniformStorageBuffers[PerObjectVariableBuffer]->SetupDescriptorSet(m_descriptorSets[PerObjectUniformsLocation], 0);
 
+	// Frame offsets change along with buffers
+	m_cachedFrameOffsets.clear();
+	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
+	{
+		std::vector<uint32_t> offsets;
+		for (uint32_t i = 0; i < UniformStorageType::PerObjectMaterialVariableBuffer; i++)
+			offsets.push_back(m_uniformStorageBuffers[i]->GetFrameOffset() * frameIndex);
+
+		m_cachedFrameOffsets.push_back(offsets);
+	}
+
+	m_cachedBufferVersions.clear();
+	for (uint32_t i = 0; i < UniformStorageType::PerObjectMaterialVariableBuffer; i++)
+		m_cachedBufferVersions.push_back(m_uniformStorageBuffers[i]->GetBufferVersion());
 }
\ No newline at end of file
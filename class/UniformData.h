@@ -71,9 +71,15 @@ public:
 
 	std::vector<std::shared_ptr<DescriptorSetLayout>> GetDescriptorSetLayouts() const { return m_descriptorSetLayouts; }
 	std::vector<std::shared_ptr<DescriptorSet>> GetDescriptorSets() const { return m_descriptorSets; }
+	// Bumped whenever descriptor sets above are replaced, anything caching them has to fetch them again
+	uint32_t GetDescriptorSetVersion() const { return m_descriptorSetVersion; }
 
 protected:
 	void BuildDescriptorSets();
+	// Allocates descriptor sets from current pool and binds current buffers of storages to them
+	void AllocateDescriptorSets();
+	// Storages could move to larger buffers, descriptor sets are replaced then, and old ones are retired until frames in flight are done
+	void RefreshDescriptorSets();
 
 protected:
 	std::vector<std::shared_ptr<UniformDataStorage>>		m_uniformStorageBuffers;
@@ -84,4 +90,8 @@ protected:
 	std::vector<std::shared_ptr<DescriptorSet>>				m_descriptorSets;
 
 	std::vector<std::vector<uint32_t>>						m_cachedFrameOffsets;
+
+	// Buffer versions of storages that descriptor sets are written with
+	std::vector<uint32_t>									m_cachedBufferVersions;
+	uint32_t												m_descriptorSetVersion = 0;
 };
\ No newline at end of file
@@ -19,7 +19,9 @@ enum VertexFormat
 	VertexFormatPTC = (1 << VAFPosition) | (1 << VAFTexCoord),
 	VertexFormatPNTC = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord),
 	VertexFormatPNTCT = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent),
-	VertexFormatPNTCTB = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent) | (1 << VAFBone)
+	VertexFormatPNTCTB = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent) | (1 << VAFBone),
+	// Output of compute skinning, color carries previous frame's skinned position
+	VertexFormatPNCTCT = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFColor) | (1 << VAFTexCoord) | (1 << VAFTangent)
 };
 
 // Reserved vertex buffer binding slot, don't use these slot
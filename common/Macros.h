@@ -1,6 +1,4 @@
-#if defined(_WIN32)
 #include <assert.h>
-#endif
 
 #include <iostream>
 
@@ -13,12 +11,14 @@
 #define EXTENSION_VULKAN_DRAW_INDIRECT_COUNT "VK_KHR_draw_indirect_count"
 #define PROJECT_NAME "VulkanLearn"
 
+#if !defined(UINT64_MAX)
 #define UINT64_MAX       0xffffffffffffffffui64
+#endif
 
 #define TO_STRING(x) #x
 
-#if defined(_WIN32)
-#if defined(_DEBUG)
+// Off Windows, debug builds are told by NDEBUG
+#if defined(_DEBUG) || (!defined(_WIN32) && !defined(NDEBUG))
 #define CHECK_VK_ERROR(vkExpress) { \
 	VkResult result = vkExpress; \
 	assert(result == VK_SUCCESS); \
@@ -37,7 +37,6 @@
 #define CHECK_ERROR(vkExpress) vkExpress;
 #define ASSERTION(express) express;
 #endif
-#endif
 
 #define GET_INSTANCE_PROC_ADDR(inst, entrypoint)                        \
 {                                                                       \
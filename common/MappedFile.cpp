@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<MappedFile> MappedFile::Create(const std::string& path)
+{
+	std::shared_ptr<MappedFile> pMappedFile = std::make_shared<MappedFile>();
+	if (pMappedFile.get() && pMappedFile->Init(path))
+		return pMappedFile;
+	return nullptr;
+}
+
+bool MappedFile::Init(const std::string& path)
+{
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	m_hFile = hFile;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+		return false;
+	m_size = (uint64_t)size.QuadPart;
+
+	m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping == nullptr)
+		return false;
+
+	m_pData = (const uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	return m_pData != nullptr;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	m_size = (uint64_t)fileStat.st_size;
+
+	// Mapping stays valid after descriptor is closed
+	void* pData = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (pData == MAP_FAILED)
+		return false;
+
+	m_pData = (const uint8_t*)pData;
+	return true;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(_WIN32)
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile)
+		CloseHandle(m_hFile);
+#else
+	if (m_pData)
+		munmap((void*)m_pData, m_size);
+#endif
+}
+
+bool MappedFile::AcquireFileStamp(const std::string& path, uint64_t& size, uint64_t& modifiedTime)
+{
+#if defined(_WIN32)
+	// "st_mtime" only has seconds, edits within the same second would go unnoticed
+	WIN32_FILE_ATTRIBUTE_DATA fileData;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &fileData))
+		return false;
+
+	size = ((uint64_t)fileData.nFileSizeHigh << 32) | fileData.nFileSizeLow;
+	modifiedTime = (((uint64_t)fileData.ftLastWriteTime.dwHighDateTime << 32) | fileData.ftLastWriteTime.dwLowDateTime) * 100;
+	return true;
+#else
+	struct stat fileStat;
+	if (stat(path.c_str(), &fileStat) != 0)
+		return false;
+
+	size = (uint64_t)fileStat.st_size;
+#if defined(__APPLE__)
+	modifiedTime = (uint64_t)fileStat.st_mtimespec.tv_sec * 1000000000 + (uint64_t)fileStat.st_mtimespec.tv_nsec;
+#else
+	modifiedTime = (uint64_t)fileStat.st_mtim.tv_sec * 1000000000 + (uint64_t)fileStat.st_mtim.tv_nsec;
+#endif
+	return true;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstdint>
+
+// Read-only view of a whole file mapped into memory, it's unmapped once the object is gone
+class MappedFile
+{
+public:
+	static std::shared_ptr<MappedFile> Create(const std::string& path);
+
+	~MappedFile();
+
+public:
+	const uint8_t* GetData() const { return m_pData; }
+	uint64_t GetSize() const { return m_size; }
+
+	// Size and last modified time of a file in nanoseconds, false if it doesn't exist
+	// Time has the finest resolution file system keeps, e.g. 100ns on NTFS, and it's only meant to be compared on the same machine
+	static bool AcquireFileStamp(const std::string& path, uint64_t& size, uint64_t& modifiedTime);
+
+protected:
+	bool Init(const std::string& path);
+
+protected:
+	const uint8_t*	m_pData = nullptr;
+	uint64_t		m_size = 0;
+
+#if defined(_WIN32)
+	void*			m_hFile = nullptr;
+	void*			m_hMapping = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "RadixSort.h"
+
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, uint32_t lowestBit)
+{
+	uint32_t count = (uint32_t)keys.size();
+	if (count < 2)
+		return;
+
+	scratch.resize(count);
+
+	uint64_t varyingBits = 0;
+	for (uint32_t i = 1; i < count; i++)
+		varyingBits |= keys[i] ^ keys[0];
+
+	for (uint32_t shift = lowestBit; shift < 64; shift += 8)
+	{
+		if (((varyingBits >> shift) & 255) == 0)
+			continue;
+
+		uint32_t histogram[256] = {};
+		for (uint32_t i = 0; i < count; i++)
+			histogram[(keys[i] >> shift) & 255]++;
+
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t digitCount = histogram[i];
+			histogram[i] = sum;
+			sum += digitCount;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+			scratch[histogram[(keys[i] >> shift) & 255]++] = keys[i];
+
+		keys.swap(scratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Stable LSD radix sort of 8 bit digits from "lowestBit" up, bits below it are left in the order they come in
+// Digits that are the same for all keys are skipped, e.g. high bits of small IDs
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, uint32_t lowestBit = 0);
\ No newline at end of file
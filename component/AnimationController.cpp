@@ -1,5 +1,4 @@
 #include "AnimationController.h"
-#include "BoneObject.h"
 #include "../class/SkeletonAnimation.h"
 #include "../class/SkeletonAnimationInstance.h"
 #include "../Base/BaseObject.h"
@@ -7,9 +6,12 @@
 #include "../class/UniformData.h"
 #include "../class/Mesh.h"
 #include "../class/Timer.h"
+#include "../class/AnimationManager.h"
 
 DEFINITE_CLASS_RTTI(AnimationController, BaseComponent);
 
+const uint32_t AnimationController::INVALID_INDEX;
+
 std::shared_ptr<AnimationController> AnimationController::Create(const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance)
 {
 	std::shared_ptr<AnimationController> pAnimationController = std::make_shared<AnimationController>();
@@ -25,9 +27,10 @@ bool AnimationController::Init(const std::shared_ptr<AnimationController>& pAnim
 		return false;
 
 	m_pAnimationInstance = pAnimationInstance;
+	m_pAnimationClip = m_pAnimationInstance->GetAnimation()->GetAnimationClip(0);
 
-	m_pCurrentAnimationIndices = new uint32_t[m_pAnimationInstance->GetAnimation()->m_animationDataDiction[0].objectAnimationDiction.size()];
-	memset(m_pCurrentAnimationIndices, 0, sizeof(uint32_t) * m_pAnimationInstance->GetAnimation()->m_animationDataDiction[0].objectAnimationDiction.size());
+	m_trackCursors.resize(m_pAnimationClip->GetTrackCount());
+	m_pose.resize(m_pAnimationClip->GetTrackCount());
 
 	return true;
 }
@@ -36,105 +39,122 @@ void AnimationController::Update()
 {
 	double elapsed = Timer::GetElapsedTime();
 	m_animationPlayedTime += elapsed / 1000.0;
-	m_animationPlayedTime = fmod(m_animationPlayedTime, m_pAnimationInstance->GetAnimation()->m_animationDataDiction[0].duration);
+	m_animationPlayedTime = fmod(m_animationPlayedTime, m_pAnimationClip->GetDuration());
 }
 
-void AnimationController::UpdateBoneTransform(const std::shared_ptr<BaseObject>& pObject)
+void AnimationController::UpdateSkeleton()
 {
-	std::shared_ptr<SkeletonAnimation> pAnimation = m_pAnimationInstance->GetAnimation();
-	auto iter = pAnimation->m_animationDataDiction[0].objectAnimationLookupTable.find(pObject->GetNameHashCode());
+	m_pAnimationClip->SamplePose((float)m_animationPlayedTime, m_trackCursors.data(), m_pose.data());
+
+	std::shared_ptr<PerBoneUniforms> pBoneUniforms = UniformData::GetInstance()->GetPerFrameBoneUniforms();
 
-	// If current object contains animation information, it's local transform will be changed accordingly
-	if (iter != pAnimation->m_animationDataDiction[0].objectAnimationLookupTable.end())
+	for (uint32_t i = 0; i < (uint32_t)m_skeleton.size(); i++)
 	{
-		uint32_t keyFrameCount = (uint32_t)pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames.size();
-		uint32_t currentKeyFrameIndex = m_pCurrentAnimationIndices[iter->second];
+		const SkeletonNode& node = m_skeleton[i];
 
-		// Check if there is actually a next key frame
-		if (m_pCurrentAnimationIndices[iter->second] + 1 < keyFrameCount
-			// And if current keyframe is done, move to next possible animation
-			&& m_animationPlayedTime > pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[m_pCurrentAnimationIndices[iter->second] + 1].time)
-		{
-			do
-			{
-				currentKeyFrameIndex += 1;
-			} while (currentKeyFrameIndex < keyFrameCount
-				&& m_animationPlayedTime > pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[currentKeyFrameIndex].time);
-
-			currentKeyFrameIndex--;
-			m_pCurrentAnimationIndices[iter->second] = currentKeyFrameIndex;
-		}
-		// If the whole animation is done, then start over again(FIXME: should add animation state and configuration later to configure this)
-		else if (m_animationPlayedTime < pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[m_pCurrentAnimationIndices[iter->second]].time)
+		Matrix4f localTransform = node.bindTransform;
+		if (node.animationTrack != INVALID_INDEX)
 		{
-			currentKeyFrameIndex = 0;
+			const AnimationClip::TrackPose& pose = m_pose[node.animationTrack];
+			const Quaternionf& rotation = m_pAnimationClip->HasRotation(node.animationTrack) ? pose.rotation : node.bindRotation;
+			const Vector3f& translation = m_pAnimationClip->HasTranslation(node.animationTrack) ? pose.translation : node.bindTranslation;
 
-			do
-			{
-				currentKeyFrameIndex += 1;
-			} while (m_animationPlayedTime > pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[currentKeyFrameIndex].time);
-
-			currentKeyFrameIndex--;
-			m_pCurrentAnimationIndices[iter->second] = currentKeyFrameIndex;
+			// Same as BaseObject local transform
+			localTransform = Matrix4f(rotation.Matrix() * Matrix3f(node.bindScale), translation);
 		}
 
-		uint32_t nextKeyFrameIndex = currentKeyFrameIndex + 1;
-
-		// To deal with the situation that some object's animation is shorter than the others, therefore it'll keep last key frame until current animation is done
-		if (nextKeyFrameIndex >= keyFrameCount)
-			nextKeyFrameIndex = currentKeyFrameIndex;
-
-		double currentAnimationTime = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[currentKeyFrameIndex].time;
-		double nextAnimationTime = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[nextKeyFrameIndex].time;
-		double factor = (m_animationPlayedTime - currentAnimationTime) / (nextAnimationTime - currentAnimationTime);
+		// Parents are already done, one linear pass is enough
+		if (node.parent == INVALID_INDEX)
+			m_modelTransforms[i] = localTransform;
+		else
+			m_modelTransforms[i] = m_modelTransforms[node.parent] * localTransform;
 
-		// To deal with the situation that some object's animation is shorter than the others, therefore it'll keep last key frame until current animation is done
-		factor = factor > 1.0f ? 1.0f : factor;
-
-		Quaterniond& currentRotation = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[currentKeyFrameIndex].transform;
-		Vector3d& currentTranslation = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].translationKeyFrames[currentKeyFrameIndex].transform;
-
-		Quaterniond& nextRotation = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].rotationKeyFrames[nextKeyFrameIndex].transform;
-		Vector3d& nextTranslation = pAnimation->m_animationDataDiction[0].objectAnimationDiction[iter->second].translationKeyFrames[nextKeyFrameIndex].transform;
-
-		Quaterniond blendRotation = Quaterniond::SLerp(currentRotation, nextRotation, factor);
-		Vector3d blendTranslation = currentTranslation * (1.0f - factor) + nextTranslation * factor;
-
-		pObject->SetRotation(blendRotation);
-		pObject->SetPos(blendTranslation);
+		if (node.boneChunkIndex != INVALID_INDEX)
+		{
+			Matrix4f boneTransform = m_modelTransforms[i] * node.boneOffset;
+			pBoneUniforms->WriteBoneOffsetTransform(node.boneChunkIndex, DualQuaternionf(boneTransform.RotationMatrix(), boneTransform.TranslationVector()));
+		}
 	}
 }
 
-void AnimationController::SyncBoneTransformToUniform(const std::shared_ptr<BaseObject>& pObject, uint32_t boneIndex, const DualQuaterniond& boneOffsetDQ)
+void AnimationController::MarkBonesDirty()
 {
-	Matrix4d transform = GetBaseObject()->GetCachedWorldTransform();
-	transform.Inverse();
-	transform *= pObject->GetCachedWorldTransform();
-	transform *= Matrix4d(boneOffsetDQ.AcquireRotation().Matrix(), boneOffsetDQ.AcquireTranslation());
+	UniformData::GetInstance()->GetPerFrameBoneUniforms()->SetBonesDirty(m_boneChunkIndices);
+}
 
-	m_pAnimationInstance->SetBoneTransform(pObject->GetNameHashCode(), boneIndex, DualQuaterniond(transform.RotationMatrix(), transform.TranslationVector()));
+void AnimationController::ApplyPoseToObjects()
+{
+	for (uint32_t i = 0; i < (uint32_t)m_skeleton.size(); i++)
+	{
+		const SkeletonNode& node = m_skeleton[i];
+		if (node.animationTrack == INVALID_INDEX)
+			continue;
+
+		std::shared_ptr<BaseObject> pObject = m_skeletonObjects[i].lock();
+		if (pObject == nullptr)
+			continue;
+
+		const AnimationClip::TrackPose& pose = m_pose[node.animationTrack];
+		if (m_pAnimationClip->HasRotation(node.animationTrack))
+			pObject->SetRotation(pose.rotation.DoublePrecision());
+		if (m_pAnimationClip->HasTranslation(node.animationTrack))
+			pObject->SetPos(pose.translation.DoublePrecision());
+	}
 }
 
 void AnimationController::OnAddedToObjectInternal(const std::shared_ptr<BaseObject>& pObject)
 {
-	InitBoneObjects(GetBaseObject());
+	m_skeleton.clear();
+	m_skeletonObjects.clear();
+	m_boneChunkIndices.clear();
+
+	// Skeleton is relative to the object controller attached to
+	for (uint32_t i = 0; i < pObject->GetChildrenCount(); i++)
+		BuildSkeleton(pObject->GetChild(i), INVALID_INDEX);
+
+	m_modelTransforms.resize(m_skeleton.size());
+
+	AnimationManager::GetInstance()->RegisterController(std::dynamic_pointer_cast<AnimationController>(GetSelfSharedPtr()));
 }
 
-void AnimationController::InitBoneObjects(std::weak_ptr<BaseObject> pRootObject)
+bool AnimationController::BuildSkeleton(const std::shared_ptr<BaseObject>& pObject, uint32_t parent)
 {
-	if (pRootObject.expired())
-		return;
+	uint32_t nodeIndex = (uint32_t)m_skeleton.size();
+	uint32_t boneCount = (uint32_t)m_boneChunkIndices.size();
+
+	SkeletonNode node;
+	node.parent = parent;
+	node.animationTrack = m_pAnimationClip->FindTrack(pObject->GetNameHashCode());
+	node.boneChunkIndex = INVALID_INDEX;
+	node.bindTransform = pObject->GetLocalTransform().SinglePrecision();
+	node.bindRotation = pObject->GetLocalRotationQ().SinglePrecision();
+	node.bindTranslation = pObject->GetLocalPosition().SinglePrecision();
+	node.bindScale = pObject->GetLocalScale().SinglePrecision();
 
-	std::shared_ptr<BaseObject> pSharedRootObject = pRootObject.lock();
 	DualQuaterniond boneOffsetDQ;
 	uint32_t boneIndex;
-	// Check if current object is a bone
-	if (UniformData::GetInstance()->GetPerBoneIndirectUniforms()->GetBoneInfo(m_pAnimationInstance->GetMesh()->GetMeshBoneChunkIndexOffset(), pSharedRootObject->GetNameHashCode(), boneIndex, boneOffsetDQ))
+	// Check if current object is a bone, bone chunks of this instance are allocated already, so mapping is resolved once here
+	if (UniformData::GetInstance()->GetPerBoneIndirectUniforms()->GetBoneInfo(m_pAnimationInstance->GetMesh()->GetMeshBoneChunkIndexOffset(), pObject->GetNameHashCode(), boneIndex, boneOffsetDQ))
+	{
+		node.boneChunkIndex = UniformData::GetInstance()->GetPerFrameBoneIndirectUniforms()->GetBoneChunkIndex(m_pAnimationInstance->GetBoneChunkIndexOffset(), boneIndex);
+		node.boneOffset = Matrix4d(boneOffsetDQ.AcquireRotation().Matrix(), boneOffsetDQ.AcquireTranslation()).SinglePrecision();
+		m_boneChunkIndices.push_back(node.boneChunkIndex);
+	}
+
+	m_skeleton.push_back(node);
+	m_skeletonObjects.push_back(pObject);
+
+	// Animated objects are kept even if they're not bones, as their local transforms are driven by this controller
+	bool keepSubTree = node.boneChunkIndex != INVALID_INDEX || node.animationTrack != INVALID_INDEX;
+	for (uint32_t i = 0; i < pObject->GetChildrenCount(); i++)
+		keepSubTree |= BuildSkeleton(pObject->GetChild(i), nodeIndex);
+
+	// Nothing to skin or animate in this sub tree
+	if (!keepSubTree)
 	{
-		std::shared_ptr<BoneObject> pBoneObject = BoneObject::Create(std::dynamic_pointer_cast<AnimationController>(GetSelfSharedPtr()), boneIndex, boneOffsetDQ);
-		pSharedRootObject->AddComponent(pBoneObject);
+		m_skeleton.resize(nodeIndex);
+		m_skeletonObjects.resize(nodeIndex);
 	}
 
-	for (uint32_t i = 0; i < pSharedRootObject->GetChildrenCount(); i++)
-		InitBoneObjects(pSharedRootObject->GetChild(i));
+	return keepSubTree;
 }
\ No newline at end of file
@@ -2,36 +2,77 @@
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
 #include "../Maths/DualQuaternion.h"
+#include "../class/AnimationClip.h"
 
 class SkeletonAnimationInstance;
 
+// Plays animation clip on objects under the one it's attached to
+// Skeleton is flattened when controller is added to object, and updated by AnimationManager together with other controllers
 class AnimationController : public BaseComponent
 {
 	DECLARE_CLASS_RTTI(AnimationController);
 
+public:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+protected:
+	// A node of flattened skeleton, parents always come before their children
+	typedef struct _SkeletonNode
+	{
+		uint32_t		parent;				// Index of parent node, INVALID_INDEX if parent is the object controller attached to
+		uint32_t		animationTrack;		// INVALID_INDEX if node isn't animated
+		uint32_t		boneChunkIndex;		// Chunk of per frame bone storage, INVALID_INDEX if node isn't a bone
+
+		// Local transform of node when it's not animated, animated ones only keep scale
+		Matrix4f		bindTransform;
+		Quaternionf		bindRotation;
+		Vector3f		bindTranslation;
+		Vector3f		bindScale;
+
+		Matrix4f		boneOffset;
+	}SkeletonNode;
+
 public:
 	static std::shared_ptr<AnimationController> Create(const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance = nullptr);
-	~AnimationController() { delete[] m_pCurrentAnimationIndices; }
 
 public:
-	void UpdateBoneTransform(const std::shared_ptr<BaseObject>& pObject);
-	void SyncBoneTransformToUniform(const std::shared_ptr<BaseObject>& pObject, uint32_t boneIndex, const DualQuaterniond& boneOffsetDQ);
 	std::shared_ptr<SkeletonAnimationInstance> GetAnimationInstance() const { return m_pAnimationInstance; }
 	double GetAnimationPlayedTime() const { return m_animationPlayedTime; }
+	// Pose of all tracks sampled this frame
+	const std::vector<AnimationClip::TrackPose>& GetPose() const { return m_pose; }
+	// Transforms of skeleton nodes relative to the object controller is attached to, as of last skeleton update
+	const std::vector<Matrix4f>& GetModelTransforms() const { return m_modelTransforms; }
+	uint32_t GetBoneCount() const { return (uint32_t)m_boneChunkIndices.size(); }
 
 	void Update() override;
 
+	// Sample pose, build bone palette and write it into per frame bone storage
+	// It only touches data of this controller and its own bone chunks, so different controllers could be updated concurrently
+	void UpdateSkeleton();
+	// Not thread safe, it follows after skeleton update
+	void MarkBonesDirty();
+	// Not thread safe, writes sampled pose back to local transforms of animated objects, so objects attached under bones follow them
+	void ApplyPoseToObjects();
+
 protected:
 	bool Init(const std::shared_ptr<AnimationController>& pAnimationController, const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance = nullptr);
 
 protected:
 	void OnAddedToObjectInternal(const std::shared_ptr<BaseObject>& pObject) override;
-	void InitBoneObjects(std::weak_ptr<BaseObject> pRootObject);
+	// Returns false if there's neither bone nor animated object in this sub tree, and it's left out
+	bool BuildSkeleton(const std::shared_ptr<BaseObject>& pObject, uint32_t parent);
 
 protected:
 	std::shared_ptr<SkeletonAnimationInstance>	m_pAnimationInstance;
+	std::shared_ptr<AnimationClip>				m_pAnimationClip;
+
+	double		m_animationPlayedTime = 0;
 
-	double		m_animationPlayedTime;
+	std::vector<AnimationClip::TrackCursor>		m_trackCursors;
+	std::vector<AnimationClip::TrackPose>		m_pose;
 
-	uint32_t*	m_pCurrentAnimationIndices;
+	std::vector<SkeletonNode>					m_skeleton;
+	std::vector<std::weak_ptr<BaseObject>>		m_skeletonObjects;
+	std::vector<Matrix4f>						m_modelTransforms;
+	std::vector<uint32_t>						m_boneChunkIndices;
 };
\ No newline at end of file
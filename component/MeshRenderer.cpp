@@ -25,6 +25,8 @@
 #include "../class/Material.h"
 #include "AnimationController.h"
 #include "../class/SkeletonAnimationInstance.h"
+#include "../class/FrustumCullingManager.h"
+#include "../class/SkinningManager.h"
 
 DEFINITE_CLASS_RTTI(MeshRenderer, BaseComponent);
 
@@ -54,7 +56,11 @@ std::shared_ptr<MeshRenderer> MeshRenderer::Create()
 
 MeshRenderer::~MeshRenderer()
 {
-	UniformData::GetInstance()->GetPerObjectUniforms()->FreePreObjectChunk(m_perObjectBufferIndex);
+	if (m_perObjectBufferIndex != ChunkRangeAllocator::INVALID_INDEX)
+		UniformData::GetInstance()->GetPerObjectUniforms()->FreePreObjectChunk(m_perObjectBufferIndex);
+	if (m_boundsIndex != FrustumCullingManager::INVALID_INDEX)
+		FrustumCullingManager::GetInstance()->FreeBounds(m_boundsIndex);
+	SkinningManager::GetInstance()->FreeSkinningJob(m_skinningJobIndex);
 }
 
 bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::shared_ptr<Mesh> pMesh, const std::vector<std::shared_ptr<MaterialInstance>>& materialInstances, const std::shared_ptr<AnimationController>& pAnimationController)
@@ -63,6 +69,14 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 		return false;
 
 	m_pMesh = pMesh;
+	m_pAnimationController = pAnimationController;
+
+	if (m_pMesh != nullptr && m_pAnimationController != nullptr && SkinningManager::GetInstance()->IsEnabled())
+	{
+		m_skinningJobIndex = SkinningManager::GetInstance()->AllocateSkinningJob(m_pMesh, m_pAnimationController->GetAnimationInstance());
+		if (m_skinningJobIndex == SkinningManager::INVALID_INDEX)
+			return false;
+	}
 
 	for (auto & val : materialInstances)
 	{
@@ -70,17 +84,40 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 
 #if defined(_DEBUG)
 		if (m_pMesh != nullptr)
-			ASSERTION(m_pMesh->GetVertexFormat() == val->GetMaterial()->GetVertexFormatInMem());
+		{
+			uint32_t vertexFormat = m_skinningJobIndex == SkinningManager::INVALID_INDEX ? m_pMesh->GetVertexFormat() : SkinningManager::GetInstance()->GetSkinnedMesh(m_skinningJobIndex)->GetVertexFormat();
+			ASSERTION(vertexFormat == val->GetMaterial()->GetVertexFormatInMem());
+		}
 #endif
 	}
 
 	m_perObjectBufferIndex = UniformData::GetInstance()->GetPerObjectUniforms()->AllocatePerObjectChunk();
-
-	m_pAnimationController = pAnimationController;
+	m_boundsIndex = FrustumCullingManager::GetInstance()->AllocateBounds();
 
 	return true;
 }
 
+// Bounds are updated here, so that they are culled in one batch before the first renderer goes into render queue
+void MeshRenderer::OnPreRender()
+{
+	// Skinned mesh moves away from its bind pose bounds, and manual instances are placed by their own per instance data
+	m_isCullable = m_frustumCulling && m_pMesh != nullptr && m_pMesh->HasBounds() && m_pAnimationController == nullptr && m_instanceCount <= 1;
+	if (!m_isCullable)
+	{
+		FrustumCullingManager::GetInstance()->DisableCulling(m_boundsIndex);
+		return;
+	}
+
+	Matrix4d worldTransform = GetBaseObject()->GetCachedWorldTransform();
+
+	double maxScale = 0;
+	for (uint32_t i = 0; i < 3; i++)
+		maxScale = std::fmax(maxScale, worldTransform[i].xyz().Length());
+
+	Vector3d center = worldTransform.TransformAsPoint(m_pMesh->GetBoundingSphereCenter().DoublePrecision());
+	FrustumCullingManager::GetInstance()->SetWorldBounds(m_boundsIndex, center.SinglePrecision(), (float)(m_pMesh->GetBoundingSphereRadius() * maxScale));
+}
+
 void MeshRenderer::OnRenderObject()
 {
 	if (m_pMesh == nullptr)
@@ -95,13 +132,38 @@ void MeshRenderer::OnRenderObject()
 	else
 		UniformData::GetInstance()->GetPerObjectUniforms()->SetModelMatrix(m_perObjectBufferIndex, GetBaseObject()->GetCachedWorldTransform());
 
+	// Skinned once, no matter how many passes draw it
+	std::shared_ptr<Mesh> pMesh = m_pMesh;
+	if (m_skinningJobIndex != SkinningManager::INVALID_INDEX)
+	{
+		SkinningManager::GetInstance()->QueueSkinning(m_skinningJobIndex);
+		pMesh = SkinningManager::GetInstance()->GetSkinnedMesh(m_skinningJobIndex);
+	}
+
 	for (uint32_t i = 0; i < m_materialInstances.size(); i++)
 	{
 		if ((RenderWorkManager::GetInstance()->GetRenderStateMask() & m_materialInstances[i]->GetRenderMask()) == 0)
 			continue;
 
+		// Only passes rendered from main camera or main light are culled
+		// Materials culled by compute shader take everything, and decide visibility on their own
+		uint32_t renderMask = m_materialInstances[i]->GetRenderMask();
+		if (!m_materialInstances[i]->GetMaterial()->IsGPUCullingEnabled())
+		{
+			if ((renderMask & (1 << RenderWorkManager::ShadowMapGen)) != 0)
+			{
+				if (!FrustumCullingManager::GetInstance()->IsVisible(m_boundsIndex, FrustumCullingManager::CullingFrustum_Light))
+					continue;
+			}
+			else if ((renderMask & (1 << RenderWorkManager::Scene)) != 0)
+			{
+				if (!FrustumCullingManager::GetInstance()->IsVisible(m_boundsIndex, FrustumCullingManager::CullingFrustum_Camera))
+					continue;
+			}
+		}
+
 		uint32_t animationChunkIndex = m_pAnimationController == nullptr ? 0 : m_pAnimationController->GetAnimationInstance()->GetAnimationChunkIndex();
 
-		m_materialInstances[i]->InsertIntoRenderQueue(m_pMesh, m_perObjectBufferIndex, m_pMesh->GetMeshChunkIndex(), animationChunkIndex, m_instanceCount, m_startInstance);
+		m_materialInstances[i]->InsertIntoRenderQueue(pMesh, m_perObjectBufferIndex, pMesh->GetMeshChunkIndex(), animationChunkIndex, m_instanceCount, m_startInstance, m_isCullable);
 	}
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include "../Base/BaseComponent.h"
+#include "../class/SkinningManager.h"
+#include "../class/FrustumCullingManager.h"
+#include "../class/ChunkRangeAllocator.h"
 
 class Mesh;
 class Material;
@@ -20,6 +23,7 @@ public:
 	~MeshRenderer();
 
 public:
+	void OnPreRender() override;
 	void OnRenderObject() override;
 
 	std::shared_ptr<Mesh> GetMesh() const { return m_pMesh; }
@@ -29,17 +33,28 @@ public:
 	uint32_t GetStartInstance() const { return m_startInstance; }
 	void SetStartInstance(uint32_t startInstance) { m_startInstance = startInstance; }
 
+	// Renderers whose geometry doesn't follow their transform, like sky box, should turn this off
+	bool GetFrustumCulling() const { return m_frustumCulling; }
+	void SetFrustumCulling(bool frustumCulling) { m_frustumCulling = frustumCulling; }
+
 protected:
 	bool Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::shared_ptr<Mesh> pMesh, const std::vector<std::shared_ptr<MaterialInstance>>& materialInstances, const std::shared_ptr<AnimationController>& pAnimationController);
 
 protected:
 	std::shared_ptr<Mesh>	m_pMesh;
-	uint32_t				m_perObjectBufferIndex;
+	// Init could fail before these are allocated, they're only freed if they're valid
+	uint32_t				m_perObjectBufferIndex = ChunkRangeAllocator::INVALID_INDEX;
+	uint32_t				m_boundsIndex = FrustumCullingManager::INVALID_INDEX;
+	bool					m_frustumCulling = true;
+	bool					m_isCullable = false;
 
 	std::vector<std::shared_ptr<MaterialInstance>> m_materialInstances;
 
 	std::shared_ptr<AnimationController>	m_pAnimationController;
 
+	// Valid if skinning is done by compute pre-pass, what's drawn is then the skinned mesh of current frame
+	uint32_t								m_skinningJobIndex = SkinningManager::INVALID_INDEX;
+
 	// For the same mesh with same material, there's a mechanism to get them rendered with instancing rather than multi indirect command
 	// And a special procedure is invented to use both "DrawID" and "InstanceID" to redirect to the right per-object data chunk
 	// However, when it comes to the need of rendering something with a customized amount of instances, the whole mechanism goes south
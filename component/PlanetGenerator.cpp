@@ -7,9 +7,17 @@
 #include "../scene/SceneGenerator.h"
 #include "../class/UniformData.h"
 #include "PhysicalCamera.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <chrono>
+#include <cstring>
 
 DEFINITE_CLASS_RTTI(PlanetGenerator, BaseComponent);
 
+const uint32_t PlanetGenerator::INVALID_INDEX;
+const uint32_t PlanetGenerator::REBASE_ALTITUDE_FACTOR;
+
 std::shared_ptr<PlanetGenerator> PlanetGenerator::Create(const std::shared_ptr<PhysicalCamera>& pCamera)
 {
 	std::shared_ptr<PlanetGenerator> pPlanetGenerator = std::make_shared<PlanetGenerator>();
@@ -18,6 +26,14 @@ std::shared_ptr<PlanetGenerator> PlanetGenerator::Create(const std::shared_ptr<P
 	return nullptr;
 }
 
+PlanetGenerator::~PlanetGenerator()
+{
+	if (m_treeRadius == 0)
+		return;
+
+	FreeFaceTrees();
+}
+
 bool PlanetGenerator::Init(const std::shared_ptr<PlanetGenerator>& pSelf, const std::shared_ptr<PhysicalCamera>& pCamera)
 {
 	if (!BaseComponent::Init(pSelf))
@@ -130,7 +146,7 @@ void PlanetGenerator::Start()
 	//ASSERTION(m_pMeshRenderer != nullptr);
 }
 
-PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height)
+PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height) const
 {
 	CullState state = CullState::DIVIDE;
 	for (uint32_t i = 0; i < m_cameraFrustumLocal.FrustumFace_COUNT; i++)
@@ -158,7 +174,7 @@ PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& a, const
 	return state;
 }
 
-void PlanetGenerator::SubDivide(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, IcoTriangle*& pOutputTriangles)
+PlanetGenerator::SubDivideResult PlanetGenerator::Classify(uint32_t currentLevel, CullState& state, const Vector3d& a, const Vector3d& b, const Vector3d& c) const
 {
 	// Only perform frustum cull if state is CULL_DIVIDE, as it intersects the volumn
 	if (state == CullState::CULL_DIVIDE)
@@ -168,78 +184,230 @@ void PlanetGenerator::SubDivide(uint32_t currentLevel, CullState state, const Ve
 
 		// Early quit if triangle is totally outside of the volumn
 		if (state == CullState::CULL)
-			return;
+			return SubDivideResult::CULLED;
 
 		// Whatever has left should be either CULL_DIVIDE or DIVIDE
 		// This state will be passed on to the next sub divide level
 	}
 
-	// vector 0 represents triangle normal
-	// vector 1 represents vector from camera position to triangle center
-	m_utilityVector0 = a;
-	m_utilityVector0 += b;
-	m_utilityVector0 += c;
+	// normal represents triangle normal
+	// toCenter represents vector from camera position to triangle center
+	Vector3d normal = a;
+	normal += b;
+	normal += c;
 
-	m_utilityVector1 = m_utilityVector0;
-	m_utilityVector1 /= 3.0;				// Get triangle center
-	m_utilityVector1 -= m_lockedPlanetSpaceCameraPosition;	// Get vector from camera to triangle center
+	Vector3d toCenter = normal;
+	toCenter /= 3.0;							// Get triangle center
+	toCenter -= m_lockedPlanetSpaceCameraPosition;	// Get vector from camera to triangle center
 
-	m_utilityVector0.Normalize();
-	m_utilityVector1.Normalize();
-	
-	if (m_utilityVector1 * m_utilityVector0 > 0.4)
-		return;
+	normal.Normalize();
+	toCenter.Normalize();
 
-	Vector3d camera_relative_a = a - m_lockedPlanetSpaceCameraPosition;
-	Vector3d camera_relative_b = b - m_lockedPlanetSpaceCameraPosition;
-	Vector3d camera_relative_c = c - m_lockedPlanetSpaceCameraPosition;
+	if (toCenter * normal > 0.4)
+		return SubDivideResult::CULLED;
 
-	double distA = camera_relative_a.Length();
-	double distB = camera_relative_b.Length();
-	double distC = camera_relative_c.Length();
+	double distA = (a - m_lockedPlanetSpaceCameraPosition).Length();
+	double distB = (b - m_lockedPlanetSpaceCameraPosition).Length();
+	double distC = (c - m_lockedPlanetSpaceCameraPosition).Length();
 
 	double minDist = std::fmin(std::fmin(distA, distB), distC);
 
 	if (m_distanceLUT[currentLevel] * m_planetRadius <= minDist || currentLevel == MAX_LEVEL)
-	{
-		if (m_toggleCameraInfoUpdate)
-		{
-			pOutputTriangles->a = camera_relative_a.SinglePrecision();
-			pOutputTriangles->b = camera_relative_b.SinglePrecision();
-			pOutputTriangles->c = camera_relative_c.SinglePrecision();
-			pOutputTriangles++;
-		}
-		else
-		{
-			camera_relative_a = a - m_planetSpaceCameraPosition;
-			camera_relative_b = b - m_planetSpaceCameraPosition;
-			camera_relative_c = c - m_planetSpaceCameraPosition;
-
-			pOutputTriangles->a = camera_relative_a.SinglePrecision();
-			pOutputTriangles->b = camera_relative_b.SinglePrecision();
-			pOutputTriangles->c = camera_relative_c.SinglePrecision();
-			pOutputTriangles++;
-		}
-		return;
-	}
+		return SubDivideResult::LEAF;
 
-	Vector3d A, B, C;
-	SceneGenerator::GetInstance()->SubDivideTriangle(a, b, c, A, B, C);
+	return SubDivideResult::DIVIDE;
+}
+
+void PlanetGenerator::DivideTriangle(const Vector3d& a, const Vector3d& b, const Vector3d& c, Vector3d& A, Vector3d& B, Vector3d& C) const
+{
+	SceneGenerator::SubDivideTriangle(a, b, c, A, B, C);
 	A.Normalize();
 	B.Normalize();
 	C.Normalize();
 	A *= m_planetRadius;
 	B *= m_planetRadius;
 	C *= m_planetRadius;
+}
+
+void PlanetGenerator::FreeFaceTrees()
+{
+	for (auto& tree : m_faceTrees)
+	{
+		for (auto& node : tree.nodes)
+		{
+			if (node.slot != INVALID_INDEX)
+				PlanetGeoDataManager::GetInstance()->FreeSlot(node.slot);
+		}
+		tree = FaceTree();
+	}
+	m_leafCount = 0;
+}
+
+void PlanetGenerator::ResetFaceTrees()
+{
+	FreeFaceTrees();
+
+	for (uint32_t i = 0; i < 20; i++)
+	{
+		m_faceTrees[i].nodes.push_back
+		({
+			m_icosahedronVertices[m_icosahedronIndices[i * 3]] * m_planetRadius,
+			m_icosahedronVertices[m_icosahedronIndices[i * 3 + 1]] * m_planetRadius,
+			m_icosahedronVertices[m_icosahedronIndices[i * 3 + 2]] * m_planetRadius,
+			0
+		});
+	}
+	m_leafCount = 20;
+	m_treeRadius = m_planetRadius;
+
+	// Forces a full update, and every visible leaf gets written
+	m_hasRebaseOrigin = false;
+}
+
+void PlanetGenerator::UpdateNode(FaceTree& tree, uint32_t nodeIndex, CullState state, bool rewriteSlots)
+{
+	SubDivideResult result;
+	{
+		const TriangleNode& node = tree.nodes[nodeIndex];
+		result = Classify(node.level, state, node.a, node.b, node.c);
+	}
 
-	SubDivide(currentLevel + 1, state, a, C, B, pOutputTriangles);
-	SubDivide(currentLevel + 1, state, C, b, A, pOutputTriangles);
-	SubDivide(currentLevel + 1, state, B, A, c, pOutputTriangles);
-	SubDivide(currentLevel + 1, state, A, B, C, pOutputTriangles);
+	// Out of budget, it stays as a leaf
+	if (result == SubDivideResult::DIVIDE && tree.nodes[nodeIndex].children == INVALID_INDEX && !SplitNode(tree, nodeIndex))
+		result = SubDivideResult::LEAF;
+
+	if (result == SubDivideResult::DIVIDE)
+	{
+		ReleaseSlot(tree, nodeIndex);
+
+		uint32_t children = tree.nodes[nodeIndex].children;
+		for (uint32_t i = 0; i < 4; i++)
+			UpdateNode(tree, children + i, state, rewriteSlots);
+		return;
+	}
+
+	if (tree.nodes[nodeIndex].children != INVALID_INDEX)
+		MergeNode(tree, nodeIndex);
+
+	if (result == SubDivideResult::CULLED)
+	{
+		ReleaseSlot(tree, nodeIndex);
+		return;
+	}
+
+	if (tree.nodes[nodeIndex].slot == INVALID_INDEX || rewriteSlots)
+		tree.pendingLeaves.push_back(nodeIndex);
+}
+
+bool PlanetGenerator::SplitNode(FaceTree& tree, uint32_t nodeIndex)
+{
+	// 4 children take place of 1 leaf
+	if (m_leafCount.fetch_add(3) + 3 > PlanetGeoDataManager::TRIANGLE_BUDGET)
+	{
+		m_leafCount -= 3;
+		return false;
+	}
+
+	uint32_t children;
+	if (!tree.freeChildren.empty())
+	{
+		children = tree.freeChildren.back();
+		tree.freeChildren.pop_back();
+	}
+	else
+	{
+		children = (uint32_t)tree.nodes.size();
+		tree.nodes.resize(tree.nodes.size() + 4);
+	}
+
+	// Fetched after resize, which might move nodes
+	TriangleNode& node = tree.nodes[nodeIndex];
+
+	Vector3d A, B, C;
+	DivideTriangle(node.a, node.b, node.c, A, B, C);
+
+	tree.nodes[children + 0] = { node.a, C, B, node.level + 1 };
+	tree.nodes[children + 1] = { C, node.b, A, node.level + 1 };
+	tree.nodes[children + 2] = { B, A, node.c, node.level + 1 };
+	tree.nodes[children + 3] = { A, B, C, node.level + 1 };
+
+	node.children = children;
+	tree.splitCount++;
+
+	return true;
+}
+
+void PlanetGenerator::MergeNode(FaceTree& tree, uint32_t nodeIndex)
+{
+	uint32_t children = tree.nodes[nodeIndex].children;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (tree.nodes[children + i].children != INVALID_INDEX)
+			MergeNode(tree, children + i);
+		ReleaseSlot(tree, children + i);
+	}
+
+	tree.freeChildren.push_back(children);
+	tree.nodes[nodeIndex].children = INVALID_INDEX;
+
+	m_leafCount -= 3;
+	tree.mergeCount++;
+}
+
+void PlanetGenerator::ReleaseSlot(FaceTree& tree, uint32_t nodeIndex)
+{
+	TriangleNode& node = tree.nodes[nodeIndex];
+	if (node.slot == INVALID_INDEX)
+		return;
+
+	tree.freedSlots.push_back(node.slot);
+	node.slot = INVALID_INDEX;
+}
+
+void PlanetGenerator::UpdateSlots()
+{
+	// Freed first, so that new leaves reuse them
+	for (auto& tree : m_faceTrees)
+	{
+		for (uint32_t slot : tree.freedSlots)
+			PlanetGeoDataManager::GetInstance()->FreeSlot(slot);
+		tree.freedSlots.clear();
+	}
+
+	for (auto& tree : m_faceTrees)
+	{
+		for (uint32_t nodeIndex : tree.pendingLeaves)
+		{
+			TriangleNode& node = tree.nodes[nodeIndex];
+			if (node.slot == INVALID_INDEX)
+			{
+				// Leaves never exceed triangle budget, so a slot is always available
+				uint32_t slot = PlanetGeoDataManager::GetInstance()->AllocateSlot();
+				ASSERTION(slot != PlanetGeoDataManager::INVALID_SLOT);
+				if (slot == PlanetGeoDataManager::INVALID_SLOT)
+					continue;
+				node.slot = slot;
+			}
+
+			IcoTriangle triangle =
+			{
+				(node.a - m_rebaseOrigin).SinglePrecision(),
+				(node.b - m_rebaseOrigin).SinglePrecision(),
+				(node.c - m_rebaseOrigin).SinglePrecision()
+			};
+			PlanetGeoDataManager::GetInstance()->WriteSlot(node.slot, &triangle);
+		}
+		tree.pendingLeaves.clear();
+
+		m_splitCount += tree.splitCount;
+		m_mergeCount += tree.mergeCount;
+	}
 }
 
 void PlanetGenerator::OnPreRender()
 {
+	auto startTime = std::chrono::high_resolution_clock::now();
+
 	// Transform from world space to planet local space
 	m_utilityTransfrom = GetBaseObject()->GetCachedWorldTransform();
 	m_utilityTransfrom.Inverse();
@@ -257,22 +425,55 @@ void PlanetGenerator::OnPreRender()
 		m_cameraFrustumLocal.Transform(m_utilityTransfrom);
 	}
 
-	uint32_t offsetInBytes;
+	if (m_treeRadius != m_planetRadius)
+		ResetFaceTrees();
+
+	// Slots are relative to rebase origin, it follows real camera rather than locked one, as it's about precision of rendering
+	double altitude = std::fmax(std::fabs(m_planetSpaceCameraPosition.Length() - m_planetRadius), m_distanceLUT[MAX_LEVEL] * m_planetRadius);
+	bool rebase = !m_hasRebaseOrigin || (m_planetSpaceCameraPosition - m_rebaseOrigin).Length() > altitude * REBASE_ALTITUDE_FACTOR;
+	if (rebase)
+	{
+		m_rebaseOrigin = m_planetSpaceCameraPosition;
+		m_hasRebaseOrigin = true;
+	}
+
+	// LOD and culling results only depend on camera info, trees stay as they are if it doesn't change
+	bool cameraChanged = memcmp(&m_updatedCameraPosition, &m_lockedPlanetSpaceCameraPosition, sizeof(Vector3d)) != 0
+		|| memcmp(&m_updatedCameraFrustum, &m_cameraFrustumLocal, sizeof(PyramidFrustumd)) != 0;
 
-	IcoTriangle* pTriangles = (IcoTriangle*)PlanetGeoDataManager::GetInstance()->AcquireDataPtr(offsetInBytes);
-	uint8_t* startPtr = (uint8_t*)pTriangles;
+	m_splitCount = 0;
+	m_mergeCount = 0;
 
-	for (uint32_t i = 0; i < 20; i++)
+	if (cameraChanged || rebase)
 	{
-		SubDivide(0, CullState::CULL_DIVIDE, m_icosahedronVertices[m_icosahedronIndices[i * 3]] * m_planetRadius, m_icosahedronVertices[m_icosahedronIndices[i * 3 + 1]] * m_planetRadius, m_icosahedronVertices[m_icosahedronIndices[i * 3 + 2]] * m_planetRadius, pTriangles);
+		m_updatedCameraPosition = m_lockedPlanetSpaceCameraPosition;
+		m_updatedCameraFrustum = m_cameraFrustumLocal;
+
+		GlobalThreadTaskQueue()->ParallelFor(0, 20, 1, [this, rebase](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				m_faceTrees[i].splitCount = 0;
+				m_faceTrees[i].mergeCount = 0;
+				UpdateNode(m_faceTrees[i], 0, CullState::CULL_DIVIDE, rebase);
+			}
+		}, FrameMgr()->FrameIndex());
+
+		UpdateSlots();
 	}
-	uint32_t updatedSize = (uint32_t)((uint8_t*)pTriangles - startPtr);
 
-	PlanetGeoDataManager::GetInstance()->FinishDataUpdate(updatedSize);
-	
+	// Slots become camera relative with this offset in vertex shader
+	UniformData::GetInstance()->GetGlobalUniforms()->SetPlanetRebaseOffset(m_rebaseOrigin - m_planetSpaceCameraPosition);
+
+	m_triangleCount = PlanetGeoDataManager::GetInstance()->GetUsedSlotCount();
+	m_updatedBytes = PlanetGeoDataManager::GetInstance()->GetUpdatedBytes();
+
+	// Free slots in between hold degenerate triangles
 	if (m_pMeshRenderer != nullptr)
 	{
-		m_pMeshRenderer->SetStartInstance(offsetInBytes / sizeof(IcoTriangle));
-		m_pMeshRenderer->SetInstanceCount(updatedSize / sizeof(IcoTriangle));
+		m_pMeshRenderer->SetStartInstance(0);
+		m_pMeshRenderer->SetInstanceCount(PlanetGeoDataManager::GetInstance()->GetSlotCount());
 	}
+
+	m_lastUpdateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 }
\ No newline at end of file
@@ -3,17 +3,26 @@
 #include "../Maths/Matrix.h"
 #include "../Maths/PyramidFrustum.h"
 #include "../class/PerFrameData.h"
+#include <atomic>
 
 class MeshRenderer;
 class PhysicalCamera;
 
 // The core idea of this class is based on brilliant https://github.com/Illation/PlanetRenderer
+//
+// Each icosahedron face keeps a triangle tree across frames, only nodes whose LOD or culling result changed are split or merged
+// Visible leaves own slots of planet geometry buffer, and a slot is only rewritten when its leaf shows up
+// Slots hold triangles relative to a rebase origin rather than camera, so that they stay valid while camera moves
 class PlanetGenerator : public BaseComponent
 {
 	DECLARE_CLASS_RTTI(PlanetGenerator);
 
 	static const uint32_t MAX_LEVEL = 32;
 	static const uint32_t TRIANGLE_SCREEN_SIZE = 400;
+	static const uint32_t INVALID_INDEX = (uint32_t)-1;
+	// Rebase origin moves to camera once camera is this many altitudes away from it, triangles are all rewritten then
+	// Float error of triangles near camera stays relative to altitude, which is far below a pixel at that distance
+	static const uint32_t REBASE_ALTITUDE_FACTOR = 64;
 
 	enum class CullState
 	{
@@ -22,6 +31,13 @@ class PlanetGenerator : public BaseComponent
 		DIVIDE			// If a triangle is fully inside a volumn
 	};
 
+	enum class SubDivideResult
+	{
+		CULLED,			// Triangle is culled by frustum or faces away from camera
+		LEAF,			// Triangle is small enough to be output
+		DIVIDE			// Triangle has to be divided further
+	};
+
 	typedef struct _IcoTriangle
 	{
 		// A triangle consists of 3 vertices, a, b and c
@@ -30,9 +46,38 @@ class PlanetGenerator : public BaseComponent
 		Vector3f	c;
 	}IcoTriangle;
 
+	typedef struct _TriangleNode
+	{
+		Vector3d	a;
+		Vector3d	b;
+		Vector3d	c;
+		uint32_t	level;
+		// The first one of 4 consecutive children, or "INVALID_INDEX" if it's a leaf
+		uint32_t	children = INVALID_INDEX;
+		// Slot in planet geometry buffer, only visible leaves have one
+		uint32_t	slot = INVALID_INDEX;
+	}TriangleNode;
+
+	typedef struct _FaceTree
+	{
+		// Root comes first, children are allocated 4 at a time
+		std::vector<TriangleNode>	nodes;
+		std::vector<uint32_t>		freeChildren;
+
+		// Slots are shared by all faces, so faces only collect slot changes while they're updated in parallel
+		std::vector<uint32_t>		freedSlots;
+		// Visible leaves that need their slots written
+		std::vector<uint32_t>		pendingLeaves;
+
+		uint32_t					splitCount = 0;
+		uint32_t					mergeCount = 0;
+	}FaceTree;
+
 public:
 	static std::shared_ptr<PlanetGenerator> Create(const std::shared_ptr<PhysicalCamera>& pCamera);
 
+	~PlanetGenerator();
+
 public:
 	double GetPlanetRadius() const { return m_planetRadius; }
 	void SetPlanetRadius(double radius) { m_planetRadius = radius; }
@@ -41,8 +86,22 @@ protected:
 	bool Init(const std::shared_ptr<PlanetGenerator>& pSelf, const std::shared_ptr<PhysicalCamera>& pCamera);
 
 protected:
-	CullState FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height);
-	void SubDivide(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, IcoTriangle*& pOutputTriangles);
+	CullState FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height) const;
+	SubDivideResult Classify(uint32_t currentLevel, CullState& state, const Vector3d& a, const Vector3d& b, const Vector3d& c) const;
+	void DivideTriangle(const Vector3d& a, const Vector3d& b, const Vector3d& c, Vector3d& A, Vector3d& B, Vector3d& C) const;
+
+	// Drops all trees and their slots, and starts over from icosahedron faces of current radius
+	void ResetFaceTrees();
+	void FreeFaceTrees();
+
+	// Only touches its own tree, so faces are free to be updated concurrently
+	void UpdateNode(FaceTree& tree, uint32_t nodeIndex, CullState state, bool rewriteSlots);
+	bool SplitNode(FaceTree& tree, uint32_t nodeIndex);
+	void MergeNode(FaceTree& tree, uint32_t nodeIndex);
+	void ReleaseSlot(FaceTree& tree, uint32_t nodeIndex);
+
+	// Applies slot changes collected by faces on calling thread
+	void UpdateSlots();
 
 public:
 	void Start() override;
@@ -51,6 +110,13 @@ public:
 public:
 	void ToggleCameraInfoUpdate(bool flag) { m_toggleCameraInfoUpdate = flag; }
 
+	// Statistics of last update
+	uint32_t GetTriangleCount() const { return m_triangleCount; }
+	uint32_t GetSplitCount() const { return m_splitCount; }
+	uint32_t GetMergeCount() const { return m_mergeCount; }
+	uint32_t GetUpdatedBytes() const { return m_updatedBytes; }
+	double GetLastUpdateTime() const { return m_lastUpdateTime; }
+
 private:
 	double			m_planetRadius = 1;
 
@@ -64,8 +130,25 @@ private:
 
 	// Utility variables, to avoid frequent construction and destruction every frame
 	Matrix4d		m_utilityTransfrom;
-	Vector3d		m_utilityVector0;
-	Vector3d		m_utilityVector1;
+
+	FaceTree				m_faceTrees[20];
+	// Radius that trees are built with
+	double					m_treeRadius = 0;
+	// Leaves of all trees, including culled ones, they're kept within triangle budget of planet geometry buffer
+	std::atomic<uint32_t>	m_leafCount = { 0 };
+
+	Vector3d		m_rebaseOrigin;
+	bool			m_hasRebaseOrigin = false;
+
+	// Camera info trees are updated with, nothing is updated if it stays the same
+	PyramidFrustumd	m_updatedCameraFrustum;
+	Vector3d		m_updatedCameraPosition;
+
+	uint32_t		m_triangleCount = 0;
+	uint32_t		m_splitCount = 0;
+	uint32_t		m_mergeCount = 0;
+	uint32_t		m_updatedBytes = 0;
+	double			m_lastUpdateTime = 0;
 
 	// Camera infor in planet local space
 	PyramidFrustumd	m_cameraFrustumLocal;
@@ -1,5 +1,5 @@
 @echo off
-for /r %%i in (*.frag *.vert) do (
+for /r %%i in (*.frag *.vert *.comp) do (
 	For %%A in (%%i) do (
 		Set Folder=%%~dpA
 		Set Name=%%~nxA
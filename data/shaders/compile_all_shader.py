@@ -29,4 +29,5 @@ def compile_shader(abs_path, ext):
 cur_path = os.path.dirname(os.path.abspath(__file__))
 	
 compile_shader(cur_path, 'vert')
-compile_shader(cur_path, 'frag')
\ No newline at end of file
+compile_shader(cur_path, 'frag')
+compile_shader(cur_path, 'comp')
\ No newline at end of file
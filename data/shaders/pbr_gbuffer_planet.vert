@@ -26,7 +26,10 @@ void main()
 	int perObjectIndex = objectDataIndex[indirectIndex].perObjectIndex;
 
 
-	vec3 position = inTriangleVertexA * inBarycentricCoord.x + inTriangleVertexB * inBarycentricCoord.y + inTriangleVertexC * inBarycentricCoord.z;
+	// Triangles are stored relative to planet rebase origin, this offset brings them relative to camera
+	vec3 rebaseOffset = globalData.PlanetRenderingSettings.yzw;
+
+	vec3 position = inTriangleVertexA * inBarycentricCoord.x + inTriangleVertexB * inBarycentricCoord.y + inTriangleVertexC * inBarycentricCoord.z + rebaseOffset;
 
 	int vertexID = gl_VertexIndex % 3;
 	if (vertexID == 0)
@@ -52,7 +55,7 @@ void main()
 
 	float distToCamera = length(position);
 	// FIXME: Remove this when I have a per-planet uniform containing planet related data including planet radius
-	float radius = length(inTriangleVertexA + perFrameData.wsCameraPosition.xyz);
+	float radius = length(inTriangleVertexA + rebaseOffset + perFrameData.wsCameraPosition.xyz);
 
 	// Add a bias to adjust the factor
 	float factor = distToCamera / (radius * globalData.PlanetRenderingSettings.x);
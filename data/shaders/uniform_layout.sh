@@ -163,6 +163,8 @@ layout(set = 2, binding = 0) buffer PerObjectUniforms
 	PerObjectData perObjectData[];
 };
 
+// Compute passes bringing their own set 3 define this to leave material indirect buffers out
+#if !defined(NO_MATERIAL_INDIRECT_LAYOUT)
 layout(set = 3, binding = 1) buffer PerMaterialIndirectUniformOffset
 {
 	IndirectOffset indirectOffsets[];
@@ -172,5 +174,6 @@ layout(set = 3, binding = 2) buffer PerMaterialIndirectUniforms
 {
 	ObjectDataIndex objectDataIndex[];
 };
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+// Times evaluating skeletons of 100 bones each frame
+// "Before" follows the per bone path AnimationController used, hash lookup and key walk over double precision animation data
+// "After" samples a compiled AnimationClip once per skeleton into a pose, and each bone copies its track of it
+// Poses of both paths are checked against each other
+
+#include "Benchmark.h"
+#include "../class/AnimationClip.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint32_t SKELETON_COUNT = 1000;
+static const uint32_t BONE_COUNT = 100;
+static const uint32_t KEY_COUNT = 60;
+static const double DURATION = 2.0;
+static const uint32_t FRAME_COUNT = 150;
+static const double FRAME_TIME = 1.0 / 60.0;
+
+static AnimationData CreateAnimationData()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+	AnimationData animationData = {};
+	animationData.duration = DURATION;
+
+	for (uint32_t bone = 0; bone < BONE_COUNT; bone++)
+	{
+		ObjectAnimation objectAnimation = {};
+		objectAnimation.objectName = L"Bone" + std::to_wstring(bone);
+
+		// Every 4th bone turns fast enough between keys for slerp, the rest are blended with nlerp
+		Vector3d axis = Vector3d(distribution(random), distribution(random), distribution(random)).Normal();
+		double angleStep = bone % 4 == 0 ? 0.5 : 0.05;
+
+		for (uint32_t key = 0; key < KEY_COUNT; key++)
+		{
+			double time = DURATION * key / (KEY_COUNT - 1);
+			objectAnimation.rotationKeyFrames.push_back({ time, Quaterniond(axis, angleStep * key) });
+			objectAnimation.translationKeyFrames.push_back({ time, Vector3d(distribution(random), distribution(random), distribution(random)) });
+		}
+
+		animationData.objectAnimationDiction.push_back(objectAnimation);
+		animationData.objectAnimationLookupTable[std::hash<std::wstring>()(objectAnimation.objectName)] = bone;
+	}
+
+	return animationData;
+}
+
+typedef struct _BonePose
+{
+	Quaterniond		rotation;
+	Vector3d		translation;
+}BonePose;
+
+// Per bone update of AnimationController before compiled clips, translation keys borrowed rotation key times
+class AnimationDataSkeleton
+{
+public:
+	AnimationDataSkeleton(const AnimationData& animationData, const std::vector<std::size_t>& boneNameHashCodes)
+		: m_animationData(animationData), m_boneNameHashCodes(boneNameHashCodes), m_currentAnimationIndices(animationData.objectAnimationDiction.size(), 0), m_bonePoses(boneNameHashCodes.size()) {}
+
+	void Update(double animationPlayedTime)
+	{
+		for (uint32_t bone = 0; bone < (uint32_t)m_boneNameHashCodes.size(); bone++)
+			UpdateBoneTransform(animationPlayedTime, bone);
+	}
+
+	const BonePose& GetBonePose(uint32_t bone) const { return m_bonePoses[bone]; }
+
+private:
+	void UpdateBoneTransform(double animationPlayedTime, uint32_t bone)
+	{
+		auto iter = m_animationData.objectAnimationLookupTable.find(m_boneNameHashCodes[bone]);
+		if (iter == m_animationData.objectAnimationLookupTable.end())
+			return;
+
+		const ObjectAnimation& objectAnimation = m_animationData.objectAnimationDiction[iter->second];
+		uint32_t keyFrameCount = (uint32_t)objectAnimation.rotationKeyFrames.size();
+		uint32_t currentKeyFrameIndex = m_currentAnimationIndices[iter->second];
+
+		if (currentKeyFrameIndex + 1 < keyFrameCount && animationPlayedTime > objectAnimation.rotationKeyFrames[currentKeyFrameIndex + 1].time)
+		{
+			do
+			{
+				currentKeyFrameIndex += 1;
+			} while (currentKeyFrameIndex < keyFrameCount && animationPlayedTime > objectAnimation.rotationKeyFrames[currentKeyFrameIndex].time);
+
+			currentKeyFrameIndex--;
+			m_currentAnimationIndices[iter->second] = currentKeyFrameIndex;
+		}
+		else if (animationPlayedTime < objectAnimation.rotationKeyFrames[currentKeyFrameIndex].time)
+		{
+			currentKeyFrameIndex = 0;
+
+			do
+			{
+				currentKeyFrameIndex += 1;
+			} while (animationPlayedTime > objectAnimation.rotationKeyFrames[currentKeyFrameIndex].time);
+
+			currentKeyFrameIndex--;
+			m_currentAnimationIndices[iter->second] = currentKeyFrameIndex;
+		}
+
+		uint32_t nextKeyFrameIndex = currentKeyFrameIndex + 1;
+		if (nextKeyFrameIndex >= keyFrameCount)
+			nextKeyFrameIndex = currentKeyFrameIndex;
+
+		double currentAnimationTime = objectAnimation.rotationKeyFrames[currentKeyFrameIndex].time;
+		double nextAnimationTime = objectAnimation.rotationKeyFrames[nextKeyFrameIndex].time;
+		double factor = (animationPlayedTime - currentAnimationTime) / (nextAnimationTime - currentAnimationTime);
+		factor = factor > 1.0f ? 1.0f : factor;
+
+		const Quaterniond& currentRotation = objectAnimation.rotationKeyFrames[currentKeyFrameIndex].transform;
+		const Vector3d& currentTranslation = objectAnimation.translationKeyFrames[currentKeyFrameIndex].transform;
+		const Quaterniond& nextRotation = objectAnimation.rotationKeyFrames[nextKeyFrameIndex].transform;
+		const Vector3d& nextTranslation = objectAnimation.translationKeyFrames[nextKeyFrameIndex].transform;
+
+		m_bonePoses[bone].rotation = Quaterniond::SLerp(currentRotation, nextRotation, factor);
+		m_bonePoses[bone].translation = currentTranslation * (1.0f - factor) + nextTranslation * factor;
+	}
+
+private:
+	const AnimationData&		m_animationData;
+	std::vector<std::size_t>	m_boneNameHashCodes;
+	std::vector<uint32_t>		m_currentAnimationIndices;
+	std::vector<BonePose>		m_bonePoses;
+};
+
+// AnimationController and BoneObject as they are now, tracks are resolved once
+class AnimationClipSkeleton
+{
+public:
+	AnimationClipSkeleton(const std::shared_ptr<AnimationClip>& pAnimationClip, const std::vector<std::size_t>& boneNameHashCodes)
+		: m_pAnimationClip(pAnimationClip), m_trackCursors(pAnimationClip->GetTrackCount()), m_pose(pAnimationClip->GetTrackCount()), m_bonePoses(boneNameHashCodes.size())
+	{
+		for (std::size_t nameHashCode : boneNameHashCodes)
+			m_boneTracks.push_back(pAnimationClip->FindTrack(nameHashCode));
+	}
+
+	void Update(double animationPlayedTime)
+	{
+		m_pAnimationClip->SamplePose((float)animationPlayedTime, m_trackCursors.data(), m_pose.data());
+
+		for (uint32_t bone = 0; bone < (uint32_t)m_boneTracks.size(); bone++)
+		{
+			if (m_boneTracks[bone] == AnimationClip::INVALID_TRACK)
+				continue;
+
+			const AnimationClip::TrackPose& pose = m_pose[m_boneTracks[bone]];
+			m_bonePoses[bone].rotation = pose.rotation.DoublePrecision();
+			m_bonePoses[bone].translation = pose.translation.DoublePrecision();
+		}
+	}
+
+	const BonePose& GetBonePose(uint32_t bone) const { return m_bonePoses[bone]; }
+
+private:
+	std::shared_ptr<AnimationClip>			m_pAnimationClip;
+	std::vector<uint32_t>					m_boneTracks;
+	std::vector<AnimationClip::TrackCursor>	m_trackCursors;
+	std::vector<AnimationClip::TrackPose>	m_pose;
+	std::vector<BonePose>					m_bonePoses;
+};
+
+// Long enough to loop over animation once
+template <typename Skeleton>
+static double TimeSkeletons(std::vector<Skeleton>& skeletons)
+{
+	double animationPlayedTime = 0;
+	return TimeMilliseconds([&]()
+	{
+		animationPlayedTime = fmod(animationPlayedTime + FRAME_TIME, DURATION);
+		for (auto& skeleton : skeletons)
+			skeleton.Update(animationPlayedTime);
+	}, FRAME_COUNT);
+}
+
+int main()
+{
+	AnimationData animationData = CreateAnimationData();
+	std::shared_ptr<AnimationClip> pAnimationClip = AnimationClip::Create(animationData);
+
+	std::vector<std::size_t> boneNameHashCodes;
+	for (auto& objectAnimation : animationData.objectAnimationDiction)
+		boneNameHashCodes.push_back(std::hash<std::wstring>()(objectAnimation.objectName));
+
+	std::vector<AnimationDataSkeleton> animationDataSkeletons(SKELETON_COUNT, AnimationDataSkeleton(animationData, boneNameHashCodes));
+	std::vector<AnimationClipSkeleton> animationClipSkeletons(SKELETON_COUNT, AnimationClipSkeleton(pAnimationClip, boneNameHashCodes));
+
+	double animationDataTime = TimeSkeletons(animationDataSkeletons);
+	double animationClipTime = TimeSkeletons(animationClipSkeletons);
+
+	// Both paths ended on the same frame, clip only differs by float precision and nlerp of close keys
+	double maxRotationError = 0, maxTranslationError = 0;
+	for (uint32_t bone = 0; bone < BONE_COUNT; bone++)
+	{
+		const BonePose& reference = animationDataSkeletons[0].GetBonePose(bone);
+		const BonePose& pose = animationClipSkeletons[0].GetBonePose(bone);
+
+		double cosom = std::abs(Quaterniond::Dot(reference.rotation, pose.rotation));
+		maxRotationError = std::max(maxRotationError, 1.0 - std::min(cosom, 1.0));
+		maxTranslationError = std::max(maxTranslationError, (reference.translation - pose.translation).Length());
+	}
+
+	printf("%u skeletons of %u bones, %u keys per bone, average of %u frames\n", SKELETON_COUNT, BONE_COUNT, KEY_COUNT, FRAME_COUNT);
+	printf("Per bone animation data: %.3f ms per frame\n", animationDataTime);
+	printf("Compiled clip: %.3f ms per frame\n", animationClipTime);
+	printf("Max rotation error (1 - |cos|): %g, max translation error: %g\n", maxRotationError, maxTranslationError);
+
+	Check(maxRotationError < 1e-6, "clip rotations match animation data");
+	Check(maxTranslationError < 1e-5, "clip translations match animation data");
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+
+// Shared by standalone checks and benchmarks under tests, each of them is a single source file that includes this once
+// Failed checks are printed and counted, main ends with "return Report();" so that ctest gets the verdict
+
+static uint32_t failureCount = 0;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("Failed: %s\n", what);
+		failureCount++;
+	}
+}
+
+// Average milliseconds of "roundCount" calls to "function"
+template <typename Function>
+static double TimeMilliseconds(Function function, uint32_t roundCount = 1)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (uint32_t round = 0; round < roundCount; round++)
+		function();
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count() / roundCount;
+}
+
+static int Report()
+{
+	printf(failureCount == 0 ? "Passed\n" : "Failed\n");
+	return failureCount == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+// Runs random allocations and frees through ChunkRangeAllocator, and checks every result against a plain array of free flags
+// Also times 100k per object chunks allocated with growth the way ChunkBasedUniforms does, freed and allocated again
+
+#include "Benchmark.h"
+#include "../class/ChunkRangeAllocator.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint32_t PAGE_CHUNKS = 256;
+static const uint32_t OPERATION_COUNT = 40000;
+static const uint32_t MAX_CHECKED_CAPACITY = 8 * PAGE_CHUNKS;
+static const uint32_t OBJECT_COUNT = 100000;
+
+typedef struct _Allocation
+{
+	uint32_t	index;
+	uint32_t	chunkCount;
+}Allocation;
+
+// Free flags, and free runs worked out of them the slow way
+class ReferenceChunks
+{
+public:
+	void Grow(uint32_t chunkCapacity) { m_free.resize(chunkCapacity, true); }
+
+	void Set(uint32_t index, uint32_t chunkCount, bool isFree)
+	{
+		for (uint32_t i = index; i < index + chunkCount; i++)
+			m_free[i] = isFree;
+	}
+
+	bool IsAll(uint32_t index, uint32_t chunkCount, bool isFree) const
+	{
+		for (uint32_t i = index; i < index + chunkCount; i++)
+		{
+			if (m_free[i] != isFree)
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t GetLowestFree() const
+	{
+		return (uint32_t)(std::find(m_free.begin(), m_free.end(), true) - m_free.begin());
+	}
+
+	uint32_t GetFreeCount() const { return (uint32_t)std::count(m_free.begin(), m_free.end(), true); }
+
+	// Runs of free chunks as [start, end)
+	std::vector<std::pair<uint32_t, uint32_t>> GetFreeRuns() const
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> runs;
+		for (uint32_t i = 0; i < (uint32_t)m_free.size(); i++)
+		{
+			if (!m_free[i])
+				continue;
+			if (runs.empty() || runs.back().second != i)
+				runs.push_back({ i, i + 1 });
+			else
+				runs.back().second++;
+		}
+		return runs;
+	}
+
+	// Size of smallest free run that holds "chunkCount", 0 if there's none
+	uint32_t GetBestFitSize(uint32_t chunkCount) const
+	{
+		uint32_t bestSize = 0;
+		for (auto& run : GetFreeRuns())
+		{
+			uint32_t size = run.second - run.first;
+			if (size >= chunkCount && (bestSize == 0 || size < bestSize))
+				bestSize = size;
+		}
+		return bestSize;
+	}
+
+	// Size of free run that "index" is the start of, before it's allocated
+	uint32_t GetRunSize(uint32_t index) const
+	{
+		for (auto& run : GetFreeRuns())
+		{
+			if (run.first <= index && index < run.second)
+				return run.first == index ? run.second - run.first : 0;
+		}
+		return 0;
+	}
+
+private:
+	std::vector<bool>	m_free;
+};
+
+static void CheckRandomOperations()
+{
+	ChunkRangeAllocator allocator;
+	ReferenceChunks reference;
+	std::mt19937 random(1);
+
+	allocator.Grow(PAGE_CHUNKS);
+	reference.Grow(PAGE_CHUNKS);
+
+	std::vector<Allocation> allocations;
+	uint32_t growCount = 0, badFreeCount = 0;
+
+	for (uint32_t i = 0; i < OPERATION_COUNT; i++)
+	{
+		uint32_t operation = random() % 100;
+
+		// Lean towards allocating until range is mostly used
+		bool allocate = allocations.empty() || operation < (allocator.GetFreeChunkCount() > allocator.GetChunkCapacity() / 4 ? 55u : 45u);
+		if (allocate)
+		{
+			// Mostly single chunks of per object data, some runs of material or indirect data
+			uint32_t chunkCount = random() % 4 == 0 ? 1 + random() % 64 : 1;
+
+			uint32_t index = chunkCount == 1 ? allocator.AllocateChunk() : allocator.AllocateConsecutiveChunks(chunkCount);
+			if (index == ChunkRangeAllocator::INVALID_INDEX)
+			{
+				Check(reference.GetBestFitSize(chunkCount) == 0, "allocation only fails if no free range is large enough");
+
+				// Capacity is capped so reference checks stay cheap, beyond that chunks are only freed
+				if (allocator.GetChunkCapacity() < MAX_CHECKED_CAPACITY)
+				{
+					allocator.Grow(allocator.GetChunkCapacity() * 2);
+					reference.Grow(allocator.GetChunkCapacity());
+					growCount++;
+				}
+				continue;
+			}
+
+			Check(index + chunkCount <= allocator.GetChunkCapacity(), "allocation is within capacity");
+			Check(reference.IsAll(index, chunkCount, true), "allocated chunks were free");
+			if (chunkCount == 1)
+				Check(index == reference.GetLowestFree(), "single chunk is the lowest free one");
+			else
+				Check(reference.GetRunSize(index) == reference.GetBestFitSize(chunkCount), "consecutive chunks start the smallest range that fits");
+
+			reference.Set(index, chunkCount, false);
+			allocations.push_back({ index, chunkCount });
+		}
+		else if (operation < 95)
+		{
+			uint32_t allocationIndex = random() % allocations.size();
+			Allocation allocation = allocations[allocationIndex];
+
+			Check(allocator.FreeConsecutiveChunks(allocation.index, allocation.chunkCount), "live chunks could be freed");
+			reference.Set(allocation.index, allocation.chunkCount, true);
+
+			allocations[allocationIndex] = allocations.back();
+			allocations.pop_back();
+		}
+		else
+		{
+			// Range that's partly or fully free already, or out of capacity, mustn't change anything
+			uint32_t index = random() % (allocator.GetChunkCapacity() + 8);
+			uint32_t chunkCount = 1 + random() % 8;
+			bool isAllocated = index + chunkCount <= allocator.GetChunkCapacity() && reference.IsAll(index, chunkCount, false);
+			if (isAllocated)
+				continue;
+
+			uint32_t freeChunkCount = allocator.GetFreeChunkCount(), freeRangeCount = allocator.GetFreeRangeCount();
+			Check(!allocator.FreeConsecutiveChunks(index, chunkCount), "bad free is refused");
+			Check(allocator.GetFreeChunkCount() == freeChunkCount && allocator.GetFreeRangeCount() == freeRangeCount, "bad free leaves ranges as they are");
+			badFreeCount++;
+		}
+
+		Check(allocator.GetFreeChunkCount() == reference.GetFreeCount(), "free chunk count matches reference");
+		Check(allocator.GetFreeRangeCount() == reference.GetFreeRuns().size(), "free ranges are coalesced as far as they go");
+	}
+
+	printf("%u operations, %u live allocations, grown %u times to %u chunks, %u bad frees refused, %u free ranges\n",
+		OPERATION_COUNT, (uint32_t)allocations.size(), growCount, allocator.GetChunkCapacity(), badFreeCount, allocator.GetFreeRangeCount());
+
+	// All free ranges merge back into one
+	for (auto& allocation : allocations)
+		allocator.FreeConsecutiveChunks(allocation.index, allocation.chunkCount);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetFreeChunkCount() == allocator.GetChunkCapacity(), "free ranges merge back into one");
+}
+
+static void CheckGrow()
+{
+	ChunkRangeAllocator allocator;
+	allocator.Grow(PAGE_CHUNKS);
+
+	// Last chunk in use, new chunks are a range of their own
+	Check(allocator.AllocateConsecutiveChunks(PAGE_CHUNKS) == 0, "whole capacity could be allocated");
+	Check(allocator.GetTrailingFreeChunkCount() == 0, "nothing trails a full range");
+	allocator.Grow(PAGE_CHUNKS * 2);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetTrailingFreeChunkCount() == PAGE_CHUNKS, "grown chunks are one trailing range");
+
+	// Last chunks free, new chunks join them
+	allocator.FreeConsecutiveChunks(PAGE_CHUNKS - 16, 16);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetTrailingFreeChunkCount() == PAGE_CHUNKS + 16, "freed chunks join trailing range");
+	allocator.Grow(PAGE_CHUNKS * 4);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetTrailingFreeChunkCount() == PAGE_CHUNKS * 3 + 16, "grown chunks join trailing range");
+	Check(allocator.AllocateConsecutiveChunks(PAGE_CHUNKS * 3 + 16) == PAGE_CHUNKS - 16, "joined range could be allocated in one piece");
+
+	// Shrinking isn't a thing
+	allocator.Grow(PAGE_CHUNKS);
+	Check(allocator.GetChunkCapacity() == PAGE_CHUNKS * 4, "capacity never shrinks");
+}
+
+static void ReportThroughput()
+{
+	ChunkRangeAllocator allocator;
+	allocator.Grow(PAGE_CHUNKS);
+
+	std::mt19937 random(2);
+	std::vector<uint32_t> indices(OBJECT_COUNT);
+	uint32_t growCount = 0;
+
+	// Page count doubles whenever chunks run out, as ChunkBasedUniforms::Grow does
+	double allocateTime = TimeMilliseconds([&]()
+	{
+		for (auto& index : indices)
+		{
+			index = allocator.AllocateChunk();
+			if (index == ChunkRangeAllocator::INVALID_INDEX)
+			{
+				allocator.Grow(allocator.GetChunkCapacity() * 2);
+				index = allocator.AllocateChunk();
+				growCount++;
+			}
+		}
+	});
+
+	std::shuffle(indices.begin(), indices.end(), random);
+	uint32_t freeEnd = OBJECT_COUNT / 2;
+
+	double freeTime = TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < freeEnd; i++)
+			allocator.FreeConsecutiveChunks(indices[i], 1);
+	});
+
+	uint32_t scatteredRangeCount = allocator.GetFreeRangeCount();
+
+	double reallocateTime = TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < freeEnd; i++)
+			indices[i] = allocator.AllocateChunk();
+	});
+
+	Check(allocator.GetFreeChunkCount() == allocator.GetChunkCapacity() - OBJECT_COUNT, "reallocated chunks fill freed ones");
+
+	printf("%u objects: allocated in %.3f ms with %u grows to %u chunks, half freed in %.3f ms into %u ranges, allocated again in %.3f ms\n",
+		OBJECT_COUNT, allocateTime, growCount, allocator.GetChunkCapacity(), freeTime, scatteredRangeCount, reallocateTime);
+}
+
+int main()
+{
+	CheckRandomOperations();
+	CheckGrow();
+	ReportThroughput();
+
+	return Report();
+}
\ No newline at end of file
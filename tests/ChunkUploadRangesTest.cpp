@@ -0,0 +1,168 @@
+// Marks chunks pending the way ChunkBasedUniforms does, and checks byte ranges each frame flushes
+// Covers adjacent and overlapping chunks, small and large gaps, ranges across bit words and pages, full uploads, growth, and reset after a flush
+// Then checks random pending sets against the chunks they're made of
+
+#include "Benchmark.h"
+#include "../class/ChunkUploadRanges.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Same as ChunkBasedUniforms
+static const uint32_t PAGE_CHUNKS = 256;
+static const uint32_t COALESCE_GAP_BYTES = 256;
+static const uint32_t PER_CHUNK_BYTES = 128;
+static const uint32_t MAX_GAP_CHUNKS = COALESCE_GAP_BYTES / PER_CHUNK_BYTES;
+static const uint32_t FRAME_COUNT = 3;
+static const uint32_t RANDOM_ROUND_COUNT = 2000;
+
+// Byte offset in a frame's region, and byte count
+typedef std::vector<std::pair<uint32_t, uint32_t>> ByteRanges;
+
+static ByteRanges FlushBytes(ChunkUploadRanges& uploadRanges, uint32_t frameIndex)
+{
+	std::vector<ChunkUploadRanges::Range> ranges;
+	uploadRanges.Flush(frameIndex, ranges);
+
+	ByteRanges byteRanges;
+	for (auto& range : ranges)
+		byteRanges.push_back({ range.start * PER_CHUNK_BYTES, (range.end - range.start) * PER_CHUNK_BYTES });
+	return byteRanges;
+}
+
+static void SetChunksPending(ChunkUploadRanges& uploadRanges, uint32_t start, uint32_t end)
+{
+	for (uint32_t i = start; i < end; i++)
+		uploadRanges.SetChunkPending(i);
+}
+
+static ByteRanges ChunkBytes(std::initializer_list<std::pair<uint32_t, uint32_t>> chunkRanges)
+{
+	ByteRanges byteRanges;
+	for (auto& range : chunkRanges)
+		byteRanges.push_back({ range.first * PER_CHUNK_BYTES, (range.second - range.first) * PER_CHUNK_BYTES });
+	return byteRanges;
+}
+
+int main()
+{
+	ChunkUploadRanges uploadRanges;
+	uploadRanges.Init(FRAME_COUNT, PER_CHUNK_BYTES, COALESCE_GAP_BYTES);
+	uploadRanges.Resize(2 * PAGE_CHUNKS);
+
+	Check(FlushBytes(uploadRanges, 0).empty(), "nothing is flushed before any chunk is pending");
+
+	// Adjacent chunks make one range
+	SetChunksPending(uploadRanges, 10, 13);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 10, 13 } }), "adjacent chunks are flushed as one range");
+
+	// Overlapping updates, chunks set twice are flushed once
+	SetChunksPending(uploadRanges, 20, 25);
+	SetChunksPending(uploadRanges, 22, 28);
+	uploadRanges.SetChunkPending(24);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 20, 28 } }), "overlapping chunks are flushed as one range");
+
+	// Gaps up to COALESCE_GAP_BYTES are uploaded along, larger ones split ranges
+	uploadRanges.SetChunkPending(40);
+	uploadRanges.SetChunkPending(40 + 1 + MAX_GAP_CHUNKS);
+	uploadRanges.SetChunkPending(80);
+	uploadRanges.SetChunkPending(80 + 2 + MAX_GAP_CHUNKS);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 40, 42 + MAX_GAP_CHUNKS }, { 80, 80 + 1 }, { 82 + MAX_GAP_CHUNKS, 83 + MAX_GAP_CHUNKS } }), "gap of COALESCE_GAP_BYTES is merged, a larger one isn't");
+
+	// Chunks across a bit word, and across a page, which is still one range in buffer
+	SetChunksPending(uploadRanges, 62, 67);
+	SetChunksPending(uploadRanges, PAGE_CHUNKS - 3, PAGE_CHUNKS + 2);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 62, 67 }, { PAGE_CHUNKS - 3, PAGE_CHUNKS + 2 } }), "ranges across bit word and page boundary");
+
+	// Last chunk of capacity ends a range
+	SetChunksPending(uploadRanges, 2 * PAGE_CHUNKS - 2, 2 * PAGE_CHUNKS);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 2 * PAGE_CHUNKS - 2, 2 * PAGE_CHUNKS } }), "range at end of capacity");
+
+	// Reset after a flush: frame 0 has nothing left, others still have everything pending since they've never flushed
+	Check(FlushBytes(uploadRanges, 0).empty(), "nothing is flushed again after a flush");
+	bool isAnyPending = false;
+	for (uint32_t i = 0; i < uploadRanges.GetChunkCapacity(); i++)
+		isAnyPending |= uploadRanges.IsChunkPending(0, i);
+	Check(!isAnyPending, "no chunk is pending after a flush");
+	Check(uploadRanges.IsChunkPending(1, 10) && uploadRanges.IsChunkPending(2, PAGE_CHUNKS), "other frames keep their pending chunks");
+
+	ByteRanges frame1Ranges = FlushBytes(uploadRanges, 1);
+	Check(frame1Ranges == ChunkBytes({ { 10, 13 }, { 20, 28 }, { 40, 42 + MAX_GAP_CHUNKS }, { 62, 67 }, { 80, 80 + 1 }, { 82 + MAX_GAP_CHUNKS, 83 + MAX_GAP_CHUNKS }, { PAGE_CHUNKS - 3, PAGE_CHUNKS + 2 }, { 2 * PAGE_CHUNKS - 2, 2 * PAGE_CHUNKS } }), "frame that hasn't flushed gets every pending chunk");
+	Check(FlushBytes(uploadRanges, 1).empty(), "nothing is flushed again after catching up");
+	FlushBytes(uploadRanges, 2);
+
+	// Chunk set pending after a flush is only in next flush
+	uploadRanges.SetChunkPending(5);
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 5, 6 } }), "chunk pending after a flush is flushed next time");
+	Check(FlushBytes(uploadRanges, 0).empty(), "and only once");
+
+	// Growth keeps pending chunks, new ones aren't pending until buffer asks for a full upload
+	uploadRanges.SetChunkPending(7);
+	uploadRanges.Resize(4 * PAGE_CHUNKS);
+	Check(uploadRanges.IsChunkPending(0, 7) && !uploadRanges.IsChunkPending(0, 3 * PAGE_CHUNKS), "pending chunks are kept on growth, new ones aren't pending");
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 7, 8 } }), "pending chunk is flushed after growth");
+	uploadRanges.SetChunkPending(3 * PAGE_CHUNKS);
+	uploadRanges.SetFullUpload();
+	Check(FlushBytes(uploadRanges, 0) == ChunkBytes({ { 0, 4 * PAGE_CHUNKS } }), "full upload is the whole capacity");
+	Check(FlushBytes(uploadRanges, 0).empty(), "full upload resets pending chunks too");
+	Check(FlushBytes(uploadRanges, 1) == ChunkBytes({ { 0, 4 * PAGE_CHUNKS } }), "full upload is for every frame");
+
+	// Random pending sets: ranges are ascending, cover every pending chunk, start and end at pending ones, and are split only by gaps larger than COALESCE_GAP_BYTES
+	std::mt19937 generator(11);
+	std::uniform_int_distribution<uint32_t> chunkDistribution(0, 4 * PAGE_CHUNKS - 1);
+	std::uniform_int_distribution<uint32_t> countDistribution(0, 200);
+	std::uniform_int_distribution<uint32_t> lengthDistribution(1, 8);
+
+	for (uint32_t i = 0; i < FRAME_COUNT; i++)
+		FlushBytes(uploadRanges, i);
+
+	bool isEveryRoundCorrect = true;
+	for (uint32_t round = 0; round < RANDOM_ROUND_COUNT && isEveryRoundCorrect; round++)
+	{
+		std::vector<bool> pending(uploadRanges.GetChunkCapacity(), false);
+		uint32_t updateCount = countDistribution(generator);
+		for (uint32_t i = 0; i < updateCount; i++)
+		{
+			uint32_t start = chunkDistribution(generator);
+			uint32_t end = std::min(start + lengthDistribution(generator), uploadRanges.GetChunkCapacity());
+			SetChunksPending(uploadRanges, start, end);
+			for (uint32_t j = start; j < end; j++)
+				pending[j] = true;
+		}
+
+		std::vector<ChunkUploadRanges::Range> ranges;
+		uploadRanges.Flush(round % FRAME_COUNT, ranges);
+
+		std::vector<bool> covered(pending.size(), false);
+		for (uint32_t i = 0; i < (uint32_t)ranges.size(); i++)
+		{
+			const ChunkUploadRanges::Range& range = ranges[i];
+			isEveryRoundCorrect &= range.start < range.end && pending[range.start] && pending[range.end - 1];
+			if (i > 0)
+				isEveryRoundCorrect &= range.start > ranges[i - 1].end && range.start - ranges[i - 1].end > MAX_GAP_CHUNKS;
+
+			uint32_t gapChunks = 0;
+			for (uint32_t j = range.start; j < range.end; j++)
+			{
+				covered[j] = true;
+				gapChunks = pending[j] ? 0 : gapChunks + 1;
+				isEveryRoundCorrect &= gapChunks <= MAX_GAP_CHUNKS;
+			}
+		}
+		for (uint32_t i = 0; i < (uint32_t)pending.size(); i++)
+			isEveryRoundCorrect &= !pending[i] || covered[i];
+
+		// Other frames have the same chunks pending, flush them to start next round clean
+		for (uint32_t i = 1; i < FRAME_COUNT; i++)
+		{
+			std::vector<ChunkUploadRanges::Range> otherRanges;
+			uploadRanges.Flush((round + i) % FRAME_COUNT, otherRanges);
+			isEveryRoundCorrect &= otherRanges.size() == ranges.size();
+			for (uint32_t j = 0; j < (uint32_t)otherRanges.size() && j < (uint32_t)ranges.size(); j++)
+				isEveryRoundCorrect &= otherRanges[j].start == ranges[j].start && otherRanges[j].end == ranges[j].end;
+		}
+	}
+	Check(isEveryRoundCorrect, "random pending chunks are covered by coalesced ranges, the same for every frame");
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+// Times a frame pass over 20k objects with 30k components, walked the ways BaseObject could go through them
+// "Recursive" is the virtual call per node while recursing the tree that passes used to be, "scene order" is the flat list passes use now,
+// and "per type" walks the dense pools of ComponentRegistry one type after another
+// Also times GetComponent against scanning component lists, and filling a reused vector from GetComponents
+
+#include "Benchmark.h"
+#include "../Base/BaseObject.h"
+#include <vector>
+
+static const uint32_t OBJECT_COUNT = 20000;
+static const uint32_t BRANCH_COUNT = 8;
+static const uint32_t ROUND_COUNT = 50;
+
+class MoverComponent : public BaseComponent
+{
+	DECLARE_CLASS_RTTI(MoverComponent);
+
+public:
+	static std::shared_ptr<MoverComponent> Create()
+	{
+		std::shared_ptr<MoverComponent> pComp = std::make_shared<MoverComponent>();
+		if (pComp.get() && pComp->Init(pComp))
+			return pComp;
+		return nullptr;
+	}
+
+	void Update() override { m_updateCount++; }
+
+	uint32_t m_updateCount = 0;
+};
+
+class SpinnerComponent : public BaseComponent
+{
+	DECLARE_CLASS_RTTI(SpinnerComponent);
+
+public:
+	static std::shared_ptr<SpinnerComponent> Create()
+	{
+		std::shared_ptr<SpinnerComponent> pComp = std::make_shared<SpinnerComponent>();
+		if (pComp.get() && pComp->Init(pComp))
+			return pComp;
+		return nullptr;
+	}
+
+	void Update() override { m_updateCount++; }
+
+	uint32_t m_updateCount = 0;
+};
+
+DEFINITE_CLASS_RTTI(MoverComponent, BaseComponent);
+DEFINITE_CLASS_RTTI(SpinnerComponent, BaseComponent);
+
+// Adds the old recursive pass and component scan, which need the protected lists
+class BenchmarkObject : public BaseObject
+{
+public:
+	static std::shared_ptr<BenchmarkObject> Create()
+	{
+		std::shared_ptr<BenchmarkObject> pObj = std::make_shared<BenchmarkObject>();
+		if (pObj.get() && pObj->Init(pObj))
+			return pObj;
+		return nullptr;
+	}
+
+	void RecursiveUpdate()
+	{
+		for (auto & pComp : m_components)
+			pComp->Update();
+		for (auto & pChild : m_children)
+			std::static_pointer_cast<BenchmarkObject>(pChild)->RecursiveUpdate();
+	}
+
+	template <typename T>
+	std::shared_ptr<T> ScanComponent() const
+	{
+		for (auto & pComp : m_components)
+		{
+			if (pComp->IsSameClass(T::ClassHashCode))
+				return std::static_pointer_cast<T>(pComp);
+		}
+		return nullptr;
+	}
+};
+
+int main()
+{
+	// Breadth first, so that parent of object i is (i - 1) / BRANCH_COUNT. Every object moves, every other one spins too
+	std::vector<std::shared_ptr<BenchmarkObject>> objects;
+	std::vector<std::shared_ptr<MoverComponent>> movers;
+	std::vector<std::shared_ptr<SpinnerComponent>> spinners;
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		objects.push_back(BenchmarkObject::Create());
+		if (i > 0)
+			objects[(i - 1) / BRANCH_COUNT]->AddChild(objects[i]);
+
+		movers.push_back(MoverComponent::Create());
+		objects[i]->AddComponent(movers.back());
+
+		if (i % 2 == 0)
+		{
+			spinners.push_back(SpinnerComponent::Create());
+			objects[i]->AddComponent(spinners.back());
+		}
+	}
+
+	uint32_t componentCount = (uint32_t)(movers.size() + spinners.size());
+	auto countUpdates = [&]()
+	{
+		uint64_t count = 0;
+		for (auto & pMover : movers)
+			count += pMover->m_updateCount;
+		for (auto & pSpinner : spinners)
+			count += pSpinner->m_updateCount;
+		return count;
+	};
+
+	std::shared_ptr<BenchmarkObject> pRoot = objects[0];
+
+	// First scene pass collects the list, it isn't part of timing
+	pRoot->Update();
+	uint64_t expectedCount = componentCount;
+
+	double recursiveTime = TimeMilliseconds([&]() { pRoot->RecursiveUpdate(); }, ROUND_COUNT);
+	expectedCount += componentCount * ROUND_COUNT;
+	Check(countUpdates() == expectedCount, "recursive pass updates every component");
+
+	double sceneOrderTime = TimeMilliseconds([&]() { pRoot->Update(); }, ROUND_COUNT);
+	expectedCount += componentCount * ROUND_COUNT;
+	Check(countUpdates() == expectedCount, "scene order pass updates every component");
+
+	double perTypeTime = TimeMilliseconds([&]()
+	{
+		ComponentRegistry::GetInstance()->ForEach<MoverComponent>([](MoverComponent* pComp) { pComp->Update(); });
+		ComponentRegistry::GetInstance()->ForEach<SpinnerComponent>([](SpinnerComponent* pComp) { pComp->Update(); });
+	}, ROUND_COUNT);
+	expectedCount += componentCount * ROUND_COUNT;
+	Check(countUpdates() == expectedCount, "per type pass updates every component");
+
+	printf("%u objects, %u components, average of %u rounds\n", OBJECT_COUNT, componentCount, ROUND_COUNT);
+	printf("Recursive pass: %.3f ms, scene order pass: %.3f ms, per type pass: %.3f ms\n", recursiveTime, sceneOrderTime, perTypeTime);
+
+	// Spinner is second in its object, so a scan passes the mover first. Objects here have at most 2 components, GetComponent scans them too
+	uint32_t foundCount = 0;
+	double lookupTime = TimeMilliseconds([&]()
+	{
+		for (auto & pObj : objects)
+			foundCount += pObj->GetComponent<SpinnerComponent>() != nullptr;
+	}, ROUND_COUNT);
+	Check(foundCount == spinners.size() * ROUND_COUNT, "GetComponent finds every spinner");
+
+	foundCount = 0;
+	double scanLookupTime = TimeMilliseconds([&]()
+	{
+		for (auto & pObj : objects)
+			foundCount += pObj->ScanComponent<SpinnerComponent>() != nullptr;
+	}, ROUND_COUNT);
+	Check(foundCount == spinners.size() * ROUND_COUNT, "scan finds every spinner");
+
+	printf("Spinner of all objects: %.3f ms through GetComponent, %.3f ms scanning\n", lookupTime, scanLookupTime);
+
+	// A vector returned by value allocates each call, a reused one only grows once
+	uint32_t filledCount = 0;
+	double newVectorTime = TimeMilliseconds([&]()
+	{
+		for (auto & pObj : objects)
+		{
+			std::vector<std::shared_ptr<MoverComponent>> components;
+			pObj->GetComponents<MoverComponent>(components);
+			filledCount += (uint32_t)components.size();
+		}
+	}, ROUND_COUNT);
+
+	std::vector<std::shared_ptr<MoverComponent>> components;
+	double reusedVectorTime = TimeMilliseconds([&]()
+	{
+		for (auto & pObj : objects)
+		{
+			components.clear();
+			pObj->GetComponents<MoverComponent>(components);
+			filledCount += (uint32_t)components.size();
+		}
+	}, ROUND_COUNT);
+	Check(filledCount == 2 * OBJECT_COUNT * ROUND_COUNT, "GetComponents finds every mover");
+
+	printf("GetComponents of all objects: %.3f ms into a new vector each, %.3f ms into a reused one\n", newVectorTime, reusedVectorTime);
+
+	return Report();
+}
\ No newline at end of file
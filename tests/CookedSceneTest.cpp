@@ -0,0 +1,200 @@
+// Cooks a synthetic scene, maps it back and compares every vertex, index and bone byte with what went in
+// Also checks node tables, data alignment, and that stale or broken containers are turned down
+// Reports time to cook, to map and validate, and to read all mesh data through mapping vs reading whole file with a stream
+
+#include "Benchmark.h"
+#include "../class/CookedScene.h"
+#include "../common/MappedFile.h"
+#include "../common/Enums.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <random>
+#include <cstring>
+#include <cstdio>
+
+static const uint32_t MESH_COUNT = 16;
+static const uint32_t VERTEX_COUNT = 65536;
+static const uint32_t INDEX_COUNT = VERTEX_COUNT * 3;
+// "VertexFormatPNTCT", bone data of skinned meshes goes with their bone table only
+static const uint32_t VERTEX_BYTES = 14 * sizeof(float);
+static const uint32_t SKINNED_MESH_INTERVAL = 4;
+static const uint32_t BONE_COUNT = 48;
+static const uint32_t IMPORT_FLAGS = 0x800B;
+static const char* SOURCE_PATH = "CookedSceneTest.source";
+
+static void WriteSource(const std::string& content)
+{
+	std::ofstream file(SOURCE_PATH, std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+static bool IsAligned(const void* p)
+{
+	return ((uintptr_t)p % CookedScene::DATA_ALIGNMENT) == 0;
+}
+
+int main()
+{
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> floatDistribution(-100.0f, 100.0f);
+	std::uniform_int_distribution<uint32_t> indexDistribution(0, VERTEX_COUNT - 1);
+
+	// Mesh data, each mesh is different in counts so that offsets don't line up by chance
+	std::vector<std::vector<float>> vertices(MESH_COUNT);
+	std::vector<std::vector<uint32_t>> indices(MESH_COUNT);
+	std::vector<std::vector<CookedScene::CookedBone>> bones(MESH_COUNT);
+
+	CookedScene::SceneData sceneData;
+	for (uint32_t i = 0; i < MESH_COUNT; i++)
+	{
+		uint32_t verticesCount = VERTEX_COUNT - i * 7;
+		vertices[i].resize(verticesCount * VERTEX_BYTES / sizeof(float));
+		for (float& value : vertices[i])
+			value = floatDistribution(generator);
+
+		indices[i].resize(INDEX_COUNT - i * 3);
+		for (uint32_t& index : indices[i])
+			index = indexDistribution(generator) % verticesCount;
+
+		if (i % SKINNED_MESH_INTERVAL == 0)
+		{
+			bones[i].resize(BONE_COUNT - i);
+			for (uint32_t j = 0; j < (uint32_t)bones[i].size(); j++)
+			{
+				bones[i][j].nameHash = ((uint64_t)i << 32) | j;
+				bones[i][j].offsetDQ = DualQuaterniond(0, 0, 0, 1, floatDistribution(generator), floatDistribution(generator), floatDistribution(generator), 0);
+			}
+		}
+
+		CookedScene::MeshData meshData = {};
+		meshData.mesh.vertexFormat = VertexFormatPNTCT;
+		meshData.mesh.vertexBytes = VERTEX_BYTES;
+		meshData.mesh.verticesCount = verticesCount;
+		meshData.mesh.indicesCount = (uint32_t)indices[i].size();
+		meshData.mesh.boneCount = (uint32_t)bones[i].size();
+		meshData.pVertices = vertices[i].data();
+		meshData.pIndices = indices[i].data();
+		meshData.pBones = bones[i].data();
+		sceneData.meshes.push_back(meshData);
+	}
+
+	// Root with two children, first child has a grand child, meshes are spread among them
+	const char* nodeNames[] = { "Root", "Body", "Head", "Weapon" };
+	const uint32_t childCounts[] = { 2, 1, 0, 0 };
+	const uint32_t meshCounts[] = { 0, 8, 5, 3 };
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		CookedScene::CookedNode node = {};
+		node.translation = Vector3d(i, i * 2.0, i * 3.0);
+		node.nameOffset = (uint32_t)sceneData.names.size();
+		node.nameLength = (uint32_t)strlen(nodeNames[i]);
+		node.meshIndexOffset = (uint32_t)sceneData.meshIndices.size();
+		node.meshCount = meshCounts[i];
+		node.childCount = childCounts[i];
+
+		sceneData.names += nodeNames[i];
+		for (uint32_t j = 0; j < meshCounts[i]; j++)
+			sceneData.meshIndices.push_back((uint32_t)sceneData.meshIndices.size());
+		sceneData.nodes.push_back(node);
+	}
+
+	WriteSource("source");
+	std::string cookedPath = CookedScene::GetCookedPath(SOURCE_PATH, IMPORT_FLAGS);
+	std::remove(cookedPath.c_str());
+
+	Check(CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS) == nullptr, "nothing is loaded before cooking");
+
+	bool isCooked = false;
+	double cookTime = TimeMilliseconds([&]() { isCooked = CookedScene::Cook(sceneData, SOURCE_PATH, IMPORT_FLAGS); });
+	Check(isCooked, "scene is cooked");
+
+	std::shared_ptr<CookedScene> pCookedScene;
+	double loadTime = TimeMilliseconds([&]() { pCookedScene = CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS); });
+	Check(pCookedScene != nullptr, "cooked scene is loaded");
+	if (pCookedScene == nullptr)
+		return Report();
+
+	Check(!pCookedScene->IsSourceMissing(), "source is found");
+	Check(pCookedScene->GetMeshCount() == MESH_COUNT, "mesh count");
+	Check(pCookedScene->GetNodeCount() == 4, "node count");
+
+	// Round trip of mesh data, read through mapping
+	bool isMeshDataEqual = true;
+	uint64_t meshBytes = 0;
+	double compareTime = TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < MESH_COUNT; i++)
+		{
+			const CookedScene::CookedMesh& mesh = pCookedScene->GetMesh(i);
+			isMeshDataEqual &= mesh.vertexFormat == VertexFormatPNTCT && mesh.vertexBytes == VERTEX_BYTES;
+			isMeshDataEqual &= mesh.verticesCount == sceneData.meshes[i].mesh.verticesCount;
+			isMeshDataEqual &= mesh.indicesCount == (uint32_t)indices[i].size();
+			isMeshDataEqual &= mesh.boneCount == (uint32_t)bones[i].size();
+			if (!isMeshDataEqual)
+				return;
+
+			isMeshDataEqual &= memcmp(pCookedScene->GetMeshVertices(i), vertices[i].data(), vertices[i].size() * sizeof(float)) == 0;
+			isMeshDataEqual &= memcmp(pCookedScene->GetMeshIndices(i), indices[i].data(), indices[i].size() * sizeof(uint32_t)) == 0;
+			isMeshDataEqual &= memcmp(pCookedScene->GetMeshBones(i), bones[i].data(), bones[i].size() * sizeof(CookedScene::CookedBone)) == 0;
+			meshBytes += vertices[i].size() * sizeof(float) + indices[i].size() * sizeof(uint32_t) + bones[i].size() * sizeof(CookedScene::CookedBone);
+		}
+	});
+	Check(isMeshDataEqual, "vertex, index and bone bytes are the same after round trip");
+
+	bool isAligned = true;
+	for (uint32_t i = 0; i < MESH_COUNT; i++)
+		isAligned &= IsAligned(pCookedScene->GetMeshVertices(i)) && IsAligned(pCookedScene->GetMeshIndices(i)) && IsAligned(pCookedScene->GetMeshBones(i));
+	Check(isAligned, "mesh data is aligned");
+
+	bool isNodeDataEqual = true;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const CookedScene::CookedNode& node = pCookedScene->GetNode(i);
+		isNodeDataEqual &= memcmp(&node, &sceneData.nodes[i], sizeof(CookedScene::CookedNode)) == 0;
+		isNodeDataEqual &= pCookedScene->GetNodeName(i) == nodeNames[i];
+		isNodeDataEqual &= memcmp(pCookedScene->GetNodeMeshIndices(i), sceneData.meshIndices.data() + node.meshIndexOffset, node.meshCount * sizeof(uint32_t)) == 0;
+	}
+	Check(isNodeDataEqual, "nodes, names and mesh index tables are the same after round trip");
+
+	// Whole file through a stream, which is what mapping saves
+	std::vector<char> streamBytes;
+	double streamTime = TimeMilliseconds([&]()
+	{
+		std::ifstream file(cookedPath, std::ios::binary | std::ios::ate);
+		streamBytes.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(streamBytes.data(), streamBytes.size());
+	});
+	Check(streamBytes.size() == pCookedScene->GetFileSize(), "file size");
+
+	uint64_t fileSize = pCookedScene->GetFileSize();
+	pCookedScene = nullptr;
+
+	// Stale or broken containers
+	Check(CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS + 1) == nullptr, "container of other import flags isn't loaded");
+
+	WriteSource("source changed");
+	Check(CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS) == nullptr, "container is stale once source changes");
+
+	Check(CookedScene::Cook(sceneData, SOURCE_PATH, IMPORT_FLAGS), "scene is cooked again");
+	Check(CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS) != nullptr, "container is up to date after cooking again");
+
+	std::remove(SOURCE_PATH);
+	pCookedScene = CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS);
+	Check(pCookedScene != nullptr && pCookedScene->IsSourceMissing(), "container without source is loaded as it is");
+	pCookedScene = nullptr;
+
+	{
+		std::ofstream file(cookedPath, std::ios::binary | std::ios::trunc);
+		file.write(streamBytes.data(), streamBytes.size() / 2);
+	}
+	Check(CookedScene::Load(SOURCE_PATH, IMPORT_FLAGS) == nullptr, "truncated container isn't loaded");
+
+	std::remove(cookedPath.c_str());
+
+	printf("Cooked %u meshes, %.1f MB of mesh data into %.1f MB\n", MESH_COUNT, meshBytes / 1048576.0, fileSize / 1048576.0);
+	printf("Cook: %.2f ms, map and validate: %.3f ms, read mesh data through mapping: %.2f ms, read whole file with stream: %.2f ms\n", cookTime, loadTime, compareTime, streamTime);
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,579 @@
+// Runs indirect_culling.comp on whatever Vulkan device there is, a software one like lavapipe included
+// Compacted draws, their instance counts and surviving object indices are compared against a CPU reference of the same sphere test
+// Draws outnumber a workgroup many times, and the second round has fewer draws than the first, leaving stale candidates beyond draw count
+// Exits with 77, which ctest takes as skipped, if there's no Vulkan device
+
+#include "Benchmark.h"
+#include "vulkan.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+// Same layout as CandidateDraw of GPUCullingManager.h
+typedef struct _CandidateDraw
+{
+	VkDrawIndexedIndirectCommand	cmd;
+	uint32_t						candidateOffset;
+	uint32_t						candidateCount;
+	uint32_t						reserved;
+	float							boundingSphere[4];
+}CandidateDraw;
+
+typedef struct _ObjectDataIndex
+{
+	int32_t	perObjectIndex;
+	int32_t	perMaterialIndex;
+	int32_t	perMeshIndex;
+	int32_t	perAnimationIndex;
+}ObjectDataIndex;
+
+static const uint32_t SKIPPED = 77;
+static const uint32_t GROUP_SIZE = 64;
+// What candidate storage holds once it has grown to 1000 draws, a page is 256 draws
+static const uint32_t CANDIDATE_CAPACITY = 1024;
+static const uint32_t MAX_CANDIDATES_PER_DRAW = 8;
+static const uint32_t MAX_CANDIDATES = CANDIDATE_CAPACITY * MAX_CANDIDATES_PER_DRAW;
+static const uint32_t OBJECT_COUNT = 4096;
+
+// Offsets of GlobalData in uniform_layout.sh
+static const uint32_t GLOBAL_DATA_BYTES = 1600;
+static const uint32_t PROJECTION_OFFSET = 0;
+static const uint32_t MAIN_LIGHT_VP_OFFSET = 256;
+// PerObjectData is 6 matrices, MV first
+static const uint32_t PER_OBJECT_BYTES = 384;
+
+enum CullingBinding
+{
+	CullingBinding_CandidateDraws,
+	CullingBinding_IndirectOffsets,
+	CullingBinding_IndirectIndices,
+	CullingBinding_CandidateIndices,
+	CullingBinding_CulledDraws,
+	CullingBinding_DrawCounts,
+	CullingBinding_Count
+};
+
+typedef struct _HostBuffer
+{
+	VkBuffer		buffer = VK_NULL_HANDLE;
+	VkDeviceMemory	memory = VK_NULL_HANDLE;
+	uint8_t*		pData = nullptr;
+	VkDeviceSize	size = 0;
+}HostBuffer;
+
+// Column major, "m[column * 4 + row]" as GLSL has it
+typedef struct _Matrix
+{
+	float m[16];
+}Matrix;
+
+static VkDevice device = VK_NULL_HANDLE;
+static VkPhysicalDeviceMemoryProperties memoryProperties;
+
+static HostBuffer CreateHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+{
+	HostBuffer hostBuffer;
+	hostBuffer.size = size;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	vkCreateBuffer(device, &bufferInfo, nullptr, &hostBuffer.buffer);
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, hostBuffer.buffer, &requirements);
+
+	VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	uint32_t typeIndex = 0;
+	while (typeIndex < memoryProperties.memoryTypeCount)
+	{
+		if ((requirements.memoryTypeBits & (1 << typeIndex)) != 0 && (memoryProperties.memoryTypes[typeIndex].propertyFlags & flags) == flags)
+			break;
+		typeIndex++;
+	}
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = typeIndex;
+	vkAllocateMemory(device, &allocateInfo, nullptr, &hostBuffer.memory);
+	vkBindBufferMemory(device, hostBuffer.buffer, hostBuffer.memory, 0);
+	vkMapMemory(device, hostBuffer.memory, 0, VK_WHOLE_SIZE, 0, (void**)&hostBuffer.pData);
+
+	return hostBuffer;
+}
+
+static void DestroyHostBuffer(HostBuffer& hostBuffer)
+{
+	vkUnmapMemory(device, hostBuffer.memory);
+	vkDestroyBuffer(device, hostBuffer.buffer, nullptr);
+	vkFreeMemory(device, hostBuffer.memory, nullptr);
+}
+
+static VkDescriptorSetLayout CreateSetLayout(const std::vector<VkDescriptorType>& types)
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	for (uint32_t i = 0; i < (uint32_t)types.size(); i++)
+		bindings.push_back({ i, types[i], 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = (uint32_t)bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout);
+	return layout;
+}
+
+static void WriteBufferDescriptor(VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type, const HostBuffer& hostBuffer)
+{
+	VkDescriptorBufferInfo bufferInfo = { hostBuffer.buffer, 0, hostBuffer.size };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = descriptorSet;
+	write.dstBinding = binding;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+static Matrix Multiply(const Matrix& a, const Matrix& b)
+{
+	Matrix result = {};
+	for (uint32_t column = 0; column < 4; column++)
+	{
+		for (uint32_t row = 0; row < 4; row++)
+		{
+			for (uint32_t k = 0; k < 4; k++)
+				result.m[column * 4 + row] += a.m[k * 4 + row] * b.m[column * 4 + k];
+		}
+	}
+	return result;
+}
+
+// Sphere test of indirect_culling.comp, "margin" is how far it's from flipping, so that float differences to the shader can be kept out
+static bool IsSphereVisible(const float center[3], float radius, const Matrix& clipMatrix, float& margin)
+{
+	float rows[4][4];
+	for (uint32_t row = 0; row < 4; row++)
+	{
+		for (uint32_t column = 0; column < 4; column++)
+			rows[row][column] = clipMatrix.m[column * 4 + row];
+	}
+
+	float planes[6][4];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		planes[0][i] = rows[3][i] + rows[0][i];
+		planes[1][i] = rows[3][i] - rows[0][i];
+		planes[2][i] = rows[3][i] + rows[1][i];
+		planes[3][i] = rows[3][i] - rows[1][i];
+		planes[4][i] = rows[2][i];
+		planes[5][i] = rows[3][i] - rows[2][i];
+	}
+
+	margin = INFINITY;
+	bool visible = true;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		float length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+		float scale = length > 1e-12f ? length : 1.0f;
+
+		float distance = (planes[i][0] * center[0] + planes[i][1] * center[1] + planes[i][2] * center[2]) / scale + planes[i][3] / scale;
+		margin = std::fmin(margin, std::fabs(distance + radius));
+		if (distance < -radius)
+			visible = false;
+	}
+
+	return visible;
+}
+
+int main()
+{
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "GPUCullingTest";
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo = &appInfo;
+
+	VkInstance instance;
+	if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS)
+	{
+		printf("No Vulkan instance, skipped\n");
+		return SKIPPED;
+	}
+
+	uint32_t physicalDeviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, nullptr);
+	std::vector<VkPhysicalDevice> physicalDevices(physicalDeviceCount);
+	vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, physicalDevices.data());
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	uint32_t queueFamilyIndex = 0;
+	for (VkPhysicalDevice candidate : physicalDevices)
+	{
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+
+		for (uint32_t i = 0; i < familyCount && physicalDevice == VK_NULL_HANDLE; i++)
+		{
+			if ((families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0)
+			{
+				physicalDevice = candidate;
+				queueFamilyIndex = i;
+			}
+		}
+	}
+
+	if (physicalDevice == VK_NULL_HANDLE)
+	{
+		printf("No Vulkan device with compute queue, skipped\n");
+		vkDestroyInstance(instance, nullptr);
+		return SKIPPED;
+	}
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	printf("Device: %s\n", deviceProperties.deviceName);
+
+	float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = queueFamilyIndex;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device);
+
+	VkQueue queue;
+	vkGetDeviceQueue(device, queueFamilyIndex, 0, &queue);
+
+	std::ifstream shaderFile(CULLING_SHADER_PATH, std::ios::binary | std::ios::ate);
+	Check(shaderFile.is_open(), "culling shader is compiled");
+	if (!shaderFile.is_open())
+		return Report();
+
+	std::vector<uint32_t> shaderCode((size_t)shaderFile.tellg() / sizeof(uint32_t));
+	shaderFile.seekg(0);
+	shaderFile.read((char*)shaderCode.data(), shaderCode.size() * sizeof(uint32_t));
+
+	VkShaderModuleCreateInfo shaderInfo = {};
+	shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderInfo.codeSize = shaderCode.size() * sizeof(uint32_t);
+	shaderInfo.pCode = shaderCode.data();
+	VkShaderModule shaderModule;
+	vkCreateShaderModule(device, &shaderInfo, nullptr, &shaderModule);
+
+	// Sets 0 to 2 only have what culling shader reads of uniform layout, set 3 is the culling set, without dynamic offsets here
+	std::vector<VkDescriptorSetLayout> setLayouts =
+	{
+		CreateSetLayout({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER }),
+		CreateSetLayout({}),
+		CreateSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }),
+		CreateSetLayout(std::vector<VkDescriptorType>(CullingBinding_Count, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER))
+	};
+
+	VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	VkPipelineLayout pipelineLayout;
+	vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	VkPipeline pipeline;
+	Check(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS, "culling pipeline is created");
+
+	std::vector<VkDescriptorPoolSize> poolSizes =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 + CullingBinding_Count }
+	};
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = (uint32_t)setLayouts.size();
+	poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
+	VkDescriptorPool descriptorPool;
+	vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool);
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = (uint32_t)setLayouts.size();
+	setAllocateInfo.pSetLayouts = setLayouts.data();
+	std::vector<VkDescriptorSet> descriptorSets(setLayouts.size());
+	vkAllocateDescriptorSets(device, &setAllocateInfo, descriptorSets.data());
+
+	HostBuffer globalBuffer = CreateHostBuffer(GLOBAL_DATA_BYTES, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+	HostBuffer perObjectBuffer = CreateHostBuffer(PER_OBJECT_BYTES * OBJECT_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+	std::vector<HostBuffer> cullingBuffers(CullingBinding_Count);
+	cullingBuffers[CullingBinding_CandidateDraws] = CreateHostBuffer(sizeof(CandidateDraw) * CANDIDATE_CAPACITY, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	cullingBuffers[CullingBinding_IndirectOffsets] = CreateHostBuffer(sizeof(int32_t) * CANDIDATE_CAPACITY, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	cullingBuffers[CullingBinding_IndirectIndices] = CreateHostBuffer(sizeof(ObjectDataIndex) * MAX_CANDIDATES, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	cullingBuffers[CullingBinding_CandidateIndices] = CreateHostBuffer(sizeof(ObjectDataIndex) * MAX_CANDIDATES, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	cullingBuffers[CullingBinding_CulledDraws] = CreateHostBuffer(sizeof(VkDrawIndexedIndirectCommand) * CANDIDATE_CAPACITY, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	cullingBuffers[CullingBinding_DrawCounts] = CreateHostBuffer(sizeof(uint32_t) * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+	WriteBufferDescriptor(descriptorSets[0], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, globalBuffer);
+	WriteBufferDescriptor(descriptorSets[2], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, perObjectBuffer);
+	for (uint32_t i = 0; i < CullingBinding_Count; i++)
+		WriteBufferDescriptor(descriptorSets[3], i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, cullingBuffers[i]);
+
+	// Camera looks down -z, depth from 0 at near to 1 at far, main light is an orthographic box
+	float nearPlane = 1.0f, farPlane = 200.0f, focal = 1.0f / std::tan(0.5f);
+	Matrix projection = {};
+	projection.m[0] = focal / 1.5f;
+	projection.m[5] = focal;
+	projection.m[10] = farPlane / (nearPlane - farPlane);
+	projection.m[11] = -1.0f;
+	projection.m[14] = nearPlane * farPlane / (nearPlane - farPlane);
+
+	Matrix lightVP = {};
+	lightVP.m[0] = 1.0f / 40.0f;
+	lightVP.m[5] = 1.0f / 40.0f;
+	lightVP.m[10] = -1.0f / 300.0f;
+	lightVP.m[14] = 0.5f;
+	lightVP.m[15] = 1.0f;
+	// Tilted, so that all 6 planes are slanted in camera space
+	Matrix tilt = {};
+	tilt.m[0] = 1.0f;
+	tilt.m[5] = std::cos(0.4f);
+	tilt.m[6] = std::sin(0.4f);
+	tilt.m[9] = -std::sin(0.4f);
+	tilt.m[10] = std::cos(0.4f);
+	tilt.m[15] = 1.0f;
+	lightVP = Multiply(lightVP, tilt);
+
+	memcpy(globalBuffer.pData + PROJECTION_OFFSET, &projection, sizeof(Matrix));
+	memcpy(globalBuffer.pData + MAIN_LIGHT_VP_OFFSET, &lightVP, sizeof(Matrix));
+
+	// Objects with uniform scale, scattered around and behind camera
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Matrix> modelViews(OBJECT_COUNT);
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		float scale = 0.5f + 1.5f * unit(random);
+		Matrix& MV = modelViews[i];
+		MV = {};
+		MV.m[0] = MV.m[5] = MV.m[10] = scale;
+		MV.m[12] = -120.0f + 240.0f * unit(random);
+		MV.m[13] = -80.0f + 160.0f * unit(random);
+		MV.m[14] = -220.0f + 240.0f * unit(random);
+		MV.m[15] = 1.0f;
+		memcpy(perObjectBuffer.pData + PER_OBJECT_BYTES * i, &MV, sizeof(Matrix));
+	}
+
+	VkCommandPoolCreateInfo commandPoolInfo = {};
+	commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+	VkCommandPool commandPool;
+	vkCreateCommandPool(device, &commandPoolInfo, nullptr, &commandPool);
+
+	VkCommandBufferAllocateInfo commandBufferInfo = {};
+	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferInfo.commandPool = commandPool;
+	commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer;
+	vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer);
+
+	CandidateDraw* pCandidateDraws = (CandidateDraw*)cullingBuffers[CullingBinding_CandidateDraws].pData;
+	int32_t* pIndirectOffsets = (int32_t*)cullingBuffers[CullingBinding_IndirectOffsets].pData;
+	ObjectDataIndex* pIndirectIndices = (ObjectDataIndex*)cullingBuffers[CullingBinding_IndirectIndices].pData;
+	ObjectDataIndex* pCandidateIndices = (ObjectDataIndex*)cullingBuffers[CullingBinding_CandidateIndices].pData;
+	VkDrawIndexedIndirectCommand* pCulledDraws = (VkDrawIndexedIndirectCommand*)cullingBuffers[CullingBinding_CulledDraws].pData;
+	uint32_t* pDrawCounts = (uint32_t*)cullingBuffers[CullingBinding_DrawCounts].pData;
+
+	auto runRound = [&](uint32_t drawCount, uint32_t cullingFrustum)
+	{
+		const Matrix& clipMatrix = cullingFrustum == 0 ? projection : lightVP;
+
+		// Survivors of each draw in candidate order, as shader packs them
+		std::vector<std::vector<ObjectDataIndex>> references(drawCount);
+		uint32_t candidateOffset = 0;
+		uint32_t referenceDrawCount = 0;
+		uint32_t referenceInstanceCount = 0;
+
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			CandidateDraw& draw = pCandidateDraws[i];
+			// Every 16th draw is manually instanced, it's never culled and keeps its own instance count
+			bool cullable = i % 16 != 0;
+
+			draw.cmd = { 36 + i, cullable ? 0u : 3u, i * 36, (int32_t)i, 0 };
+			draw.candidateOffset = candidateOffset;
+			draw.candidateCount = cullable ? 1 + (uint32_t)(unit(random) * MAX_CANDIDATES_PER_DRAW) % MAX_CANDIDATES_PER_DRAW : 1;
+			draw.reserved = 0;
+			draw.boundingSphere[0] = unit(random) - 0.5f;
+			draw.boundingSphere[1] = unit(random) - 0.5f;
+			draw.boundingSphere[2] = unit(random) - 0.5f;
+			draw.boundingSphere[3] = cullable ? 0.5f + 2.0f * unit(random) : -1.0f;
+			if (cullable)
+				draw.cmd.instanceCount = draw.candidateCount;
+
+			for (uint32_t j = 0; j < draw.candidateCount; j++)
+			{
+				// Candidates too close to a plane are swapped for another object, so float differences can't flip them
+				bool visible = true;
+				uint32_t object;
+				for (;;)
+				{
+					object = (uint32_t)(unit(random) * OBJECT_COUNT) % OBJECT_COUNT;
+					if (!cullable)
+						break;
+
+					const Matrix& MV = modelViews[object];
+					float center[3];
+					for (uint32_t k = 0; k < 3; k++)
+						center[k] = MV.m[k] * draw.boundingSphere[0] + MV.m[4 + k] * draw.boundingSphere[1] + MV.m[8 + k] * draw.boundingSphere[2] + MV.m[12 + k];
+
+					float margin;
+					visible = IsSphereVisible(center, draw.boundingSphere[3] * MV.m[0], clipMatrix, margin);
+					if (margin > 1e-2f)
+						break;
+				}
+
+				ObjectDataIndex candidate = { (int32_t)object, (int32_t)i, (int32_t)j, 0 };
+				pCandidateIndices[candidateOffset + j] = candidate;
+				if (visible)
+					references[i].push_back(candidate);
+			}
+
+			if (references[i].size() > 0)
+			{
+				referenceDrawCount++;
+				referenceInstanceCount += cullable ? (uint32_t)references[i].size() : draw.cmd.instanceCount;
+			}
+
+			candidateOffset += draw.candidateCount;
+		}
+
+		// Outputs are filled with garbage, so that anything the shader doesn't write is caught
+		memset(pIndirectOffsets, 0xFF, (size_t)cullingBuffers[CullingBinding_IndirectOffsets].size);
+		memset(pIndirectIndices, 0xFF, (size_t)cullingBuffers[CullingBinding_IndirectIndices].size);
+		memset(pCulledDraws, 0xFF, (size_t)cullingBuffers[CullingBinding_CulledDraws].size);
+		pDrawCounts[0] = 0;
+		pDrawCounts[1] = drawCount;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, (uint32_t)descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &cullingFrustum);
+		// Covers capacity of candidate storage, as GPUCullingManager does
+		vkCmdDispatch(commandBuffer, (CANDIDATE_CAPACITY + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(queue);
+
+		uint32_t culledDrawCount = pDrawCounts[0];
+		printf("%u draws, %u candidates against %s: %u draws survive, reference %u draws of %u instances\n",
+			drawCount, candidateOffset, cullingFrustum == 0 ? "camera" : "main light", culledDrawCount, referenceDrawCount, referenceInstanceCount);
+
+		Check(culledDrawCount == referenceDrawCount, "culled draw count matches reference");
+		if (culledDrawCount != referenceDrawCount)
+			return;
+
+		// Slots are taken in any order, each one points back to its draw with indirect offset
+		std::vector<uint8_t> drawSeen(drawCount, 0);
+		std::vector<uint32_t> drawByOffset(candidateOffset, drawCount);
+		for (uint32_t i = 0; i < drawCount; i++)
+			drawByOffset[pCandidateDraws[i].candidateOffset] = i;
+
+		bool slotsMatch = true;
+		uint32_t instanceCount = 0;
+		for (uint32_t slot = 0; slot < culledDrawCount && slotsMatch; slot++)
+		{
+			int32_t offset = pIndirectOffsets[slot];
+			slotsMatch = offset >= 0 && (uint32_t)offset < candidateOffset && drawByOffset[offset] < drawCount && !drawSeen[drawByOffset[offset]];
+			if (!slotsMatch)
+				break;
+
+			uint32_t drawID = drawByOffset[offset];
+			drawSeen[drawID] = 1;
+
+			const CandidateDraw& draw = pCandidateDraws[drawID];
+			const VkDrawIndexedIndirectCommand& cmd = pCulledDraws[slot];
+			const std::vector<ObjectDataIndex>& reference = references[drawID];
+			bool cullable = draw.boundingSphere[3] >= 0;
+
+			slotsMatch = reference.size() > 0
+				&& cmd.indexCount == draw.cmd.indexCount
+				&& cmd.instanceCount == (cullable ? (uint32_t)reference.size() : draw.cmd.instanceCount)
+				&& cmd.firstIndex == draw.cmd.firstIndex
+				&& cmd.vertexOffset == draw.cmd.vertexOffset
+				&& cmd.firstInstance == draw.cmd.firstInstance
+				&& memcmp(pIndirectIndices + offset, reference.data(), reference.size() * sizeof(ObjectDataIndex)) == 0;
+
+			instanceCount += cmd.instanceCount;
+		}
+
+		Check(slotsMatch, "compacted draws and surviving indices match reference");
+		Check(!slotsMatch || instanceCount == referenceInstanceCount, "instance count matches reference");
+	};
+
+	runRound(1000, 0);
+	// Candidates of the first round stay beyond draw count
+	runRound(300, 1);
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+	for (HostBuffer& hostBuffer : cullingBuffers)
+		DestroyHostBuffer(hostBuffer);
+	DestroyHostBuffer(perObjectBuffer);
+	DestroyHostBuffer(globalBuffer);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	for (VkDescriptorSetLayout setLayout : setLayouts)
+		vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+	vkDestroyShaderModule(device, shaderModule, nullptr);
+	vkDestroyDevice(device, nullptr);
+	vkDestroyInstance(instance, nullptr);
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+// Same checks as MathsSIMDTest, on scalar fallback of SIMD wrapper
+
+#define SIMD_FORCE_SCALAR
+#include "MathsSIMDTest.cpp"
\ No newline at end of file
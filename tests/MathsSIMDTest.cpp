@@ -0,0 +1,295 @@
+// Checks float specializations of maths templates, built on SIMD wrapper, against their scalar templates
+// Reference is the same template run on a float that has no SIMD specializations, so it adds up in the same order
+// Multiply, transpose and batch transforms have to match it bit for bit, unless fused multiply add is on
+// Inverse, quaternion product, SLerp and DLB only have to match double templates within float rounding
+// Also times batch transforms against one element at a time, and float matrix product against double one
+
+#include "Benchmark.h"
+#include "../Maths/Matrix.h"
+#include "../Maths/DualQuaternion.h"
+#include "../Maths/Plane.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint32_t CHECK_COUNT = 10000;
+static const uint32_t BATCH_COUNT = 100000;
+static const uint32_t BENCHMARK_ROUND_COUNT = 20;
+
+// No specializations exist for this type, so templates run their scalar code in float precision
+struct ScalarFloat
+{
+	float value;
+
+	ScalarFloat() = default;
+	ScalarFloat(float v) : value(v) {}
+	operator float() const { return value; }
+
+	ScalarFloat& operator += (float v) { value += v; return *this; }
+	ScalarFloat& operator -= (float v) { value -= v; return *this; }
+	ScalarFloat& operator *= (float v) { value *= v; return *this; }
+	ScalarFloat& operator /= (float v) { value /= v; return *this; }
+};
+
+static std::mt19937 randomEngine(1);
+static std::uniform_real_distribution<float> randomDistribution(-2.0f, 2.0f);
+
+static float RandomFloat()
+{
+	return randomDistribution(randomEngine);
+}
+
+// Diagonal is pushed away from zero so inverse stays well conditioned
+static Matrix4f RandomMatrix()
+{
+	Matrix4f m;
+	for (uint32_t i = 0; i < 16; i++)
+		(&m.c00)[i] = RandomFloat() + (i % 5 == 0 ? 4.0f : 0.0f);
+	return m;
+}
+
+static Vector3f RandomVector()
+{
+	return { RandomFloat(), RandomFloat(), RandomFloat() };
+}
+
+static Quaternionf RandomRotation()
+{
+	return Quaternionf(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat()).Normal();
+}
+
+static Matrix4x4<ScalarFloat> ToScalar(const Matrix4f& m)
+{
+	Matrix4x4<ScalarFloat> ret;
+	for (uint32_t i = 0; i < 16; i++)
+		(&ret.c00)[i] = (&m.c00)[i];
+	return ret;
+}
+
+static Vector3<ScalarFloat> ToScalar(const Vector3f& v)
+{
+	return Vector3<ScalarFloat>(v.x, v.y, v.z);
+}
+
+static bool Equal(const Vector3f& v, const Vector3<ScalarFloat>& reference)
+{
+#if defined(SIMD_FMA)
+	return std::abs(v.x - reference.x) <= 1e-5f * (1.0f + std::abs(reference.x))
+		&& std::abs(v.y - reference.y) <= 1e-5f * (1.0f + std::abs(reference.y))
+		&& std::abs(v.z - reference.z) <= 1e-5f * (1.0f + std::abs(reference.z));
+#else
+	return v.x == reference.x && v.y == reference.y && v.z == reference.z;
+#endif
+}
+
+static bool Equal(const Vector4f& v, const Vector4<ScalarFloat>& reference)
+{
+	return Equal(Vector3f(v.x, v.y, v.z), Vector3<ScalarFloat>(reference.x, reference.y, reference.z))
+		&& Equal(Vector3f(v.w, 0, 0), Vector3<ScalarFloat>(reference.w, 0.0f, 0.0f));
+}
+
+static bool Equal(const Matrix4f& m, const Matrix4x4<ScalarFloat>& reference)
+{
+	bool equal = true;
+	for (uint32_t i = 0; i < 4; i++)
+		equal = equal && Equal(m.c[i], reference.c[i]);
+	return equal;
+}
+
+template <typename Float>
+static double MaxError(const Float* pData, const double* pReference, uint32_t count)
+{
+	double maxError = 0;
+	for (uint32_t i = 0; i < count; i++)
+		maxError = std::max(maxError, std::abs((float)pData[i] - pReference[i]) / (1.0 + std::abs(pReference[i])));
+	return maxError;
+}
+
+static bool Close(const float* pData, const double* pReference, uint32_t count, double tolerance)
+{
+	return MaxError(pData, pReference, count) <= tolerance;
+}
+
+static void CheckMatrix()
+{
+	for (uint32_t i = 0; i < CHECK_COUNT; i++)
+	{
+		Matrix4f a = RandomMatrix(), b = RandomMatrix();
+		Vector4f v(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+
+		Matrix4x4<ScalarFloat> product = ToScalar(a);
+		product *= ToScalar(b);
+		Check(Equal(a * b, product), "matrix product matches scalar template");
+
+		Vector4<ScalarFloat> transformed = ToScalar(a) * Vector4<ScalarFloat>(v.x, v.y, v.z, v.w);
+		Check(Equal(a * v, transformed), "matrix vector product matches scalar template");
+
+		Check(Equal(a.Transpose(), ToScalar(a).Transpose()), "transpose matches scalar template");
+
+		// Float template itself drifts from double one as much as matrix conditioning lets it, so inverse is held to that
+		Matrix4d inverse = b.DoublePrecision().Inverse();
+		double templateError = MaxError(&ToScalar(b).Inverse().c00, &inverse.c00, 16);
+		Check(MaxError(&b.Inverse().c00, &inverse.c00, 16) <= templateError * 2 + 1e-5, "inverse matches double template as close as float template does");
+	}
+}
+
+static void CheckBatchTransforms()
+{
+	Matrix4f m = RandomMatrix();
+	Matrix4x4<ScalarFloat> scalarMatrix = ToScalar(m);
+
+	// Odd count, so tail after 4 at a time is taken too
+	const uint32_t count = 1003;
+	std::vector<Vector3f> points(count), vectors(count), mins(count), maxs(count), dstMins(count), dstMaxs(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		points[i] = RandomVector();
+		mins[i] = RandomVector();
+		maxs[i] = mins[i] + Vector3f(std::abs(RandomFloat()), std::abs(RandomFloat()), std::abs(RandomFloat()));
+	}
+
+	std::vector<Vector3<ScalarFloat>> scalarPoints(count), scalarMins(count), scalarMaxs(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		scalarPoints[i] = ToScalar(points[i]);
+		scalarMins[i] = ToScalar(mins[i]);
+		scalarMaxs[i] = ToScalar(maxs[i]);
+	}
+
+	m.TransformAsVectors(points.data(), vectors.data(), count);
+	bool equal = true;
+	for (uint32_t i = 0; i < count; i++)
+		equal = equal && Equal(vectors[i], scalarMatrix.TransformAsVector(scalarPoints[i]));
+	Check(equal, "batch vector transform matches scalar template");
+
+	m.TransformBounds(mins.data(), maxs.data(), dstMins.data(), dstMaxs.data(), count);
+	std::vector<Vector3<ScalarFloat>> referenceMins(count), referenceMaxs(count);
+	scalarMatrix.TransformBounds(scalarMins.data(), scalarMaxs.data(), referenceMins.data(), referenceMaxs.data(), count);
+	equal = true;
+	for (uint32_t i = 0; i < count; i++)
+		equal = equal && Equal(dstMins[i], referenceMins[i]) && Equal(dstMaxs[i], referenceMaxs[i]);
+	Check(equal, "batch bounds transform matches scalar template");
+
+	// In place, as the header allows
+	m.TransformAsPoints(points.data(), points.data(), count);
+	equal = true;
+	for (uint32_t i = 0; i < count; i++)
+		equal = equal && Equal(points[i], scalarMatrix.TransformAsPoint(scalarPoints[i]));
+	Check(equal, "batch point transform in place matches scalar template");
+
+	std::vector<Planef> planes(count);
+	std::vector<Plane<ScalarFloat>> scalarPlanes(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		planes[i] = Planef(RandomVector().Normal(), RandomFloat());
+		scalarPlanes[i] = Plane<ScalarFloat>(ToScalar(planes[i].normal), planes[i].D);
+	}
+
+	Planef::Transform(m, planes.data(), count);
+	Plane<ScalarFloat>::Transform(scalarMatrix, scalarPlanes.data(), count);
+	equal = true;
+	for (uint32_t i = 0; i < count; i++)
+		equal = equal && Equal(Vector4f(planes[i].normal, planes[i].D), Vector4<ScalarFloat>(scalarPlanes[i].normal, scalarPlanes[i].D));
+	Check(equal, "batch plane transform matches scalar template");
+}
+
+static void CheckQuaternion()
+{
+	for (uint32_t i = 0; i < CHECK_COUNT; i++)
+	{
+		Quaternionf a = RandomRotation(), b = RandomRotation();
+		float factor = std::abs(RandomFloat()) * 0.5f;
+
+		Quaternionf product = a * b;
+		Quaterniond doubleProduct = a.DoublePrecision() * b.DoublePrecision();
+		Check(Close(&product.x, &doubleProduct.x, 4, 1e-6), "quaternion product matches double template");
+
+		Quaternionf slerp = Quaternionf::SLerp(a, b, factor);
+		Quaterniond doubleSLerp = Quaterniond::SLerp(a.DoublePrecision(), b.DoublePrecision(), factor);
+		Check(Close(&slerp.x, &doubleSLerp.x, 4, 1e-5), "quaternion SLerp matches double template");
+
+		DualQuaternionf from(a, RandomVector()), to(b, RandomVector());
+		DualQuaternionf dlb = DualQuaternionf::DLB(from, to, factor);
+		DualQuaterniond doubleDLB = DualQuaterniond::DLB(from.DoublePrecision(), to.DoublePrecision(), factor);
+		Check(Close(&dlb.x, &doubleDLB.x, 8, 1e-5), "dual quaternion DLB matches double template");
+	}
+}
+
+template <typename Function>
+static double TimeNanoseconds(uint32_t count, Function function)
+{
+	return TimeMilliseconds(function, BENCHMARK_ROUND_COUNT) * 1e6 / count;
+}
+
+static void ReportThroughput()
+{
+	Matrix4f m = RandomMatrix();
+	Matrix4x4<ScalarFloat> scalarMatrix = ToScalar(m);
+
+	std::vector<Vector3f> points(BATCH_COUNT), dst(BATCH_COUNT);
+	std::vector<Vector3<ScalarFloat>> scalarPoints(BATCH_COUNT), scalarDst(BATCH_COUNT);
+	for (uint32_t i = 0; i < BATCH_COUNT; i++)
+	{
+		points[i] = RandomVector();
+		scalarPoints[i] = ToScalar(points[i]);
+	}
+
+	double batchTime = TimeNanoseconds(BATCH_COUNT, [&]() { m.TransformAsPoints(points.data(), dst.data(), BATCH_COUNT); });
+	double singleTime = TimeNanoseconds(BATCH_COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < BATCH_COUNT; i++)
+			scalarDst[i] = scalarMatrix.TransformAsPoint(scalarPoints[i]);
+	});
+	printf("Point transform: %.2f ns each in batch, %.2f ns each one at a time\n", batchTime, singleTime);
+
+	std::vector<Planef> planes(BATCH_COUNT, Planef(Vector3f(0, 1, 0), 1.0f));
+	std::vector<Plane<ScalarFloat>> scalarPlanes(BATCH_COUNT, Plane<ScalarFloat>(Vector3<ScalarFloat>(0.0f, 1.0f, 0.0f), 1.0f));
+	batchTime = TimeNanoseconds(BATCH_COUNT, [&]() { Planef::Transform(m, planes.data(), BATCH_COUNT); });
+	singleTime = TimeNanoseconds(BATCH_COUNT, [&]() { Plane<ScalarFloat>::Transform(scalarMatrix, scalarPlanes.data(), BATCH_COUNT); });
+	printf("Plane transform: %.2f ns each in batch, %.2f ns each one at a time\n", batchTime, singleTime);
+
+	// Chained, so each product depends on the last one like a transform hierarchy, rotation keeps them from overflowing
+	Matrix4f rotation = Matrix4f::EulerAngle(0.1f, 0.2f, 0.3f), product;
+	Matrix4x4<ScalarFloat> scalarRotation = ToScalar(rotation), scalarProduct = ToScalar(product);
+	Matrix4d doubleRotation = rotation.DoublePrecision(), doubleProduct = product.DoublePrecision();
+	double floatTime = TimeNanoseconds(BATCH_COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < BATCH_COUNT; i++)
+			product *= rotation;
+	});
+	double scalarTime = TimeNanoseconds(BATCH_COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < BATCH_COUNT; i++)
+			scalarProduct *= scalarRotation;
+	});
+	double doubleTime = TimeNanoseconds(BATCH_COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < BATCH_COUNT; i++)
+			doubleProduct *= doubleRotation;
+	});
+	printf("Matrix product: %.2f ns float, %.2f ns scalar float template, %.2f ns double template\n", floatTime, scalarTime, doubleTime);
+
+	// Keeps results alive
+	volatile float sink = dst[0].x + scalarDst[0].x + planes[0].D + scalarPlanes[0].D + product.c00 + scalarProduct.c00 + (float)doubleProduct.c00;
+	(void)sink;
+}
+
+int main()
+{
+#if defined(SIMD_SSE) && defined(SIMD_FMA)
+	printf("SIMD path: SSE with FMA\n");
+#elif defined(SIMD_SSE)
+	printf("SIMD path: SSE\n");
+#elif defined(SIMD_NEON)
+	printf("SIMD path: NEON\n");
+#else
+	printf("SIMD path: scalar\n");
+#endif
+
+	CheckMatrix();
+	CheckBatchTransforms();
+	CheckQuaternion();
+	ReportThroughput();
+
+	return Report();
+}
\ No newline at end of file
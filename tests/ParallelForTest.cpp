@@ -0,0 +1,115 @@
+// Checks job counters and ParallelFor of ThreadTaskQueue
+// Stages chained by counters have to see all jobs of the previous stage done, and ParallelFor nested in ParallelFor must neither miss nor repeat any index
+
+#include "Benchmark.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <atomic>
+#include <vector>
+
+static const uint32_t WORKER_COUNT = 4;
+static const uint32_t COUNTER_JOB_COUNT = 1000;
+static const uint32_t STAGE_COUNT = 4;
+static const uint32_t STAGE_JOB_COUNT = 200;
+static const uint32_t OUTER_COUNT = 64;
+static const uint32_t INNER_COUNT = 1000;
+static const uint32_t INNER_GRAIN = 16;
+
+static void TestCounterWait(ThreadTaskQueue& taskQueue)
+{
+	std::vector<std::atomic<uint32_t>> runCounts(COUNTER_JOB_COUNT);
+	JobCounter counter;
+	for (uint32_t i = 0; i < COUNTER_JOB_COUNT; i++)
+		taskQueue.AddJob([&runCounts, i](const std::shared_ptr<PerFrameResource>&) { runCounts[i]++; }, 0, &counter);
+
+	taskQueue.WaitForCounter(counter);
+
+	bool allDone = true;
+	for (auto& runCount : runCounts)
+		allDone &= runCount == 1;
+	Check(allDone, "jobs of a counter are all done once main thread's wait returns");
+	Check(counter.GetCount() == 0, "counter drops to zero");
+}
+
+// One job drives the stages from a worker, so its waits execute other jobs instead of blocking
+static void TestDependencyOrder(ThreadTaskQueue& taskQueue)
+{
+	std::vector<std::atomic<uint32_t>> stageDoneCounts(STAGE_COUNT);
+	std::atomic<uint32_t> orderViolationCount = { 0 };
+
+	JobCounter rootCounter;
+	taskQueue.AddJob([&](const std::shared_ptr<PerFrameResource>&)
+	{
+		for (uint32_t stage = 0; stage < STAGE_COUNT; stage++)
+		{
+			JobCounter stageCounter;
+			for (uint32_t i = 0; i < STAGE_JOB_COUNT; i++)
+			{
+				taskQueue.AddJob([&, stage](const std::shared_ptr<PerFrameResource>&)
+				{
+					if (stage > 0 && stageDoneCounts[stage - 1] != STAGE_JOB_COUNT)
+						orderViolationCount++;
+					stageDoneCounts[stage]++;
+				}, 0, &stageCounter);
+			}
+			taskQueue.WaitForCounter(stageCounter);
+		}
+	}, 0, &rootCounter);
+
+	taskQueue.WaitForCounter(rootCounter);
+
+	Check(orderViolationCount == 0, "no job starts before the stage it depends on is done");
+	bool allStagesDone = true;
+	for (auto& doneCount : stageDoneCounts)
+		allStagesDone &= doneCount == STAGE_JOB_COUNT;
+	Check(allStagesDone, "every stage runs all its jobs");
+}
+
+static void TestNestedParallelFor(ThreadTaskQueue& taskQueue)
+{
+	std::vector<std::atomic<uint32_t>> hitCounts(OUTER_COUNT * INNER_COUNT);
+
+	// Inner range doesn't divide by grain, so the last chunk is a short one
+	taskQueue.ParallelFor(0, OUTER_COUNT, 1, [&](uint32_t outerBegin, uint32_t outerEnd)
+	{
+		for (uint32_t outer = outerBegin; outer < outerEnd; outer++)
+		{
+			taskQueue.ParallelFor(0, INNER_COUNT, INNER_GRAIN, [&, outer](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t inner = begin; inner < end; inner++)
+					hitCounts[outer * INNER_COUNT + inner]++;
+			});
+		}
+	});
+
+	bool allOnce = true;
+	for (auto& hitCount : hitCounts)
+		allOnce &= hitCount == 1;
+	Check(allOnce, "nested ParallelFor visits every index exactly once");
+
+	// Offset and empty ranges
+	std::atomic<uint32_t> sum = { 0 };
+	taskQueue.ParallelFor(10, 20, 3, [&sum](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			sum += i;
+	});
+	Check(sum == 145, "ParallelFor over [10, 20)");
+
+	bool emptyCalled = false;
+	taskQueue.ParallelFor(5, 5, 1, [&emptyCalled](uint32_t, uint32_t) { emptyCalled = true; });
+	Check(!emptyCalled, "ParallelFor over an empty range does nothing");
+}
+
+int main()
+{
+	ThreadTaskQueue taskQueue(0, nullptr, WORKER_COUNT);
+
+	TestCounterWait(taskQueue);
+	TestDependencyOrder(taskQueue);
+	TestNestedParallelFor(taskQueue);
+
+	taskQueue.WaitForFree();
+	Check(taskQueue.GetExecutedJobCount() == taskQueue.GetSubmittedJobCount(), "every submitted job is executed");
+
+	return Report();
+}
\ No newline at end of file
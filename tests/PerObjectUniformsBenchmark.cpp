@@ -0,0 +1,145 @@
+// Times per object uniforms of 10k objects through update, derive and write, the way PerObjectUniforms did it before and does it now
+// Before: double model view per object, derived in double, narrowed into a float shadow array that's copied into buffer
+// Now: float model matrix relative to camera, derived in float and written straight into destination, as it would be into mapped memory
+// Also checks that float path keeps precision far from origin, where narrowing world matrices first doesn't
+
+#include "Benchmark.h"
+#include "../class/PerObjectVariables.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const uint32_t OBJECT_COUNT = 10000;
+static const uint32_t BENCHMARK_ROUND_COUNT = 50;
+// Around planet scale, objects are spread around camera
+static const double CAMERA_POSITION[] = { 3000000.0, -2000000.0, 5000000.0 };
+static const double OBJECT_SPREAD = 500.0;
+static const double MAX_RELATIVE_ERROR = 1e-4;
+
+// State each object keeps now
+typedef struct _PerObjectState
+{
+	Matrix4f	relativeModel;
+	Matrix4f	MV;
+	Matrix4f	prevMV;
+}PerObjectState;
+
+// Largest difference of elements, relative to the larger of 1 and reference element
+static double GetRelativeError(const Matrix4f& m, const Matrix4d& reference)
+{
+	double maxError = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		for (uint32_t j = 0; j < 4; j++)
+			maxError = std::max(maxError, std::abs(m[i][j] - reference[i][j]) / std::max(1.0, std::abs(reference[i][j])));
+	}
+	return maxError;
+}
+
+int main()
+{
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<double> angleDistribution(-3.14159, 3.14159);
+	std::uniform_real_distribution<double> offsetDistribution(-OBJECT_SPREAD, OBJECT_SPREAD);
+
+	Vector3d cameraPosition(CAMERA_POSITION[0], CAMERA_POSITION[1], CAMERA_POSITION[2]);
+	Matrix4d view = Matrix4d(Matrix4d::EulerAngle(0.3, -1.1, 0.2).RotationMatrix(), cameraPosition);
+	view.Inverse();
+
+	// Perspective of 90 degrees vertical field of view, 16:9, reversed depth from 0.1
+	Matrix4d projection(
+		0.5625, 0, 0, 0,
+		0, -1, 0, 0,
+		0, 0, 0, -1,
+		0, 0, 0.1, 0);
+
+	std::vector<Matrix4d> models(OBJECT_COUNT);
+	for (auto& model : models)
+		model = Matrix4d(Matrix4d::EulerAngle(angleDistribution(generator), angleDistribution(generator), angleDistribution(generator)).RotationMatrix(),
+			cameraPosition + Vector3d(offsetDistribution(generator), offsetDistribution(generator), offsetDistribution(generator)));
+
+	// Destination of both paths, stands for mapped memory of a frame region
+	std::vector<PerObjectVariablesf> destination(OBJECT_COUNT);
+
+	// Before: double copy, float shadow, copy into buffer
+	std::vector<PerObjectVariablesd> doubleVariables(OBJECT_COUNT);
+	std::vector<PerObjectVariablesf> shadowVariables(OBJECT_COUNT);
+	double doubleTime = TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+		{
+			PerObjectVariablesd& variables = doubleVariables[i];
+			variables.prevMV = variables.MV;
+			variables.MV = view * models[i];
+
+			variables.MVP = projection * variables.MV;
+			variables.prevMVP = projection * variables.prevMV;
+
+			Matrix4d temp = variables.MV;
+			temp.c30 = temp.c31 = temp.c32 = 0;
+			variables.MV_Rotation_P = projection * temp;
+			temp = variables.prevMV;
+			temp.c30 = temp.c31 = temp.c32 = 0;
+			variables.prevMV_Rotation_P = projection * temp;
+
+			shadowVariables[i].MV = variables.MV.SinglePrecision();
+			shadowVariables[i].MVP = variables.MVP.SinglePrecision();
+			shadowVariables[i].MV_Rotation_P = variables.MV_Rotation_P.SinglePrecision();
+			shadowVariables[i].prevMV = variables.prevMV.SinglePrecision();
+			shadowVariables[i].prevMVP = variables.prevMVP.SinglePrecision();
+			shadowVariables[i].prevMV_Rotation_P = variables.prevMV_Rotation_P.SinglePrecision();
+		}
+		memcpy(destination.data(), shadowVariables.data(), OBJECT_COUNT * sizeof(PerObjectVariablesf));
+	}, BENCHMARK_ROUND_COUNT);
+
+	// Now: float relative model, view rotation and projection cached once per frame, written as whole structs
+	std::vector<PerObjectState> states(OBJECT_COUNT);
+	double floatTime = TimeMilliseconds([&]()
+	{
+		Matrix4d viewRotation = view;
+		viewRotation.c30 = viewRotation.c31 = viewRotation.c32 = 0;
+		Matrix4f viewRotationf = viewRotation.SinglePrecision();
+		Matrix4f projectionf = projection.SinglePrecision();
+
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+		{
+			PerObjectState& state = states[i];
+			state.relativeModel = GetRelativeModelMatrix(models[i], cameraPosition);
+			state.prevMV = state.MV;
+			state.MV = viewRotationf * state.relativeModel;
+		}
+
+		PerObjectVariablesf variables;
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+		{
+			DerivePerObjectVariables(states[i].MV, states[i].prevMV, projectionf, variables);
+			destination[i] = variables;
+		}
+	}, BENCHMARK_ROUND_COUNT);
+
+	// Precision against double model view, and against narrowing world matrices before multiplying
+	Matrix4f viewf = view.SinglePrecision();
+	Matrix4f projectionf = projection.SinglePrecision();
+	double maxMVError = 0, maxMVPError = 0, maxNarrowedError = 0;
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		Matrix4d MV = view * models[i];
+		maxMVError = std::max(maxMVError, GetRelativeError(destination[i].MV, MV));
+		maxMVPError = std::max(maxMVPError, GetRelativeError(destination[i].MVP, projection * MV));
+		maxMVPError = std::max(maxMVPError, GetRelativeError(destination[i].prevMVP, projection * MV));
+		maxNarrowedError = std::max(maxNarrowedError, GetRelativeError(viewf * models[i].SinglePrecision(), MV));
+	}
+	Check(maxMVError < MAX_RELATIVE_ERROR, "float model view relative to camera is within float rounding of double one");
+	Check(maxMVPError < MAX_RELATIVE_ERROR, "float MVP is within float rounding of double one");
+	Check(maxNarrowedError > maxMVError, "narrowing world matrices first loses more");
+
+	// Previous frame is the one before
+	Check(memcmp(&destination[0].prevMV, &destination[0].MV, sizeof(Matrix4f)) == 0, "previous model view is kept for an unchanged object");
+
+	printf("%u objects, update, derive and write, double then narrowed: %.3f ms, float relative to camera: %.3f ms\n", OBJECT_COUNT, doubleTime, floatTime);
+	printf("Max relative error of MV: %g, of MVP: %g, of MV narrowed from world matrices: %g\n", maxMVError, maxMVPError, maxNarrowedError);
+
+	return Report();
+}
\ No newline at end of file
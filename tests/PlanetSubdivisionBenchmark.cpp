@@ -0,0 +1,374 @@
+// Times subdividing all 20 icosahedron faces of a planet from scratch, the work PlanetGenerator does after its trees are reset
+// "Before" runs faces one after another on one thread, "after" updates each face on its own, spread over worker threads
+// Classification and division follow PlanetGenerator, and workers take faces the way ThreadTaskQueue::ParallelFor hands out chunks
+// Leaves of both paths are checked to be the same, in the same order
+
+#include "Benchmark.h"
+#include "../Maths/Matrix.h"
+#include "../Maths/Plane.h"
+#include "../Maths/PyramidFrustum.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const uint32_t MAX_LEVEL = 32;
+static const uint32_t TRIANGLE_SCREEN_SIZE = 400;
+static const double HORIZONTAL_FOV = 1.2;
+static const double WINDOW_WIDTH = 1920;
+static const double ASPECT = 16.0 / 9.0;
+static const uint32_t ROUND_COUNT = 20;
+
+enum class CullState
+{
+	CULL,
+	CULL_DIVIDE,
+	DIVIDE
+};
+
+enum class SubDivideResult
+{
+	CULLED,
+	LEAF,
+	DIVIDE
+};
+
+typedef struct _Triangle
+{
+	Vector3d	a;
+	Vector3d	b;
+	Vector3d	c;
+}Triangle;
+
+class PlanetSubdivision
+{
+public:
+	PlanetSubdivision(uint32_t triangleScreenSize)
+	{
+		double ratio = (1.0 + sqrt(5.0)) / 2.0;
+		double scale = 1.0 / Vector2d(ratio, 1.0).Length();
+		ratio *= scale;
+
+		Vector3d vertices[] =
+		{
+			{ ratio, 0, -scale }, { -ratio, 0, -scale }, { ratio, 0, scale }, { -ratio, 0, scale },
+			{ 0, -scale, ratio }, { 0, -scale, -ratio }, { 0, scale, ratio }, { 0, scale, -ratio },
+			{ -scale, ratio, 0 }, { -scale, -ratio, 0 }, { scale, ratio, 0 }, { scale, -ratio, 0 }
+		};
+
+		uint32_t indices[20 * 3] =
+		{
+			1, 3, 8, 3, 1, 9, 0, 10, 2, 2, 11, 0,
+			5, 7, 0, 7, 5, 1, 4, 2, 6, 6, 3, 4,
+			9, 11, 4, 11, 9, 5, 8, 6, 10, 10, 7, 8,
+			1, 8, 7, 5, 9, 1, 0, 7, 10, 5, 0, 11,
+			3, 6, 8, 4, 3, 9, 2, 10, 6, 4, 11, 2
+		};
+
+		for (uint32_t i = 0; i < 12; i++)
+			vertices[i].Normalize();
+
+		for (uint32_t i = 0; i < 20; i++)
+			m_faces[i] = { vertices[indices[i * 3]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]] };
+
+		// Height and distance tables, built as PlanetGenerator::Init and Start do
+		Vector3d a = m_faces[0].a, b = m_faces[0].b, c = m_faces[0].c;
+		Vector3d center = (a + b + c) / 3.0;
+		center.Normalize();
+
+		m_heightLUT.push_back(1 / (a * center));
+		for (uint32_t i = 1; i < MAX_LEVEL + 1; i++)
+		{
+			Vector3d A = (b + c) * 0.5;
+			Vector3d B = (a + c) * 0.5;
+			Vector3d C = (a + b) * 0.5;
+			A.Normalize();
+			m_heightLUT.push_back(1 / (A * center));
+			a = A;
+			b = B;
+			c = C;
+		}
+
+		double size = (m_faces[0].a - m_faces[0].b).Length();
+		double frac = std::tan(HORIZONTAL_FOV * triangleScreenSize / WINDOW_WIDTH);
+		for (uint32_t i = 0; i < MAX_LEVEL + 1; i++)
+		{
+			m_distanceLUT.push_back(size / frac);
+			size *= 0.5;
+		}
+	}
+
+	// Camera looks at planet center from "cameraPosition"
+	void SetCamera(const Vector3d& cameraPosition)
+	{
+		m_cameraPosition = cameraPosition;
+
+		m_cameraFrustum = PyramidFrustumd({ 0, 0, 0 }, { 0, 0, -1 }, HORIZONTAL_FOV / ASPECT * 0.5, ASPECT);
+		Quaterniond rotation({ 0, 0, -1 }, (Vector3d() - cameraPosition).Normal());
+		m_cameraFrustum.Transform(Matrix4d(rotation.Matrix(), cameraPosition));
+	}
+
+	void SubdivideFace(uint32_t face, std::vector<Triangle>& leaves) const
+	{
+		const Triangle& triangle = m_faces[face];
+		Subdivide(0, CullState::CULL_DIVIDE, triangle.a * m_planetRadius, triangle.b * m_planetRadius, triangle.c * m_planetRadius, leaves);
+	}
+
+private:
+	CullState FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height) const
+	{
+		CullState state = CullState::DIVIDE;
+		for (uint32_t i = 0; i < m_cameraFrustum.FrustumFace_COUNT; i++)
+		{
+			uint32_t outsideCount = 0;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(a) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(b) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(c) > 0 ? 0 : 1;
+
+			if (outsideCount == 3)
+			{
+				outsideCount += m_cameraFrustum.planes[i].PlaneTest(a * height) > 0 ? 0 : 1;
+				outsideCount += m_cameraFrustum.planes[i].PlaneTest(b * height) > 0 ? 0 : 1;
+				outsideCount += m_cameraFrustum.planes[i].PlaneTest(c * height) > 0 ? 0 : 1;
+
+				if (outsideCount == 6)
+					return CullState::CULL;
+				else
+					state = CullState::CULL_DIVIDE;
+			}
+			else if (outsideCount > 0)
+				state = CullState::CULL_DIVIDE;
+		}
+
+		return state;
+	}
+
+	SubDivideResult Classify(uint32_t currentLevel, CullState& state, const Vector3d& a, const Vector3d& b, const Vector3d& c) const
+	{
+		if (state == CullState::CULL_DIVIDE)
+		{
+			state = FrustumCull(a, b, c, m_heightLUT[currentLevel]);
+			if (state == CullState::CULL)
+				return SubDivideResult::CULLED;
+		}
+
+		Vector3d normal = a;
+		normal += b;
+		normal += c;
+
+		Vector3d toCenter = normal;
+		toCenter /= 3.0;
+		toCenter -= m_cameraPosition;
+
+		normal.Normalize();
+		toCenter.Normalize();
+
+		if (toCenter * normal > 0.4)
+			return SubDivideResult::CULLED;
+
+		double distA = (a - m_cameraPosition).Length();
+		double distB = (b - m_cameraPosition).Length();
+		double distC = (c - m_cameraPosition).Length();
+
+		double minDist = std::fmin(std::fmin(distA, distB), distC);
+
+		if (m_distanceLUT[currentLevel] * m_planetRadius <= minDist || currentLevel == MAX_LEVEL)
+			return SubDivideResult::LEAF;
+
+		return SubDivideResult::DIVIDE;
+	}
+
+	// Same as SceneGenerator::SubDivideTriangle followed by PlanetGenerator::DivideTriangle
+	void Divide(const Vector3d& a, const Vector3d& b, const Vector3d& c, Vector3d& A, Vector3d& B, Vector3d& C) const
+	{
+		A = (c + b) * 0.5;
+		B = (c + a) * 0.5;
+		C = (b + a) * 0.5;
+		A.Normalize();
+		B.Normalize();
+		C.Normalize();
+		A *= m_planetRadius;
+		B *= m_planetRadius;
+		C *= m_planetRadius;
+	}
+
+	void Subdivide(uint32_t level, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, std::vector<Triangle>& leaves) const
+	{
+		SubDivideResult result = Classify(level, state, a, b, c);
+		if (result == SubDivideResult::CULLED)
+			return;
+
+		if (result == SubDivideResult::LEAF)
+		{
+			leaves.push_back({ a, b, c });
+			return;
+		}
+
+		Vector3d A, B, C;
+		Divide(a, b, c, A, B, C);
+
+		Subdivide(level + 1, state, a, C, B, leaves);
+		Subdivide(level + 1, state, C, b, A, leaves);
+		Subdivide(level + 1, state, B, A, c, leaves);
+		Subdivide(level + 1, state, A, B, C, leaves);
+	}
+
+private:
+	double					m_planetRadius = 6371000.0;
+	Triangle				m_faces[20];
+	std::vector<double>		m_heightLUT;
+	std::vector<double>		m_distanceLUT;
+
+	Vector3d				m_cameraPosition;
+	PyramidFrustumd			m_cameraFrustum;
+};
+
+// Workers live as long as the pool, like those of ThreadTaskQueue
+// Chunks are taken from a shared counter by calling thread and workers alike, as ThreadTaskQueue::ParallelFor does with grain 1
+class WorkerPool
+{
+public:
+	WorkerPool(uint32_t workerCount)
+	{
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_workers.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_workCondition.notify_all();
+		for (auto& worker : m_workers)
+			worker.join();
+	}
+
+	void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pFunc = &func;
+			m_count = count;
+			m_nextChunk = 0;
+			m_busyWorkers = (uint32_t)m_workers.size();
+			m_generation++;
+		}
+		m_workCondition.notify_all();
+
+		ProcessChunks();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [this]() { return m_busyWorkers == 0; });
+	}
+
+private:
+	void ProcessChunks()
+	{
+		uint32_t chunk;
+		while ((chunk = m_nextChunk++) < m_count)
+			(*m_pFunc)(chunk);
+	}
+
+	void WorkerLoop()
+	{
+		uint32_t generation = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_workCondition.wait(lock, [this, generation]() { return m_quit || m_generation != generation; });
+				if (m_quit)
+					return;
+				generation = m_generation;
+			}
+
+			ProcessChunks();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_busyWorkers == 0)
+				m_doneCondition.notify_one();
+		}
+	}
+
+private:
+	std::vector<std::thread>				m_workers;
+	std::mutex								m_mutex;
+	std::condition_variable					m_workCondition;
+	std::condition_variable					m_doneCondition;
+	const std::function<void(uint32_t)>*	m_pFunc = nullptr;
+	uint32_t								m_count = 0;
+	std::atomic<uint32_t>					m_nextChunk = { 0 };
+	uint32_t								m_busyWorkers = 0;
+	uint32_t								m_generation = 0;
+	bool									m_quit = false;
+};
+
+int main()
+{
+	// At least a few workers, so that faces are really taken concurrently even on a small machine
+	uint32_t workerCount = std::max(3u, std::thread::hardware_concurrency() - 1);
+	WorkerPool workerPool(workerCount);
+
+	std::vector<Triangle> serialLeaves;
+	std::vector<std::vector<Triangle>> faceLeaves(20);
+
+	printf("Full subdivision of 20 faces, %u worker threads, average of %u rounds\n", workerCount, ROUND_COUNT);
+
+	// Triangle size PlanetGenerator uses, and a much finer one that gives workers more to do
+	const uint32_t triangleScreenSizes[] = { TRIANGLE_SCREEN_SIZE, 25 };
+
+	// From orbit down to close to the ground, deeper levels show up as camera gets closer
+	const double altitudes[] = { 10000000.0, 1000000.0, 100000.0, 10000.0, 1000.0 };
+
+	for (uint32_t triangleScreenSize : triangleScreenSizes)
+	{
+		PlanetSubdivision planet(triangleScreenSize);
+		printf("Triangles of %u pixels\n", triangleScreenSize);
+
+		for (double altitude : altitudes)
+		{
+			Vector3d cameraPosition = Vector3d(0.3, 0.2, 1.0).Normal() * (6371000.0 + altitude);
+			planet.SetCamera(cameraPosition);
+
+			double serialTime = TimeMilliseconds([&]()
+			{
+				serialLeaves.clear();
+				for (uint32_t face = 0; face < 20; face++)
+					planet.SubdivideFace(face, serialLeaves);
+			}, ROUND_COUNT);
+
+			double parallelTime = TimeMilliseconds([&]()
+			{
+				workerPool.ParallelFor(20, [&planet, &faceLeaves](uint32_t face)
+				{
+					faceLeaves[face].clear();
+					planet.SubdivideFace(face, faceLeaves[face]);
+				});
+			}, ROUND_COUNT);
+
+			// Speedup is bounded by the face with most work, as a face is never split between workers
+			std::vector<Triangle> parallelLeaves;
+			uint32_t largestFace = 0;
+			for (auto& leaves : faceLeaves)
+			{
+				parallelLeaves.insert(parallelLeaves.end(), leaves.begin(), leaves.end());
+				largestFace = std::max(largestFace, (uint32_t)leaves.size());
+			}
+
+			Check(!serialLeaves.empty() && parallelLeaves.size() == serialLeaves.size()
+				&& memcmp(parallelLeaves.data(), serialLeaves.data(), sizeof(Triangle) * serialLeaves.size()) == 0, "parallel leaves match serial ones");
+
+			printf("Altitude %.0f m: %u triangles, largest face %u, serial %.3f ms, parallel %.3f ms\n",
+				altitude, (uint32_t)serialLeaves.size(), largestFace, serialTime, parallelTime);
+		}
+	}
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+// Compiles a render graph shaped like the frame RenderWorkManager builds, and checks culling, lifetimes, aliasing and barriers
+// Also reports peak transient memory before and after aliasing
+// Only Compile() is involved, so no device is needed, just Vulkan headers
+
+#include "Benchmark.h"
+#include "../class/RenderGraph.h"
+
+// Compile results are protected, they're looked at from here
+class RenderGraphInspector : public RenderGraph
+{
+public:
+	const Resource& GetResource(ResourceHandle resource) const { return m_resources[resource]; }
+	const BarrierBatch& GetBarrierBatch(uint32_t orderIndex) const { return m_barrierBatches[orderIndex]; }
+	uint32_t GetOrderIndex(PassHandle pass) const
+	{
+		for (uint32_t i = 0; i < m_passOrder.size(); i++)
+		{
+			if (m_passOrder[i] == pass)
+				return i;
+		}
+		return INVALID_HANDLE;
+	}
+	uint32_t GetSurvivingPassCount() const { return (uint32_t)m_passOrder.size(); }
+};
+
+static const uint64_t WIDTH = 1920;
+static const uint64_t HEIGHT = 1080;
+static const uint64_t IMAGE_ALIGNMENT = 65536;
+static const uint32_t DEVICE_LOCAL_TYPES = 0x0F;
+
+static VkMemoryRequirements ImageReqs(uint64_t width, uint64_t height, uint64_t bytesPerPixel, uint32_t memoryTypeBits = DEVICE_LOCAL_TYPES)
+{
+	VkMemoryRequirements reqs = {};
+	reqs.size = width * height * bytesPerPixel;
+	reqs.alignment = IMAGE_ALIGNMENT;
+	reqs.memoryTypeBits = memoryTypeBits;
+	return reqs;
+}
+
+static bool Overlaps(uint64_t offset0, uint64_t size0, uint64_t offset1, uint64_t size1)
+{
+	return offset0 < offset1 + size1 && offset1 < offset0 + size0;
+}
+
+int main()
+{
+	RenderGraphInspector graph;
+
+	typedef RenderGraph::ResourceHandle ResourceHandle;
+	typedef RenderGraph::PassHandle PassHandle;
+
+	// Imported resources
+	ResourceHandle gbuffer = graph.AddResource("GBuffer", nullptr);
+	ResourceHandle depth = graph.AddResource("Depth", nullptr);
+	ResourceHandle motion = graph.AddResource("MotionVector", nullptr);
+	ResourceHandle shadowMap = graph.AddResource("ShadowMap", nullptr);
+	ResourceHandle history = graph.AddResource("TemporalHistory", nullptr, RenderGraph::ResourceUsage_ColorAttachment);
+	ResourceHandle shading = graph.AddResource("Shading", nullptr);
+	ResourceHandle temporal = graph.AddResource("TemporalResult", nullptr);
+	ResourceHandle swapchain = graph.AddResource("Swapchain", nullptr);
+	graph.MarkOutput(temporal);
+	graph.MarkOutput(swapchain);
+
+	// Transient resources
+	ResourceHandle tileMax = graph.AddTransientResource("MotionTileMax", nullptr, ImageReqs(WIDTH / 20, HEIGHT / 20, 4));
+	ResourceHandle neighborMax = graph.AddTransientResource("MotionNeighborMax", nullptr, ImageReqs(WIDTH / 20, HEIGHT / 20, 4));
+	ResourceHandle ssao = graph.AddTransientResource("SSAO", nullptr, ImageReqs(WIDTH, HEIGHT, 8));
+	ResourceHandle blurV = graph.AddTransientResource("SSAOBlurV", nullptr, ImageReqs(WIDTH, HEIGHT, 8));
+	ResourceHandle blurH = graph.AddTransientResource("SSAOBlurH", nullptr, ImageReqs(WIDTH, HEIGHT, 8));
+	ResourceHandle bloomDown = graph.AddTransientResource("BloomDown", nullptr, ImageReqs(WIDTH / 2, HEIGHT / 2, 8));
+	ResourceHandle bloomUp = graph.AddTransientResource("BloomUp", nullptr, ImageReqs(WIDTH / 2, HEIGHT / 2, 8));
+	ResourceHandle combine = graph.AddTransientResource("Combine", nullptr, ImageReqs(WIDTH, HEIGHT, 8));
+	// Lives in memory types none of the others could use, so it can't be aliased
+	ResourceHandle lensFlare = graph.AddTransientResource("LensFlare", nullptr, ImageReqs(WIDTH / 4, HEIGHT / 4, 8, 0x10));
+	ResourceHandle debugView = graph.AddTransientResource("DebugView", nullptr, ImageReqs(WIDTH, HEIGHT, 8));
+
+	PassHandle gbufferPass = graph.AddPass("GBuffer", nullptr);
+	graph.Write(gbufferPass, gbuffer);
+	graph.Write(gbufferPass, motion);
+	graph.Write(gbufferPass, depth, RenderGraph::ResourceUsage_DepthAttachment);
+
+	PassHandle shadowPass = graph.AddPass("ShadowMapGen", nullptr);
+	graph.Write(shadowPass, shadowMap, RenderGraph::ResourceUsage_DepthAttachment);
+
+	// Nothing reads what it writes
+	PassHandle debugPass = graph.AddPass("DebugView", nullptr);
+	graph.Read(debugPass, gbuffer);
+	graph.Write(debugPass, debugView);
+
+	PassHandle tileMaxPass = graph.AddPass("MotionTileMax", nullptr);
+	graph.Read(tileMaxPass, motion);
+	graph.Write(tileMaxPass, tileMax);
+
+	PassHandle neighborMaxPass = graph.AddPass("MotionNeighborMax", nullptr);
+	graph.Read(neighborMaxPass, tileMax);
+	graph.Write(neighborMaxPass, neighborMax);
+
+	PassHandle ssaoPass = graph.AddPass("SSAO", nullptr);
+	graph.Read(ssaoPass, gbuffer);
+	graph.Read(ssaoPass, depth);
+	graph.Write(ssaoPass, ssao);
+
+	PassHandle blurVPass = graph.AddPass("SSAOBlurV", nullptr);
+	graph.Read(blurVPass, ssao);
+	graph.Write(blurVPass, blurV);
+
+	PassHandle blurHPass = graph.AddPass("SSAOBlurH", nullptr);
+	graph.Read(blurHPass, blurV);
+	graph.Write(blurHPass, blurH);
+
+	PassHandle shadingPass = graph.AddPass("Shading", nullptr);
+	graph.Read(shadingPass, gbuffer);
+	graph.Read(shadingPass, depth);
+	graph.Read(shadingPass, depth, RenderGraph::ResourceUsage_DepthTestRead);
+	graph.Read(shadingPass, shadowMap);
+	graph.Read(shadingPass, blurH);
+	graph.Write(shadingPass, shading);
+
+	PassHandle temporalPass = graph.AddPass("TemporalResolve", nullptr);
+	graph.Read(temporalPass, shading);
+	graph.Read(temporalPass, motion);
+	graph.Read(temporalPass, neighborMax);
+	graph.Read(temporalPass, history);
+	graph.Write(temporalPass, temporal);
+
+	PassHandle bloomDownPass = graph.AddPass("BloomDownsample", nullptr);
+	graph.Read(bloomDownPass, temporal);
+	graph.Write(bloomDownPass, bloomDown);
+
+	PassHandle lensFlarePass = graph.AddPass("LensFlare", nullptr);
+	graph.Read(lensFlarePass, bloomDown);
+	graph.Write(lensFlarePass, lensFlare);
+
+	PassHandle bloomUpPass = graph.AddPass("BloomUpsample", nullptr);
+	graph.Read(bloomUpPass, bloomDown);
+	graph.Read(bloomUpPass, lensFlare);
+	graph.Write(bloomUpPass, bloomUp);
+
+	// Overwritten by the combine pass before anything reads it
+	PassHandle staleCombinePass = graph.AddPass("StaleCombine", nullptr);
+	graph.Read(staleCombinePass, temporal);
+	graph.Write(staleCombinePass, combine);
+
+	PassHandle combinePass = graph.AddPass("Combine", nullptr);
+	graph.Read(combinePass, temporal);
+	graph.Read(combinePass, bloomUp);
+	graph.Write(combinePass, combine);
+
+	PassHandle postPass = graph.AddPass("PostProcess", nullptr);
+	graph.Read(postPass, combine);
+	graph.Read(postPass, neighborMax);
+	graph.Write(postPass, swapchain);
+
+	Check(graph.Compile(), "graph compiles");
+	const RenderGraph::CompileStatistics& statistics = graph.GetStatistics();
+
+	// Culling
+	Check(graph.IsPassCulled(debugPass), "pass whose result isn't read is culled");
+	Check(graph.IsPassCulled(staleCombinePass), "pass whose result is overwritten before read is culled");
+	Check(statistics.culledPassCount == 2, "only those 2 passes are culled");
+	Check(graph.GetSurvivingPassCount() == graph.GetPassCount() - 2, "surviving passes are the rest");
+	for (PassHandle pass = 0; pass < graph.GetPassCount(); pass++)
+	{
+		if (pass != debugPass && pass != staleCombinePass)
+			Check(!graph.IsPassCulled(pass), "pass feeding an output survives");
+	}
+
+	// Lifetimes, in indices of surviving passes
+	auto checkLifetime = [&](ResourceHandle resource, PassHandle first, PassHandle last)
+	{
+		Check(graph.GetResource(resource).firstPass == graph.GetOrderIndex(first) && graph.GetResource(resource).lastPass == graph.GetOrderIndex(last), "lifetime spans from first write to last read");
+	};
+	checkLifetime(tileMax, tileMaxPass, neighborMaxPass);
+	checkLifetime(neighborMax, neighborMaxPass, postPass);
+	checkLifetime(ssao, ssaoPass, blurVPass);
+	checkLifetime(blurV, blurVPass, blurHPass);
+	checkLifetime(blurH, blurHPass, shadingPass);
+	checkLifetime(bloomDown, bloomDownPass, bloomUpPass);
+	checkLifetime(bloomUp, bloomUpPass, combinePass);
+	checkLifetime(combine, combinePass, postPass);
+	Check(graph.GetResource(debugView).firstPass == RenderGraph::INVALID_HANDLE, "resource of culled passes only has no lifetime");
+
+	// Aliasing
+	const VkMemoryRequirements& transientReqs = graph.GetTransientMemoryRequirements();
+	Check(graph.GetAliasOffset(debugView) == RenderGraph::INVALID_OFFSET, "resource without lifetime gets no memory");
+	Check(graph.GetAliasOffset(lensFlare) == RenderGraph::INVALID_OFFSET, "resource with incompatible memory types isn't aliased");
+	Check(graph.GetAliasOffset(shading) == RenderGraph::INVALID_OFFSET, "imported resource isn't aliased");
+	Check(transientReqs.memoryTypeBits == DEVICE_LOCAL_TYPES && transientReqs.alignment == IMAGE_ALIGNMENT, "transient memory satisfies all aliased resources");
+
+	bool anyShared = false;
+	for (ResourceHandle i = 0; i < graph.GetResourceCount(); i++)
+	{
+		const auto& resource = graph.GetResource(i);
+		if (resource.aliasOffset == RenderGraph::INVALID_OFFSET)
+			continue;
+
+		Check(resource.aliasOffset % resource.memoryReqs.alignment == 0, "alias offset is aligned");
+		Check(resource.aliasOffset + resource.memoryReqs.size <= transientReqs.size, "aliased resource fits in transient memory");
+
+		for (ResourceHandle j = i + 1; j < graph.GetResourceCount(); j++)
+		{
+			const auto& other = graph.GetResource(j);
+			if (other.aliasOffset == RenderGraph::INVALID_OFFSET)
+				continue;
+
+			bool aliveTogether = resource.firstPass <= other.lastPass && other.firstPass <= resource.lastPass;
+			bool sharesMemory = Overlaps(resource.aliasOffset, resource.memoryReqs.size, other.aliasOffset, other.memoryReqs.size);
+			Check(!(aliveTogether && sharesMemory), "resources alive at the same time don't share memory");
+			anyShared = anyShared || sharesMemory;
+		}
+	}
+	Check(anyShared, "some resources share memory");
+	Check(statistics.transientResourceCount == 9, "transient resources used by surviving passes are counted");
+	Check(statistics.aliasedTransientBytes < statistics.transientBytes, "aliasing saves memory");
+	Check(statistics.aliasedTransientBytes >= statistics.liveTransientBytes, "aliasing can't go below live peak");
+	Check(statistics.aliasedTransientBytes == transientReqs.size + graph.GetResource(lensFlare).memoryReqs.size, "aliased peak is transient memory plus unaliased resources");
+
+	// Barriers
+	for (uint32_t i = 0; i < graph.GetSurvivingPassCount(); i++)
+	{
+		const auto& batch = graph.GetBarrierBatch(i);
+		for (uint32_t j = 0; j < batch.imageBarriers.size(); j++)
+		{
+			for (uint32_t k = j + 1; k < batch.imageBarriers.size(); k++)
+				Check(batch.imageBarriers[j].resource != batch.imageBarriers[k].resource, "one image barrier per resource in a batch");
+		}
+	}
+
+	const auto& shadingBatch = graph.GetBarrierBatch(graph.GetOrderIndex(shadingPass));
+	bool hasGBufferBarrier = false, hasDepthBarrier = false;
+	for (auto& barrier : shadingBatch.imageBarriers)
+	{
+		hasGBufferBarrier = hasGBufferBarrier || barrier.resource == gbuffer;
+		if (barrier.resource == depth)
+		{
+			hasDepthBarrier = true;
+			Check(barrier.dstAccess == RenderGraph::GetUsageInfo(RenderGraph::ResourceUsage_DepthTestRead).access, "depth barrier only adds what SSAO read didn't cover");
+		}
+	}
+	Check(!hasGBufferBarrier, "read covered by an earlier barrier of the same write is skipped");
+	Check(hasDepthBarrier, "depth test read of depth written before gets a barrier");
+	Check(shadingBatch.imageBarriers.size() == 3, "shading waits on depth, shadow map and SSAO only");
+	Check(statistics.skippedBarrierCount > 0, "skipped barriers are counted");
+	Check(graph.GetBarrierBatch(graph.GetOrderIndex(gbufferPass)).srcStages == 0, "first pass waits on nothing");
+
+	// First write into memory a dead resource used to hold waits on that resource's last reads
+	uint32_t reuseCount = 0;
+	for (ResourceHandle i = 0; i < graph.GetResourceCount(); i++)
+	{
+		const auto& resource = graph.GetResource(i);
+		if (resource.aliasOffset == RenderGraph::INVALID_OFFSET)
+			continue;
+
+		for (ResourceHandle j = 0; j < graph.GetResourceCount(); j++)
+		{
+			const auto& other = graph.GetResource(j);
+			if (other.aliasOffset == RenderGraph::INVALID_OFFSET || other.lastPass >= resource.firstPass)
+				continue;
+
+			if (Overlaps(resource.aliasOffset, resource.memoryReqs.size, other.aliasOffset, other.memoryReqs.size))
+			{
+				const auto& batch = graph.GetBarrierBatch(resource.firstPass);
+				Check((batch.srcStages & RenderGraph::GetUsageInfo(RenderGraph::ResourceUsage_FragmentShaderRead).stages) != 0, "reused memory waits on reads of its previous resource");
+				reuseCount++;
+			}
+		}
+	}
+	Check(reuseCount > 0, "some memory is reused");
+
+	printf("%u passes, %u culled, %u barrier batches, %u image barriers, %u skipped\n",
+		statistics.passCount, statistics.culledPassCount, statistics.barrierBatchCount, statistics.imageBarrierCount, statistics.skippedBarrierCount);
+	for (ResourceHandle i = 0; i < graph.GetResourceCount(); i++)
+	{
+		const auto& resource = graph.GetResource(i);
+		if (!resource.isTransient || resource.firstPass == RenderGraph::INVALID_HANDLE)
+			continue;
+
+		if (resource.aliasOffset == RenderGraph::INVALID_OFFSET)
+			printf("%-18s passes %2u-%2u, %9llu bytes, not aliased\n", resource.name.c_str(), resource.firstPass, resource.lastPass, (unsigned long long)resource.memoryReqs.size);
+		else
+			printf("%-18s passes %2u-%2u, %9llu bytes at offset %9llu\n", resource.name.c_str(), resource.firstPass, resource.lastPass, (unsigned long long)resource.memoryReqs.size, (unsigned long long)resource.aliasOffset);
+	}
+	printf("Peak transient memory: %llu bytes before aliasing, %llu bytes after aliasing, %llu bytes alive at most\n",
+		(unsigned long long)statistics.transientBytes, (unsigned long long)statistics.aliasedTransientBytes, (unsigned long long)statistics.liveTransientBytes);
+
+	return Report();
+}
\ No newline at end of file
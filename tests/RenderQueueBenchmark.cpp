@@ -0,0 +1,222 @@
+// Times building a material's render queue out of 50k draw submissions, per frame
+// "Before" follows the per mesh hash map path Material used, "after" the flat sort key path it uses now
+// Both paths are reproduced here without device objects, and their output is checked against each other
+
+#include "Benchmark.h"
+#include "../common/RadixSort.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+static const uint32_t SUBMISSION_COUNT = 50000;
+static const uint32_t MESH_COUNT = 1000;
+static const uint32_t FRAME_COUNT = 200;
+
+// Same layout as Material's sort key
+static const uint32_t INDEX_BITS = 20;
+static const uint32_t DISTANCE_BITS = 11;
+
+struct Mesh
+{
+	uint32_t	meshID;
+};
+
+struct IndirectIndices
+{
+	uint32_t	perObjectIndex;
+	uint32_t	perMaterialIndex;
+	uint32_t	perMeshIndex;
+	uint32_t	perAnimationIndex;
+};
+
+struct Submission
+{
+	std::shared_ptr<Mesh>	pMesh;
+	uint32_t				perObjectIndex;
+	float					distance;
+};
+
+// Draws of a queue, and indirect indices in the order they're written
+struct QueueOutput
+{
+	std::vector<Mesh*>		drawMeshes;
+	std::vector<uint32_t>	drawInstanceCounts;
+	std::vector<uint32_t>	objectIndices;
+};
+
+class HashMapQueue
+{
+public:
+	void Insert(const Submission& submission)
+	{
+		auto iter = m_meshRefTable.find(submission.pMesh);
+		if (iter == m_meshRefTable.end())
+		{
+			m_renderData.push_back({ submission.pMesh, 1, std::vector<IndirectIndices>(1, { submission.perObjectIndex, 0, 0, 0 }) });
+			m_meshRefTable[submission.pMesh] = (uint32_t)m_renderData.size() - 1;
+			return;
+		}
+
+		m_renderData[iter->second].instanceCount++;
+		m_renderData[iter->second].indirectIndices.push_back({ submission.perObjectIndex, 0, 0, 0 });
+	}
+
+	void Build(QueueOutput& output)
+	{
+		for (auto& renderData : m_renderData)
+		{
+			output.drawMeshes.push_back(renderData.pMesh.get());
+			output.drawInstanceCounts.push_back(renderData.instanceCount);
+			for (auto& indices : renderData.indirectIndices)
+				output.objectIndices.push_back(indices.perObjectIndex);
+		}
+	}
+
+	void Clear()
+	{
+		m_meshRefTable.clear();
+		m_renderData.clear();
+	}
+
+private:
+	struct MeshRenderData
+	{
+		std::shared_ptr<Mesh>			pMesh;
+		uint32_t						instanceCount;
+		std::vector<IndirectIndices>	indirectIndices;
+	};
+
+	std::unordered_map<std::shared_ptr<Mesh>, uint32_t>	m_meshRefTable;
+	std::vector<MeshRenderData>							m_renderData;
+};
+
+class SortKeyQueue
+{
+public:
+	void Insert(const Submission& submission)
+	{
+		uint32_t distanceBits;
+		memcpy(&distanceBits, &submission.distance, sizeof(float));
+
+		uint64_t sortKey = (uint64_t)submission.pMesh->meshID << (DISTANCE_BITS + 1 + INDEX_BITS);
+		sortKey |= (uint64_t)(distanceBits >> (31 - DISTANCE_BITS)) << INDEX_BITS;
+
+		m_items.push_back({ submission.pMesh.get(), { submission.perObjectIndex, 0, 0, 0 }, sortKey });
+	}
+
+	void Build(QueueOutput& output)
+	{
+		m_keys.resize(m_items.size());
+		for (uint32_t i = 0; i < (uint32_t)m_items.size(); i++)
+			m_keys[i] = m_items[i].sortKey | i;
+
+		RadixSort(m_keys, m_scratch, INDEX_BITS);
+
+		for (uint64_t key : m_keys)
+		{
+			const Item& item = m_items[(uint32_t)(key & ((1 << INDEX_BITS) - 1))];
+			if (output.drawMeshes.empty() || output.drawMeshes.back() != item.pMesh)
+			{
+				output.drawMeshes.push_back(item.pMesh);
+				output.drawInstanceCounts.push_back(0);
+			}
+			output.drawInstanceCounts.back()++;
+			output.objectIndices.push_back(item.indirectIndices.perObjectIndex);
+		}
+	}
+
+	void Clear()
+	{
+		m_items.clear();
+	}
+
+private:
+	struct Item
+	{
+		Mesh*			pMesh;
+		IndirectIndices	indirectIndices;
+		uint64_t		sortKey;
+	};
+
+	std::vector<Item>		m_items;
+	std::vector<uint64_t>	m_keys;
+	std::vector<uint64_t>	m_scratch;
+};
+
+template <typename Queue>
+static double TimeQueue(Queue& queue, const std::vector<Submission>& submissions, QueueOutput& output)
+{
+	return TimeMilliseconds([&]()
+	{
+		output = {};
+		queue.Clear();
+		for (auto& submission : submissions)
+			queue.Insert(submission);
+		queue.Build(output);
+	}, FRAME_COUNT);
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distanceDistribution(1.0f, 1000000.0f);
+
+	std::vector<std::shared_ptr<Mesh>> meshes;
+	for (uint32_t i = 0; i < MESH_COUNT; i++)
+		meshes.push_back(std::make_shared<Mesh>(Mesh{ i }));
+
+	std::vector<Submission> submissions;
+	for (uint32_t i = 0; i < SUBMISSION_COUNT; i++)
+		submissions.push_back({ meshes[random() % MESH_COUNT], i, distanceDistribution(random) });
+
+	HashMapQueue hashMapQueue;
+	SortKeyQueue sortKeyQueue;
+	QueueOutput hashMapOutput, sortKeyOutput;
+
+	double hashMapTime = TimeQueue(hashMapQueue, submissions, hashMapOutput);
+	double sortKeyTime = TimeQueue(sortKeyQueue, submissions, sortKeyOutput);
+
+	printf("%u submissions, %u meshes, average of %u frames\n", SUBMISSION_COUNT, MESH_COUNT, FRAME_COUNT);
+	printf("Hash map queue: %.3f ms per frame, %u draws\n", hashMapTime, (uint32_t)hashMapOutput.drawMeshes.size());
+	printf("Sort key queue: %.3f ms per frame, %u draws\n", sortKeyTime, (uint32_t)sortKeyOutput.drawMeshes.size());
+
+	// One draw per mesh either way, with the same instances
+	bool sameDraws = hashMapOutput.drawMeshes.size() == MESH_COUNT && sortKeyOutput.drawMeshes.size() == MESH_COUNT;
+
+	std::vector<uint32_t> hashMapInstances(MESH_COUNT), sortKeyInstances(MESH_COUNT);
+	for (uint32_t i = 0; sameDraws && i < MESH_COUNT; i++)
+	{
+		hashMapInstances[hashMapOutput.drawMeshes[i]->meshID] = hashMapOutput.drawInstanceCounts[i];
+		sortKeyInstances[sortKeyOutput.drawMeshes[i]->meshID] = sortKeyOutput.drawInstanceCounts[i];
+	}
+	Check(sameDraws && hashMapInstances == sortKeyInstances, "both queues have one draw per mesh with the same instances");
+
+	// Sort key queue goes from near to far within a draw, as far as distance bits tell
+	bool nearToFar = true;
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < (uint32_t)sortKeyOutput.drawMeshes.size(); i++)
+	{
+		for (uint32_t j = offset + 1; j < offset + sortKeyOutput.drawInstanceCounts[i]; j++)
+		{
+			uint32_t nearBits, farBits;
+			memcpy(&nearBits, &submissions[sortKeyOutput.objectIndices[j - 1]].distance, sizeof(float));
+			memcpy(&farBits, &submissions[sortKeyOutput.objectIndices[j]].distance, sizeof(float));
+			nearToFar = nearToFar && (nearBits >> (31 - DISTANCE_BITS)) <= (farBits >> (31 - DISTANCE_BITS));
+		}
+		offset += sortKeyOutput.drawInstanceCounts[i];
+	}
+
+	Check(nearToFar, "instances of a draw go from near to far");
+
+	std::vector<uint32_t> objectIndices = sortKeyOutput.objectIndices;
+	std::sort(objectIndices.begin(), objectIndices.end());
+	bool everyObject = objectIndices.size() == SUBMISSION_COUNT;
+	for (uint32_t i = 0; everyObject && i < SUBMISSION_COUNT; i++)
+		everyObject = objectIndices[i] == i;
+	Check(everyObject, "every submission is drawn once");
+
+	return Report();
+}
\ No newline at end of file
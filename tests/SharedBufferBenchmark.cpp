@@ -0,0 +1,226 @@
+// Times allocating and freeing chunks of a shared buffer, the way meshes take their vertex and index ranges
+// "Before" follows the sorted chunk table SharedBufferManager scanned, whose key map was rewritten on every insert and erase
+// "After" follows TLSF with stable key slots it uses now, including growth of the backing range
+// Both paths are reproduced here without device objects, and their chunks are checked to never overlap
+
+#include "Benchmark.h"
+#include "../vulkan/TLSFAllocator.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+static const uint32_t CHUNK_COUNT = 10000;
+static const uint32_t GROWTH_CHUNK_COUNT = 100000;
+static const uint32_t BUFFER_BYTES = 256 * 1024 * 1024;
+static const uint32_t GROWTH_INITIAL_BYTES = 1024 * 1024;
+
+typedef struct _Chunk
+{
+	uint32_t	offset;
+	uint32_t	range;
+}Chunk;
+
+class ChunkTableBuffer
+{
+public:
+	ChunkTableBuffer(uint32_t numBytes) : m_numBytes(numBytes) {}
+
+	bool Allocate(uint32_t numBytes, uint32_t& key)
+	{
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < m_bufferTable.size(); i++)
+		{
+			if (offset + numBytes - 1 < m_bufferTable[i].offset)
+			{
+				for (auto& value : m_lookupTable)
+				{
+					if (value.second >= i)
+						value.second++;
+				}
+
+				m_bufferTable.insert(m_bufferTable.begin() + i, { offset, numBytes });
+				m_lookupTable[m_numAllocatedKeys] = i;
+				key = m_numAllocatedKeys++;
+				return true;
+			}
+			offset = m_bufferTable[i].offset + m_bufferTable[i].range;
+		}
+
+		if (offset + numBytes > m_numBytes)
+			return false;
+
+		m_bufferTable.push_back({ offset, numBytes });
+		m_lookupTable[m_numAllocatedKeys] = (uint32_t)m_bufferTable.size() - 1;
+		key = m_numAllocatedKeys++;
+		return true;
+	}
+
+	void Free(uint32_t key)
+	{
+		uint32_t index = m_lookupTable[key];
+		m_lookupTable.erase(key);
+		m_bufferTable.erase(m_bufferTable.begin() + index);
+
+		for (auto& value : m_lookupTable)
+		{
+			if (value.second > index)
+				value.second--;
+		}
+	}
+
+	Chunk GetChunk(uint32_t key) { return m_bufferTable[m_lookupTable[key]]; }
+
+private:
+	uint32_t						m_numBytes;
+	std::vector<Chunk>				m_bufferTable;
+	std::map<uint32_t, uint32_t>	m_lookupTable;
+	uint32_t						m_numAllocatedKeys = 0;
+};
+
+class TLSFBuffer
+{
+public:
+	TLSFBuffer(uint32_t numBytes, bool allowGrowth) : m_allocator(numBytes), m_allowGrowth(allowGrowth) {}
+
+	bool Allocate(uint32_t numBytes, uint32_t& key)
+	{
+		uint32_t offset, allocationHandle;
+		if (!m_allocator.Allocate(numBytes, 1, offset, allocationHandle))
+		{
+			if (!Grow(numBytes) || !m_allocator.Allocate(numBytes, 1, offset, allocationHandle))
+				return false;
+		}
+
+		if (!m_freeKeys.empty())
+		{
+			key = m_freeKeys.back();
+			m_freeKeys.pop_back();
+		}
+		else
+		{
+			key = (uint32_t)m_bufferTable.size();
+			m_bufferTable.push_back({});
+		}
+
+		m_bufferTable[key] = { offset, numBytes, allocationHandle };
+		return true;
+	}
+
+	void Free(uint32_t key)
+	{
+		m_allocator.Free(m_bufferTable[key].allocationHandle);
+		m_bufferTable[key].allocationHandle = TLSFAllocator::INVALID_HANDLE;
+		m_freeKeys.push_back(key);
+	}
+
+	Chunk GetChunk(uint32_t key) const { return { m_bufferTable[key].offset, m_bufferTable[key].range }; }
+	uint32_t GetGrowCount() const { return m_growCount; }
+	uint32_t GetSize() const { return m_allocator.GetSize(); }
+
+private:
+	// Same policy as SharedBufferManager::GrowBuffer, device copy left out
+	bool Grow(uint32_t requiredBytes)
+	{
+		if (!m_allowGrowth)
+			return false;
+
+		uint64_t newSize = (uint64_t)m_allocator.GetSize() * 2;
+		if (newSize < (uint64_t)m_allocator.GetSize() + requiredBytes)
+			newSize = (uint64_t)m_allocator.GetSize() + requiredBytes;
+		if (newSize > UINT32_MAX)
+			return false;
+
+		m_allocator.Grow((uint32_t)newSize);
+		m_growCount++;
+		return true;
+	}
+
+private:
+	typedef struct _BufferChunk
+	{
+		uint32_t	offset;
+		uint32_t	range;
+		uint32_t	allocationHandle;
+	}BufferChunk;
+
+	TLSFAllocator				m_allocator;
+	bool						m_allowGrowth;
+	uint32_t					m_growCount = 0;
+	std::vector<BufferChunk>	m_bufferTable;
+	std::vector<uint32_t>		m_freeKeys;
+};
+
+// Allocates all chunks, frees every other one, then allocates them again, like meshes loaded, dropped and reloaded
+template <typename Buffer>
+static double TimeBuffer(Buffer& buffer, const std::vector<uint32_t>& sizes, std::vector<uint32_t>& keys)
+{
+	bool succeeded = true;
+	double time = TimeMilliseconds([&]()
+	{
+		keys.resize(sizes.size());
+		for (uint32_t i = 0; i < sizes.size(); i++)
+			succeeded = buffer.Allocate(sizes[i], keys[i]) && succeeded;
+
+		for (uint32_t i = 0; i < sizes.size(); i += 2)
+			buffer.Free(keys[i]);
+
+		for (uint32_t i = 0; i < sizes.size(); i += 2)
+			succeeded = buffer.Allocate(sizes[i], keys[i]) && succeeded;
+	});
+
+	Check(succeeded, "every chunk could be allocated");
+	return time;
+}
+
+template <typename Buffer>
+static bool CheckChunks(Buffer& buffer, const std::vector<uint32_t>& sizes, const std::vector<uint32_t>& keys, uint32_t numBytes)
+{
+	std::vector<Chunk> chunks;
+	for (uint32_t i = 0; i < keys.size(); i++)
+	{
+		chunks.push_back(buffer.GetChunk(keys[i]));
+		if (chunks.back().range != sizes[i] || (uint64_t)chunks.back().offset + chunks.back().range > numBytes)
+			return false;
+	}
+
+	std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.offset < b.offset; });
+	for (uint32_t i = 1; i < chunks.size(); i++)
+	{
+		if (chunks[i - 1].offset + chunks[i - 1].range > chunks[i].offset)
+			return false;
+	}
+	return true;
+}
+
+int main()
+{
+	// Vertex and index ranges of small to mid sized meshes
+	std::mt19937 random(1);
+	std::vector<uint32_t> sizes(GROWTH_CHUNK_COUNT);
+	for (auto& size : sizes)
+		size = 64 + random() % (16 * 1024);
+	std::vector<uint32_t> chunkSizes(sizes.begin(), sizes.begin() + CHUNK_COUNT);
+
+	std::vector<uint32_t> keys;
+
+	ChunkTableBuffer chunkTableBuffer(BUFFER_BYTES);
+	double chunkTableTime = TimeBuffer(chunkTableBuffer, chunkSizes, keys);
+	Check(CheckChunks(chunkTableBuffer, chunkSizes, keys, BUFFER_BYTES), "chunk table chunks don't overlap");
+
+	TLSFBuffer tlsfBuffer(BUFFER_BYTES, false);
+	double tlsfTime = TimeBuffer(tlsfBuffer, chunkSizes, keys);
+	Check(CheckChunks(tlsfBuffer, chunkSizes, keys, BUFFER_BYTES), "TLSF chunks don't overlap");
+
+	TLSFBuffer growingBuffer(GROWTH_INITIAL_BYTES, true);
+	double growingTime = TimeBuffer(growingBuffer, sizes, keys);
+	Check(CheckChunks(growingBuffer, sizes, keys, growingBuffer.GetSize()), "grown TLSF chunks don't overlap");
+
+	printf("%u chunks allocated, half freed and allocated again\n", CHUNK_COUNT);
+	printf("Chunk table: %.3f ms\n", chunkTableTime);
+	printf("TLSF: %.3f ms\n", tlsfTime);
+	printf("%u chunks with growth from %u bytes: %.3f ms, grown %u times to %u bytes\n",
+		GROWTH_CHUNK_COUNT, GROWTH_INITIAL_BYTES, growingTime, growingBuffer.GetGrowCount(), growingBuffer.GetSize());
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+// Runs random allocations and frees through TLSFAllocator, and checks every result against a plain map of live ranges
+// Also reports allocation and free throughput, the same figures DeviceMemoryManager accumulates in its statistics
+
+#include "Benchmark.h"
+#include "../vulkan/TLSFAllocator.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+static const uint32_t RANGE_BYTES = 64 * 1024 * 1024;
+static const uint32_t OPERATION_COUNT = 1000000;
+
+typedef struct _Allocation
+{
+	uint32_t	offset;
+	uint32_t	numBytes;
+	uint32_t	handle;
+}Allocation;
+
+// Live ranges keyed by offset, a new range mustn't overlap its neighbours
+static bool InsertRange(std::map<uint32_t, uint32_t>& ranges, uint32_t offset, uint32_t numBytes)
+{
+	auto next = ranges.lower_bound(offset);
+	if (next != ranges.end() && next->first < offset + numBytes)
+		return false;
+	if (next != ranges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second > offset)
+			return false;
+	}
+	ranges[offset] = numBytes;
+	return true;
+}
+
+// Mostly small buffers, some large ones, alignments of uniform buffers and images mixed in
+static void RandomRequest(std::mt19937& random, uint32_t& numBytes, uint32_t& alignment)
+{
+	static const uint32_t alignments[] = { 1, 4, 16, 64, 256, 4096, 65536 };
+	alignment = alignments[random() % (sizeof(alignments) / sizeof(uint32_t))];
+	numBytes = random() % 8 == 0 ? 1 + random() % (1024 * 1024) : 1 + random() % 4096;
+}
+
+static void CheckRandomOperations()
+{
+	TLSFAllocator allocator(RANGE_BYTES);
+	std::mt19937 random(1);
+
+	std::vector<Allocation> allocations;
+	std::map<uint32_t, uint32_t> ranges;
+	uint64_t usedBytes = 0;
+	uint32_t failedAllocations = 0;
+
+	for (uint32_t i = 0; i < OPERATION_COUNT; i++)
+	{
+		// Lean towards allocating until range is mostly used, then keep it around there
+		bool allocate = allocations.empty() || random() % 100 < (usedBytes < RANGE_BYTES * 3ull / 4 ? 60u : 40u);
+		if (allocate)
+		{
+			uint32_t numBytes, alignment;
+			RandomRequest(random, numBytes, alignment);
+
+			Allocation allocation = { 0, numBytes, 0 };
+			if (!allocator.Allocate(numBytes, alignment, allocation.offset, allocation.handle))
+			{
+				// Worst case padding is part of the search, so a failure needs at least that much missing
+				// Size classes round search size up by 1/32 at most
+				uint64_t searchBytes = (uint64_t)numBytes + alignment - 1;
+				Check(allocator.GetLargestFreeRange() < searchBytes + (searchBytes >> 4) + 32, "allocation only fails if no free range is close to large enough");
+				failedAllocations++;
+				continue;
+			}
+
+			Check(allocation.offset % alignment == 0, "offset is aligned");
+			Check((uint64_t)allocation.offset + numBytes <= RANGE_BYTES, "allocation is within range");
+			Check(InsertRange(ranges, allocation.offset, numBytes), "allocation doesn't overlap live ones");
+
+			allocations.push_back(allocation);
+			usedBytes += numBytes;
+		}
+		else
+		{
+			uint32_t index = random() % allocations.size();
+			allocator.Free(allocations[index].handle);
+			ranges.erase(allocations[index].offset);
+			usedBytes -= allocations[index].numBytes;
+
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+
+		Check(allocator.GetUsedBytes() == usedBytes, "used bytes match live allocations");
+		Check(allocator.GetAllocationCount() == allocations.size(), "allocation count matches live allocations");
+	}
+
+	printf("%u operations, %u failed allocations, %u live, %u free ranges, fragmentation %.3f\n",
+		OPERATION_COUNT, failedAllocations, allocator.GetAllocationCount(), allocator.GetFreeRangeCount(), allocator.GetFragmentation());
+
+	// All free ranges merge back into one
+	for (auto& allocation : allocations)
+		allocator.Free(allocation.handle);
+	Check(allocator.IsEmpty() && allocator.GetUsedBytes() == 0, "allocator is empty after freeing everything");
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == RANGE_BYTES, "free ranges merge back into one");
+}
+
+static void CheckGrow()
+{
+	uint32_t offset, handle, handle0;
+	TLSFAllocator allocator(1024);
+
+	// Last block in use, extra bytes become a new free block
+	Check(allocator.Allocate(1024, 1, offset, handle0), "whole range could be allocated");
+	Check(!allocator.Allocate(1, 1, offset, handle), "full range can't allocate more");
+	allocator.Grow(2048);
+	Check(allocator.GetSize() == 2048 && allocator.GetFreeRangeCount() == 1, "grown bytes are one free range");
+	Check(allocator.Allocate(1024, 1, offset, handle) && offset == 1024, "grown bytes are right after old range");
+
+	// Last block free, extra bytes join it
+	allocator.Free(handle);
+	allocator.Grow(4096);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == 3072, "grown bytes join free last block");
+	Check(allocator.Allocate(3072, 1, offset, handle) && offset == 1024, "joined range could be allocated in one piece");
+
+	// Allocations made before growing stay where they are, and merge with grown bytes once freed
+	allocator.Free(handle0);
+	allocator.Free(handle);
+	Check(allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == 4096, "old and grown bytes merge once freed");
+}
+
+static void ReportThroughput()
+{
+	TLSFAllocator allocator(RANGE_BYTES);
+	std::mt19937 random(2);
+
+	std::vector<uint32_t> handles;
+	std::vector<uint32_t> sizes(OPERATION_COUNT), alignments(OPERATION_COUNT);
+	for (uint32_t i = 0; i < OPERATION_COUNT; i++)
+		RandomRequest(random, sizes[i], alignments[i]);
+
+	double allocateTime = 0, freeTime = 0;
+	uint32_t allocateCount = 0, freeCount = 0;
+
+	// Fill until it's full, then free a random half, and again
+	uint32_t request = 0;
+	while (request < OPERATION_COUNT)
+	{
+		allocateTime += TimeMilliseconds([&]()
+		{
+			uint32_t offset, handle;
+			for (; request < OPERATION_COUNT && allocator.Allocate(sizes[request], alignments[request], offset, handle); request++)
+			{
+				handles.push_back(handle);
+				allocateCount++;
+			}
+		});
+
+		// Request that didn't fit is skipped
+		request++;
+
+		std::shuffle(handles.begin(), handles.end(), random);
+		uint32_t freeEnd = (uint32_t)handles.size() / 2;
+
+		freeTime += TimeMilliseconds([&]()
+		{
+			for (uint32_t i = 0; i < freeEnd; i++)
+				allocator.Free(handles[i]);
+		});
+
+		freeCount += freeEnd;
+		handles.erase(handles.begin(), handles.begin() + freeEnd);
+	}
+
+	printf("%u allocations: %.1f ns each, %u frees: %.1f ns each\n", allocateCount, allocateTime * 1e6 / allocateCount, freeCount, freeTime * 1e6 / freeCount);
+}
+
+int main()
+{
+	CheckRandomOperations();
+	CheckGrow();
+	ReportThroughput();
+
+	return Report();
+}
\ No newline at end of file
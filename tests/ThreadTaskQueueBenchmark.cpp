@@ -0,0 +1,206 @@
+// Jobs per second and submit to start latency of ThreadTaskQueue, against the dispatcher based mutex queue it replaced
+// Throughput submits lots of small jobs from main thread at once, latency submits one job at a time to idle workers
+
+#include "Benchmark.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <atomic>
+#include <deque>
+#include <queue>
+#include <thread>
+#include <vector>
+
+static const uint32_t WORKER_COUNT = 4;
+static const uint32_t THROUGHPUT_JOB_COUNT = 50000;
+static const uint32_t LATENCY_JOB_COUNT = 500;
+
+typedef std::chrono::steady_clock Clock;
+
+// Same scheme as the old ThreadTaskQueue: one locked queue, a dispatcher thread polling workers round robin,
+// and each worker taking at most 2 jobs into its own locked queue. Pending count is added so that waiting is exact
+class MutexTaskQueue
+{
+	class Worker
+	{
+	public:
+		Worker(MutexTaskQueue* pTaskQueue) : m_pTaskQueue(pTaskQueue) { m_worker = std::thread(&Worker::Loop, this); }
+
+		~Worker()
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_queueMutex);
+				m_isDestroying = true;
+			}
+			m_condition.notify_one();
+			m_worker.join();
+		}
+
+		void AppendJob(const std::function<void()>& job)
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_jobQueue.push(job);
+			m_condition.notify_one();
+		}
+
+		bool IsTaskQueueFree()
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			return m_jobQueue.size() < 2;
+		}
+
+	private:
+		void Loop()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(m_queueMutex);
+					m_condition.wait(lock, [this]() { return !m_jobQueue.empty() || m_isDestroying; });
+					if (m_isDestroying)
+						break;
+
+					job = m_jobQueue.front();
+					m_jobQueue.pop();
+				}
+				job();
+				m_pTaskQueue->m_pendingJobCount--;
+			}
+		}
+
+	private:
+		MutexTaskQueue*						m_pTaskQueue;
+		std::thread							m_worker;
+		std::mutex							m_queueMutex;
+		std::condition_variable				m_condition;
+		std::queue<std::function<void()>>	m_jobQueue;
+		bool								m_isDestroying = false;
+	};
+
+public:
+	MutexTaskQueue(uint32_t workerCount)
+	{
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_workers.push_back(std::make_shared<Worker>(this));
+		m_dispatcher = std::thread(&MutexTaskQueue::Loop, this);
+	}
+
+	~MutexTaskQueue()
+	{
+		WaitForFree();
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_isDestroying = true;
+		}
+		m_condition.notify_one();
+		m_dispatcher.join();
+	}
+
+	void AddJob(const std::function<void()>& job)
+	{
+		m_pendingJobCount++;
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		m_taskQueue.push(job);
+		m_condition.notify_all();
+	}
+
+	void WaitForFree()
+	{
+		while (m_pendingJobCount != 0)
+			std::this_thread::yield();
+	}
+
+private:
+	void Loop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_queueMutex);
+				m_condition.wait(lock, [this]() { return !m_taskQueue.empty() || m_isDestroying; });
+				if (m_isDestroying)
+					break;
+
+				job = m_taskQueue.front();
+				m_taskQueue.pop();
+			}
+
+			// Busy polling until some worker has room
+			while (true)
+			{
+				std::shared_ptr<Worker> pWorker = m_workers[m_currentWorker];
+				m_currentWorker = (m_currentWorker + 1) % m_workers.size();
+				if (pWorker->IsTaskQueueFree())
+				{
+					pWorker->AppendJob(job);
+					break;
+				}
+			}
+		}
+	}
+
+private:
+	std::vector<std::shared_ptr<Worker>>	m_workers;
+	std::thread								m_dispatcher;
+	std::mutex								m_queueMutex;
+	std::condition_variable					m_condition;
+	std::queue<std::function<void()>>		m_taskQueue;
+	uint32_t								m_currentWorker = 0;
+	std::atomic<uint32_t>					m_pendingJobCount = { 0 };
+	bool									m_isDestroying = false;
+};
+
+// A little work per job, so that it isn't all queue overhead
+static uint32_t SmallWork(uint32_t seed)
+{
+	uint32_t value = seed;
+	for (uint32_t i = 0; i < 64; i++)
+		value = value * 1664525 + 1013904223;
+	return value;
+}
+
+// "submit" takes a job and queues it, "wait" blocks until all are done
+template <typename Submit, typename Wait>
+static void Measure(const char* name, Submit submit, Wait wait)
+{
+	std::atomic<uint32_t> doneCount = { 0 };
+	std::atomic<uint32_t> checksum = { 0 };
+
+	double throughputTime = TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < THROUGHPUT_JOB_COUNT; i++)
+			submit([&doneCount, &checksum, i]() { checksum += SmallWork(i); doneCount++; });
+		wait();
+	});
+	Check(doneCount == THROUGHPUT_JOB_COUNT, "every job runs");
+
+	// Workers have gone idle between jobs, this is the delay until one of them starts
+	double totalLatency = 0;
+	for (uint32_t i = 0; i < LATENCY_JOB_COUNT; i++)
+	{
+		std::atomic<int64_t> startTime = { 0 };
+		auto submitTime = Clock::now();
+		submit([&startTime]() { startTime = Clock::now().time_since_epoch().count(); });
+		wait();
+		totalLatency += std::chrono::duration<double, std::micro>(Clock::time_point(Clock::duration(startTime.load())) - submitTime).count();
+	}
+
+	printf("%-16s %10.0f jobs/s, %8.2f us latency\n", name, THROUGHPUT_JOB_COUNT / throughputTime * 1000.0, totalLatency / LATENCY_JOB_COUNT);
+}
+
+int main()
+{
+	printf("%u workers, %u jobs for throughput, %u jobs for latency\n", WORKER_COUNT, THROUGHPUT_JOB_COUNT, LATENCY_JOB_COUNT);
+
+	{
+		MutexTaskQueue taskQueue(WORKER_COUNT);
+		Measure("Mutex queue", [&](const std::function<void()>& job) { taskQueue.AddJob(job); }, [&]() { taskQueue.WaitForFree(); });
+	}
+
+	{
+		ThreadTaskQueue taskQueue(0, nullptr, WORKER_COUNT);
+		Measure("Work stealing", [&](const std::function<void()>& job) { taskQueue.AddJob([job](const std::shared_ptr<PerFrameResource>&) { job(); }, 0); }, [&]() { taskQueue.WaitForFree(); });
+	}
+
+	return Report();
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+// Hammers the Chase-Lev deque with one owner pushing and popping while several thieves steal, every item has to come out exactly once
+// Then runs jobs through ThreadTaskQueue, both from main thread and spawned by jobs themselves, and wakes sleeping workers up again and again
+
+#include "Benchmark.h"
+#include "../thread/WorkStealingDeque.hpp"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const uint32_t DEQUE_ITEM_COUNT = 200000;
+static const uint32_t THIEF_COUNT = 3;
+static const uint32_t WORKER_COUNT = 4;
+static const uint32_t ROOT_JOB_COUNT = 2000;
+static const uint32_t CHILD_JOB_COUNT = 8;
+static const uint32_t WAKEUP_ROUND_COUNT = 20;
+
+static bool AllOnce(const std::vector<std::atomic<uint32_t>>& runCounts)
+{
+	for (auto& runCount : runCounts)
+	{
+		if (runCount != 1)
+			return false;
+	}
+	return true;
+}
+
+static void TestDeque()
+{
+	// Small capacity so that it grows while thieves are reading
+	WorkStealingDeque<uint32_t> deque(16);
+	std::vector<std::atomic<uint32_t>> runCounts(DEQUE_ITEM_COUNT);
+	std::atomic<bool> ownerDone = { false };
+	std::atomic<uint32_t> stolenCount = { 0 };
+
+	std::vector<std::thread> thieves;
+	for (uint32_t i = 0; i < THIEF_COUNT; i++)
+	{
+		thieves.push_back(std::thread([&]()
+		{
+			uint32_t item;
+			while (!ownerDone || !deque.Empty())
+			{
+				if (deque.Steal(item))
+				{
+					runCounts[item]++;
+					stolenCount++;
+				}
+				else
+					std::this_thread::yield();
+			}
+		}));
+	}
+
+	// Owner pops one of every three it pushes, so that pops keep racing thieves for the last item
+	uint32_t item;
+	for (uint32_t i = 0; i < DEQUE_ITEM_COUNT; i++)
+	{
+		deque.Push(i);
+		if (i % 3 == 2 && deque.Pop(item))
+			runCounts[item]++;
+	}
+	while (deque.Pop(item))
+		runCounts[item]++;
+
+	ownerDone = true;
+	for (auto& thief : thieves)
+		thief.join();
+
+	printf("Deque: %u items, %u stolen\n", DEQUE_ITEM_COUNT, (uint32_t)stolenCount);
+	Check(AllOnce(runCounts), "every deque item is taken exactly once");
+	Check(deque.Empty(), "deque is empty");
+}
+
+static void TestTaskQueue()
+{
+	ThreadTaskQueue taskQueue(0, nullptr, WORKER_COUNT);
+	Check(taskQueue.GetWorkerCount() == WORKER_COUNT, "worker count");
+
+	// Root jobs from main thread go to external queues, children spawned on workers go to their deques and get stolen
+	std::vector<std::atomic<uint32_t>> runCounts(ROOT_JOB_COUNT * (CHILD_JOB_COUNT + 1));
+	std::atomic<uint32_t> resourceCount = { 0 };
+	for (uint32_t i = 0; i < ROOT_JOB_COUNT; i++)
+	{
+		taskQueue.AddJob([&, i](const std::shared_ptr<PerFrameResource>& pFrameRes)
+		{
+			runCounts[i]++;
+			if (pFrameRes != nullptr)
+				resourceCount++;
+
+			for (uint32_t j = 0; j < CHILD_JOB_COUNT; j++)
+			{
+				uint32_t childIndex = ROOT_JOB_COUNT + i * CHILD_JOB_COUNT + j;
+				taskQueue.AddJob([&, childIndex](const std::shared_ptr<PerFrameResource>&) { runCounts[childIndex]++; }, 0);
+			}
+		}, 0);
+	}
+
+	taskQueue.WaitForFree();
+
+	printf("Task queue: %llu jobs executed, %llu stolen\n", (unsigned long long)taskQueue.GetExecutedJobCount(), (unsigned long long)taskQueue.GetStolenJobCount());
+	Check(AllOnce(runCounts), "every job runs exactly once");
+	Check(taskQueue.GetExecutedJobCount() == runCounts.size(), "executed job count");
+	Check(taskQueue.GetTaskQueueSize() == 0, "nothing left queued");
+	Check(resourceCount == 0, "jobs get no frame resource without an allocator");
+
+	// Workers spin a little then sleep after running dry, each new job has to wake one of them up
+	for (uint32_t round = 0; round < WAKEUP_ROUND_COUNT; round++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		std::atomic<bool> ran = { false };
+		JobCounter counter;
+		taskQueue.AddJob([&ran](const std::shared_ptr<PerFrameResource>&) { ran = true; }, 0, &counter);
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!counter.IsDone() && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::yield();
+
+		if (!counter.IsDone())
+		{
+			// A worker that never wakes up would hang the task queue's destructor too
+			Check(false, "sleeping worker wakes up for a new job");
+			std::exit(Report());
+		}
+		Check(ran, "woken job runs");
+	}
+}
+
+int main()
+{
+	TestDeque();
+	TestTaskQueue();
+	return Report();
+}
\ No newline at end of file
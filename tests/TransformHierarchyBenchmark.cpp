@@ -0,0 +1,135 @@
+// Times world transform updates of 100k nodes in TransformHierarchy, against recursing a node tree the way BaseObject used to
+// Recursion recomputes every node each frame, the hierarchy only walks dirty slices of each level and subtrees below them
+// World transforms of both are compared after each case
+
+#include "Benchmark.h"
+#include "../Base/TransformHierarchy.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint32_t NODE_COUNT = 100000;
+static const uint32_t BRANCH_COUNT = 4;
+static const uint32_t WORKER_COUNT = 3;
+static const uint32_t ROUND_COUNT = 20;
+
+typedef struct _TreeNode
+{
+	Matrix4d				localTransform;
+	Matrix4d				worldTransform;
+	std::vector<uint32_t>	children;
+}TreeNode;
+
+static void RecursiveUpdate(std::vector<TreeNode>& nodes, uint32_t node, const Matrix4d& parentWorldTransform)
+{
+	nodes[node].worldTransform = parentWorldTransform * nodes[node].localTransform;
+	for (uint32_t child : nodes[node].children)
+		RecursiveUpdate(nodes, child, nodes[node].worldTransform);
+}
+
+static bool MatchesReference(const std::vector<TreeNode>& nodes, const std::vector<uint32_t>& handles)
+{
+	TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+	for (uint32_t i = 0; i < NODE_COUNT; i++)
+	{
+		const Matrix4d& worldTransform = pHierarchy->GetWorldTransform(handles[i]);
+		for (uint32_t j = 0; j < 16; j++)
+		{
+			if (worldTransform[j / 4][j % 4] != nodes[i].worldTransform[j / 4][j % 4])
+				return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+	auto randomTransform = [&]()
+	{
+		return Matrix4d(Matrix3d::EulerAngle(distribution(random), distribution(random), distribution(random)), Vector3d(distribution(random), distribution(random), distribution(random)));
+	};
+
+	// Parents are linked in shuffled order, so that the hierarchy's own order comes from its rebuild rather than creation
+	TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+	std::vector<TreeNode> nodes(NODE_COUNT);
+	std::vector<uint32_t> handles(NODE_COUNT);
+	for (uint32_t i = 0; i < NODE_COUNT; i++)
+	{
+		handles[i] = pHierarchy->AllocateNode();
+		nodes[i].localTransform = randomTransform();
+		pHierarchy->SetLocalTransform(handles[i], nodes[i].localTransform);
+	}
+
+	std::vector<uint32_t> linkOrder(NODE_COUNT - 1);
+	for (uint32_t i = 0; i < NODE_COUNT - 1; i++)
+		linkOrder[i] = i + 1;
+	std::shuffle(linkOrder.begin(), linkOrder.end(), random);
+	for (uint32_t i : linkOrder)
+	{
+		uint32_t parent = (i - 1) / BRANCH_COUNT;
+		nodes[parent].children.push_back(i);
+		pHierarchy->SetParent(handles[i], handles[parent]);
+	}
+
+	// Tree children are in link order, which isn't the hierarchy's sibling order, results don't depend on it
+	pHierarchy->Update();
+	RecursiveUpdate(nodes, 0, Matrix4d());
+	Check(MatchesReference(nodes, handles), "first update matches recursion");
+	printf("%u nodes in %u levels, %u children each, average of %u rounds\n", pHierarchy->GetNodeCount(), pHierarchy->GetLevelCount(), BRANCH_COUNT, ROUND_COUNT);
+
+	double recursiveTime = TimeMilliseconds([&]() { RecursiveUpdate(nodes, 0, Matrix4d()); }, ROUND_COUNT);
+	printf("Recursion over all nodes: %.3f ms\n", recursiveTime);
+
+	std::shared_ptr<ThreadTaskQueue> pTaskQueue = std::make_shared<ThreadTaskQueue>(0, nullptr, WORKER_COUNT);
+
+	// Changes "count" random nodes each round, root is changed too when "moveRoot" so that every node has to be recomputed
+	auto runCase = [&](const char* name, uint32_t count, bool moveRoot)
+	{
+		std::uniform_int_distribution<uint32_t> nodeDistribution(0, NODE_COUNT - 1);
+		uint32_t recomputedCount = 0;
+
+		for (uint32_t useQueue = 0; useQueue < 2; useQueue++)
+		{
+			pHierarchy->SetTaskQueue(useQueue ? pTaskQueue : nullptr);
+
+			double totalTime = 0;
+			for (uint32_t round = 0; round < ROUND_COUNT; round++)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					uint32_t node = moveRoot && i == 0 ? 0 : nodeDistribution(random);
+					nodes[node].localTransform = randomTransform();
+					pHierarchy->SetLocalTransform(handles[node], nodes[node].localTransform);
+				}
+
+				totalTime += TimeMilliseconds([&]() { pHierarchy->Update(); });
+				recomputedCount = pHierarchy->GetRecomputedCount();
+			}
+
+			RecursiveUpdate(nodes, 0, Matrix4d());
+			Check(MatchesReference(nodes, handles), name);
+
+			printf("%-22s %s: %.3f ms, %u nodes recomputed in last round\n", name, useQueue ? "with 3 workers" : "serial        ", totalTime / ROUND_COUNT, recomputedCount);
+		}
+	};
+
+	runCase("Root moved", 1, true);
+	runCase("1% of nodes changed", NODE_COUNT / 100, false);
+	runCase("16 nodes changed", 16, false);
+	runCase("1 node changed", 1, false);
+
+	// Reparenting rebuilds the order, results still have to match, new parent is a grandchild of root outside of node 1's subtree
+	uint32_t newParent = 4 * BRANCH_COUNT + 1;
+	nodes[0].children.erase(std::find(nodes[0].children.begin(), nodes[0].children.end(), 1));
+	nodes[newParent].children.push_back(1);
+	pHierarchy->SetParent(handles[1], handles[newParent]);
+	pHierarchy->Update();
+	RecursiveUpdate(nodes, 0, Matrix4d());
+	Check(MatchesReference(nodes, handles), "update after reparenting matches recursion");
+
+	pHierarchy->SetTaskQueue(nullptr);
+	return Report();
+}
\ No newline at end of file
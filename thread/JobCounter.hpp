@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// Counts jobs in flight, anyone could wait until all of them are done
+// Works as a fence between a group of jobs and the code depending on them
+class JobCounter
+{
+public:
+	JobCounter() : m_count(0) {}
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator = (const JobCounter&) = delete;
+
+public:
+	void Add(uint32_t count = 1) { m_count += count; }
+
+	// Decrease under lock, since waiter is free to destroy this counter as soon as it sees zero
+	void Decrement()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (--m_count == 0)
+			m_condition.notify_all();
+	}
+
+	bool IsDone()
+	{
+		if (m_count != 0)
+			return false;
+
+		// Make sure the last decrement has released the lock
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return true;
+	}
+
+	uint32_t GetCount() const { return m_count; }
+
+	// Blocking wait, don't call this from a worker thread, use ThreadTaskQueue::WaitForCounter instead
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this]() { return m_count == 0; });
+	}
+
+private:
+	std::atomic<uint32_t>		m_count;
+	std::mutex					m_mutex;
+	std::condition_variable		m_condition;
+};
@@ -1,149 +1,278 @@
 #pragma once
 #include <thread>
 #include <functional>
-#include <queue>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
-#include "../vulkan/FrameManager.h"
+#include <memory>
 #include "ThreadWorker.hpp"
 
-class Device;
 class CommandBuffer;
 
+// Work stealing task queue
+// There's no dispatcher thread anymore, jobs go directly into workers' queues from whichever thread submits them:
+// 1. Jobs spawned from a worker thread go to the bottom of its own lock free deque
+// 2. Jobs from other threads(main thread mostly) are distributed round robin into workers' external queues
+// Idle workers steal from their siblings before going to sleep
 class ThreadTaskQueue
 {
+	static const uint32_t SPIN_COUNT_BEFORE_SLEEP = 64;
+
 public:
-	ThreadTaskQueue(const std::shared_ptr<Device>& pDevice, uint32_t frameRoundBinCount, const std::shared_ptr<FrameManager>& pFrameMgr)
+	typedef std::function<std::shared_ptr<PerFrameResource>(uint32_t frameIndex)> FrameResourceAllocator;
+
+	// Each worker gets "frameRoundBinCount" per frame resources from "allocateFrameRes", jobs receive null resource without them
+	// Worker count defaults to one less than cores, since main thread takes one
+	ThreadTaskQueue(uint32_t frameRoundBinCount, const FrameResourceAllocator& allocateFrameRes, uint32_t workerCount = 0)
 	{
-		m_worker = std::thread(&ThreadTaskQueue::Loop, this);
+		if (workerCount == 0)
+		{
+			int numThreads = std::thread::hardware_concurrency();
+			workerCount = numThreads > 1 ? numThreads - 1 : 1;
+		}
 
-		int numThreads = std::thread::hardware_concurrency();
-		for (int i = 0; i < numThreads - 1; i++)
+		for (uint32_t i = 0; i < workerCount; i++)
 		{
-			m_threadWorkers.push_back(std::make_shared<ThreadWorker>(pDevice, frameRoundBinCount, pFrameMgr));
+			std::vector<std::shared_ptr<PerFrameResource>> frameRes;
+			for (uint32_t j = 0; allocateFrameRes != nullptr && j < frameRoundBinCount; j++)
+				frameRes.push_back(allocateFrameRes(j));
+
+			m_threadWorkers.push_back(std::make_shared<ThreadWorker>(frameRes, this, i));
 		}
 
-		m_currentWorker = 0;
+		for (auto & pWorker : m_threadWorkers)
+			pWorker->Start();
 	}
 
 	~ThreadTaskQueue()
 	{
-		if (m_worker.joinable())
+		WaitForFree();
+
 		{
-			WaitForEmptyQueue();
-			std::unique_lock<std::mutex> lock(m_queueMutex);
+			std::unique_lock<std::mutex> lock(m_idleMutex);
 			m_isDestroying = true;
-			lock.unlock();
-			m_condition.notify_one();
-			m_worker.join();
 		}
+		m_idleCondition.notify_all();
+
+		// All threads have to be joined before any worker is released, since they might be stealing from each other
+		for (auto & pWorker : m_threadWorkers)
+			pWorker->Join();
+
+		m_threadWorkers.clear();
 	}
 
 public:
-	void AddJob(ThreadJobFunc jobFunc, uint32_t frameIndex)
+	// Counter is optional, it's increased here and decreased after job is done
+	void AddJob(ThreadJobFunc jobFunc, uint32_t frameIndex, JobCounter* pCounter = nullptr)
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		ThreadWorker::ThreadJob job;
-		job.job = jobFunc;
-		job.frameIndex = frameIndex;
-		job.pThreadTaskQueue = this;
-		m_taskQueue.push(job);
-		m_condition.notify_all();
+		ThreadWorker::ThreadJob* pJob = new ThreadWorker::ThreadJob();
+		pJob->job = jobFunc;
+		pJob->frameIndex = frameIndex;
+		pJob->pThreadTaskQueue = this;
+		pJob->pCounter = pCounter;
+
+		if (pCounter != nullptr)
+			pCounter->Add();
+
+		// Count it before anyone could possibly pick it up or finish it
+		m_pendingJobCount++;
+		m_queuedJobCount++;
+		m_submittedJobCount++;
+
+		ThreadWorker* pCurrentWorker = ThreadWorker::GetCurrentWorker();
+		if (pCurrentWorker != nullptr && pCurrentWorker->GetTaskQueue() == this)
+			pCurrentWorker->PushLocalJob(pJob);
+		else
+			m_threadWorkers[m_nextExternalWorker++ % m_threadWorkers.size()]->PushExternalJob(pJob);
+
+		// Only bother the lock when someone is actually sleeping
+		if (m_sleepingWorkerCount > 0)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_idleMutex);
+			}
+			m_idleCondition.notify_one();
+		}
 	}
 
 	void WaitForFree()
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		m_condition.wait(lock, [this]() { return m_taskQueue.empty() && !m_isSearchingThread; });
-		for (uint32_t i = 0; i < m_threadWorkers.size(); i++)
-		{
-			m_threadWorkers[i]->WaitForFree();
-		}
+		std::unique_lock<std::mutex> lock(m_doneMutex);
+		m_doneCondition.wait(lock, [this]() { return m_pendingJobCount == 0; });
 	}
 
 	void WaitForEmptyQueue()
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		m_condition.wait(lock, [this]() { return m_taskQueue.empty() && !m_isSearchingThread; });
+		std::unique_lock<std::mutex> lock(m_doneMutex);
+		m_doneCondition.wait(lock, [this]() { return m_queuedJobCount == 0; });
 	}
 
 	void WaitForWorkersAllFree()
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		for (uint32_t i = 0; i < m_threadWorkers.size(); i++)
+		WaitForFree();
+	}
+
+	// Wait until all jobs attached to this counter are done
+	// Worker threads keep executing other jobs while waiting, so that jobs are free to wait for their child jobs
+	void WaitForCounter(JobCounter& counter)
+	{
+		ThreadWorker* pCurrentWorker = ThreadWorker::GetCurrentWorker();
+		if (pCurrentWorker == nullptr || pCurrentWorker->GetTaskQueue() != this)
 		{
-			m_threadWorkers[i]->WaitForFree();
+			counter.Wait();
+			return;
+		}
+
+		ThreadWorker::ThreadJob* pJob = nullptr;
+		while (!counter.IsDone())
+		{
+			if (TryAcquireJob(pCurrentWorker, pJob))
+				pCurrentWorker->ExecuteJob(pJob);
+			else
+				std::this_thread::yield();
 		}
 	}
 
+	// Split [begin, end) into chunks of "grain" size, and execute them across workers and the calling thread
+	// Chunks are grabbed dynamically, so uneven chunks get balanced automatically. This function returns after all chunks are done
+	void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& func, uint32_t frameIndex = 0)
+	{
+		if (begin >= end)
+			return;
+
+		grain = grain == 0 ? 1 : grain;
+		uint32_t chunkCount = (end - begin + grain - 1) / grain;
+
+		// Not worth it
+		if (chunkCount == 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		std::atomic<uint32_t> nextChunk = { 0 };
+		auto processChunks = [&nextChunk, chunkCount, begin, end, grain, &func]()
+		{
+			uint32_t chunk;
+			while ((chunk = nextChunk++) < chunkCount)
+			{
+				uint32_t chunkBegin = begin + chunk * grain;
+				uint32_t chunkEnd = chunkBegin + grain < end ? chunkBegin + grain : end;
+				func(chunkBegin, chunkEnd);
+			}
+		};
+
+		JobCounter counter;
+		uint32_t jobCount = chunkCount - 1 < GetWorkerCount() ? chunkCount - 1 : GetWorkerCount();
+		for (uint32_t i = 0; i < jobCount; i++)
+			AddJob([&processChunks](const std::shared_ptr<PerFrameResource>&) { processChunks(); }, frameIndex, &counter);
+
+		// Calling thread takes its share too
+		processChunks();
+
+		WaitForCounter(counter);
+	}
+
 	uint32_t GetTaskQueueSize()
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		return (uint32_t)m_taskQueue.size();
+		return m_queuedJobCount;
 	}
 
-private:
-	void Loop()
+	uint32_t GetWorkerCount() const { return (uint32_t)m_threadWorkers.size(); }
+
+	// Statistics
+	uint64_t GetSubmittedJobCount() const { return m_submittedJobCount; }
+	uint64_t GetExecutedJobCount() const { return m_executedJobCount; }
+	uint64_t GetStolenJobCount() const { return m_stolenJobCount; }
+
+protected:
+	bool TryAcquireJob(ThreadWorker* pWorker, ThreadWorker::ThreadJob*& pJob)
 	{
-		while (true)
+		bool acquired = pWorker->PopLocalJob(pJob) || pWorker->PopExternalJob(pJob);
+
+		// Nothing for myself, try to steal from siblings, starting from the next one to spread the contention
+		for (uint32_t i = 1; !acquired && i < m_threadWorkers.size(); i++)
 		{
-			ThreadWorker::ThreadJob job;
-			job.pThreadTaskQueue = this;
+			uint32_t victimIndex = (pWorker->GetWorkerIndex() + i) % (uint32_t)m_threadWorkers.size();
+			if (m_threadWorkers[victimIndex]->StealJob(pJob))
 			{
-				std::unique_lock<std::mutex> lock(m_queueMutex);
-				m_condition.wait(lock, [this]() { return !m_taskQueue.empty() || m_isDestroying; });
+				acquired = true;
+				m_stolenJobCount++;
+			}
+		}
 
-				if (m_isDestroying)
-				{
-					break;
-				}
+		if (acquired && --m_queuedJobCount == 0)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_doneMutex);
+			}
+			m_doneCondition.notify_all();
+		}
 
-				job = m_taskQueue.front();
-				m_taskQueue.pop();
+		return acquired;
+	}
 
-				m_isSearchingThread = true;
+	// Block until a job is acquired, return false if task queue is destroying
+	bool AcquireJob(ThreadWorker* pWorker, ThreadWorker::ThreadJob*& pJob)
+	{
+		uint32_t spinCount = 0;
+		while (true)
+		{
+			if (TryAcquireJob(pWorker, pJob))
+				return true;
 
-				m_condition.notify_all();
+			if (spinCount++ < SPIN_COUNT_BEFORE_SLEEP)
+			{
+				std::this_thread::yield();
+				continue;
 			}
 
-			bool shouldExit = false;
-			while (!shouldExit)
+			std::unique_lock<std::mutex> lock(m_idleMutex);
+			m_sleepingWorkerCount++;
+			m_idleCondition.wait(lock, [this]() { return m_queuedJobCount > 0 || m_isDestroying; });
+			m_sleepingWorkerCount--;
+
+			if (m_isDestroying)
+				return false;
+
+			spinCount = 0;
+		}
+	}
+
+	void OnJobDone()
+	{
+		m_executedJobCount++;
+
+		if (--m_pendingJobCount == 0)
+		{
 			{
-				std::shared_ptr<ThreadWorker> pTWroker = m_threadWorkers[m_currentWorker];
-				m_currentWorker = (m_currentWorker + 1) % m_threadWorkers.size();
-
-				bool isFree = pTWroker->IsTaskQueueFree();
-				if (isFree)
-				{
-					std::unique_lock<std::mutex> lock(m_queueMutex);
-
-					//********************************************************************************************
-					//** Important: I have to set states here before sending job to thread worker
-					//** Or else, thread worker is busy, while states are still indicating current queue is free
-					//** Then thread which is waiting for queue free will be fired, which is very very very wrong
-					//** Damn this introduced a crash when frame rate is high, and this is really difficult to find
-					//********************************************************************************************
-					m_isSearchingThread = false;
-
-					pTWroker->AppendJob(job);
-					m_condition.notify_all();
-
-					shouldExit = true;
-				}
+				std::unique_lock<std::mutex> lock(m_doneMutex);
 			}
+			m_doneCondition.notify_all();
 		}
 	}
 
 private:
-	std::mutex									m_queueMutex;
-	std::thread									m_worker;
-	std::condition_variable						m_condition;
-	std::queue<ThreadWorker::ThreadJob>			m_taskQueue;
 	std::vector<std::shared_ptr<ThreadWorker>>	m_threadWorkers;
-	uint32_t									m_currentWorker;
 
-	bool m_isSearchingThread =		false;
+	// Jobs submitted but not finished yet
+	std::atomic<uint32_t>						m_pendingJobCount = { 0 };
+	// Jobs submitted but not picked up by any worker yet
+	std::atomic<uint32_t>						m_queuedJobCount = { 0 };
+	std::atomic<uint32_t>						m_nextExternalWorker = { 0 };
+
+	std::mutex									m_idleMutex;
+	std::condition_variable						m_idleCondition;
+	std::atomic<uint32_t>						m_sleepingWorkerCount = { 0 };
+
+	std::mutex									m_doneMutex;
+	std::condition_variable						m_doneCondition;
+
+	std::atomic<uint64_t>						m_submittedJobCount = { 0 };
+	std::atomic<uint64_t>						m_executedJobCount = { 0 };
+	std::atomic<uint64_t>						m_stolenJobCount = { 0 };
+
 	bool m_isDestroying =			false;
-	static bool m_isWorkerReady;
-	uint32_t m_currentWorkerIndex = 0;
-};
\ No newline at end of file
+
+	friend class ThreadWorker;
+};
@@ -1,86 +1,87 @@
-#pragma once
 #include "ThreadWorker.hpp"
 #include "ThreadTaskQueue.hpp"
-#include "../vulkan/GlobalDeviceObjects.h"
-#include "../vulkan/SwapChain.h"
-#include "../vulkan/FrameManager.h"
 
-ThreadWorker::ThreadWorker(const std::shared_ptr<Device>& pDevice, uint32_t frameRoundBinCount, const std::shared_ptr<FrameManager>& pFrameMgr) : m_isWorking(false)
+thread_local ThreadWorker* ThreadWorker::m_pCurrentWorker = nullptr;
+
+ThreadWorker::ThreadWorker(const std::vector<std::shared_ptr<PerFrameResource>>& frameRes, ThreadTaskQueue* pTaskQueue, uint32_t workerIndex)
+	: m_frameRes(frameRes), m_externalJobCount(0), m_pTaskQueue(pTaskQueue), m_workerIndex(workerIndex), m_isWorking(false)
 {
-	for (uint32_t i = 0; i < frameRoundBinCount; i++)
-		m_frameRes.push_back(pFrameMgr->AllocatePerFrameResource(i));
-	m_worker = std::thread(&ThreadWorker::Loop, this);
 }
 
 ThreadWorker::~ThreadWorker()
+{
+	Join();
+}
+
+// Thread can only be started after all workers of a task queue are created, since it steals from its siblings
+void ThreadWorker::Start()
+{
+	m_worker = std::thread(&ThreadWorker::Loop, this);
+}
+
+// Task queue is responsible for waking up its workers with destroying flag set before joining
+void ThreadWorker::Join()
 {
 	if (m_worker.joinable())
-	{
-		WaitForFree();
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		m_isDestroying = true;
-		lock.unlock();
-		m_condition.notify_one();
 		m_worker.join();
-	}
 }
 
 void ThreadWorker::Loop()
 {
-	while (true)
+	m_pCurrentWorker = this;
+
+	ThreadJob* pJob = nullptr;
+	while (m_pTaskQueue->AcquireJob(this, pJob))
 	{
-		ThreadJob job;
-		{
-			std::unique_lock<std::mutex> lock(m_queueMutex);
-			m_condition.wait(lock, [this] { return !m_jobQueue.empty() || m_isDestroying; });
-
-			if (m_isDestroying)
-			{
-				break;
-			}
-
-			job = m_jobQueue.front();
-			m_jobQueue.pop();
-			m_isWorking = true;
-		}
-		job.job(m_frameRes[job.frameIndex]);
-		{
-			std::unique_lock<std::mutex> lock(m_queueMutex);
-			m_isWorking = false;
-			m_condition.notify_one();
-		}
+		m_isWorking = true;
+		ExecuteJob(pJob);
+		m_isWorking = false;
 	}
+
+	m_pCurrentWorker = nullptr;
 }
 
-void ThreadWorker::AppendJob(ThreadJob job)
+// Could be called recursively, when a job is waiting for other jobs it helps executing them
+void ThreadWorker::ExecuteJob(ThreadJob* pJob)
 {
-	std::unique_lock<std::mutex> lock(m_queueMutex);
-	m_jobQueue.push(job);
-	m_condition.notify_one();
+	pJob->job(pJob->frameIndex < m_frameRes.size() ? m_frameRes[pJob->frameIndex] : nullptr);
+
+	JobCounter* pCounter = pJob->pCounter;
+	delete pJob;
+
+	if (pCounter != nullptr)
+		pCounter->Decrement();
+
+	m_pTaskQueue->OnJobDone();
 }
 
-bool ThreadWorker::IsTaskQueueFree()
+bool ThreadWorker::StealJob(ThreadJob*& pJob)
 {
-	bool ret = false;
-	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		ret = m_jobQueue.size() < m_jobQueueSize;
-	}
-	return ret;
+	if (m_localJobs.Steal(pJob))
+		return true;
+
+	return PopExternalJob(pJob);
 }
 
-bool ThreadWorker::IsWorking()
+void ThreadWorker::PushExternalJob(ThreadJob* pJob)
 {
-	bool ret = false;
-	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		ret = m_isWorking;
-	}
-	return ret;
+	std::unique_lock<std::mutex> lock(m_externalJobMutex);
+	m_externalJobs.push_back(pJob);
+	m_externalJobCount++;
 }
 
-void ThreadWorker::WaitForFree()
+bool ThreadWorker::PopExternalJob(ThreadJob*& pJob)
 {
-	std::unique_lock<std::mutex> lock(m_queueMutex);
-	m_condition.wait(lock, [this] { return m_jobQueue.empty() && !m_isWorking; });
+	// Don't bother locking when there's nothing to take
+	if (m_externalJobCount.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_externalJobMutex);
+	if (m_externalJobs.empty())
+		return false;
+
+	pJob = m_externalJobs.front();
+	m_externalJobs.pop_front();
+	m_externalJobCount--;
+	return true;
 }
@@ -3,7 +3,11 @@
 #include <functional>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <memory>
+#include "WorkStealingDeque.hpp"
+#include "JobCounter.hpp"
 
 class Device;
 class ThreadTaskQueue;
@@ -22,27 +26,48 @@ public:
 		ThreadJobFunc	job;
 		uint32_t		frameIndex;
 		ThreadTaskQueue* pThreadTaskQueue = nullptr;
+		JobCounter*		pCounter = nullptr;
 	}ThreadJob;
 
 public:
-	ThreadWorker(const std::shared_ptr<Device>& pDevice, uint32_t frameRoundBinCount, const std::shared_ptr<FrameManager>& pFrameMgr);
+	ThreadWorker(const std::vector<std::shared_ptr<PerFrameResource>>& frameRes, ThreadTaskQueue* pTaskQueue, uint32_t workerIndex);
 	~ThreadWorker();
 
 public:
-	void AppendJob(ThreadJob job);
-	bool IsTaskQueueFree();
-	bool IsWorking();
+	void Start();
+	void Join();
 	void Loop();
-	void WaitForFree();
+	void ExecuteJob(ThreadJob* pJob);
+
+	// Jobs created by this worker's own thread, lock free
+	void PushLocalJob(ThreadJob* pJob) { m_localJobs.Push(pJob); }
+	bool PopLocalJob(ThreadJob*& pJob) { return m_localJobs.Pop(pJob); }
+	bool StealJob(ThreadJob*& pJob);
+
+	// Jobs submitted from threads other than worker threads
+	void PushExternalJob(ThreadJob* pJob);
+	bool PopExternalJob(ThreadJob*& pJob);
+
+	bool IsWorking() const { return m_isWorking; }
+	uint32_t GetWorkerIndex() const { return m_workerIndex; }
+	ThreadTaskQueue* GetTaskQueue() const { return m_pTaskQueue; }
+
+	static ThreadWorker* GetCurrentWorker() { return m_pCurrentWorker; }
 
 private:
-	std::thread					m_worker;
-	std::mutex					m_queueMutex;
-	std::condition_variable		m_condition;
-	std::queue<ThreadJob>		m_jobQueue;
+	std::thread									m_worker;
 	std::vector<std::shared_ptr<PerFrameResource>>	m_frameRes;
 
-	bool m_isWorking = false;
-	bool m_isDestroying = false;
-	const int32_t m_jobQueueSize = 2;
-};
\ No newline at end of file
+	WorkStealingDeque<ThreadJob*>				m_localJobs;
+
+	// External submission is rare compared to jobs spawned by workers, a short lock here is fine
+	std::mutex									m_externalJobMutex;
+	std::deque<ThreadJob*>						m_externalJobs;
+	std::atomic<uint32_t>						m_externalJobCount;
+
+	ThreadTaskQueue*							m_pTaskQueue;
+	uint32_t									m_workerIndex;
+	std::atomic<bool>							m_isWorking;
+
+	static thread_local ThreadWorker*			m_pCurrentWorker;
+};
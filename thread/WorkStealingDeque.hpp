@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+// Chase-Lev work stealing deque
+// Owner thread pushes and pops at the bottom, any other thread steals from the top
+// Ring arrays are never freed while the deque is alive, since a thief might still be reading an old one after growth
+template <typename T>
+class WorkStealingDeque
+{
+	class RingArray
+	{
+	public:
+		RingArray(int64_t capacity) : m_capacity(capacity), m_mask(capacity - 1), m_pData(new std::atomic<T>[capacity]) {}
+		~RingArray() { delete[] m_pData; }
+
+		int64_t Capacity() const { return m_capacity; }
+		T Get(int64_t index) const { return m_pData[index & m_mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, T item) { m_pData[index & m_mask].store(item, std::memory_order_relaxed); }
+
+		RingArray* Grow(int64_t bottom, int64_t top) const
+		{
+			RingArray* pArray = new RingArray(m_capacity * 2);
+			for (int64_t i = top; i < bottom; i++)
+				pArray->Put(i, Get(i));
+			return pArray;
+		}
+
+	private:
+		int64_t			m_capacity;
+		int64_t			m_mask;
+		std::atomic<T>*	m_pData;
+	};
+
+public:
+	// Capacity must be power of 2
+	WorkStealingDeque(int64_t capacity = 1024) : m_top(0), m_bottom(0), m_pArray(new RingArray(capacity)) {}
+
+	~WorkStealingDeque()
+	{
+		delete m_pArray.load();
+		for (auto pArray : m_retiredArrays)
+			delete pArray;
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator = (const WorkStealingDeque&) = delete;
+
+public:
+	// Owner thread only
+	void Push(T item)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		RingArray* pArray = m_pArray.load(std::memory_order_relaxed);
+
+		if (bottom - top > pArray->Capacity() - 1)
+		{
+			m_retiredArrays.push_back(pArray);
+			pArray = pArray->Grow(bottom, top);
+			m_pArray.store(pArray, std::memory_order_release);
+		}
+
+		pArray->Put(bottom, item);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	// Owner thread only
+	bool Pop(T& item)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		RingArray* pArray = m_pArray.load(std::memory_order_relaxed);
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		// Empty
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = pArray->Get(bottom);
+
+		// More than one item left, no race with thieves
+		if (top != bottom)
+			return true;
+
+		// Last item, race against thieves
+		bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	// Any thread
+	bool Steal(T& item)
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+			return false;
+
+		RingArray* pArray = m_pArray.load(std::memory_order_acquire);
+		T stolen = pArray->Get(top);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+
+		item = stolen;
+		return true;
+	}
+
+	// Approximation only, since other threads could modify it concurrently
+	int64_t Size() const
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		return bottom > top ? bottom - top : 0;
+	}
+
+	bool Empty() const { return Size() == 0; }
+
+private:
+	std::atomic<int64_t>		m_top;
+	std::atomic<int64_t>		m_bottom;
+	std::atomic<RingArray*>		m_pArray;
+	std::vector<RingArray*>		m_retiredArrays;
+};
@@ -2,6 +2,7 @@
 #include "StagingBuffer.h"
 #include "StagingBufferManager.h"
 #include "GlobalDeviceObjects.h"
+#include <cstring>
 
 Buffer::~Buffer()
 {
@@ -13,8 +14,19 @@ bool Buffer::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<
 {
 	if (!BufferBase::Init(pDevice, pSelf, info))
 		return false;
+
+	VkBufferCreateInfo createInfo = info;
+
+	// Staging uploads might be written by a dedicated transfer queue, share it between families rather than transfering ownership for each upload
+	uint32_t queueFamilyIndices[] = { pDevice->GetPhysicalDevice()->GetGraphicQueueIndex(), pDevice->GetPhysicalDevice()->GetTransferQueueIndex() };
+	if ((info.usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && pDevice->GetPhysicalDevice()->HasDedicatedTransferQueue())
+	{
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilyIndices;
+	}
 	
-	CHECK_VK_ERROR(vkCreateBuffer(GetDevice()->GetDeviceHandle(), &info, nullptr, &m_buffer));
+	CHECK_VK_ERROR(vkCreateBuffer(GetDevice()->GetDeviceHandle(), &createInfo, nullptr, &m_buffer));
 	m_pMemKey = DeviceMemMgr()->AllocateBufferMemChunk(pSelf, memoryPropertyFlag);
 
 	m_isHostVisible = memoryPropertyFlag & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
@@ -40,6 +52,21 @@ void Buffer::UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBy
 	StagingBufferMgr()->UpdateByteStream(std::static_pointer_cast<Buffer>(GetSelfSharedPtr()), pData, offset, numBytes);
 }
 
+void* Buffer::GetMappedDataPtr() const
+{
+	return DeviceMemMgr()->GetDataPtr(m_pMemKey, 0, (uint32_t)m_info.size);
+}
+
+bool Buffer::ReadByteStream(void* pData, uint32_t offset, uint32_t numBytes) const
+{
+	const char* pSrc = (const char*)DeviceMemMgr()->GetDataPtr(m_pMemKey, offset, numBytes);
+	if (pSrc == nullptr || offset + numBytes > m_info.size)
+		return false;
+
+	memcpy(pData, pSrc + offset, numBytes);
+	return true;
+}
+
 VkMemoryRequirements Buffer::GetMemoryReqirments() const
 {
 	VkMemoryRequirements reqs;
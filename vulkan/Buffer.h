@@ -23,6 +23,9 @@ public:
 	bool IsHostVisible() const override { return m_isHostVisible; }
 	VkBuffer GetDeviceHandle() const override { return m_buffer; }
 	void UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes) override;
+	void* GetMappedDataPtr() const override;
+	// Copy data out of a host visible buffer, false if it's not host visible
+	bool ReadByteStream(void* pData, uint32_t offset, uint32_t numBytes) const;
 
 protected:
 	void BindMemory(VkDeviceMemory memory, uint32_t offset) const;
@@ -18,6 +18,8 @@ public:
 	virtual bool IsHostVisible() const = 0;
 	virtual VkBuffer GetDeviceHandle() const = 0;
 	virtual void UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes) = 0;
+	// Persistently mapped memory of this buffer, or nullptr if it's not host visible
+	virtual void* GetMappedDataPtr() const = 0;
 
 protected:
 	VkBufferCreateInfo				m_info;
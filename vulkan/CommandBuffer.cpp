@@ -6,6 +6,7 @@
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 #include "GraphicPipeline.h"
+#include "ComputePipeline.h"
 #include "PipelineLayout.h"
 #include "Buffer.h"
 #include "Image.h"
@@ -847,7 +848,7 @@ void CommandBuffer::SetScissors(const std::vector<VkRect2D>& scissors)
 	vkCmdSetScissor(GetDeviceHandle(), 0, (uint32_t)scissors.size(), scissors.data());
 }
 
-void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets)
+void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets, VkPipelineBindPoint bindPoint)
 {
 	std::vector<VkDescriptorSet> rawDSList;
 	for (uint32_t i = 0; i < (uint32_t)descriptorSets.size(); i++)
@@ -859,7 +860,7 @@ void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pP
 	vkCmdBindDescriptorSets
 	(
 		GetDeviceHandle(),
-		VK_PIPELINE_BIND_POINT_GRAPHICS, pPipelineLayout->GetDeviceHandle(),
+		bindPoint, pPipelineLayout->GetDeviceHandle(),
 		0, (uint32_t)descriptorSets.size(), rawDSList.data(),
 		(uint32_t)offsets.size(), offsets.data()
 	);
@@ -873,6 +874,12 @@ void CommandBuffer::BindPipeline(const std::shared_ptr<GraphicPipeline>& pPipeli
 	AddToReferenceTable(pPipeline);
 }
 
+void CommandBuffer::BindPipeline(const std::shared_ptr<ComputePipeline>& pPipeline)
+{
+	vkCmdBindPipeline(GetDeviceHandle(), VK_PIPELINE_BIND_POINT_COMPUTE, pPipeline->GetDeviceHandle());
+	AddToReferenceTable(pPipeline);
+}
+
 void CommandBuffer::BindVertexBuffer(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset, uint32_t startSlot)
 {
 	VkBuffer rawBuffer = pBuffer->GetDeviceHandle();
@@ -930,6 +937,11 @@ void CommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t
 	vkCmdDraw(GetDeviceHandle(), vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void CommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	vkCmdDispatch(GetDeviceHandle(), groupCountX, groupCountY, groupCountZ);
+}
+
 void CommandBuffer::NextSubpass()
 {
 	vkCmdNextSubpass(GetDeviceHandle(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "DeviceObjectBase.h"
+#include <unordered_set>
 
 class CommandPool;
 class GraphicPipeline;
+class ComputePipeline;
 class RenderPass;
 class DescriptorSet;
 class VertexBuffer;
@@ -97,8 +99,9 @@ public:
 	void SetViewports(const std::vector<VkViewport>& viewports);
 	void SetScissors(const std::vector<VkRect2D>& scissors);
 
-	void BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets);
+	void BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
 	void BindPipeline(const std::shared_ptr<GraphicPipeline>& pPipeline);
+	void BindPipeline(const std::shared_ptr<ComputePipeline>& pPipeline);
 	void BindVertexBuffer(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset = 0, uint32_t startSlot = 0);
 	void BindVertexBuffers(const std::vector<std::shared_ptr<BufferBase>>& vertexBuffers, uint32_t startSlot = 0);
 	void BindIndexBuffer(const std::shared_ptr<BufferBase>& pIndexBuffer, VkIndexType type);
@@ -112,6 +115,8 @@ public:
 	void DrawIndexedIndirectCount(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t indirectOffset, const std::shared_ptr<BufferBase>& pIndirectCmdCountBuffer, uint32_t indirectCountOffset);
 	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
 
+	void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
 	void NextSubpass();
 
 	void Execute(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers);
@@ -120,6 +125,16 @@ protected:
 	static std::shared_ptr<CommandBuffer> Create(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<CommandPool>& pCmdPool, VkCommandBufferLevel cmdBufferLevel);
 
 protected:
+	// Objects used by recorded commands have to live as long as this command buffer
+	// A command buffer is recorded by only one thread, so a plain set of raw pointers is enough to skip objects already referenced
+	// It saves the atomic reference counting of shared pointers, which gets contended when many threads bind the same objects
+	template <typename T>
+	void AddToReferenceTable(const std::shared_ptr<T>& pObj)
+	{
+		if (m_referencedObjects.insert(pObj.get()).second)
+			m_referenceTable.emplace_back(pObj);
+	}
+
 	bool IsValide() const { m_isValide; }
 	void SetIsValide(bool flag) { m_isValide = flag; }
 
@@ -145,5 +160,7 @@ private:
 	DrawCmdData										m_drawCmdData;
 	BufferCopyCmdData								m_bufferCopyCmdData;
 
+	std::unordered_set<const void*>					m_referencedObjects;
+
 	friend class CommandPool;
 };
\ No newline at end of file
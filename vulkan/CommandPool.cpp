@@ -10,13 +10,18 @@ CommandPool::~CommandPool()
 }
 
 bool CommandPool::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<CommandPool>& pSelf, VkCommandPoolCreateFlags flags)
+{
+	return Init(pDevice, pPerFrameRes, pSelf, flags, pDevice->GetPhysicalDevice()->GetGraphicQueueIndex());
+}
+
+bool CommandPool::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<CommandPool>& pSelf, VkCommandPoolCreateFlags flags, uint32_t queueFamilyIndex)
 {
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
 	m_info = {};
 	m_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	m_info.queueFamilyIndex = m_pDevice->GetPhysicalDevice()->GetGraphicQueueIndex();
+	m_info.queueFamilyIndex = queueFamilyIndex;
 	m_info.flags = flags;
 	CHECK_VK_ERROR(vkCreateCommandPool(pDevice->GetDeviceHandle(), &m_info, nullptr, &m_commandPool));
 
@@ -71,6 +76,14 @@ std::shared_ptr<CommandPool> CommandPool::CreateTransientCBPool(const std::share
 	return nullptr;
 }
 
+std::shared_ptr<CommandPool> CommandPool::CreateTransferCBPool(const std::shared_ptr<Device>& pDevice)
+{
+	std::shared_ptr<CommandPool> pCommandPool = std::make_shared<CommandPool>();
+	if (pCommandPool.get() && pCommandPool->Init(pDevice, nullptr, pCommandPool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, pDevice->GetPhysicalDevice()->GetTransferQueueIndex()))
+		return pCommandPool;
+	return nullptr;
+}
+
 std::shared_ptr<CommandPool> CommandPool::Create(const std::shared_ptr<Device>& pDevice)
 {
 	return Create(pDevice, nullptr);
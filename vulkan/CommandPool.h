@@ -12,6 +12,7 @@ public:
 	~CommandPool();
 
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<CommandPool>& pSelf, VkCommandPoolCreateFlags flags = 0);
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<CommandPool>& pSelf, VkCommandPoolCreateFlags flags, uint32_t queueFamilyIndex);
 
 public:
 	std::shared_ptr<CommandBuffer> AllocatePrimaryCommandBuffer();
@@ -27,6 +28,8 @@ public:
 	static std::shared_ptr<CommandPool> Create(const std::shared_ptr<Device>& pDevice);
 	static std::shared_ptr<CommandPool> Create(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes);
 	static std::shared_ptr<CommandPool> CreateTransientCBPool(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PerFrameResource>& pPerFrameRes);
+	// Command buffers allocated from this pool could only be submitted to transfer queue
+	static std::shared_ptr<CommandPool> CreateTransferCBPool(const std::shared_ptr<Device>& pDevice);
 
 protected:
 	VkCommandPool					m_commandPool;
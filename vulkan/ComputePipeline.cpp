@@ -1,11 +1,14 @@
 #include "ComputePipeline.h"
 #include "PipelineLayout.h"
 #include "ShaderModule.h"
+#include "PipelineCache.h"
+#include "GlobalDeviceObjects.h"
 #include <fstream>
 
 ComputePipeline::~ComputePipeline()
 {
-	vkDestroyPipeline(GetDevice()->GetDeviceHandle(), m_pipeline, nullptr);
+	if (m_pipeline)
+		vkDestroyPipeline(GetDevice()->GetDeviceHandle(), m_pipeline, nullptr);
 
 	delete[] m_shaderStageInfo.pName;
 }
@@ -17,6 +20,7 @@ bool ComputePipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 
 	m_info = info;
 
+	m_shaderStageInfo = {};
 	m_shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	m_shaderStageInfo.stage = m_pShaderModule->GetShaderStage();
 	m_shaderStageInfo.module = m_pShaderModule->GetDeviceHandle();
@@ -27,7 +31,17 @@ bool ComputePipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 
 	m_info.stage = m_shaderStageInfo;
 
-	CHECK_VK_ERROR(vkCreateComputePipelines(m_pDevice->GetDeviceHandle(), 0, 1, &m_info, nullptr, &m_pipeline));
+	// Pipeline cache could defer compiling to a batch
+	std::shared_ptr<ComputePipeline> pPipeline = pSelf;
+	PipelineCache::CompileFunc compileFunc = [pPipeline](VkPipelineCache pipelineCache)
+	{
+		CHECK_VK_ERROR(vkCreateComputePipelines(pPipeline->GetDevice()->GetDeviceHandle(), pipelineCache, 1, &pPipeline->m_info, nullptr, &pPipeline->m_pipeline));
+	};
+
+	if (GlobalPipelineCache() != nullptr)
+		GlobalPipelineCache()->Compile(compileFunc);
+	else
+		compileFunc(VK_NULL_HANDLE);
 
 	return true;
 }
@@ -31,7 +31,7 @@ private:
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<ComputePipeline>& pSelf, const VkComputePipelineCreateInfo& info);
 
 protected:
-	VkPipeline							m_pipeline;
+	VkPipeline							m_pipeline = VK_NULL_HANDLE;
 	VkComputePipelineCreateInfo			m_info;
 	VkPipelineShaderStageCreateInfo		m_shaderStageInfo;
 	std::shared_ptr<PipelineLayout>		m_pPipelineLayout;
@@ -5,6 +5,7 @@
 #include "Image.h"
 #include "UniformBuffer.h"
 #include "ShaderStorageBuffer.h"
+#include "SharedIndirectBuffer.h"
 #include "ImageView.h"
 #include "Sampler.h"
 
@@ -60,7 +61,8 @@ void DescriptorSet::UpdateUniformBufferDynamic(uint32_t binding, const std::shar
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable[binding].push_back(pBuffer);
+	// Dynamic buffers are rewritten once their storages grow, old buffers aren't referred any more
+	m_resourceTable[binding] = { pBuffer };
 }
 
 void DescriptorSet::UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer)
@@ -177,6 +179,57 @@ void DescriptorSet::UpdateInputImage(uint32_t binding, const std::shared_ptr<Ima
 	AddToReferenceTable(pImageView);
 }
 
+void DescriptorSet::UpdateIndirectBuffer(uint32_t binding, const std::shared_ptr<SharedIndirectBuffer>& pBuffer)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
+	writeData[0].pBufferInfo = &info;
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_resourceTable[binding].push_back(pBuffer);
+}
+
+void DescriptorSet::UpdateStorageBuffer(uint32_t binding, const std::shared_ptr<Buffer>& pBuffer)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = { pBuffer->GetDeviceHandle(), 0, VK_WHOLE_SIZE };
+	writeData[0].pBufferInfo = &info;
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_resourceTable[binding].push_back(pBuffer);
+}
+
+void DescriptorSet::UpdateBufferDynamic(uint32_t binding, VkDescriptorType descriptorType, const std::shared_ptr<Buffer>& pBuffer, uint32_t range)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = descriptorType;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = { pBuffer->GetDeviceHandle(), 0, range };
+	writeData[0].pBufferInfo = &info;
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_resourceTable[binding] = { pBuffer };
+}
+
 void DescriptorSet::UpdateTexBuffer(uint32_t binding, const VkBufferView& texBufferView)
 {
 	std::vector<VkWriteDescriptorSet> writeData = { {} };
@@ -204,7 +257,8 @@ void DescriptorSet::UpdateShaderStorageBufferDynamic(uint32_t binding, const std
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable[binding].push_back(pBuffer);
+	// Dynamic buffers are rewritten once their storages grow, old buffers aren't referred any more
+	m_resourceTable[binding] = { pBuffer };
 }
 
 void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer)
@@ -222,4 +276,28 @@ void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::share
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
 	m_resourceTable[binding].push_back(pBuffer);
+}
+
+void DescriptorSet::CopyDescriptors(const std::shared_ptr<DescriptorSet>& pSrcDescriptorSet)
+{
+	std::vector<VkCopyDescriptorSet> copyData;
+	for (auto & binding : m_pDescriptorSetLayout->GetDescriptorSetLayoutBinding())
+	{
+		// Only bindings written in source set are valid to copy
+		if (pSrcDescriptorSet->m_resourceTable.find(binding.binding) == pSrcDescriptorSet->m_resourceTable.end())
+			continue;
+
+		VkCopyDescriptorSet copy = {};
+		copy.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+		copy.srcSet = pSrcDescriptorSet->GetDeviceHandle();
+		copy.srcBinding = binding.binding;
+		copy.dstSet = GetDeviceHandle();
+		copy.dstBinding = binding.binding;
+		copy.descriptorCount = binding.descriptorCount;
+		copyData.push_back(copy);
+	}
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), 0, nullptr, (uint32_t)copyData.size(), copyData.data());
+
+	m_resourceTable = pSrcDescriptorSet->m_resourceTable;
 }
\ No newline at end of file
@@ -7,6 +7,8 @@ class DescriptorPool;
 class DescriptorSetLayout;
 class UniformBuffer;
 class ShaderStorageBuffer;
+class SharedIndirectBuffer;
+class Buffer;
 class Image;
 class Sampler;
 class ImageView;
@@ -37,6 +39,12 @@ public:
 	void UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer);
 	void UpdateShaderStorageBufferDynamic(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
 	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
+	// Indirect buffer bound as a storage buffer, for compute shaders that generate draw commands
+	void UpdateIndirectBuffer(uint32_t binding, const std::shared_ptr<SharedIndirectBuffer>& pBuffer);
+	// Whole buffer bound as a storage buffer, for compute shaders working on internal buffers of shared buffer managers
+	void UpdateStorageBuffer(uint32_t binding, const std::shared_ptr<Buffer>& pBuffer);
+	// Window of "range" bytes of a buffer bound as a dynamic uniform or storage buffer, e.g. transient data picked by dynamic offsets
+	void UpdateBufferDynamic(uint32_t binding, VkDescriptorType descriptorType, const std::shared_ptr<Buffer>& pBuffer, uint32_t range);
 	void UpdateImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView);
 	void UpdateImage(uint32_t binding, const CombinedImage& image);
 	void UpdateImages(uint32_t binding, const std::vector<CombinedImage>& images);
@@ -45,6 +53,9 @@ public:
 	// FIXME: Refactor this when I create texture buffer object class
 	void UpdateTexBuffer(uint32_t binding, const VkBufferView& texBufferView);
 
+	// Copies every written binding of a set with the same layout, so that a set still used by frames in flight could be replaced rather than rewritten
+	void CopyDescriptors(const std::shared_ptr<DescriptorSet>& pSrcDescriptorSet);
+
 public:
 	static std::shared_ptr<DescriptorSet> Create(const std::shared_ptr<Device>& pDevice,
 		const std::shared_ptr<DescriptorPool>& pDescriptorPool,
@@ -22,16 +22,26 @@ bool Device::Init(const std::shared_ptr<Instance>& pInst, const std::shared_ptr<
 	m_pPhysicalDevice = pPhyisicalDevice;
 
 	std::array<float, 1> queueProperties = { 0.0f };
+	std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos;
+
 	VkDeviceQueueCreateInfo deviceQueueCreateInfo = {};
 	deviceQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 	deviceQueueCreateInfo.queueFamilyIndex = m_pPhysicalDevice->GetGraphicQueueIndex();
 	deviceQueueCreateInfo.queueCount = (uint32_t)queueProperties.size();
 	deviceQueueCreateInfo.pQueuePriorities = queueProperties.data();
+	deviceQueueCreateInfos.push_back(deviceQueueCreateInfo);
+
+	// Staging uploads go through a dedicated transfer queue if there is one
+	if (m_pPhysicalDevice->HasDedicatedTransferQueue())
+	{
+		deviceQueueCreateInfo.queueFamilyIndex = m_pPhysicalDevice->GetTransferQueueIndex();
+		deviceQueueCreateInfos.push_back(deviceQueueCreateInfo);
+	}
 
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	deviceCreateInfo.queueCreateInfoCount = 1;
-	deviceCreateInfo.pQueueCreateInfos = &deviceQueueCreateInfo;
+	deviceCreateInfo.queueCreateInfoCount = (uint32_t)deviceQueueCreateInfos.size();
+	deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfos.data();
 	std::vector<const char*> extensions = { EXTENSION_VULKAN_SWAPCHAIN, EXTENSION_SHADER_DRAW_PARAMETERS, EXTENSION_VULKAN_DRAW_INDIRECT_COUNT };
 	deviceCreateInfo.enabledExtensionCount = (uint32_t)extensions.size();
 	deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
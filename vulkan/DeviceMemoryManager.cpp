@@ -2,12 +2,11 @@
 #include "MemoryConsumer.h"
 #include "../common/Macros.h"
 #include <algorithm>
+#include <chrono>
 #include "Buffer.h"
 #include "Image.h"
 #include "GlobalDeviceObjects.h"
 
-uint32_t MemoryKey::m_allocatedKeys = 0;
-
 std::shared_ptr<MemoryKey> MemoryKey::Create(const std::shared_ptr<DeviceMemoryManager>& pDeviceMemMgr, bool bufferOrImage)
 {
 	std::shared_ptr<MemoryKey> pMemKey = std::make_shared<MemoryKey>();
@@ -18,15 +17,12 @@ std::shared_ptr<MemoryKey> MemoryKey::Create(const std::shared_ptr<DeviceMemoryM
 
 MemoryKey::~MemoryKey()
 {
-	if (m_bufferOrImage)
-		m_pDeviceMemMgr->FreeBufferMemChunk(m_key);
-	else
-		m_pDeviceMemMgr->FreeImageMemChunk(m_key);
+	m_pDeviceMemMgr->FreeMemChunk(m_key);
 }
 
 bool MemoryKey::Init(const std::shared_ptr<DeviceMemoryManager>& pDeviceMemMgr, bool bufferOrImage)
 {
-	m_key = m_allocatedKeys++;
+	m_key = pDeviceMemMgr->AcquireKey();
 	m_bufferOrImage = bufferOrImage;
 	m_pDeviceMemMgr = pDeviceMemMgr;
 	return true;
@@ -42,7 +38,16 @@ bool DeviceMemoryManager::Init(const std::shared_ptr<Device>& pDevice, const std
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
-	m_bufferMemPool.resize(sizeof(uint32_t) * 8, {});	// Same size as bit count of uint32_t, i.e. type index count
+	m_linearMemPools.resize(VK_MAX_MEMORY_TYPES);
+	m_optimalMemPools.resize(VK_MAX_MEMORY_TYPES);
+
+	// Pools are keyed by memory type, so their properties are those of the type, not of what any request asked for
+	const VkPhysicalDeviceMemoryProperties& memProperties = GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceMemoryProperties();
+	for (uint32_t typeIndex = 0; typeIndex < memProperties.memoryTypeCount; typeIndex++)
+	{
+		m_linearMemPools[typeIndex].memProperty = memProperties.memoryTypes[typeIndex].propertyFlags;
+		m_optimalMemPools[typeIndex].memProperty = memProperties.memoryTypes[typeIndex].propertyFlags;
+	}
 
 	return true;
 }
@@ -55,271 +60,304 @@ std::shared_ptr<DeviceMemoryManager> DeviceMemoryManager::Create(const std::shar
 	return nullptr;
 }
 
+uint32_t DeviceMemoryManager::AcquireKey()
+{
+	if (m_freeKeys.size() != 0)
+	{
+		uint32_t key = m_freeKeys.back();
+		m_freeKeys.pop_back();
+		return key;
+	}
+
+	m_bindingTable.push_back({});
+	return (uint32_t)m_bindingTable.size() - 1;
+}
+
+void DeviceMemoryManager::ReleaseKey(uint32_t key)
+{
+	m_bindingTable[key] = {};
+	m_freeKeys.push_back(key);
+}
+
 std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateBufferMemChunk(const std::shared_ptr<Buffer>& pBuffer, uint32_t memoryPropertyBits, const void* pData)
 {
 	std::shared_ptr<MemoryKey> pMemKey = MemoryKey::Create(GetSelfSharedPtr(), true);
 
 	VkMemoryRequirements reqs = pBuffer->GetMemoryReqirments();
+	AllocateMemory(pMemKey->m_key, reqs, memoryPropertyBits, true);
 
-	uint32_t typeIndex;
-	uint32_t offset;
-	AllocateBufferMemory(pMemKey->m_key, (uint32_t)reqs.size, reqs.memoryTypeBits, memoryPropertyBits, typeIndex, offset);
+	BindingInfo& bindingInfo = m_bindingTable[pMemKey->m_key];
+	pBuffer->BindMemory(bindingInfo.pBlock->memory, bindingInfo.startByte);
 
-	// If key exceeds lookup table size, increase it
-	if (pMemKey->m_key >= m_bufferBindingLookupTable.size())
-	{
-		std::vector<std::pair<uint32_t, bool>> newLookupTable(m_bufferBindingLookupTable.size() + LOOKUP_TABLE_SIZE_INC);
-		std::swap_ranges(m_bufferBindingLookupTable.begin(), m_bufferBindingLookupTable.end(), newLookupTable.begin());
-		m_bufferBindingLookupTable = std::move(newLookupTable);
-	}
+	UpdateBufferMemChunk(pMemKey, pData, 0, (uint32_t)reqs.size);
+
+	return pMemKey;
+}
 
-	pBuffer->BindMemory(m_bufferMemPool[typeIndex].memory, offset);
+std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateImageMemChunk(const std::shared_ptr<Image>& pImage, uint32_t memoryPropertyBits, const void* pData)
+{
+	std::shared_ptr<MemoryKey> pMemKey = MemoryKey::Create(GetSelfSharedPtr(), false);
 
-	uint32_t bindingTableIndex = (uint32_t)m_bufferBindingTable.size();
-	m_bufferBindingTable.push_back
-		(
-			{
-				{
-					typeIndex,
-					offset,
-					(uint32_t)reqs.size,
-					nullptr
-				},
-				{
-					false
-				}
-			}
-		);
+	VkMemoryRequirements reqs = pImage->GetMemoryReqirments();
 
-	if (m_bufferMemPool[typeIndex].pData)
-		m_bufferBindingTable[bindingTableIndex].first.pData = (char*)m_bufferMemPool[typeIndex].pData + offset;
+	// Linear images live with buffers, optimal ones get their own pools, so that buffer image granularity never applies between neighbours
+	bool isLinear = pImage->GetImageInfo().tiling == VK_IMAGE_TILING_LINEAR;
+	AllocateMemory(pMemKey->m_key, reqs, memoryPropertyBits, isLinear);
 
-	m_bufferBindingLookupTable[pMemKey->m_key] = { bindingTableIndex, false };
+	BindingInfo& bindingInfo = m_bindingTable[pMemKey->m_key];
+	pImage->BindMemory(bindingInfo.pBlock->memory, bindingInfo.startByte);
 
-	UpdateBufferMemChunk(pMemKey, pData, offset, (uint32_t)reqs.size);
+	UpdateImageMemChunk(pMemKey, pData, 0, (uint32_t)reqs.size);
 
 	return pMemKey;
 }
 
-std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateImageMemChunk(const std::shared_ptr<Image>& pImage, uint32_t memoryPropertyBits, const void* pData)
+std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateImageMemChunk(const VkMemoryRequirements& reqs, uint32_t memoryPropertyBits)
 {
 	std::shared_ptr<MemoryKey> pMemKey = MemoryKey::Create(GetSelfSharedPtr(), false);
+	AllocateMemory(pMemKey->m_key, reqs, memoryPropertyBits, false);
+	return pMemKey;
+}
 
-	VkMemoryRequirements reqs = pImage->GetMemoryReqirments();
+void DeviceMemoryManager::BindImageMemChunk(const std::shared_ptr<Image>& pImage, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset)
+{
+	BindingInfo& bindingInfo = m_bindingTable[pMemKey->m_key];
 
-	uint32_t typeIndex;
-	uint32_t offset;
-	AllocateImageMemory(pMemKey->m_key, (uint32_t)reqs.size, reqs.memoryTypeBits, memoryPropertyBits, typeIndex, offset);
-	pImage->BindMemory(m_imageMemPool[m_imageMemPoolLookupTable[pMemKey->m_key].first].memory, offset);
+	VkMemoryRequirements reqs = pImage->GetMemoryReqirments();
+	ASSERTION(!bindingInfo.isFreed && offset % reqs.alignment == 0 && offset + reqs.size <= bindingInfo.numBytes);
+	ASSERTION(reqs.memoryTypeBits & (1 << bindingInfo.typeIndex));
 
-	return pMemKey;
+	pImage->BindMemory(bindingInfo.pBlock->memory, bindingInfo.startByte + offset);
 }
 
 bool DeviceMemoryManager::UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes)
 {
+	auto& bindingInfo = m_bindingTable[pMemKey->m_key];
+
 	// Early return if it's been freed
-	if (m_bufferBindingLookupTable[pMemKey->m_key].second)
+	if (bindingInfo.isFreed)
 		return false;
 
 	if (pData == nullptr)
 		return false;
 
-	auto& bindingInfo = m_bufferBindingTable[m_bufferBindingLookupTable[pMemKey->m_key].first].first;
-	auto& memoryNode = m_bufferMemPool[bindingInfo.typeIndex];
+	// Not host visible
+	if (bindingInfo.pData == nullptr)
+		return false;
 
-	if ((memoryNode.memProperty & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+	if (offset >= bindingInfo.numBytes)
 		return false;
 
 	// If numbytes is larger than buffer's bytes, use buffer bytes
-	uint32_t updateNumBytes = numBytes > bindingInfo.numBytes ? bindingInfo.numBytes : numBytes;
+	uint32_t updateNumBytes = numBytes > bindingInfo.numBytes - offset ? bindingInfo.numBytes - offset : numBytes;
 
-	UpdateMemoryChunk(memoryNode.memory, offset, updateNumBytes, bindingInfo.pData, pData);
+	UpdateMemoryChunk(offset, updateNumBytes, bindingInfo.pData, pData);
 	return true;
 }
 
 bool DeviceMemoryManager::UpdateImageMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes)
 {
-	if (pData == nullptr)
-		return false;
-
-	auto& memoryNode = m_imageMemPool[m_imageMemPoolLookupTable[pMemKey->m_key].first];
-
-	if ((memoryNode.memProperty & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
-		return false;
-
-	// If numbytes is larger than buffer's bytes, use buffer bytes
-	uint32_t updateNumBytes = numBytes > memoryNode.numBytes ? memoryNode.numBytes : numBytes;
-
-	UpdateMemoryChunk(memoryNode.memory, 0, updateNumBytes, memoryNode.pData, pData);
-	return true;
+	// Images share the same binding table, there's no difference in updating
+	return UpdateBufferMemChunk(pMemKey, pData, offset, numBytes);
 }
 
-void DeviceMemoryManager::UpdateMemoryChunk(VkDeviceMemory memory, uint32_t offset, uint32_t numBytes, void* pDst, const void* pData)
+void DeviceMemoryManager::UpdateMemoryChunk(uint32_t offset, uint32_t numBytes, void* pDst, const void* pData)
 {
 	memcpy_s((char*)pDst + offset, numBytes, pData, numBytes);
 }
 
-void DeviceMemoryManager::AllocateBufferMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset)
+uint32_t DeviceMemoryManager::FindMemoryType(uint32_t memoryTypeBits, uint32_t memoryPropertyBits) const
 {
-	typeIndex = 0;
-	uint32_t typeBits = memoryTypeBits;
-	while (typeBits)
+	const VkPhysicalDeviceMemoryProperties& memProperties = GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceMemoryProperties();
+	for (uint32_t typeIndex = 0; typeIndex < memProperties.memoryTypeCount; typeIndex++)
 	{
-		if (typeBits & 1)
-		{
-			int res = GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceMemoryProperties().memoryTypes[typeIndex].propertyFlags & memoryPropertyBits;
-			if (res == memoryPropertyBits)
-			{
-				break;
-			}
-		}
-		typeBits >>= 1;
-		typeIndex++;
+		if ((memoryTypeBits & (1 << typeIndex)) == 0)
+			continue;
+
+		if ((memProperties.memoryTypes[typeIndex].propertyFlags & memoryPropertyBits) == memoryPropertyBits)
+			return typeIndex;
 	}
 
-	if (m_bufferMemPool[typeIndex].memory == 0)
-	{
-		MemoryNode node;
-		node.numBytes = (memoryPropertyBits & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? STAGING_MEMORY_ALLOCATE_INC : DEVICE_MEMORY_ALLOCATE_INC;
-		node.memProperty = memoryPropertyBits;
+	ASSERTION(false);
+	return 0;
+}
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = node.numBytes;
-		allocInfo.memoryTypeIndex = typeIndex;
-		CHECK_VK_ERROR(vkAllocateMemory(GetDevice()->GetDeviceHandle(), &allocInfo, nullptr, &node.memory));
+std::shared_ptr<DeviceMemoryManager::MemoryBlock> DeviceMemoryManager::CreateMemoryBlock(uint32_t typeIndex, uint32_t numBytes)
+{
+	std::shared_ptr<MemoryBlock> pBlock = std::make_shared<MemoryBlock>();
+	pBlock->numBytes = numBytes;
+	pBlock->pAllocator = std::make_shared<TLSFAllocator>(numBytes);
 
-		if (memoryPropertyBits & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
-			CHECK_VK_ERROR(vkMapMemory(GetDevice()->GetDeviceHandle(), node.memory, 0, numBytes, 0, &node.pData));
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = numBytes;
+	allocInfo.memoryTypeIndex = typeIndex;
+	CHECK_VK_ERROR(vkAllocateMemory(GetDevice()->GetDeviceHandle(), &allocInfo, nullptr, &pBlock->memory));
 
-		m_bufferMemPool[typeIndex] = node;
-	}
+	// Host visible blocks stay mapped as a whole during their lifetime
+	// It's up to memory type rather than requested bits, as a device local request could land in a host visible type(UMA, resizable BAR),
+	// and later host visible requests of the same type share this block
+	if (m_linearMemPools[typeIndex].memProperty & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		CHECK_VK_ERROR(vkMapMemory(GetDevice()->GetDeviceHandle(), pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pBlock->pData));
 
-	if (!FindFreeBufferMemoryChunk(key, typeIndex, numBytes, offset))
-	{ 
-		// Should create a larger chunck of memory, do it later
-		assert(false);
-	}
+	return pBlock;
 }
 
-void DeviceMemoryManager::AllocateImageMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset)
+void DeviceMemoryManager::AllocateMemory(uint32_t key, const VkMemoryRequirements& reqs, uint32_t memoryPropertyBits, bool isLinear)
 {
-	typeIndex = 0;
-	uint32_t typeBits = memoryTypeBits;
-	while (typeBits)
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	uint32_t typeIndex = FindMemoryType(reqs.memoryTypeBits, memoryPropertyBits);
+	MemoryPool& pool = isLinear ? m_linearMemPools[typeIndex] : m_optimalMemPools[typeIndex];
+
+	uint32_t numBytes = (uint32_t)reqs.size;
+	uint32_t alignment = (uint32_t)reqs.alignment;
+
+	uint32_t offset;
+	uint32_t allocationHandle;
+	std::shared_ptr<MemoryBlock> pBlock;
+
+	for (auto & pExistingBlock : pool.blocks)
 	{
-		if (typeBits & 1)
+		if (pExistingBlock->pAllocator->Allocate(numBytes, alignment, offset, allocationHandle))
 		{
-			if (GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceMemoryProperties().memoryTypes[typeIndex].propertyFlags & memoryPropertyBits)
-			{
-				break;
-			}
+			pBlock = pExistingBlock;
+			break;
 		}
-		typeBits >>= 1;
-		typeIndex++;
 	}
 
-	MemoryNode node;
-	node.numBytes = numBytes;
-	node.memProperty = memoryPropertyBits;
-
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = numBytes;
-	allocInfo.memoryTypeIndex = typeIndex;
-	CHECK_VK_ERROR(vkAllocateMemory(GetDevice()->GetDeviceHandle(), &allocInfo, nullptr, &node.memory));
-
-	offset = 0;
+	// No room in existing blocks, grow the pool by a new block, large enough for this request in case it's huge
+	if (pBlock == nullptr)
+	{
+		uint32_t blockBytes;
+		if (!isLinear)
+			blockBytes = IMAGE_MEMORY_ALLOCATE_INC;
+		else
+			blockBytes = (pool.memProperty & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? STAGING_MEMORY_ALLOCATE_INC : DEVICE_MEMORY_ALLOCATE_INC;
+		blockBytes = std::max(blockBytes, numBytes + alignment);
 
-	uint32_t imageMemPoolIndex = (uint32_t)m_imageMemPool.size();
-	m_imageMemPool.push_back(node);
+		pBlock = CreateMemoryBlock(typeIndex, blockBytes);
+		pool.blocks.push_back(pBlock);
 
-	if (key >= m_imageMemPoolLookupTable.size())
-	{
-		std::vector<std::pair<uint32_t, bool>> newLookupTable(m_imageMemPoolLookupTable.size() + LOOKUP_TABLE_SIZE_INC);
-		std::swap_ranges(m_imageMemPoolLookupTable.begin(), m_imageMemPoolLookupTable.end(), newLookupTable.begin());
-		m_imageMemPoolLookupTable = std::move(newLookupTable);
+		bool allocated = pBlock->pAllocator->Allocate(numBytes, alignment, offset, allocationHandle);
+		ASSERTION(allocated);
 	}
 
-	m_imageMemPoolLookupTable[key] = { imageMemPoolIndex, false };
+	BindingInfo& bindingInfo = m_bindingTable[key];
+	bindingInfo.pBlock = pBlock;
+	bindingInfo.allocationHandle = allocationHandle;
+	bindingInfo.typeIndex = typeIndex;
+	bindingInfo.isLinear = isLinear;
+	bindingInfo.startByte = offset;
+	bindingInfo.numBytes = numBytes;
+	bindingInfo.pData = pBlock->pData ? (char*)pBlock->pData + offset : nullptr;
+	bindingInfo.isFreed = false;
+
+	m_totalAllocations++;
+	m_allocationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 }
 
-void DeviceMemoryManager::FreeBufferMemChunk(uint32_t key)
+void DeviceMemoryManager::FreeMemChunk(uint32_t key)
 {
-	// Early return if it's freed
-	if (m_bufferBindingLookupTable[key].second)
-		return;
-
-	auto& bindingInfo = m_bufferBindingTable[m_bufferBindingLookupTable[key].first];
-	
-	MemoryNode& node = m_bufferMemPool[bindingInfo.first.typeIndex];
-	auto memIter = std::find_if(node.bindingList.begin(), node.bindingList.end(), [key](uint32_t poolKey)
-	{
-		return poolKey == key;
-	});
-	if (memIter == node.bindingList.end())
-		return;
+	auto startTime = std::chrono::high_resolution_clock::now();
 
-	m_bufferBindingLookupTable[key].second = true;
-	m_bufferBindingTable[m_bufferBindingLookupTable[key].first].second = true;
+	BindingInfo& bindingInfo = m_bindingTable[key];
 
-	node.bindingList.erase(memIter);
+	if (!bindingInfo.isFreed)
+	{
+		bindingInfo.pBlock->pAllocator->Free(bindingInfo.allocationHandle);
+		m_totalFrees++;
+	}
+
+	ReleaseKey(key);
 
-	// Need to add some sort of logics to make buffer tables more compact
+	m_freeTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 }
 
-void DeviceMemoryManager::FreeImageMemChunk(uint32_t key)
+uint32_t DeviceMemoryManager::Defragment()
 {
-	auto index = m_imageMemPoolLookupTable[key];
+	uint32_t releasedCount = 0;
 
-	vkFreeMemory(GetDevice()->GetDeviceHandle(), m_imageMemPool[index.first].memory, nullptr);
+	auto releaseEmptyBlocks = [this, &releasedCount](MemoryPool& pool)
+	{
+		// Keep the first block, so that a pool with fluctuating usage doesn't keep allocating and freeing device memory
+		for (size_t i = pool.blocks.size(); i > 1; i--)
+		{
+			auto& pBlock = pool.blocks[i - 1];
+			if (!pBlock->pAllocator->IsEmpty())
+				continue;
 
-	//m_imageMemPool.erase(m_imageMemPool.begin() + index.first);
-	m_imageMemPoolLookupTable[key].second = true;
+			vkFreeMemory(GetDevice()->GetDeviceHandle(), pBlock->memory, nullptr);
+			pool.blocks.erase(pool.blocks.begin() + (i - 1));
+			releasedCount++;
+		}
+	};
 
-	// Need to add some sort of logics to make buffer tables more compact
-}
+	std::for_each(m_linearMemPools.begin(), m_linearMemPools.end(), releaseEmptyBlocks);
+	std::for_each(m_optimalMemPools.begin(), m_optimalMemPools.end(), releaseEmptyBlocks);
 
-bool DeviceMemoryManager::FindFreeBufferMemoryChunk(uint32_t key, uint32_t typeIndex, uint32_t numBytes, uint32_t& offset)
-{
- 	offset = 0;
-	uint32_t endByte = 0;
-	for (uint32_t i = 0; i < m_bufferMemPool[typeIndex].bindingList.size(); i++)
+	// Trailing free keys could be dropped from binding table
+	std::sort(m_freeKeys.begin(), m_freeKeys.end());
+	while (m_freeKeys.size() != 0 && m_freeKeys.back() == m_bindingTable.size() - 1)
 	{
-		auto& bindingInfo = m_bufferBindingTable[m_bufferBindingLookupTable[m_bufferMemPool[typeIndex].bindingList[i]].first];
+		m_freeKeys.pop_back();
+		m_bindingTable.pop_back();
+	}
+	// Smaller keys are handed out first
+	std::reverse(m_freeKeys.begin(), m_freeKeys.end());
 
-		// Skip if it's freed
-		if (bindingInfo.second)
-			continue;
+	m_bindingTable.shrink_to_fit();
+	m_freeKeys.shrink_to_fit();
 
-		endByte = offset + numBytes - 1;
-		if (endByte < bindingInfo.first.startByte)
-		{
-			m_bufferMemPool[typeIndex].bindingList.insert(m_bufferMemPool[typeIndex].bindingList.begin() + i, key);
-			return true;
-		}
-		else
+	return releasedCount;
+}
+
+DeviceMemoryManager::MemoryStatistics DeviceMemoryManager::GetStatistics() const
+{
+	MemoryStatistics stats;
+
+	uint64_t freeBytes = 0;
+	auto accumulate = [&stats, &freeBytes](const MemoryPool& pool)
+	{
+		for (auto & pBlock : pool.blocks)
 		{
-			offset = bindingInfo.first.startByte + bindingInfo.first.numBytes;
+			stats.blockCount++;
+			stats.reservedBytes += pBlock->numBytes;
+			stats.usedBytes += pBlock->pAllocator->GetUsedBytes();
+			stats.allocationCount += pBlock->pAllocator->GetAllocationCount();
+			stats.freeRangeCount += pBlock->pAllocator->GetFreeRangeCount();
+			stats.largestFreeRange = std::max(stats.largestFreeRange, pBlock->pAllocator->GetLargestFreeRange());
+			freeBytes += pBlock->pAllocator->GetFreeBytes();
 		}
-	}
+	};
 
-	if (offset + numBytes > m_bufferMemPool[typeIndex].numBytes)
-		return false;
+	std::for_each(m_linearMemPools.begin(), m_linearMemPools.end(), accumulate);
+	std::for_each(m_optimalMemPools.begin(), m_optimalMemPools.end(), accumulate);
 
-	m_bufferMemPool[typeIndex].bindingList.push_back(key);
-	return true;
+	stats.fragmentation = freeBytes == 0 ? 0 : 1.0 - (double)stats.largestFreeRange / freeBytes;
+
+	stats.totalAllocations = m_totalAllocations;
+	stats.totalFrees = m_totalFrees;
+	stats.allocationTime = m_allocationTime;
+	stats.freeTime = m_freeTime;
+
+	return stats;
 }
 
 void DeviceMemoryManager::ReleaseMemory()
 {
-	std::for_each(m_bufferMemPool.begin(), m_bufferMemPool.end(), [this](MemoryNode& node)
+	auto releasePool = [this](MemoryPool& pool)
 	{
-		vkFreeMemory(GetDevice()->GetDeviceHandle(), node.memory, nullptr);
-	});
+		for (auto & pBlock : pool.blocks)
+			vkFreeMemory(GetDevice()->GetDeviceHandle(), pBlock->memory, nullptr);
+		pool.blocks.clear();
+	};
+
+	std::for_each(m_linearMemPools.begin(), m_linearMemPools.end(), releasePool);
+	std::for_each(m_optimalMemPools.begin(), m_optimalMemPools.end(), releasePool);
 }
 
 void* DeviceMemoryManager::GetDataPtr(const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset, uint32_t numBytes)
 {
-	return m_bufferBindingTable[m_bufferBindingLookupTable[pMemKey->m_key].first].first.pData;
+	return m_bindingTable[pMemKey->m_key].pData;
 }
\ No newline at end of file
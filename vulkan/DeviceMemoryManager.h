@@ -3,6 +3,7 @@
 #include "DeviceObjectBase.h"
 #include <map>
 #include <unordered_map>
+#include "TLSFAllocator.h"
 
 class Buffer;
 class Image;
@@ -19,7 +20,6 @@ private:
 private:
 	uint32_t		m_key;
 	bool			m_bufferOrImage;		//true: buffer, false: image
-	static uint32_t m_allocatedKeys;
 
 	std::shared_ptr<DeviceMemoryManager>	m_pDeviceMemMgr;
 
@@ -28,26 +28,57 @@ private:
 
 class DeviceMemoryManager : public DeviceObjectBase<DeviceMemoryManager>
 {
-	typedef struct _MemoryNode
+	// One VkDeviceMemory, sub allocated with TLSF
+	typedef struct _MemoryBlock
 	{
-		uint32_t				numBytes = 0;
-		VkDeviceMemory			memory;
-		void*					pData = nullptr;
-		std::vector<uint32_t>	bindingList;
-		uint32_t				memProperty = 0;
-	}MemoryNode;
+		VkDeviceMemory					memory = 0;
+		void*							pData = nullptr;
+		uint32_t						numBytes = 0;
+		std::shared_ptr<TLSFAllocator>	pAllocator;
+	}MemoryBlock;
+
+	// All blocks of one memory type, buffers and images use different pools
+	typedef struct _MemoryPool
+	{
+		// Property flags of the memory type
+		uint32_t									memProperty = 0;
+		std::vector<std::shared_ptr<MemoryBlock>>	blocks;
+	}MemoryPool;
 
 	typedef struct _BindingInfo
 	{
-		uint32_t	typeIndex;
-		uint32_t	startByte = 0;
-		uint32_t	numBytes = 0;
-		void*		pData = nullptr;
+		std::shared_ptr<MemoryBlock>	pBlock;
+		uint32_t						allocationHandle = TLSFAllocator::INVALID_HANDLE;
+		uint32_t						typeIndex = 0;
+		bool							isLinear = true;
+		uint32_t						startByte = 0;
+		uint32_t						numBytes = 0;
+		void*							pData = nullptr;
+		bool							isFreed = true;
 	}BindingInfo;
 
 public:
 	static const uint32_t DEVICE_MEMORY_ALLOCATE_INC = 1024 * 1024 * 512;
 	static const uint32_t STAGING_MEMORY_ALLOCATE_INC = 1024 * 1024 * 256;
+	static const uint32_t IMAGE_MEMORY_ALLOCATE_INC = 1024 * 1024 * 256;
+
+	typedef struct _MemoryStatistics
+	{
+		uint32_t	blockCount = 0;
+		uint64_t	reservedBytes = 0;
+		uint64_t	usedBytes = 0;
+		uint32_t	allocationCount = 0;
+		uint32_t	freeRangeCount = 0;
+		uint32_t	largestFreeRange = 0;
+		// 0 means free bytes are in one piece, closer to 1 means they're scattered
+		double		fragmentation = 0;
+
+		// Accumulated since created, for throughput
+		uint64_t	totalAllocations = 0;
+		uint64_t	totalFrees = 0;
+		double		allocationTime = 0;
+		double		freeTime = 0;
+	}MemoryStatistics;
 
 public:
 	~DeviceMemoryManager();
@@ -58,35 +89,44 @@ public:
 	static std::shared_ptr<DeviceMemoryManager> Create(const std::shared_ptr<Device>& pDevice);
 	std::shared_ptr<MemoryKey> AllocateBufferMemChunk(const std::shared_ptr<Buffer>& pBuffer, uint32_t memoryPropertyBits, const void* pData = nullptr);
 	std::shared_ptr<MemoryKey> AllocateImageMemChunk(const std::shared_ptr<Image>& pImage, uint32_t memoryPropertyBits, const void* pData = nullptr);
+	// Memory chunk for optimal images not created yet, several images could be bound into it at different offsets and alias each other
+	std::shared_ptr<MemoryKey> AllocateImageMemChunk(const VkMemoryRequirements& reqs, uint32_t memoryPropertyBits);
+	void BindImageMemChunk(const std::shared_ptr<Image>& pImage, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset);
 	bool UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	bool UpdateImageMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	void* GetDataPtr(const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset, uint32_t numBytes);
 
-protected:
-	void AllocateBufferMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset);
-	bool FindFreeBufferMemoryChunk(uint32_t key, uint32_t typeIndex, uint32_t numBytes, uint32_t& offset);
-	void FreeBufferMemChunk(uint32_t key);
-
-	void AllocateImageMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset);
-	void FreeImageMemChunk(uint32_t key);
+	// Release blocks that don't hold any allocation anymore, except the first one of each pool, and shrink bookkeeping tables
+	// Live allocations are not moved, since buffers and images can't be rebound to other memory once bound
+	uint32_t Defragment();
 
-	void UpdateMemoryChunk(VkDeviceMemory memory, uint32_t offset, uint32_t numBytes, void* pDst, const void* pData);
-	void ReleaseMemory();
+	MemoryStatistics GetStatistics() const;
 
 protected:
-	std::vector<MemoryNode>						m_bufferMemPool;
-	std::vector<MemoryNode>						m_imageMemPool;
-	std::vector<std::pair<BindingInfo, bool>>	m_bufferBindingTable;	// bool stands for whether it's freed
+	uint32_t AcquireKey();
+	void ReleaseKey(uint32_t key);
 
-	// uint32_t stands for actual image mem pool index
-	// bool stands for whether it's freed
-	std::vector<std::pair<uint32_t, bool>>		m_imageMemPoolLookupTable;
+	uint32_t FindMemoryType(uint32_t memoryTypeBits, uint32_t memoryPropertyBits) const;
+	void AllocateMemory(uint32_t key, const VkMemoryRequirements& reqs, uint32_t memoryPropertyBits, bool isLinear);
+	std::shared_ptr<MemoryBlock> CreateMemoryBlock(uint32_t typeIndex, uint32_t numBytes);
+	void FreeMemChunk(uint32_t key);
 
-	// uint32_t stands for actual buffer binding table index
-	// bool stands for whether it's freed
-	std::vector<std::pair<uint32_t, bool>>		m_bufferBindingLookupTable;
+	void UpdateMemoryChunk(uint32_t offset, uint32_t numBytes, void* pDst, const void* pData);
+	void ReleaseMemory();
 
-	static const uint32_t						LOOKUP_TABLE_SIZE_INC = 256;
+protected:
+	// Indexed by memory type index
+	std::vector<MemoryPool>						m_linearMemPools;	// Buffers and linear images
+	std::vector<MemoryPool>						m_optimalMemPools;	// Optimal tiling images
+
+	// Indexed by key, keys are recycled so this doesn't grow beyond peak allocation count
+	std::vector<BindingInfo>					m_bindingTable;
+	std::vector<uint32_t>						m_freeKeys;
+
+	uint64_t									m_totalAllocations = 0;
+	uint64_t									m_totalFrees = 0;
+	double										m_allocationTime = 0;
+	double										m_freeTime = 0;
 
 	friend class MemoryKey;
 };
\ No newline at end of file
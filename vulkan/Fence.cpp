@@ -34,6 +34,15 @@ void Fence::Wait()
 	m_signaled = true;
 }
 
+bool Fence::CheckSignaled()
+{
+	if (m_signaled)
+		return true;
+
+	m_signaled = vkGetFenceStatus(GetDevice()->GetDeviceHandle(), m_fence) == VK_SUCCESS;
+	return m_signaled;
+}
+
 void Fence::Reset()
 {
 	if (!m_signaled)
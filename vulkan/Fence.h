@@ -14,6 +14,8 @@ public:
 public:
 	VkFence GetDeviceHandle() const { return m_fence; }
 	bool Signaled() const { return m_signaled; }
+	// Non-blocking, query device for fence status if it's not known to be signaled yet
+	bool CheckSignaled();
 	void Reset();
 	void Wait();
 
@@ -141,12 +141,13 @@ void FrameManager::CacheSubmissioninfoInternal(
 	std::vector<std::shared_ptr<Semaphore>> _waitSemaphores = waitSemaphores;
 	_waitSemaphores.push_back(GetAcqurieDoneSemaphore());
 
-	std::vector<VkPipelineStageFlags> _waitStages;
+	// Stages have to pair with semaphores one by one
+	std::vector<VkPipelineStageFlags> _waitStages = waitStages;
+	_waitStages.resize(waitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 	_waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
 	// Attach render done semaphores to signal list
 	std::vector<std::shared_ptr<Semaphore>> _signalSemaphores = signalSemaphores;
-	_signalSemaphores.insert(_signalSemaphores.end(), signalSemaphores.begin(), signalSemaphores.end());
 	_signalSemaphores.push_back(GetRenderDoneSemaphore());
 
 	SubmissionInfo info = 
@@ -196,6 +197,28 @@ void FrameManager::WaitForGPUWork(uint32_t frameIndex)
 {
 	WaitForFence(frameIndex);
 	m_submissionInfoTable[frameIndex].clear();
+
+	// A retired resource is released once every frame has been waited after it's retired
+	for (uint32_t i = 0; i < (uint32_t)m_retiredResources.size();)
+	{
+		m_retiredResources[i].second &= ~(1 << frameIndex);
+		if (m_retiredResources[i].second == 0)
+		{
+			m_retiredResources[i] = m_retiredResources.back();
+			m_retiredResources.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+void FrameManager::RetireResource(const std::shared_ptr<Base>& pResource)
+{
+	if (pResource == nullptr)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_retiredResources.push_back({ pResource, (1 << m_maxFrameCount) - 1 });
 }
 
 // End work submission, which means that current frame's work has been submitted completely
@@ -58,6 +58,9 @@ public:
 
 	void WaitForAllJobsDone();
 
+	// Keeps a resource alive until GPU work of every frame in flight is done, for resources replaced while frames could still be using them
+	void RetireResource(const std::shared_ptr<Base>& pResource);
+
 protected:
 	bool Init(const std::shared_ptr<Device>& pDevice, uint32_t maxFrameCount, const std::shared_ptr<FrameManager>& pSelf);
 	static std::shared_ptr<FrameManager> Create(const std::shared_ptr<Device>& pDevice, uint32_t maxFrameCount);
@@ -100,6 +103,9 @@ private:
 	SubmissionInfoTable						m_pendingSubmissionInfoTable;
 	SubmissionInfoTable						m_submissionInfoTable;
 
+	// Retired resources, and frames they're still waiting for as bits
+	std::vector<std::pair<std::shared_ptr<Base>, uint32_t>>	m_retiredResources;
+
 	uint32_t m_maxFrameCount;
 
 	std::mutex										m_mutex;
@@ -13,13 +13,19 @@
 #include "GlobalVulkanStates.h"
 #include "PhysicalDevice.h"
 #include "PerFrameResource.h"
+#include "PipelineCache.h"
+#include "../Base/TransformHierarchy.h"
+
+static const char* PIPELINE_CACHE_PATH = "../data/pipeline_cache.bin";
 
 bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 {
 	m_pDevice = pDevice;
 
 	m_pGraphicQueue = Queue::Create(pDevice, pDevice->GetPhysicalDevice()->GetGraphicQueueIndex());
-	m_pPresentQueue = Queue::Create(pDevice, pDevice->GetPhysicalDevice()->GetPresentQueueIndex());
+	// Only one queue is created for graphic family, present goes through it as well
+	m_pPresentQueue = Queue::Create(pDevice, pDevice->GetPhysicalDevice()->GetGraphicQueueIndex());
+	m_pTransferQueue = Queue::Create(pDevice, pDevice->GetPhysicalDevice()->GetTransferQueueIndex());
 
 	m_pMainThreadCmdPool = CommandPool::Create(pDevice);
 
@@ -44,7 +50,7 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 		SHADER_STORAGE_BUFFER_SIZE);
 
 	m_pIndirectBufferMgr = SharedBufferManager::Create(pDevice, 
-		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
 		(VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
 		INDIRECT_BUFFER_SIZE);
 
@@ -55,13 +61,17 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 
 	m_pSwapChain = SwapChain::Create(pDevice);
 
-	m_pThreadTaskQueue = std::make_shared<ThreadTaskQueue>(pDevice, FrameMgr()->MaxFrameCount(), FrameMgr());
+	m_pThreadTaskQueue = std::make_shared<ThreadTaskQueue>(FrameMgr()->MaxFrameCount(), [](uint32_t frameIndex) { return FrameMgr()->AllocatePerFrameResource(frameIndex); });
+	TransformHierarchy::GetInstance()->SetTaskQueue(m_pThreadTaskQueue);
 
 	m_pGlobalVulkanStates = GlobalVulkanStates::Create(pDevice);
 
 	for (uint32_t i = 0; i < m_pSwapChain->GetSwapChainImageCount(); i++)
 		m_mainThreadPerFrameRes.push_back(FrameMgr()->AllocatePerFrameResource(i));
 
+	// Pipelines are created all over the place, even before scene setup, so cache goes with other global objects
+	m_pPipelineCache = PipelineCache::Create(pDevice, PIPELINE_CACHE_PATH);
+
 	return true;
 }
 
@@ -89,14 +99,16 @@ const std::shared_ptr<PerFrameResource> GlobalDeviceObjects::GetMainThreadPerFra
 
 const std::shared_ptr<SharedBufferManager> GlobalDeviceObjects::GetVertexAttribBufferMgr(uint32_t vertexFormat) 
 { 
+	// Storage usage lets compute shaders read and write vertices in place, e.g. skinning
 	if (m_vertexAttribBufferMgrs.find(vertexFormat) == m_vertexAttribBufferMgrs.end())
-		m_vertexAttribBufferMgrs[vertexFormat] = SharedBufferManager::Create(m_pDevice, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ATTRIBUTE_BUFFER_SIZE);
+		m_vertexAttribBufferMgrs[vertexFormat] = SharedBufferManager::Create(m_pDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ATTRIBUTE_BUFFER_SIZE);
 
 	return m_vertexAttribBufferMgrs[vertexFormat];
 }
 
 std::shared_ptr<Queue> GlobalGraphicQueue() { return GlobalObjects()->GetGraphicQueue(); }
 std::shared_ptr<Queue> GlobalPresentQueue() { return GlobalObjects()->GetPresentQueue(); }
+std::shared_ptr<Queue> GlobalTransferQueue() { return GlobalObjects()->GetTransferQueue(); }
 std::shared_ptr<CommandPool> MainThreadPool() { return GlobalObjects()->GetMainThreadCmdPool(); }
 std::shared_ptr<DeviceMemoryManager> DeviceMemMgr() { return GlobalObjects()->GetDeviceMemMgr(); }
 std::shared_ptr<StagingBufferManager> StagingBufferMgr() { return GlobalObjects()->GetStagingBufferMgr(); }
@@ -113,4 +125,5 @@ std::shared_ptr<SharedBufferManager> IndirectBufferMgr() { return GlobalObjects(
 std::shared_ptr<SharedBufferManager> StreamingBufferMgr() { return GlobalObjects()->GetStreamingBufferMgr(); }
 std::shared_ptr<ThreadTaskQueue> GlobalThreadTaskQueue() { return GlobalObjects()->GetThreadTaskQueue(); }
 std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates() { return GlobalObjects()->GetGlobalVulkanStates(); }
-std::shared_ptr<PerFrameResource> MainThreadPerFrameRes() { return GlobalObjects()->GetMainThreadPerFrameRes(); }
\ No newline at end of file
+std::shared_ptr<PerFrameResource> MainThreadPerFrameRes() { return GlobalObjects()->GetMainThreadPerFrameRes(); }
+std::shared_ptr<PipelineCache> GlobalPipelineCache() { return GlobalObjects()->GetPipelineCache(); }
\ No newline at end of file
@@ -18,12 +18,14 @@ class ThreadTaskQueue;
 class GlobalVulkanStates;
 class PerFrameResource;
 class RenderPass;
+class PipelineCache;
 
 class GlobalDeviceObjects;
 
 GlobalDeviceObjects* GlobalObjects();
 std::shared_ptr<Queue> GlobalGraphicQueue();
 std::shared_ptr<Queue> GlobalPresentQueue();
+std::shared_ptr<Queue> GlobalTransferQueue();
 std::shared_ptr<CommandPool> MainThreadPool();
 std::shared_ptr<DeviceMemoryManager> DeviceMemMgr();
 std::shared_ptr<StagingBufferManager> StagingBufferMgr();
@@ -40,6 +42,7 @@ std::shared_ptr<SharedBufferManager> StreamingBufferMgr();
 std::shared_ptr<ThreadTaskQueue> GlobalThreadTaskQueue();
 std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates();
 std::shared_ptr<PerFrameResource> MainThreadPerFrameRes();
+std::shared_ptr<PipelineCache> GlobalPipelineCache();
 
 class GlobalDeviceObjects : public Singleton<GlobalDeviceObjects>
 {
@@ -52,6 +55,7 @@ public:
 	const std::shared_ptr<Device> GetDevice() const { return m_pDevice; }
 	const std::shared_ptr<Queue> GetGraphicQueue() const { return m_pGraphicQueue; }
 	const std::shared_ptr<Queue> GetPresentQueue() const { return m_pPresentQueue; }
+	const std::shared_ptr<Queue> GetTransferQueue() const { return m_pTransferQueue; }
 	const std::shared_ptr<CommandPool> GetMainThreadCmdPool() const { return m_pMainThreadCmdPool; }
 	const std::shared_ptr<DeviceMemoryManager> GetDeviceMemMgr() const { return m_pDeviceMemMgr; }
 	const std::shared_ptr<StagingBufferManager> GetStagingBufferMgr() const { return m_pStaingBufferMgr; }
@@ -65,6 +69,7 @@ public:
 	const std::shared_ptr<ThreadTaskQueue> GetThreadTaskQueue() const { return m_pThreadTaskQueue; }
 	const std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates() const { return m_pGlobalVulkanStates; }
 	const std::shared_ptr<PerFrameResource> GetMainThreadPerFrameRes() const;
+	const std::shared_ptr<PipelineCache> GetPipelineCache() const { return m_pPipelineCache; }
 
 	//FIXME : remove me
 	bool RequestAttributeBuffer(uint32_t size, uint32_t& offset);
@@ -73,6 +78,7 @@ protected:
 	std::shared_ptr<Device>					m_pDevice;
 	std::shared_ptr<Queue>					m_pGraphicQueue;
 	std::shared_ptr<Queue>					m_pPresentQueue;
+	std::shared_ptr<Queue>					m_pTransferQueue;
 	std::shared_ptr<CommandPool>			m_pMainThreadCmdPool;
 	std::shared_ptr<DeviceMemoryManager>	m_pDeviceMemMgr;
 
@@ -95,6 +101,8 @@ protected:
 
 	std::vector<std::shared_ptr<PerFrameResource>> m_mainThreadPerFrameRes;
 
+	std::shared_ptr<PipelineCache>			m_pPipelineCache;
+
 	static const uint32_t ATTRIBUTE_BUFFER_SIZE = 1024 * 1024 * 64;
 	static const uint32_t INDEX_BUFFER_SIZE = 1024 * 1024 * 4;
 	static const uint32_t UNIFORM_BUFFER_SIZE = 1024 * 512;
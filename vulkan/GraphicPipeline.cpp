@@ -2,11 +2,14 @@
 #include "PipelineLayout.h"
 #include "RenderPass.h"
 #include "ShaderModule.h"
+#include "PipelineCache.h"
+#include "GlobalDeviceObjects.h"
 #include <fstream>
 
 GraphicPipeline::~GraphicPipeline()
 {
-	vkDestroyPipeline(GetDevice()->GetDeviceHandle(), m_pipeline, nullptr);
+	if (m_pipeline)
+		vkDestroyPipeline(GetDevice()->GetDeviceHandle(), m_pipeline, nullptr);
 
 	for (uint32_t i = 0; i < m_shaderStageInfo.size(); i++)
 		delete[] m_shaderStageInfo[i].pName;
@@ -33,6 +36,12 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 	m_info.pInputAssemblyState = &m_assemblyCreateInfo;
 
 	m_multiSampleCreateInfo = *m_info.pMultisampleState;
+	if (m_multiSampleCreateInfo.pSampleMask != nullptr)
+	{
+		// One mask bit per sample
+		m_sampleMask.assign(m_multiSampleCreateInfo.pSampleMask, m_multiSampleCreateInfo.pSampleMask + ((uint32_t)m_multiSampleCreateInfo.rasterizationSamples + 31) / 32);
+		m_multiSampleCreateInfo.pSampleMask = m_sampleMask.data();
+	}
 	m_info.pMultisampleState = &m_multiSampleCreateInfo;
 
 	m_rasterizerCreateInfo = *m_info.pRasterizationState;
@@ -44,6 +53,7 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 	m_viewportStateCreateInfo.pScissors = nullptr;
 	m_viewportStateCreateInfo.scissorCount = 1;
 	m_viewportStateCreateInfo.pViewports = nullptr;
+	m_info.pViewportState = &m_viewportStateCreateInfo;
 
 	m_dynamicStates =
 	{
@@ -51,14 +61,21 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 		VK_DYNAMIC_STATE_SCISSOR
 	};
 
-	m_dynamicStatesCreateInfo = *m_info.pDynamicState;
+	if (m_info.pDynamicState != nullptr)
+		m_dynamicStatesCreateInfo = *m_info.pDynamicState;
+	else
+		m_dynamicStatesCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
 	m_dynamicStatesCreateInfo.dynamicStateCount = (uint32_t)m_dynamicStates.size();
 	m_dynamicStatesCreateInfo.pDynamicStates = m_dynamicStates.data();
 	m_info.pDynamicState = &m_dynamicStatesCreateInfo;
 
+	// Entry names are allocated by "Create" and released by destructor, specialization data isn't copied so it's not supported
 	m_shaderStageInfo.resize(m_info.stageCount);
 	for (uint32_t i = 0; i < m_info.stageCount; i++)
+	{
+		ASSERTION(m_info.pStages[i].pSpecializationInfo == nullptr);
 		m_shaderStageInfo[i] = m_info.pStages[i];
+	}
 	m_info.pStages = m_shaderStageInfo.data();
 
 	m_vertexBindingsInfo.resize(m_info.pVertexInputState->vertexBindingDescriptionCount);
@@ -74,7 +91,29 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 	m_vertexInputCreateInfo.pVertexAttributeDescriptions = m_vertexAttributesInfo.data();
 	m_info.pVertexInputState = &m_vertexInputCreateInfo;
 
-	CHECK_VK_ERROR(vkCreateGraphicsPipelines(m_pDevice->GetDeviceHandle(), 0, 1, &m_info, nullptr, &m_pipeline));
+	if (m_info.pTessellationState != nullptr)
+	{
+		m_tessellationCreateInfo = *m_info.pTessellationState;
+		m_info.pTessellationState = &m_tessellationCreateInfo;
+	}
+
+	// Extension structures aren't copied, so none of them is allowed to outlive caller's stack
+	ASSERTION(m_info.pNext == nullptr);
+	ASSERTION(m_blendCreateInfo.pNext == nullptr && m_depthStencilCreateInfo.pNext == nullptr && m_assemblyCreateInfo.pNext == nullptr);
+	ASSERTION(m_multiSampleCreateInfo.pNext == nullptr && m_rasterizerCreateInfo.pNext == nullptr && m_viewportStateCreateInfo.pNext == nullptr);
+	ASSERTION(m_dynamicStatesCreateInfo.pNext == nullptr && m_vertexInputCreateInfo.pNext == nullptr);
+
+	// Pipeline cache could defer compiling to a batch, everything "m_info" points to is owned by this object from now on
+	std::shared_ptr<GraphicPipeline> pPipeline = pSelf;
+	PipelineCache::CompileFunc compileFunc = [pPipeline](VkPipelineCache pipelineCache)
+	{
+		CHECK_VK_ERROR(vkCreateGraphicsPipelines(pPipeline->GetDevice()->GetDeviceHandle(), pipelineCache, 1, &pPipeline->m_info, nullptr, &pPipeline->m_pipeline));
+	};
+
+	if (GlobalPipelineCache() != nullptr)
+		GlobalPipelineCache()->Compile(compileFunc);
+	else
+		compileFunc(VK_NULL_HANDLE);
 
 	return true;
 }
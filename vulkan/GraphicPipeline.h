@@ -54,13 +54,14 @@ private:
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<GraphicPipeline>& pSelf, const VkGraphicsPipelineCreateInfo& info);
 
 protected:
-	VkPipeline						m_pipeline;
+	VkPipeline						m_pipeline = VK_NULL_HANDLE;
 
 	std::vector<VkPipelineColorBlendAttachmentState>	m_blendStatesInfo;
 	std::vector<VkDynamicState>							m_dynamicStates;
 	std::vector<VkVertexInputBindingDescription>		m_vertexBindingsInfo;
 	std::vector<VkVertexInputAttributeDescription>		m_vertexAttributesInfo;
 	std::vector<VkPipelineShaderStageCreateInfo>		m_shaderStageInfo;
+	std::vector<VkSampleMask>							m_sampleMask;
 
 	VkPipelineColorBlendStateCreateInfo					m_blendCreateInfo;
 	VkPipelineDepthStencilStateCreateInfo				m_depthStencilCreateInfo;
@@ -69,6 +70,7 @@ protected:
 	VkPipelineRasterizationStateCreateInfo				m_rasterizerCreateInfo;
 	VkPipelineViewportStateCreateInfo					m_viewportStateCreateInfo;
 	VkPipelineDynamicStateCreateInfo					m_dynamicStatesCreateInfo;
+	VkPipelineTessellationStateCreateInfo				m_tessellationCreateInfo;
 	VkPipelineVertexInputStateCreateInfo				m_vertexInputCreateInfo;
 	VkGraphicsPipelineCreateInfo						m_info;
 
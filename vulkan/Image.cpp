@@ -17,6 +17,11 @@ Image::~Image()
 }
 
 bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const VkImageCreateInfo& info, uint32_t memoryPropertyFlag)
+{
+	return Init(pDevice, pSelf, info, memoryPropertyFlag, nullptr, 0);
+}
+
+bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const VkImageCreateInfo& info, uint32_t memoryPropertyFlag, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t memoryOffset)
 {
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
@@ -38,7 +43,13 @@ bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<I
 	m_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
 	CHECK_VK_ERROR(vkCreateImage(GetDevice()->GetDeviceHandle(), &m_info, nullptr, &m_image));
-	m_pMemKey = DeviceMemMgr()->AllocateImageMemChunk(GetSelfSharedPtr(), memoryPropertyFlag);
+	if (pMemKey != nullptr)
+	{
+		DeviceMemMgr()->BindImageMemChunk(GetSelfSharedPtr(), pMemKey, memoryOffset);
+		m_pMemKey = pMemKey;
+	}
+	else
+		m_pMemKey = DeviceMemMgr()->AllocateImageMemChunk(GetSelfSharedPtr(), memoryPropertyFlag);
 
 	m_info.initialLayout = layout;
 	m_memProperty = memoryPropertyFlag;
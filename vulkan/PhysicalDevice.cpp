@@ -80,6 +80,18 @@ bool PhysicalDevice::Init(const std::shared_ptr<Instance>& pVulkanInstance, HINS
 
 	ASSERTION(m_graphicQueueIndex != -1);
 
+	// A transfer only family usually maps to dedicated DMA engines, uploads through it run alongside graphics work
+	m_transferQueueIndex = -1;
+	for (uint32_t i = 0; i < m_queueProperties.size(); i++)
+	{
+		VkQueueFlags flags = m_queueProperties[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+		{
+			m_transferQueueIndex = i;
+			break;
+		}
+	}
+
 	GET_INSTANCE_PROC_ADDR(pVulkanInstance->GetDeviceHandle(), GetPhysicalDeviceSurfaceCapabilitiesKHR);
 	GET_INSTANCE_PROC_ADDR(pVulkanInstance->GetDeviceHandle(), GetPhysicalDeviceSurfaceFormatsKHR);
 	GET_INSTANCE_PROC_ADDR(pVulkanInstance->GetDeviceHandle(), GetPhysicalDeviceSurfacePresentModesKHR);
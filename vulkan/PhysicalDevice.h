@@ -27,6 +27,9 @@ public:
 
 	const uint32_t GetGraphicQueueIndex() const { return m_graphicQueueIndex; }
 	const uint32_t GetPresentQueueIndex() const { return m_presentQueueIndex; }
+	// Falls back to graphic queue family if there's no dedicated transfer family
+	const uint32_t GetTransferQueueIndex() const { return HasDedicatedTransferQueue() ? m_transferQueueIndex : m_graphicQueueIndex; }
+	bool HasDedicatedTransferQueue() const { return m_transferQueueIndex != -1; }
 
 	const VkSurfaceFormatKHR GetSurfaceFormat() const { return m_surfaceFormats[0]; }
 	const std::vector<VkPresentModeKHR>& GetPresentModes() const { return m_presentModes; }
@@ -46,6 +49,7 @@ private:
 	VkFormat							m_depthStencilFormat;
 
 	uint32_t							m_graphicQueueIndex;
+	uint32_t							m_transferQueueIndex;
 
 	//Surface related
 	VkSurfaceKHR						m_surface;
@@ -0,0 +1,223 @@
+#include "PipelineCache.h"
+#include "PhysicalDevice.h"
+#include "GlobalDeviceObjects.h"
+#include "FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <fstream>
+#include <chrono>
+#include <cstring>
+
+// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, see vkGetPipelineCacheData
+static const uint32_t PIPELINE_CACHE_HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+PipelineCache::~PipelineCache()
+{
+	vkDestroyPipelineCache(GetDevice()->GetDeviceHandle(), m_pipelineCache, nullptr);
+}
+
+bool PipelineCache::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PipelineCache>& pSelf, const std::string& path, const std::vector<uint8_t>& initialData)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	m_path = path;
+
+	std::vector<uint8_t> data = initialData;
+	if (data.size() == 0 && m_path.size() != 0)
+	{
+		std::ifstream ifs;
+		ifs.open(m_path, std::ios::binary);
+		if (!ifs.fail())
+			data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+
+	// Stale data is simply dropped, cache starts cold
+	if (!ValidateHeader(data))
+		data.clear();
+
+	m_statistics.isWarm = data.size() != 0;
+	m_statistics.loadedBytes = data.size();
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize = data.size();
+	info.pInitialData = data.size() != 0 ? data.data() : nullptr;
+	RETURN_FALSE_VK_RESULT(vkCreatePipelineCache(m_pDevice->GetDeviceHandle(), &info, nullptr, &m_pipelineCache));
+
+	return true;
+}
+
+std::shared_ptr<PipelineCache> PipelineCache::Create(const std::shared_ptr<Device>& pDevice, const std::string& path)
+{
+	std::shared_ptr<PipelineCache> pPipelineCache = std::make_shared<PipelineCache>();
+	if (pPipelineCache.get() && pPipelineCache->Init(pDevice, pPipelineCache, path, {}))
+		return pPipelineCache;
+	return nullptr;
+}
+
+std::shared_ptr<PipelineCache> PipelineCache::Create(const std::shared_ptr<Device>& pDevice, const std::vector<uint8_t>& initialData)
+{
+	std::shared_ptr<PipelineCache> pPipelineCache = std::make_shared<PipelineCache>();
+	if (pPipelineCache.get() && pPipelineCache->Init(pDevice, pPipelineCache, "", initialData))
+		return pPipelineCache;
+	return nullptr;
+}
+
+bool PipelineCache::ValidateHeader(const std::vector<uint8_t>& data) const
+{
+	if (data.size() < PIPELINE_CACHE_HEADER_SIZE)
+		return false;
+
+	uint32_t headerSize, headerVersion, vendorID, deviceID;
+	memcpy(&headerSize, &data[0], sizeof(uint32_t));
+	memcpy(&headerVersion, &data[4], sizeof(uint32_t));
+	memcpy(&vendorID, &data[8], sizeof(uint32_t));
+	memcpy(&deviceID, &data[12], sizeof(uint32_t));
+
+	const VkPhysicalDeviceProperties& props = GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceProperties();
+
+	if (headerSize < PIPELINE_CACHE_HEADER_SIZE || headerSize > data.size())
+		return false;
+	if (headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		return false;
+	if (vendorID != props.vendorID || deviceID != props.deviceID)
+		return false;
+
+	return memcmp(&data[16], props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::GetData(std::vector<uint8_t>& data) const
+{
+	size_t size = 0;
+	CHECK_VK_ERROR(vkGetPipelineCacheData(GetDevice()->GetDeviceHandle(), m_pipelineCache, &size, nullptr));
+
+	data.resize(size);
+	if (size != 0)
+		CHECK_VK_ERROR(vkGetPipelineCacheData(GetDevice()->GetDeviceHandle(), m_pipelineCache, &size, data.data()));
+	data.resize(size);
+}
+
+void PipelineCache::Merge(const std::vector<std::shared_ptr<PipelineCache>>& srcCaches)
+{
+	std::vector<VkPipelineCache> rawCaches;
+	for (auto& pCache : srcCaches)
+		rawCaches.push_back(pCache->GetDeviceHandle());
+
+	if (rawCaches.size() != 0)
+		CHECK_VK_ERROR(vkMergePipelineCaches(GetDevice()->GetDeviceHandle(), m_pipelineCache, (uint32_t)rawCaches.size(), rawCaches.data()));
+}
+
+bool PipelineCache::Save()
+{
+	if (m_path.size() == 0)
+		return false;
+
+	std::vector<uint8_t> data;
+	GetData(data);
+
+	std::ofstream ofs;
+	ofs.open(m_path, std::ios::binary | std::ios::trunc);
+	if (ofs.fail())
+		return false;
+
+	ofs.write((const char*)data.data(), data.size());
+	m_statistics.savedBytes = data.size();
+
+	return !ofs.fail();
+}
+
+void PipelineCache::BeginBatch()
+{
+	std::unique_lock<std::mutex> lock(m_batchMutex);
+	ASSERTION(!m_isBatching);
+	m_isBatching = true;
+}
+
+void PipelineCache::Compile(const CompileFunc& compileFunc)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_batchMutex);
+		if (m_isBatching)
+		{
+			m_batchedCompiles.push_back(compileFunc);
+			return;
+		}
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Pipeline cache is internally synchronized for pipeline creation
+	compileFunc(m_pipelineCache);
+
+	std::unique_lock<std::mutex> lock(m_batchMutex);
+	m_statistics.compiledPipelineCount++;
+	m_statistics.compileTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+void PipelineCache::EndBatch()
+{
+	std::vector<CompileFunc> compiles;
+	{
+		std::unique_lock<std::mutex> lock(m_batchMutex);
+		ASSERTION(m_isBatching);
+		m_isBatching = false;
+		compiles.swap(m_batchedCompiles);
+	}
+
+	uint32_t compileCount = (uint32_t)compiles.size();
+	if (compileCount == 0)
+		return;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	uint32_t threadCount = GlobalThreadTaskQueue()->GetWorkerCount() + 1;
+	threadCount = compileCount < threadCount ? compileCount : threadCount;
+
+	if (threadCount == 1)
+	{
+		for (auto& compileFunc : compiles)
+			compileFunc(m_pipelineCache);
+	}
+	else
+	{
+		// Each thread compiles into its own cache, seeded with what's already here so that warm start still hits
+		std::vector<uint8_t> data;
+		GetData(data);
+
+		std::vector<std::shared_ptr<PipelineCache>> threadCaches;
+		for (uint32_t i = 0; i < threadCount; i++)
+			threadCaches.push_back(PipelineCache::Create(GetDevice(), data));
+
+		std::atomic<uint32_t> nextCompile = { 0 };
+		auto compilePipelines = [&nextCompile, &compiles, compileCount](const std::shared_ptr<PipelineCache>& pThreadCache)
+		{
+			uint32_t index;
+			while ((index = nextCompile++) < compileCount)
+				compiles[index](pThreadCache->GetDeviceHandle());
+		};
+
+		JobCounter counter;
+		for (uint32_t i = 1; i < threadCount; i++)
+		{
+			std::shared_ptr<PipelineCache> pThreadCache = threadCaches[i];
+			GlobalThreadTaskQueue()->AddJob([&compilePipelines, pThreadCache](const std::shared_ptr<PerFrameResource>&) { compilePipelines(pThreadCache); }, FrameMgr()->FrameIndex(), &counter);
+		}
+
+		// Calling thread takes its share too
+		compilePipelines(threadCaches[0]);
+
+		GlobalThreadTaskQueue()->WaitForCounter(counter);
+
+		Merge(threadCaches);
+	}
+
+	m_statistics.compiledPipelineCount += compileCount;
+	m_statistics.batchCount++;
+	m_statistics.compileTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+PipelineCache::PipelineCacheStatistics PipelineCache::GetStatistics() const
+{
+	std::unique_lock<std::mutex> lock(m_batchMutex);
+	return m_statistics;
+}
\ No newline at end of file
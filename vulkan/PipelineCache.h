@@ -0,0 +1,64 @@
+#pragma once
+
+#include "DeviceObjectBase.h"
+#include <functional>
+#include <mutex>
+
+// Pipeline cache persisted to disk, so that pipelines compiled by last run don't have to be compiled again
+// Data is only loaded when its header matches current device, a driver update or a different GPU starts with an empty cache
+// Pipelines could be compiled in a batch across worker threads, each thread compiles into its own cache, and they're merged afterwards
+class PipelineCache : public DeviceObjectBase<PipelineCache>
+{
+public:
+	typedef std::function<void(VkPipelineCache pipelineCache)> CompileFunc;
+
+	typedef struct _PipelineCacheStatistics
+	{
+		// Whether valid data is loaded from disk, i.e. a warm start
+		bool		isWarm = false;
+		uint64_t	loadedBytes = 0;
+		uint64_t	savedBytes = 0;
+
+		uint32_t	compiledPipelineCount = 0;
+		uint32_t	batchCount = 0;
+		// Milliseconds spent on compiling pipelines, which is what differs between cold and warm starts
+		double		compileTime = 0;
+	}PipelineCacheStatistics;
+
+public:
+	~PipelineCache();
+
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PipelineCache>& pSelf, const std::string& path, const std::vector<uint8_t>& initialData);
+
+	// Empty path means cache lives in memory only
+	static std::shared_ptr<PipelineCache> Create(const std::shared_ptr<Device>& pDevice, const std::string& path = "");
+	static std::shared_ptr<PipelineCache> Create(const std::shared_ptr<Device>& pDevice, const std::vector<uint8_t>& initialData);
+
+public:
+	VkPipelineCache GetDeviceHandle() const { return m_pipelineCache; }
+
+	void GetData(std::vector<uint8_t>& data) const;
+	void Merge(const std::vector<std::shared_ptr<PipelineCache>>& srcCaches);
+	bool Save();
+
+	// Pipelines compiled between "BeginBatch" and "EndBatch" are deferred, and compiled together in "EndBatch" across worker threads
+	// Objects compiled in a batch can't be used before "EndBatch"
+	void BeginBatch();
+	void Compile(const CompileFunc& compileFunc);
+	void EndBatch();
+
+	PipelineCacheStatistics GetStatistics() const;
+
+protected:
+	bool ValidateHeader(const std::vector<uint8_t>& data) const;
+
+protected:
+	VkPipelineCache					m_pipelineCache = VK_NULL_HANDLE;
+	std::string						m_path;
+
+	bool							m_isBatching = false;
+	std::vector<CompileFunc>		m_batchedCompiles;
+	mutable std::mutex				m_batchMutex;
+
+	PipelineCacheStatistics			m_statistics;
+};
\ No newline at end of file
@@ -15,7 +15,8 @@ bool Queue::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Q
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
-	vkGetDeviceQueue(pDevice->GetDeviceHandle(), pDevice->GetPhysicalDevice()->GetGraphicQueueIndex(), 0, &m_queue);
+	m_queueFamilyIndex = queueIndex;
+	vkGetDeviceQueue(pDevice->GetDeviceHandle(), m_queueFamilyIndex, 0, &m_queue);
 	return true;
 }
 
@@ -65,7 +66,7 @@ void Queue::SubmitPerFrameCommandBuffers(
 	const std::vector<VkPipelineStageFlags>& waitStages,
 	bool waitUtilQueueIdle)
 {
-	SubmitPerFrameCommandBuffers(cmdBuffers, std::vector<std::shared_ptr<Semaphore>>(), std::vector<VkPipelineStageFlags>(), std::vector<std::shared_ptr<Semaphore>>(), waitUtilQueueIdle);
+	SubmitPerFrameCommandBuffers(cmdBuffers, waitSemaphores, waitStages, std::vector<std::shared_ptr<Semaphore>>(), waitUtilQueueIdle);
 }
 
 void Queue::SubmitCommandBuffer(
@@ -86,7 +87,7 @@ void Queue::SubmitCommandBuffers(
 	const std::shared_ptr<Fence>& pFence,
 	bool waitUtilQueueIdle)
 {
-	SubmitCommandBuffers(cmdBuffers, std::vector<std::shared_ptr<Semaphore>>(), std::vector<VkPipelineStageFlags>(), std::vector<std::shared_ptr<Semaphore>>(), pFence, waitUtilQueueIdle);
+	SubmitCommandBuffers(cmdBuffers, waitSemaphores, waitStages, std::vector<std::shared_ptr<Semaphore>>(), pFence, waitUtilQueueIdle);
 }
 
 void Queue::SubmitPerFrameCommandBuffer(
@@ -15,6 +15,7 @@ public:
 
 public:
 	VkQueue GetDeviceHandle() { return m_queue; }
+	uint32_t GetQueueFamilyIndex() const { return m_queueFamilyIndex; }
 
 	void SubmitPerFrameCommandBuffer(const std::shared_ptr<CommandBuffer>& pCmdBuffer, bool waitUtilQueueIdle = false);
 	void SubmitPerFrameCommandBuffers(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers, bool waitUtilQueueIdle = false);
@@ -77,4 +78,5 @@ public:
 
 protected:
 	VkQueue		m_queue;
+	uint32_t	m_queueFamilyIndex;
 };
\ No newline at end of file
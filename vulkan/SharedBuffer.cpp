@@ -30,4 +30,13 @@ VkBuffer SharedBuffer::GetDeviceHandle() const
 void SharedBuffer::UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes)
 {
 	m_pBufferKey->GetSharedBufferMgr()->UpdateByteStream(pData, std::static_pointer_cast<SharedBuffer>(GetSelfSharedPtr()), m_pBufferKey, offset, numBytes);
+}
+
+void* SharedBuffer::GetMappedDataPtr() const
+{
+	char* pData = (char*)m_pBufferKey->GetSharedBufferMgr()->GetBuffer()->GetMappedDataPtr();
+	if (pData == nullptr)
+		return nullptr;
+
+	return pData + GetBufferOffset();
 }
\ No newline at end of file
@@ -12,6 +12,7 @@ public:
 	bool IsHostVisible() const override;
 	VkBuffer GetDeviceHandle() const override;
 	void UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes) override;
+	void* GetMappedDataPtr() const override;
 
 protected:
 	virtual std::shared_ptr<BufferKey>	AcquireBuffer(uint32_t numBytes) = 0;
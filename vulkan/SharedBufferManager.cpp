@@ -2,8 +2,8 @@
 #include "GlobalDeviceObjects.h"
 #include "StagingBufferManager.h"
 #include "SharedBuffer.h"
-
-uint32_t SharedBufferManager::m_numAllocatedKeys = 0;
+#include "CommandBuffer.h"
+#include "Queue.h"
 
 std::shared_ptr<BufferKey> BufferKey::Create(const std::shared_ptr<SharedBufferManager>& pSharedBufMgr, uint32_t key)
 {
@@ -29,121 +29,151 @@ bool SharedBufferManager::Init(const std::shared_ptr<Device>& pDevice,
 	const std::shared_ptr<SharedBufferManager>& pSelf,
 	VkBufferUsageFlags usage,
 	VkMemoryPropertyFlagBits memFlag,
-	uint32_t numBytes)
+	uint32_t numBytes,
+	bool allowGrowth)
 {
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
+	// Growing copies old content into the new buffer on device
+	if (allowGrowth)
+		usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
 	VkBufferCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	info.usage = usage;
 	info.size = numBytes;
 	m_pBuffer = Buffer::Create(pDevice, info, memFlag);
 
+	m_memFlag = memFlag;
+	m_allowGrowth = allowGrowth;
+	m_pAllocator = std::make_shared<TLSFAllocator>(numBytes);
+
 	return true;
 }
 
 std::shared_ptr<SharedBufferManager> SharedBufferManager::Create(const std::shared_ptr<Device>& pDevice,
 	VkBufferUsageFlags usage,
 	VkMemoryPropertyFlagBits memFlag,
-	uint32_t numBytes)
+	uint32_t numBytes,
+	bool allowGrowth)
 {
 	std::shared_ptr<SharedBufferManager> pSharedBufferManager = std::make_shared<SharedBufferManager>();
-	if (pSharedBufferManager.get() && pSharedBufferManager->Init(pDevice, pSharedBufferManager, usage, memFlag, numBytes))
+	if (pSharedBufferManager.get() && pSharedBufferManager->Init(pDevice, pSharedBufferManager, usage, memFlag, numBytes, allowGrowth))
 		return pSharedBufferManager;
 	return nullptr;
 }
 
-void SharedBufferManager::FreeBuffer(uint32_t index)
+void SharedBufferManager::FreeBuffer(uint32_t key)
 {
-	uint32_t bufferChunkIndex = m_lookupTable[index];
-	m_lookupTable.erase(index);
-	m_bufferTable.erase(m_bufferTable.begin() + bufferChunkIndex);
-
-	// Update lookup table since one record is removed, all records after it must be decreased
-	for (auto& value : m_lookupTable)
-	{
-		if (value.second > bufferChunkIndex)
-			value.second--;
-	}
+	m_pAllocator->Free(m_bufferTable[key].allocationHandle);
+	m_bufferTable[key].allocationHandle = TLSFAllocator::INVALID_HANDLE;
+	m_freeKeys.push_back(key);
 }
 
 std::shared_ptr<BufferKey> SharedBufferManager::AllocateBuffer(uint32_t numBytes)
 {
-	VkDescriptorBufferInfo info = {};
-	info.buffer = GetBuffer()->GetDeviceHandle();
-	uint32_t offset = 0;
-	uint32_t endByte = 0;
+	// Chunks are packed without extra alignment, same as before, users pad their sizes to what they need
+	uint32_t offset, allocationHandle;
+	if (!m_pAllocator->Allocate(numBytes, 1, offset, allocationHandle))
+	{
+		if (!GrowBuffer(numBytes) || !m_pAllocator->Allocate(numBytes, 1, offset, allocationHandle))
+			return nullptr;
+	}
 
-	for (uint32_t i = 0; i < m_bufferTable.size(); i++)
+	uint32_t key;
+	if (!m_freeKeys.empty())
+	{
+		key = m_freeKeys.back();
+		m_freeKeys.pop_back();
+	}
+	else
 	{
-		endByte = offset + numBytes - 1;
-		if (endByte < m_bufferTable[i].offset)
-		{
-			// Update lookup table since one record is inserted, all records after it must be increased
-			for (auto& value : m_lookupTable)
-			{
-				if (value.second >= i)
-					value.second++;
-			}
-
-			// Insert buffer chunk
-			info.offset = offset;
-			info.range = numBytes;
-			m_bufferTable.insert(m_bufferTable.begin() + i, info);
-
-			// Update lookup table
-			m_lookupTable[m_numAllocatedKeys] = i;
-
-			// Generate BufferKey
-			return BufferKey::Create(GetSelfSharedPtr(), m_numAllocatedKeys++);
-		}
-		else
-		{
-			offset = (uint32_t)m_bufferTable[i].offset + (uint32_t)m_bufferTable[i].range;
-		}
+		key = (uint32_t)m_bufferTable.size();
+		m_bufferTable.push_back({});
 	}
 
-	if (offset + numBytes > m_pBuffer->GetBufferInfo().size)
-		return nullptr;
+	m_bufferTable[key] = { offset, numBytes, allocationHandle };
 
-	// Insert buffer chunk
-	info.offset = offset;
-	info.range = numBytes;
-	m_bufferTable.insert(m_bufferTable.end(), info);
+	return BufferKey::Create(GetSelfSharedPtr(), key);
+}
 
-	// Update lookup table
-	m_lookupTable[m_numAllocatedKeys] = (uint32_t)m_bufferTable.size() - 1;
+bool SharedBufferManager::GrowBuffer(uint32_t requiredBytes)
+{
+	if (!m_allowGrowth)
+		return false;
 
-	// Generate BufferKey
-	return BufferKey::Create(GetSelfSharedPtr(), m_numAllocatedKeys++);
+	uint32_t oldSize = m_pAllocator->GetSize();
+	uint64_t newSize = (uint64_t)oldSize * 2;
+	if (newSize < (uint64_t)oldSize + requiredBytes)
+		newSize = (uint64_t)oldSize + requiredBytes;
+	if (newSize > UINT32_MAX)
+		return false;
+
+	VkBufferCreateInfo info = m_pBuffer->GetBufferInfo();
+	info.size = newSize;
+	std::shared_ptr<Buffer> pNewBuffer = Buffer::Create(GetDevice(), info, m_memFlag);
+	if (pNewBuffer == nullptr)
+		return false;
+
+	// Staging copies still pending target whatever internal buffer is at flush time, let them land in the old one first
+	StagingBufferMgr()->FlushDataMainThread();
+
+	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPool()->AllocatePrimaryCommandBuffer();
+	pCmdBuffer->StartPrimaryRecording();
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, { barrier }, {}, {});
+
+	VkBufferCopy copy = {};
+	copy.size = oldSize;
+	vkCmdCopyBuffer(pCmdBuffer->GetDeviceHandle(), m_pBuffer->GetDeviceHandle(), pNewBuffer->GetDeviceHandle(), 1, &copy);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	pCmdBuffer->AttachBarriers(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, { barrier }, {}, {});
+
+	pCmdBuffer->EndPrimaryRecording();
+
+	// Growing is rare, simply wait for it
+	GlobalGraphicQueue()->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+
+	m_pBuffer = pNewBuffer;
+	m_pAllocator->Grow((uint32_t)newSize);
+	m_generation++;
+
+	return true;
 }
 
 void SharedBufferManager::UpdateByteStream(const void* pData, const std::shared_ptr<Buffer>& pWrapperBuffer, const std::shared_ptr<BufferKey>& pBufKey, uint32_t offset, uint32_t numBytes)
 {
 	if (m_pBuffer->IsHostVisible())
-		m_pBuffer->UpdateByteStream(pData, offset + (uint32_t)m_bufferTable[m_lookupTable[pBufKey->m_key]].offset, numBytes);
+		m_pBuffer->UpdateByteStream(pData, offset + (uint32_t)m_bufferTable[pBufKey->m_key].offset, numBytes);
 	// Since shared buffer manager holds a buffer shared by different shared buffers, with various usage and access flags, we can't simply let buffer do its update
 	// Without specific buffer's information
 	// So here we do a little hack to override, by directly call staging buffer to update wrapper buffer with its information
 	else
-		StagingBufferMgr()->UpdateByteStream(pWrapperBuffer, pData, offset + (uint32_t)m_bufferTable[m_lookupTable[pBufKey->m_key]].offset, numBytes);
+		StagingBufferMgr()->UpdateByteStream(pWrapperBuffer, pData, offset + (uint32_t)m_bufferTable[pBufKey->m_key].offset, numBytes);
 }
 
 void SharedBufferManager::UpdateByteStream(const void* pData, const std::shared_ptr<SharedBuffer>& pWrapperBuffer, const std::shared_ptr<BufferKey>& pBufKey, uint32_t offset, uint32_t numBytes)
 {
 	if (m_pBuffer->IsHostVisible())
-		m_pBuffer->UpdateByteStream(pData, offset + (uint32_t)m_bufferTable[m_lookupTable[pBufKey->m_key]].offset, numBytes);
+		m_pBuffer->UpdateByteStream(pData, offset + (uint32_t)m_bufferTable[pBufKey->m_key].offset, numBytes);
 	else
-		StagingBufferMgr()->UpdateByteStream(pWrapperBuffer, pData, offset + (uint32_t)m_bufferTable[m_lookupTable[pBufKey->m_key]].offset, numBytes);
+		StagingBufferMgr()->UpdateByteStream(pWrapperBuffer, pData, offset + (uint32_t)m_bufferTable[pBufKey->m_key].offset, numBytes);
 }
 
 uint32_t SharedBufferManager::GetOffset(const std::shared_ptr<BufferKey>& pBufKey)
 { 
-	return (uint32_t)m_bufferTable[m_lookupTable[pBufKey->m_key]].offset;
+	return (uint32_t)m_bufferTable[pBufKey->m_key].offset;
 }
 
 VkDescriptorBufferInfo SharedBufferManager::GetBufferDesc(const std::shared_ptr<BufferKey>& pBufKey)
 { 
-	return m_bufferTable[m_lookupTable[pBufKey->m_key]]; 
+	const BufferChunk& chunk = m_bufferTable[pBufKey->m_key];
+	return { m_pBuffer->GetDeviceHandle(), chunk.offset, chunk.numBytes };
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Buffer.h"
 #include "GlobalDeviceObjects.h"
+#include "TLSFAllocator.h"
 
 class SharedBufferManager;
 class SharedBuffer;
@@ -24,22 +25,38 @@ private:
 	friend class SharedBufferManager;
 };
 
+// Buffer chunks are sub allocated with a TLSF allocator, both allocating and freeing are O(1)
+// A key is an index into chunk table and never changes during its life time, freed slots are recycled
 class SharedBufferManager : public DeviceObjectBase<SharedBufferManager>
 {
+	typedef struct _BufferChunk
+	{
+		uint32_t	offset;
+		uint32_t	numBytes;
+		uint32_t	allocationHandle;
+	}BufferChunk;
+
 protected:
 	bool Init(const std::shared_ptr<Device>& pDevice, 
 		const std::shared_ptr<SharedBufferManager>& pSelf,
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlagBits memFlag,
-		uint32_t numBytes);
+		uint32_t numBytes,
+		bool allowGrowth);
+
+	void FreeBuffer(uint32_t key);
 
-	void FreeBuffer(uint32_t index);
+	// Re-create internal buffer with a larger size and copy everything over
+	bool GrowBuffer(uint32_t requiredBytes);
 
 public:
+	// Growing replaces internal buffer, so it's only allowed for users who fetch device handle again after "GetGeneration()" changes,
+	// rather than baking it into descriptor sets or command buffers once
 	static std::shared_ptr<SharedBufferManager> Create(const std::shared_ptr<Device>& pDevice,
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlagBits memFlag,
-		uint32_t numBytes);
+		uint32_t numBytes,
+		bool allowGrowth = false);
 
 public:
 	std::shared_ptr<Buffer> GetBuffer() const { return m_pBuffer; }
@@ -48,6 +65,13 @@ public:
 	uint32_t GetOffset(const std::shared_ptr<BufferKey>& pBufKey);
 	VkDescriptorBufferInfo GetBufferDesc(const std::shared_ptr<BufferKey>& pBufKey);
 
+	// Increased each time internal buffer is re-created
+	uint32_t GetGeneration() const { return m_generation; }
+	uint32_t GetAllocationCount() const { return m_pAllocator->GetAllocationCount(); }
+	uint32_t GetUsedBytes() const { return m_pAllocator->GetUsedBytes(); }
+	uint32_t GetFreeBytes() const { return m_pAllocator->GetFreeBytes(); }
+	double GetFragmentation() const { return m_pAllocator->GetFragmentation(); }
+
 	// Since m_pBuffer is used as internal buffer for shared buffers, we cannot directly use it, as many buffer specific member variables are missing
 	// So I add one more input parameter "pWrapperBuffer", which wrappers "m_pBuffer" and behave exactly like a shared buffer with its member variable inited properly
 	// Therefore other classes can access this shared buffer correctly
@@ -56,15 +80,15 @@ public:
 
 protected:
 	std::shared_ptr<Buffer>					m_pBuffer;
+	VkMemoryPropertyFlagBits				m_memFlag;
+	bool									m_allowGrowth = false;
+	uint32_t								m_generation = 0;
 
-	// Where buffer chunks located, one after another
-	std::vector<VkDescriptorBufferInfo>		m_bufferTable;
-
-	// Key is BufferKey's m_key, and value is m_bufferTable's index
-	std::map<uint32_t, uint32_t>			m_lookupTable;
+	std::shared_ptr<TLSFAllocator>			m_pAllocator;
 
-	// After allocating a buffer key, this static variable is increased by one
-	static uint32_t m_numAllocatedKeys;
+	// Indexed by BufferKey's m_key
+	std::vector<BufferChunk>				m_bufferTable;
+	std::vector<uint32_t>					m_freeKeys;
 
 	friend class BufferKey;
 };
\ No newline at end of file
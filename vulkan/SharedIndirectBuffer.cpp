@@ -1,12 +1,16 @@
 #include "SharedIndirectBuffer.h"
 #include "GlobalDeviceObjects.h"
+#include "PhysicalDevice.h"
 
 bool SharedIndirectBuffer::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<SharedIndirectBuffer>& pSelf, uint32_t numBytes)
 {
 	VkBufferCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	info.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-	info.size = numBytes;
+	// Indirect buffers could be bound as storage buffers and written by compute shaders
+	// Pad size to storage buffer offset alignment, so that chunks packed one after another stay aligned
+	uint32_t minAlign = (uint32_t)GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.minStorageBufferOffsetAlignment;
+	info.size = (numBytes + minAlign - 1) / minAlign * minAlign;
 
 	if (!SharedBuffer::Init(pDevice, pSelf, info))
 		return false;
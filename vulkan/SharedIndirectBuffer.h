@@ -14,6 +14,8 @@ public:
 	void SetIndirectCmd(uint32_t index, const VkDrawIndexedIndirectCommand& cmd);
 	void SetIndirectCmdCount(uint32_t count);
 
+	VkDescriptorBufferInfo GetDescBufferInfo() const { return m_pBufferKey->GetSharedBufferMgr()->GetBufferDesc(m_pBufferKey); }
+
 protected:
 	std::shared_ptr<BufferKey>	AcquireBuffer(uint32_t numBytes) override;
 };
\ No newline at end of file
@@ -2,10 +2,20 @@
 #include "GlobalDeviceObjects.h"
 #include "CommandPool.h"
 #include <algorithm>
+#include <chrono>
 #include "Queue.h"
 #include "CommandBuffer.h"
 #include "PerFrameResource.h"
 #include "FrameManager.h"
+#include "Fence.h"
+#include "Semaphore.h"
+
+StagingBufferManager::~StagingBufferManager()
+{
+	// Staging buffer and command buffers can't go away while gpu is still reading them
+	for (auto& submission : m_inFlightSubmissions)
+		submission.pFence->Wait();
+}
 
 bool StagingBufferManager::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<StagingBufferManager>& pSelf)
 {
@@ -13,6 +23,13 @@ bool StagingBufferManager::Init(const std::shared_ptr<Device>& pDevice, const st
 		return false;
 
 	m_pStagingBufferPool = StagingBuffer::Create(pDevice, STAGING_BUFFER_INC);
+	m_ringSize = STAGING_BUFFER_INC;
+
+	if (pDevice->GetPhysicalDevice()->HasDedicatedTransferQueue())
+		m_pTransferCmdPool = CommandPool::CreateTransferCBPool(pDevice);
+
+	m_statistics.ringSize = m_ringSize;
+	m_statistics.dedicatedTransferQueue = m_pTransferCmdPool != nullptr;
 
 	return true;
 }
@@ -27,57 +44,293 @@ std::shared_ptr<StagingBufferManager> StagingBufferManager::Create(const std::sh
 
 void StagingBufferManager::FlushDataMainThread()
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPool()->AllocatePrimaryCommandBuffer();
+	if (m_pendingUpdateBuffer.empty())
+		return;
 
-	pCmdBuffer->StartPrimaryRecording();
+	// Group copies by destination buffer, shared buffers wrap the same device buffer, so device handle is the key
+	// Stable sort keeps the submission order of copies to the same offset
+	std::vector<uint32_t> order(m_pendingUpdateBuffer.size());
+	for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+		order[i] = i;
 
-	// Copy each chunk to dst buffer
-	std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
 	{
-		VkBufferCopy copy = {};
-		copy.dstOffset = info.dstOffset;
-		copy.srcOffset = info.srcOffset;
-		copy.size = info.numBytes;
-		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
+		const PendingBufferInfo& infoA = m_pendingUpdateBuffer[a];
+		const PendingBufferInfo& infoB = m_pendingUpdateBuffer[b];
+		if (infoA.pBuffer->GetDeviceHandle() != infoB.pBuffer->GetDeviceHandle())
+			return infoA.pBuffer->GetDeviceHandle() < infoB.pBuffer->GetDeviceHandle();
+		return infoA.dstOffset < infoB.dstOffset;
 	});
 
+	std::shared_ptr<CommandBuffer> pCmdBuffer;
+	if (m_pTransferCmdPool != nullptr)
+		pCmdBuffer = m_pTransferCmdPool->AllocatePrimaryCommandBuffer();
+	else
+		pCmdBuffer = MainThreadPool()->AllocatePrimaryCommandBuffer();
+
+	pCmdBuffer->StartPrimaryRecording();
+
+	InFlightSubmission submission;
+
+	auto recordCopy = [&](const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+	{
+		// Transfer queue doesn't support graphic stages used by CopyBuffer's barriers, semaphore takes care of synchronization
+		if (m_pTransferCmdPool != nullptr)
+		{
+			vkCmdCopyBuffer(pCmdBuffer->GetDeviceHandle(), m_pStagingBufferPool->GetDeviceHandle(), pDst->GetDeviceHandle(), (uint32_t)regions.size(), regions.data());
+			submission.dstBuffers.push_back(pDst);
+		}
+		else
+			pCmdBuffer->CopyBuffer(m_pStagingBufferPool, pDst, regions);
+
+		m_statistics.totalCopyCommands++;
+		m_statistics.totalCopyRegions += regions.size();
+	};
+
+	uint32_t groupStart = 0;
+	while (groupStart < (uint32_t)order.size())
+	{
+		const std::shared_ptr<BufferBase>& pDst = m_pendingUpdateBuffer[order[groupStart]].pBuffer;
+
+		uint32_t groupEnd = groupStart + 1;
+		while (groupEnd < (uint32_t)order.size() && m_pendingUpdateBuffer[order[groupEnd]].pBuffer->GetDeviceHandle() == pDst->GetDeviceHandle())
+			groupEnd++;
+
+		// Regions of one copy command must not overlap, merge adjacent ones that are contiguous in both staging and dst buffer
+		std::vector<VkBufferCopy> regions;
+		bool overlapped = false;
+		for (uint32_t i = groupStart; i < groupEnd; i++)
+		{
+			const PendingBufferInfo& info = m_pendingUpdateBuffer[order[i]];
+
+			if (!regions.empty())
+			{
+				VkBufferCopy& last = regions.back();
+				if (last.dstOffset + last.size > info.dstOffset)
+				{
+					overlapped = true;
+					break;
+				}
+
+				if (last.dstOffset + last.size == info.dstOffset && last.srcOffset + last.size == info.srcOffset)
+				{
+					last.size += info.numBytes;
+					continue;
+				}
+			}
+
+			regions.push_back({ info.srcOffset, info.dstOffset, info.numBytes });
+		}
+
+		if (!overlapped)
+			recordCopy(pDst, regions);
+		else
+		{
+			// Rare case that the same range is updated more than once before flushing, copy one by one in submission order
+			std::vector<uint32_t> groupOrder(order.begin() + groupStart, order.begin() + groupEnd);
+			std::sort(groupOrder.begin(), groupOrder.end());
+			for (uint32_t index : groupOrder)
+			{
+				const PendingBufferInfo& info = m_pendingUpdateBuffer[index];
+				recordCopy(info.pBuffer, { { info.srcOffset, info.dstOffset, info.numBytes } });
+			}
+		}
+
+		groupStart = groupEnd;
+	}
+
 	pCmdBuffer->EndPrimaryRecording();
 
-	GlobalGraphicQueue()->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+	submission.pFence = AcquireFence();
+	submission.pFence->Reset();
+	submission.cmdBuffers.push_back(pCmdBuffer);
+	submission.ringBytes = m_unsubmittedRingBytes;
+
+	if (m_pTransferCmdPool != nullptr)
+	{
+		// Copy on transfer queue after the last submitted frame is done reading, the next frame's graphic submission waits for it
+		// Dst buffers are created concurrent between both families by Buffer, no ownership transfer needed
+		submission.pSemaphore = Semaphore::Create(GetDevice());
+		submission.pWaitSemaphore = m_pFrameReadSemaphore;
+		m_pFrameReadSemaphore = nullptr;
+
+		if (submission.pWaitSemaphore != nullptr)
+			GlobalTransferQueue()->SubmitCommandBuffers(submission.cmdBuffers, { submission.pWaitSemaphore }, { VK_PIPELINE_STAGE_TRANSFER_BIT }, { submission.pSemaphore }, submission.pFence);
+		else
+			GlobalTransferQueue()->SubmitCommandBuffers(submission.cmdBuffers, {}, {}, { submission.pSemaphore }, submission.pFence);
+
+		m_unwaitedCopySemaphores.push_back(submission.pSemaphore);
+	}
+	else
+		GlobalGraphicQueue()->SubmitCommandBuffers(submission.cmdBuffers, submission.pFence);
+
+	m_inFlightSubmissions.push_back(submission);
+	m_statistics.totalSubmissions++;
 
 	m_pendingUpdateBuffer.clear();
-	m_usedNumBytes = 0;
+	m_unsubmittedRingBytes = 0;
 }
 
-void StagingBufferManager::RecordDataFlush(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+void StagingBufferManager::FlushFrameUploads()
 {
-	// Copy each chunk to dst buffer
-	std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
+	// Last frame is submitted by now, its signal could be waited
+	if (m_pPendingFrameReadSemaphore != nullptr)
 	{
-		VkBufferCopy copy = {};
-		copy.dstOffset = info.dstOffset;
-		copy.srcOffset = info.srcOffset;
-		copy.size = info.numBytes;
-		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
-	});
+		m_pFrameReadSemaphore = m_pPendingFrameReadSemaphore;
+		m_pPendingFrameReadSemaphore = nullptr;
+	}
 
-	m_pendingUpdateBuffer.clear();
-	m_usedNumBytes = 0;
+	FlushDataMainThread();
+	RetireSubmissions(false);
+
+	m_statistics.lastFrameUploadBytes = m_frameUploadBytes;
+	m_statistics.lastFrameStallTime = m_frameStallTime;
+	m_frameUploadBytes = 0;
+	m_frameStallTime = 0;
+}
+
+void StagingBufferManager::TakeFrameSemaphores(std::vector<std::shared_ptr<Semaphore>>& waitSemaphores, std::vector<VkPipelineStageFlags>& waitStages, std::vector<std::shared_ptr<Semaphore>>& signalSemaphores)
+{
+	// Copies on graphic queue are ordered by their own barriers
+	if (m_pTransferCmdPool == nullptr)
+		return;
+
+	for (auto& pSemaphore : m_unwaitedCopySemaphores)
+	{
+		waitSemaphores.push_back(pSemaphore);
+		waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	}
+	m_unwaitedCopySemaphores.clear();
+
+	// A binary semaphore is signaled again only after it's waited, an older one nobody waited for is simply dropped
+	// Signal operation covers all earlier work on graphic queue, the newest one is enough
+	m_pPendingFrameReadSemaphore = Semaphore::Create(GetDevice());
+	signalSemaphores.push_back(m_pPendingFrameReadSemaphore);
+}
+
+StagingBufferManager::StagingStatistics StagingBufferManager::GetStatistics() const
+{
+	StagingStatistics stats = m_statistics;
+	stats.ringUsedBytes = m_ringUsedBytes;
+	stats.inFlightSubmissionCount = (uint32_t)m_inFlightSubmissions.size();
+	return stats;
 }
 
 void StagingBufferManager::UpdateByteStream(const std::shared_ptr<BufferBase>& pBuffer, const void* pData, uint32_t offset, uint32_t numBytes)
 {
-	uint32_t currentOffset = m_usedNumBytes;
-	m_pendingUpdateBuffer.push_back({ pBuffer, offset, currentOffset, numBytes });
-	m_usedNumBytes += numBytes;
+	if (numBytes > MAX_UPLOAD_CHUNK)
+		m_statistics.splitUploadCount++;
+
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	while (numBytes > 0)
+	{
+		uint32_t chunkBytes = numBytes < MAX_UPLOAD_CHUNK ? numBytes : MAX_UPLOAD_CHUNK;
+		uint32_t srcOffset = AcquireRingSpace(chunkBytes);
+
+		m_pStagingBufferPool->UpdateByteStream(pBytes, srcOffset, chunkBytes);
+		m_pendingUpdateBuffer.push_back({ pBuffer, offset, srcOffset, chunkBytes });
+
+		pBytes += chunkBytes;
+		offset += chunkBytes;
+		numBytes -= chunkBytes;
+	}
+}
+
+uint32_t StagingBufferManager::AcquireRingSpace(uint32_t numBytes)
+{
+	uint32_t offset;
+	if (!AllocateRingSpace(numBytes, offset))
+	{
+		// Ring is used up, pending copies have to be submitted before their range could ever be recycled
+		FlushDataMainThread();
+		RetireSubmissions(false);
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		while (!AllocateRingSpace(numBytes, offset))
+		{
+			ASSERTION(!m_inFlightSubmissions.empty());
+			RetireSubmissions(true);
+		}
+		double stallTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		m_frameStallTime += stallTime;
+		m_statistics.totalStallTime += stallTime;
+	}
+
+	m_frameUploadBytes += numBytes;
+	m_statistics.totalUploadBytes += numBytes;
+
+	return offset;
+}
+
+// Allocation is always contiguous, if the tail of the ring isn't enough, it's wasted and allocation starts over from the beginning
+bool StagingBufferManager::AllocateRingSpace(uint32_t numBytes, uint32_t& offset)
+{
+	ASSERTION(numBytes <= m_ringSize);
+
+	if (m_ringUsedBytes == 0)
+		m_ringHead = 0;
+
+	if (m_ringUsedBytes + numBytes > m_ringSize)
+		return false;
+
+	uint32_t ringTail = (m_ringHead + m_ringSize - m_ringUsedBytes) % m_ringSize;
+	uint32_t wastedBytes = 0;
+
+	if (m_ringHead >= ringTail)
+	{
+		// Free space is [head, end) and [0, tail)
+		if (m_ringSize - m_ringHead >= numBytes)
+			offset = m_ringHead;
+		else if (ringTail >= numBytes)
+		{
+			wastedBytes = m_ringSize - m_ringHead;
+			offset = 0;
+		}
+		else
+			return false;
+	}
+	else
+	{
+		// Free space is [head, tail)
+		if (ringTail - m_ringHead >= numBytes)
+			offset = m_ringHead;
+		else
+			return false;
+	}
+
+	m_ringHead = (offset + numBytes) % m_ringSize;
+	m_ringUsedBytes += numBytes + wastedBytes;
+	m_unsubmittedRingBytes += numBytes + wastedBytes;
+	m_statistics.wrapWastedBytes += wastedBytes;
+
+	return true;
+}
+
+void StagingBufferManager::RetireSubmissions(bool waitForOldest)
+{
+	if (waitForOldest && !m_inFlightSubmissions.empty())
+		m_inFlightSubmissions.front().pFence->Wait();
 
-	if (m_usedNumBytes > m_pStagingBufferPool->GetBufferInfo().size)
+	// Submissions are retired in order, since ring ranges are released from tail
+	while (!m_inFlightSubmissions.empty() && m_inFlightSubmissions.front().pFence->CheckSignaled())
 	{
-		// Acquire a bigger chunck of memory for staging buffer
-		// Copy data into new staging buffer
-		// Delete old staging buffer
-		assert(false);
+		InFlightSubmission& submission = m_inFlightSubmissions.front();
+
+		m_ringUsedBytes -= submission.ringBytes;
+		m_freeFences.push_back(submission.pFence);
+
+		m_inFlightSubmissions.pop_front();
 	}
+}
 
-	m_pStagingBufferPool->UpdateByteStream(pData, currentOffset, numBytes);
-}
\ No newline at end of file
+std::shared_ptr<Fence> StagingBufferManager::AcquireFence()
+{
+	if (m_freeFences.empty())
+		return Fence::Create(GetDevice());
+
+	std::shared_ptr<Fence> pFence = m_freeFences.back();
+	m_freeFences.pop_back();
+	return pFence;
+}
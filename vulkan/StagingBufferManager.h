@@ -1,11 +1,17 @@
 #pragma once
 
 #include "StagingBuffer.h"
+#include <deque>
 
 class PerFrameResource;
 class CommandBuffer;
+class CommandPool;
 class BufferBase;
+class Fence;
+class Semaphore;
 
+// Staging buffer is used as a ring, each flush submits its copies asynchronously and retires its range once its fence is signaled
+// Main thread only waits for gpu when the ring is used up
 class StagingBufferManager : public DeviceObjectBase<StagingBufferManager>
 {
 	typedef struct _PendingBufferInfo
@@ -16,23 +22,97 @@ class StagingBufferManager : public DeviceObjectBase<StagingBufferManager>
 		uint32_t numBytes;
 	}PendingBufferInfo;
 
+	typedef struct _InFlightSubmission
+	{
+		std::shared_ptr<Fence>						pFence;
+		// Transfer queue only: signaled by copies, and the frame's reads they waited for
+		std::shared_ptr<Semaphore>					pSemaphore;
+		std::shared_ptr<Semaphore>					pWaitSemaphore;
+		std::vector<std::shared_ptr<CommandBuffer>>	cmdBuffers;
+		// Transfer queue copies don't go through CommandBuffer::CopyBuffer, keep dst buffers alive here
+		std::vector<std::shared_ptr<BufferBase>>	dstBuffers;
+		// Ring bytes to release after fence is signaled, including the tail wasted by wrapping
+		uint32_t									ringBytes;
+	}InFlightSubmission;
+
 public:
+	typedef struct _StagingStatistics
+	{
+		uint32_t	ringSize = 0;
+		uint32_t	ringUsedBytes = 0;
+		uint32_t	inFlightSubmissionCount = 0;
+		bool		dedicatedTransferQueue = false;
+
+		uint64_t	lastFrameUploadBytes = 0;
+		// Milliseconds main thread spent waiting for ring space
+		double		lastFrameStallTime = 0;
+
+		// Accumulated since created
+		uint64_t	totalUploadBytes = 0;
+		double		totalStallTime = 0;
+		uint64_t	totalSubmissions = 0;
+		uint64_t	totalCopyCommands = 0;
+		uint64_t	totalCopyRegions = 0;
+		uint64_t	splitUploadCount = 0;
+		uint64_t	wrapWastedBytes = 0;
+	}StagingStatistics;
+
+public:
+	~StagingBufferManager();
+
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<StagingBufferManager>& pSelf);
 
 	static std::shared_ptr<StagingBufferManager> Create(const std::shared_ptr<Device>& pDevice);
 
 public:
+	// Submit pending copies without waiting for them
 	void FlushDataMainThread();
-	void RecordDataFlush(const std::shared_ptr<CommandBuffer>& pCmdBuffer);
+	// Called once per frame: flush, recycle finished ranges and roll per frame counters
+	void FlushFrameUploads();
+	// Called by the frame's graphic submission, it waits for copies on transfer queue and signals once its reads are done, so later copies won't overwrite them
+	void TakeFrameSemaphores(std::vector<std::shared_ptr<Semaphore>>& waitSemaphores, std::vector<VkPipelineStageFlags>& waitStages, std::vector<std::shared_ptr<Semaphore>>& signalSemaphores);
+
+	StagingStatistics GetStatistics() const;
 
 protected:
 	void UpdateByteStream(const std::shared_ptr<BufferBase>& pBuffer, const void* pData, uint32_t offset, uint32_t numBytes);
 
+	uint32_t AcquireRingSpace(uint32_t numBytes);
+	bool AllocateRingSpace(uint32_t numBytes, uint32_t& offset);
+	void RetireSubmissions(bool waitForOldest);
+
+	std::shared_ptr<Fence> AcquireFence();
+
 protected:
 	std::shared_ptr<StagingBuffer>	m_pStagingBufferPool;
 	std::vector<PendingBufferInfo>	m_pendingUpdateBuffer;
-	uint32_t						m_usedNumBytes = 0;
+
+	uint32_t						m_ringSize = 0;
+	uint32_t						m_ringHead = 0;
+	uint32_t						m_ringUsedBytes = 0;
+	uint32_t						m_unsubmittedRingBytes = 0;
+
+	std::deque<InFlightSubmission>	m_inFlightSubmissions;
+	std::vector<std::shared_ptr<Fence>>		m_freeFences;
+
+	// Semaphores aren't recycled, the frame waiting for or signaling them keeps them alive until its fence
+	// Copies submitted but not waited by any frame yet
+	std::vector<std::shared_ptr<Semaphore>>	m_unwaitedCopySemaphores;
+	// Reads of the last submitted frame, copies wait for it. Handed to a frame, it becomes waitable after that frame is submitted
+	std::shared_ptr<Semaphore>				m_pFrameReadSemaphore;
+	std::shared_ptr<Semaphore>				m_pPendingFrameReadSemaphore;
+
+	// Only exists with a dedicated transfer queue family
+	std::shared_ptr<CommandPool>	m_pTransferCmdPool;
+
+	uint64_t						m_frameUploadBytes = 0;
+	double							m_frameStallTime = 0;
+	StagingStatistics				m_statistics;
+
 	const static uint32_t STAGING_BUFFER_INC = 1024 * 1024 * 64;
+	// Large uploads are split so that one of them never needs the whole ring
+	const static uint32_t MAX_UPLOAD_CHUNK = STAGING_BUFFER_INC / 4;
+
 	friend class Buffer;
 	friend class Image;
 	friend class SharedBufferManager;
@@ -0,0 +1,330 @@
+#include "TLSFAllocator.h"
+#include "../common/Macros.h"
+
+const uint32_t TLSFAllocator::INVALID_HANDLE;
+
+TLSFAllocator::TLSFAllocator(uint32_t numBytes)
+	: m_numBytes(numBytes)
+{
+	for (uint32_t i = 0; i < FL_INDEX_COUNT; i++)
+	{
+		m_slBitmaps[i] = 0;
+		for (uint32_t j = 0; j < SL_INDEX_COUNT; j++)
+			m_freeHeads[i][j] = INVALID_HANDLE;
+	}
+
+	// The whole range is one free block at the beginning
+	uint32_t blockIndex = AcquireBlock();
+	m_blocks[blockIndex].offset = 0;
+	m_blocks[blockIndex].numBytes = numBytes;
+	InsertFreeBlock(blockIndex);
+
+	m_lastBlock = blockIndex;
+}
+
+uint32_t TLSFAllocator::HighestBit(uint32_t value)
+{
+	uint32_t bit = 0;
+	if (value & 0xffff0000) { bit += 16; value >>= 16; }
+	if (value & 0xff00) { bit += 8; value >>= 8; }
+	if (value & 0xf0) { bit += 4; value >>= 4; }
+	if (value & 0xc) { bit += 2; value >>= 2; }
+	if (value & 0x2) { bit += 1; }
+	return bit;
+}
+
+uint32_t TLSFAllocator::LowestBit(uint32_t value)
+{
+	return HighestBit(value & (~value + 1));
+}
+
+void TLSFAllocator::MappingInsert(uint32_t numBytes, uint32_t& fl, uint32_t& sl) const
+{
+	if (numBytes < SMALL_BLOCK_SIZE)
+	{
+		fl = 0;
+		sl = numBytes;
+		return;
+	}
+
+	uint32_t highestBit = HighestBit(numBytes);
+	sl = (numBytes >> (highestBit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+	fl = highestBit - SL_INDEX_COUNT_LOG2 + 1;
+}
+
+// Round up to next size class, so that any block found in it is large enough
+void TLSFAllocator::MappingSearch(uint32_t numBytes, uint32_t& fl, uint32_t& sl) const
+{
+	uint64_t roundedBytes = numBytes;
+	if (numBytes >= SMALL_BLOCK_SIZE)
+		roundedBytes += (1ull << (HighestBit(numBytes) - SL_INDEX_COUNT_LOG2)) - 1;
+
+	if (roundedBytes > UINT32_MAX)
+	{
+		fl = FL_INDEX_COUNT;
+		sl = 0;
+		return;
+	}
+
+	MappingInsert((uint32_t)roundedBytes, fl, sl);
+}
+
+uint32_t TLSFAllocator::FindFreeBlock(uint32_t fl, uint32_t sl) const
+{
+	if (fl >= FL_INDEX_COUNT)
+		return INVALID_HANDLE;
+
+	// Same first level with large enough second level
+	uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+	if (slMap == 0)
+	{
+		// Any larger first level
+		uint32_t flMap = fl + 1 < 32 ? (m_flBitmap & (~0u << (fl + 1))) : 0;
+		if (flMap == 0)
+			return INVALID_HANDLE;
+
+		fl = LowestBit(flMap);
+		slMap = m_slBitmaps[fl];
+	}
+
+	return m_freeHeads[fl][LowestBit(slMap)];
+}
+
+void TLSFAllocator::InsertFreeBlock(uint32_t blockIndex)
+{
+	Block& block = m_blocks[blockIndex];
+
+	uint32_t fl, sl;
+	MappingInsert(block.numBytes, fl, sl);
+
+	block.isFree = true;
+	block.prevFree = INVALID_HANDLE;
+	block.nextFree = m_freeHeads[fl][sl];
+	if (block.nextFree != INVALID_HANDLE)
+		m_blocks[block.nextFree].prevFree = blockIndex;
+
+	m_freeHeads[fl][sl] = blockIndex;
+	m_flBitmap |= 1 << fl;
+	m_slBitmaps[fl] |= 1 << sl;
+
+	m_freeRangeCount++;
+}
+
+void TLSFAllocator::RemoveFreeBlock(uint32_t blockIndex)
+{
+	Block& block = m_blocks[blockIndex];
+
+	uint32_t fl, sl;
+	MappingInsert(block.numBytes, fl, sl);
+
+	if (block.prevFree != INVALID_HANDLE)
+		m_blocks[block.prevFree].nextFree = block.nextFree;
+	else
+		m_freeHeads[fl][sl] = block.nextFree;
+
+	if (block.nextFree != INVALID_HANDLE)
+		m_blocks[block.nextFree].prevFree = block.prevFree;
+
+	if (m_freeHeads[fl][sl] == INVALID_HANDLE)
+	{
+		m_slBitmaps[fl] &= ~(1 << sl);
+		if (m_slBitmaps[fl] == 0)
+			m_flBitmap &= ~(1 << fl);
+	}
+
+	block.isFree = false;
+	m_freeRangeCount--;
+}
+
+uint32_t TLSFAllocator::AcquireBlock()
+{
+	uint32_t blockIndex;
+	if (m_freeBlockSlots.size() != 0)
+	{
+		blockIndex = m_freeBlockSlots.back();
+		m_freeBlockSlots.pop_back();
+	}
+	else
+	{
+		blockIndex = (uint32_t)m_blocks.size();
+		m_blocks.push_back({});
+	}
+
+	m_blocks[blockIndex] = { 0, 0, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE, false };
+	return blockIndex;
+}
+
+void TLSFAllocator::ReleaseBlock(uint32_t blockIndex)
+{
+	m_freeBlockSlots.push_back(blockIndex);
+}
+
+uint32_t TLSFAllocator::SplitBlock(uint32_t blockIndex, uint32_t numBytes)
+{
+	uint32_t newIndex = AcquireBlock();
+
+	// Acquiring might reallocate block array, don't hold reference before it
+	Block& block = m_blocks[blockIndex];
+	Block& newBlock = m_blocks[newIndex];
+
+	newBlock.offset = block.offset + numBytes;
+	newBlock.numBytes = block.numBytes - numBytes;
+	newBlock.prevPhysical = blockIndex;
+	newBlock.nextPhysical = block.nextPhysical;
+
+	if (block.nextPhysical != INVALID_HANDLE)
+		m_blocks[block.nextPhysical].prevPhysical = newIndex;
+	else
+		m_lastBlock = newIndex;
+
+	block.numBytes = numBytes;
+	block.nextPhysical = newIndex;
+
+	return newIndex;
+}
+
+void TLSFAllocator::MergeBlock(uint32_t blockIndex, uint32_t nextIndex)
+{
+	Block& block = m_blocks[blockIndex];
+	Block& nextBlock = m_blocks[nextIndex];
+
+	block.numBytes += nextBlock.numBytes;
+	block.nextPhysical = nextBlock.nextPhysical;
+
+	if (nextBlock.nextPhysical != INVALID_HANDLE)
+		m_blocks[nextBlock.nextPhysical].prevPhysical = blockIndex;
+	else
+		m_lastBlock = blockIndex;
+
+	ReleaseBlock(nextIndex);
+}
+
+bool TLSFAllocator::Allocate(uint32_t numBytes, uint32_t alignment, uint32_t& offset, uint32_t& handle)
+{
+	ASSERTION((alignment & (alignment - 1)) == 0);
+
+	numBytes = numBytes == 0 ? 1 : numBytes;
+	alignment = alignment == 0 ? 1 : alignment;
+
+	// Worst case padding is included in search size, so any block found could hold the aligned range
+	uint64_t searchBytes = (uint64_t)numBytes + alignment - 1;
+	if (searchBytes > m_numBytes)
+		return false;
+
+	uint32_t fl, sl;
+	MappingSearch((uint32_t)searchBytes, fl, sl);
+
+	uint32_t blockIndex = FindFreeBlock(fl, sl);
+	if (blockIndex == INVALID_HANDLE)
+		return false;
+
+	RemoveFreeBlock(blockIndex);
+
+	// Front padding for alignment goes back to free list
+	uint32_t blockOffset = m_blocks[blockIndex].offset;
+	uint32_t padding = ((blockOffset + alignment - 1) & ~(alignment - 1)) - blockOffset;
+	if (padding != 0)
+	{
+		uint32_t alignedIndex = SplitBlock(blockIndex, padding);
+		InsertFreeBlock(blockIndex);
+		blockIndex = alignedIndex;
+	}
+
+	// Remainder goes back to free list too
+	if (m_blocks[blockIndex].numBytes > numBytes)
+	{
+		uint32_t remainderIndex = SplitBlock(blockIndex, numBytes);
+		InsertFreeBlock(remainderIndex);
+	}
+
+	m_blocks[blockIndex].isFree = false;
+
+	offset = m_blocks[blockIndex].offset;
+	handle = blockIndex;
+
+	m_usedBytes += numBytes;
+	m_allocationCount++;
+
+	return true;
+}
+
+void TLSFAllocator::Free(uint32_t handle)
+{
+	ASSERTION(handle < m_blocks.size() && !m_blocks[handle].isFree);
+
+	m_usedBytes -= m_blocks[handle].numBytes;
+	m_allocationCount--;
+
+	uint32_t blockIndex = handle;
+
+	uint32_t prevIndex = m_blocks[blockIndex].prevPhysical;
+	if (prevIndex != INVALID_HANDLE && m_blocks[prevIndex].isFree)
+	{
+		RemoveFreeBlock(prevIndex);
+		MergeBlock(prevIndex, blockIndex);
+		blockIndex = prevIndex;
+	}
+
+	uint32_t nextIndex = m_blocks[blockIndex].nextPhysical;
+	if (nextIndex != INVALID_HANDLE && m_blocks[nextIndex].isFree)
+	{
+		RemoveFreeBlock(nextIndex);
+		MergeBlock(blockIndex, nextIndex);
+	}
+
+	InsertFreeBlock(blockIndex);
+}
+
+void TLSFAllocator::Grow(uint32_t numBytes)
+{
+	ASSERTION(numBytes >= m_numBytes);
+
+	uint32_t extraBytes = numBytes - m_numBytes;
+	if (extraBytes == 0)
+		return;
+
+	// Extra bytes join the last block if it's free, otherwise they become a new free block after it
+	if (m_blocks[m_lastBlock].isFree)
+	{
+		RemoveFreeBlock(m_lastBlock);
+		m_blocks[m_lastBlock].numBytes += extraBytes;
+		InsertFreeBlock(m_lastBlock);
+	}
+	else
+	{
+		uint32_t newIndex = AcquireBlock();
+		m_blocks[newIndex].offset = m_numBytes;
+		m_blocks[newIndex].numBytes = extraBytes;
+		m_blocks[newIndex].prevPhysical = m_lastBlock;
+		m_blocks[m_lastBlock].nextPhysical = newIndex;
+		m_lastBlock = newIndex;
+		InsertFreeBlock(newIndex);
+	}
+
+	m_numBytes = numBytes;
+}
+
+uint32_t TLSFAllocator::GetLargestFreeRange() const
+{
+	if (m_flBitmap == 0)
+		return 0;
+
+	// Largest one must be in the highest non-empty bucket
+	uint32_t fl = HighestBit(m_flBitmap);
+	uint32_t sl = HighestBit(m_slBitmaps[fl]);
+
+	uint32_t largest = 0;
+	for (uint32_t blockIndex = m_freeHeads[fl][sl]; blockIndex != INVALID_HANDLE; blockIndex = m_blocks[blockIndex].nextFree)
+		largest = m_blocks[blockIndex].numBytes > largest ? m_blocks[blockIndex].numBytes : largest;
+
+	return largest;
+}
+
+double TLSFAllocator::GetFragmentation() const
+{
+	uint32_t freeBytes = GetFreeBytes();
+	if (freeBytes == 0)
+		return 0;
+
+	return 1.0 - (double)GetLargestFreeRange() / freeBytes;
+}
\ No newline at end of file
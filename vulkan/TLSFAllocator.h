@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Two level segregated fit allocator over an abstract range of bytes
+// It never touches memory itself, only hands out offsets, so it's used to sub allocate device memory blocks,
+// and it could be exercised without any device at all
+//
+// Free ranges are bucketed by size class: first level is power of 2, second level splits each power of 2 linearly
+// Two bitmaps tell which buckets are non-empty, so both allocation and free are O(1)
+class TLSFAllocator
+{
+	static const uint32_t SL_INDEX_COUNT_LOG2 = 5;
+	static const uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+	// Ranges smaller than this are all in first level 0, split linearly
+	static const uint32_t SMALL_BLOCK_SIZE = 1 << SL_INDEX_COUNT_LOG2;
+	static const uint32_t FL_INDEX_COUNT = 32 - SL_INDEX_COUNT_LOG2 + 1;
+
+	typedef struct _Block
+	{
+		uint32_t	offset;
+		uint32_t	numBytes;
+		uint32_t	prevPhysical;
+		uint32_t	nextPhysical;
+		uint32_t	prevFree;
+		uint32_t	nextFree;
+		bool		isFree;
+	}Block;
+
+public:
+	static const uint32_t INVALID_HANDLE = (uint32_t)-1;
+
+public:
+	TLSFAllocator(uint32_t numBytes);
+
+public:
+	// Alignment must be power of 2
+	bool Allocate(uint32_t numBytes, uint32_t alignment, uint32_t& offset, uint32_t& handle);
+	void Free(uint32_t handle);
+	// Extend the range at its end, existing allocations stay where they are
+	void Grow(uint32_t numBytes);
+
+	uint32_t GetSize() const { return m_numBytes; }
+	uint32_t GetUsedBytes() const { return m_usedBytes; }
+	uint32_t GetFreeBytes() const { return m_numBytes - m_usedBytes; }
+	uint32_t GetAllocationCount() const { return m_allocationCount; }
+	uint32_t GetFreeRangeCount() const { return m_freeRangeCount; }
+	uint32_t GetLargestFreeRange() const;
+	bool IsEmpty() const { return m_allocationCount == 0; }
+
+	// 0 means all free bytes are in one piece, closer to 1 means they're scattered into small pieces
+	double GetFragmentation() const;
+
+private:
+	static uint32_t HighestBit(uint32_t value);
+	static uint32_t LowestBit(uint32_t value);
+
+	void MappingInsert(uint32_t numBytes, uint32_t& fl, uint32_t& sl) const;
+	void MappingSearch(uint32_t numBytes, uint32_t& fl, uint32_t& sl) const;
+	uint32_t FindFreeBlock(uint32_t fl, uint32_t sl) const;
+
+	void InsertFreeBlock(uint32_t blockIndex);
+	void RemoveFreeBlock(uint32_t blockIndex);
+
+	uint32_t AcquireBlock();
+	void ReleaseBlock(uint32_t blockIndex);
+
+	// Cut a block in 2, first one keeps "numBytes", the rest goes to the returned new block
+	uint32_t SplitBlock(uint32_t blockIndex, uint32_t numBytes);
+	// Absorb next physical block into this one
+	void MergeBlock(uint32_t blockIndex, uint32_t nextIndex);
+
+private:
+	uint32_t				m_numBytes;
+	uint32_t				m_usedBytes = 0;
+	uint32_t				m_allocationCount = 0;
+	uint32_t				m_freeRangeCount = 0;
+	// Block at the end of the range, where growing happens
+	uint32_t				m_lastBlock = INVALID_HANDLE;
+
+	std::vector<Block>		m_blocks;
+	std::vector<uint32_t>	m_freeBlockSlots;
+
+	uint32_t				m_flBitmap = 0;
+	uint32_t				m_slBitmaps[FL_INDEX_COUNT];
+	uint32_t				m_freeHeads[FL_INDEX_COUNT][SL_INDEX_COUNT];
+};
\ No newline at end of file
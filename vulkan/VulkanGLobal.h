@@ -209,6 +209,8 @@ public:
 	std::shared_ptr<BaseObject>			m_pSceneRootObject;
 
 	std::vector<std::shared_ptr<CommandBuffer>> m_commandBufferList;
+	// Storage resize count that each prebaked command buffer is recorded with
+	std::vector<uint32_t>						m_recordedResizeCounts;
 
 #if defined(_WIN32)
 	HINSTANCE							m_hPlatformInst;
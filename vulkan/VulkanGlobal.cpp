@@ -22,6 +22,7 @@
 #include "../class/RenderWorkManager.h"
 #include <iostream>
 #include "GlobalVulkanStates.h"
+#include "PipelineCache.h"
 #include "../class/UniformData.h"
 #include "IndirectBuffer.h"
 #include "SharedIndirectBuffer.h"
@@ -38,10 +39,36 @@
 #include "../component/FrustumJitter.h"
 #include "../class/AssimpSceneReader.h"
 #include "../component/AnimationController.h"
+#include "../class/AnimationManager.h"
 #include "../class/PerFrameData.h"
 #include "../class/FrameEventManager.h"
+#include "../class/TransientDataAllocator.h"
+#include "../class/SkinningManager.h"
+#include "../class/PlanetGeoDataManager.h"
 
 bool PREBAKE_CB = true;
+// Skins meshes once per frame in compute rather than in every pass drawing them, takes effect only if skinning.comp.spv is built
+bool COMPUTE_SKINNING = true;
+
+// Statistics go to debugger output, same as validation messages
+static void LogStatistics(const std::string& message)
+{
+#if defined(_WIN32)
+	OutputDebugStringA(message.c_str());
+	OutputDebugStringA("\n");
+#endif
+}
+
+static void PrintLoadStatistics(const AssimpSceneReader::LoadStatistics& statistics)
+{
+	std::stringstream ss;
+	ss << statistics.path << ": " << (statistics.fromCookedScene ? "cooked" : "assimp")
+		<< ", import " << statistics.importTime << "ms, cook " << statistics.cookTime << "ms, total " << statistics.totalTime << "ms";
+	LogStatistics(ss.str());
+
+	if (statistics.sourceMissing)
+		LogStatistics(statistics.path + " is missing, its cooked file is used without checking whether it's up to date");
+}
 
 void VulkanGlobal::InitVulkanInstance()
 {
@@ -305,6 +332,8 @@ void VulkanGlobal::Update()
 			{
 				quitMessageReceived = true;
 				FrameMgr()->WaitForAllJobsDone();
+				// Write pipelines compiled by this run back, so that next start is warm
+				GlobalPipelineCache()->Save();
 				return;
 			}
 		}
@@ -494,6 +523,26 @@ void VulkanGlobal::InitDescriptorSetLayout()
 
 void VulkanGlobal::InitPipelineCache()
 {
+	// Pipeline cache itself is loaded together with other global device objects, as pipelines are created even before this
+	// Pre-warm here: render work manager compiles all material pipelines in one parallel batch, rather than at first use
+	// Skinned materials are created for vertex shader or compute skinning, so it's decided ahead
+	SkinningManager::GetInstance()->SetEnabled(COMPUTE_SKINNING);
+	RenderWorkManager::GetInstance();
+
+	// Compile time is what tells a warm start from a cold one
+	PipelineCache::PipelineCacheStatistics statistics = GlobalPipelineCache()->GetStatistics();
+	std::stringstream ss;
+	ss << "Pipeline cache: " << (statistics.isWarm ? "warm" : "cold") << " start, " << statistics.loadedBytes << " bytes loaded, "
+		<< statistics.compiledPipelineCount << " pipelines compiled in " << statistics.compileTime << "ms";
+	LogStatistics(ss.str());
+
+	// Render graph has been compiled by render work manager as well
+	const RenderGraph::CompileStatistics& graphStatistics = RenderWorkManager::GetInstance()->GetRenderGraphStatistics();
+	ss.str("");
+	ss << "Render graph: " << graphStatistics.culledPassCount << " of " << graphStatistics.passCount << " passes culled, "
+		<< graphStatistics.imageBarrierCount << " image barriers in " << graphStatistics.barrierBatchCount << " batches, peak transient memory "
+		<< graphStatistics.transientBytes << " bytes before aliasing, " << graphStatistics.aliasedTransientBytes << " bytes after";
+	LogStatistics(ss.str());
 }
 
 void VulkanGlobal::InitPipeline()
@@ -718,6 +767,7 @@ void VulkanGlobal::InitScene()
 	AssimpSceneReader::SceneInfo sceneInfo;
 
 	m_pGunObject = AssimpSceneReader::ReadAndAssemblyScene("../data/textures/cerberus/cerberus.fbx", { VertexFormatPNTCT }, sceneInfo);
+	PrintLoadStatistics(AssimpSceneReader::GetLoadStatistics());
 	m_pGunMesh = sceneInfo.meshLinks[0].first;
 	m_pGunMeshRenderer = MeshRenderer::Create(m_pGunMesh, { m_pGunMaterialInstance, m_pShadowMapMaterialInstance });
 	sceneInfo.meshLinks[0].second->AddComponent(m_pGunMeshRenderer);
@@ -743,6 +793,7 @@ void VulkanGlobal::InitScene()
 	sceneInfo.meshLinks.clear();
 
 	m_pInnerBall = AssimpSceneReader::ReadAndAssemblyScene("../data/models/Sample.FBX", { VertexFormatPNTCT }, sceneInfo);
+	PrintLoadStatistics(AssimpSceneReader::GetLoadStatistics());
 	for (uint32_t i = 0; i < sceneInfo.meshLinks.size(); i++)
 	{
 		m_innerBallRenderers.push_back(MeshRenderer::Create(sceneInfo.meshLinks[i].first, { m_innerBallMaterialInstances[i], m_pShadowMapMaterialInstance }));
@@ -774,6 +825,8 @@ void VulkanGlobal::InitScene()
 
 	m_pSkyBoxObject = BaseObject::Create();
 	m_pSkyBoxMeshRenderer = MeshRenderer::Create(m_pCubeMesh, { m_pSkyBoxMaterialInstance });
+	// Sky box is drawn around camera regardless of its transform
+	m_pSkyBoxMeshRenderer->SetFrustumCulling(false);
 	m_pSkyBoxObject->AddComponent(m_pSkyBoxMeshRenderer);
 
 	m_pSophiaObject = AssimpSceneReader::ReadAndAssemblyScene("../data/models/rp_sophia_animated_003_idling.FBX", { VertexFormatPNTCTB }, sceneInfo);
@@ -790,6 +843,8 @@ void VulkanGlobal::InitScene()
 	sceneInfo.meshLinks.clear();
 
 	m_pPlanetRenderer = MeshRenderer::Create(m_pTriangleMesh, m_pPlanetMaterialInstance);
+	// Planet geometry comes from generator, triangle mesh bounds mean nothing
+	m_pPlanetRenderer->SetFrustumCulling(false);
 
 	m_pPlanetObject = BaseObject::Create();
 	m_pPlanetGenerator->SetPlanetRadius(32);
@@ -900,6 +955,10 @@ void VulkanGlobal::EndSetup()
 {
 	GlobalDeviceObjects::GetInstance()->GetStagingBufferMgr()->FlushDataMainThread();
 	m_commandBufferList.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+	m_recordedResizeCounts.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+
+	// Created ahead, so that it's reset from the first frame on
+	TransientDataAllocator::GetInstance();
 
 	m_pRootObject->Awake();
 	m_pRootObject->Start();
@@ -938,16 +997,21 @@ void VulkanGlobal::Draw()
 
 	m_pRootObject->Update();
 	m_pRootObject->OnAnimationUpdate();
+	AnimationManager::GetInstance()->Update();
 	m_pRootObject->LateUpdate();
 	m_pRootObject->UpdateCachedData();
 	m_pRootObject->OnPreRender();
 	m_pRootObject->OnRenderObject();
 
 	// Sync data for current frame before rendering
+	PerFrameDataStorage::ResetUploadStatistics();
 	UniformData::GetInstance()->SyncDataBuffer();
 	RenderWorkManager::GetInstance()->SyncMaterialData();
 	PerFrameData::GetInstance()->SyncDataBuffer();
 
+	// Submit uploads of this frame ahead of rendering, it doesn't wait for them
+	StagingBufferMgr()->FlushFrameUploads();
+
 	RenderWorkManager::GetInstance()->OnFrameBegin();
 
 	static bool newCBCreated = false;
@@ -956,7 +1020,8 @@ void VulkanGlobal::Draw()
 		m_commandBufferList[cbIndex] = m_perFrameRes[FrameMgr()->FrameIndex()]->AllocateTransientPrimaryCommandBuffer();
 		newCBCreated = true;
 	}
-	else if (m_commandBufferList[cbIndex] == nullptr)
+	// Prebaked commands refer to descriptor sets and buffers of storages, they're recorded again once any storage grows
+	else if (m_commandBufferList[cbIndex] == nullptr || m_recordedResizeCounts[cbIndex] != PerFrameDataStorage::GetResizeCount())
 	{
 		m_commandBufferList[cbIndex] = m_perFrameRes[FrameMgr()->FrameIndex()]->AllocatePersistantPrimaryCommandBuffer();
 		newCBCreated = true;
@@ -964,6 +1029,8 @@ void VulkanGlobal::Draw()
 
 	if (newCBCreated)
 	{
+		m_recordedResizeCounts[cbIndex] = PerFrameDataStorage::GetResizeCount();
+
 		m_commandBufferList[cbIndex]->StartPrimaryRecording();
 
 		RenderWorkManager::GetInstance()->Draw(m_commandBufferList[cbIndex], pingpong);
@@ -973,11 +1040,26 @@ void VulkanGlobal::Draw()
 		newCBCreated = false;
 	}
 
+	// Planet uploads and skinning jobs change from frame to frame, they're recorded every frame and submitted ahead of prebaked commands
+	std::vector<std::shared_ptr<CommandBuffer>> cmdBuffers;
+	std::shared_ptr<CommandBuffer> pPlanetCmdBuffer = PlanetGeoDataManager::GetInstance()->RecordUploads();
+	if (pPlanetCmdBuffer != nullptr)
+		cmdBuffers.push_back(pPlanetCmdBuffer);
+	std::shared_ptr<CommandBuffer> pSkinningCmdBuffer = SkinningManager::GetInstance()->RecordDispatches();
+	if (pSkinningCmdBuffer != nullptr)
+		cmdBuffers.push_back(pSkinningCmdBuffer);
+	cmdBuffers.push_back(m_commandBufferList[cbIndex]);
+
 	m_pRootObject->OnPostRender();
 
 	RenderWorkManager::GetInstance()->OnFrameEnd();
 
-	FrameMgr()->CacheSubmissioninfo(GlobalGraphicQueue(), { m_commandBufferList[cbIndex] }, {}, false);
+	// Frame waits for copies on transfer queue, and tells later copies when it's done reading
+	std::vector<std::shared_ptr<Semaphore>> waitSemaphores, signalSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
+	StagingBufferMgr()->TakeFrameSemaphores(waitSemaphores, waitStages, signalSemaphores);
+
+	FrameMgr()->CacheSubmissioninfo(GlobalGraphicQueue(), cmdBuffers, waitSemaphores, waitStages, signalSemaphores, false);
 	
 	GetSwapChain()->QueuePresentImage(GlobalObjects()->GetPresentQueue());
 